@@ -3,9 +3,10 @@
  *
  * Provides keyboard_event() / mouse_event() for the USB HID driver to post
  * events into, and keyboard_poll() / mouse_poll() for the WIMP / apps to
- * consume them.  Both use simple lock-free single-consumer circular queues
- * (safe because we run single-core, no concurrent writers from IRQ context
- * while xHCI polling is done from the main loop).
+ * consume them.  Both are single-consumer circular queues.  boot417: the
+ * HID driver now posts from the xHCI MSI handler as well as from the main
+ * loop, so each queue takes a spinlock with interrupts masked.  Events
+ * carry the time their report arrived (time_ms).
  *
  * Mouse absolute position is tracked here; dx/dy from HID reports are
  * accumulated and clamped to the screen bounds set via mouse_set_bounds().
@@ -22,6 +23,7 @@
 static keyboard_event_t kbd_queue[KBD_QUEUE_SIZE];
 static volatile int     kbd_head = 0;  /* next slot to write into */
 static volatile int     kbd_tail = 0;  /* next slot to read from  */
+static spinlock_t       kbd_lock = SPINLOCK_INIT;   /* boot417 */
 
 int keyboard_init(void)
 {
@@ -33,6 +35,8 @@ int keyboard_init(void)
 /* Called by USB HID driver to post a new key event */
 void keyboard_event(const keyboard_event_t *ev)
 {
+    unsigned long flags;
+    spin_lock_irqsave(&kbd_lock, &flags);
     int next = (kbd_head + 1) & (KBD_QUEUE_SIZE - 1);
     if (next == kbd_tail) {
         /* Queue full — drop oldest event */
@@ -40,16 +44,22 @@ void keyboard_event(const keyboard_event_t *ev)
     }
     kbd_queue[kbd_head] = *ev;
     kbd_head = next;
+    spin_unlock_irqrestore(&kbd_lock, flags);
 }
 
 /* Called by WIMP/apps to consume one event.  Returns 0 if queue empty. */
 int keyboard_poll(keyboard_event_t *ev)
 {
-    if (kbd_tail == kbd_head)
-        return 0;  /* empty */
-    *ev = kbd_queue[kbd_tail];
-    kbd_tail = (kbd_tail + 1) & (KBD_QUEUE_SIZE - 1);
-    return 1;
+    unsigned long flags;
+    int got = 0;
+    spin_lock_irqsave(&kbd_lock, &flags);
+    if (kbd_tail != kbd_head) {
+        *ev = kbd_queue[kbd_tail];
+        kbd_tail = (kbd_tail + 1) & (KBD_QUEUE_SIZE - 1);
+        got = 1;
+    }
+    spin_unlock_irqrestore(&kbd_lock, flags);
+    return got;
 }
 
 /* ── Mouse event queue + absolute position ───────────────────────────────── */
@@ -59,6 +69,7 @@ int keyboard_poll(keyboard_event_t *ev)
 static mouse_event_t mouse_queue[MOUSE_QUEUE_SIZE];
 static volatile int  mouse_head = 0;
 static volatile int  mouse_tail = 0;
+static spinlock_t    mouse_lock = SPINLOCK_INIT;    /* boot417 */
 
 /* Absolute pointer position, clamped to [0, bounds] */
 static int16_t mouse_x = 640;
@@ -86,6 +97,9 @@ void mouse_set_bounds(int16_t width, int16_t height)
 /* Called by USB HID driver to post a mouse movement/click event */
 void mouse_event(const mouse_event_t *ev)
 {
+    unsigned long flags;
+    spin_lock_irqsave(&mouse_lock, &flags);
+
     /* Accumulate deltas into absolute position */
     int nx = (int)mouse_x + ev->dx;
     int ny = (int)mouse_y + ev->dy;
@@ -104,16 +118,22 @@ void mouse_event(const mouse_event_t *ev)
     mouse_queue[mouse_head].x       = mouse_x;
     mouse_queue[mouse_head].y       = mouse_y;
     mouse_head = next;
+    spin_unlock_irqrestore(&mouse_lock, flags);
 }
 
 /* Called by WIMP/apps to consume one event.  Returns 0 if queue empty. */
 int mouse_poll(mouse_event_t *ev)
 {
-    if (mouse_tail == mouse_head)
-        return 0;
-    *ev = mouse_queue[mouse_tail];
-    mouse_tail = (mouse_tail + 1) & (MOUSE_QUEUE_SIZE - 1);
-    return 1;
+    unsigned long flags;
+    int got = 0;
+    spin_lock_irqsave(&mouse_lock, &flags);
+    if (mouse_tail != mouse_head) {
+        *ev = mouse_queue[mouse_tail];
+        mouse_tail = (mouse_tail + 1) & (MOUSE_QUEUE_SIZE - 1);
+        got = 1;
+    }
+    spin_unlock_irqrestore(&mouse_lock, flags);
+    return got;
 }
 
 /* ── Absolute pointer position query (boot179) ───────────────────────────── */
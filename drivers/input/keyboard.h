@@ -28,9 +28,10 @@
 #define MOD_ALT     0x04
 
 typedef struct {
-    uint8_t key_code;
-    uint8_t key_char;
-    uint8_t modifiers;
+    uint8_t  key_code;
+    uint8_t  key_char;
+    uint8_t  modifiers;
+    uint32_t time_ms;     /* boot417: when the report arrived (ms counter) */
 } keyboard_event_t;
 
 int  keyboard_init(void);
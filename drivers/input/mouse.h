@@ -18,6 +18,7 @@ typedef struct {
     int16_t dx, dy;
     uint8_t buttons;
     int8_t  wheel;
+    uint32_t time_ms;     /* boot417: when the report arrived (ms counter) */
 } mouse_event_t;
 
 int  mouse_init(void);
@@ -3,6 +3,7 @@
  * Raspberry Pi BCM2711/BCM2712 SD Host Controller
  * Based on R Andrews MMC driver, adapted for Phoenix bare-metal
  * Follows RISC OS principles: simple, direct hardware access
+ * Updated: boot409 – Oct 2026 – native blockdev_submit: host queue + MMCio task
  */
 
 #include "kernel.h"
@@ -374,12 +375,54 @@ static ssize_t mmc_bd_write(blockdev_t *dev, uint64_t lba,
            ? (ssize_t)(count * 512) : -1;
 }
 
+/* ── Asynchronous requests (boot409) ─────────────────────────────────────────
+ * One SDHCI host, one queue: the MMCio task runs the PIO transfers so a
+ * submitter only sleeps if it chooses to wait.  Before the scheduler runs
+ * submit declines and the block layer performs the request inline.      */
+static blockdev_reqq_t mmc_ioq;
+static task_t         *mmc_io_task = NULL;
+
+static void mmc_io_worker(void)
+{
+    asm volatile("msr daifclr, #2" ::: "memory");   /* tasks start masked */
+
+    for (;;) {
+        blockdev_req_t *req = blockdev_reqq_pop(&mmc_ioq);
+        if (!req) {
+            current_task->state = TASK_BLOCKED;
+            if (__atomic_load_n(&mmc_ioq.head, __ATOMIC_ACQUIRE))
+                current_task->state = TASK_RUNNING;
+            else
+                schedule();
+            continue;
+        }
+        int rc = (req->op == BLOCKDEV_WRITE)
+               ? mmc_write_blocks((uint32_t)req->lba, req->count, req->buf)
+               : mmc_read_blocks ((uint32_t)req->lba, req->count, req->buf);
+        blockdev_complete(req, rc == 0 ? (ssize_t)req->count : -1);
+    }
+}
+
+static int mmc_bd_submit(blockdev_t *dev, blockdev_req_t *req)
+{
+    (void)dev;
+    if (!current_task) return -1;                   /* no scheduler yet */
+    if (!mmc_io_task)
+        mmc_io_task = task_create("MMCio", mmc_io_worker, BLOCKDEV_IO_PRIORITY, 0);
+    if (!mmc_io_task) return -1;
+
+    blockdev_reqq_push(&mmc_ioq, req);
+    task_wakeup(mmc_io_task);
+    return 0;
+}
+
 static blockdev_ops_t mmc_bd_ops = {
-    .read  = mmc_bd_read,
-    .write = mmc_bd_write,
-    .trim  = NULL,
-    .poll  = NULL,
-    .close = NULL,
+    .read   = mmc_bd_read,
+    .write  = mmc_bd_write,
+    .trim   = NULL,
+    .poll   = NULL,
+    .close  = NULL,
+    .submit = mmc_bd_submit,
 };
 
 /* Initialize SD card */
@@ -3,12 +3,16 @@
  * Defines Information Units (IUs) for UASP command queuing and streams
  * Supports USB 3.0+ multi-stream transfers
  * Author: R Andrews – 04 Feb 2026
+ * Updated: boot412 – Oct 2026 – IU layouts per UAS r04 §6.2; pipe IDs;
+ *          uas_probe() for the UAS class driver (usb_uas.c)
+ * Updated: boot413 – Oct 2026 – msc_set_limits() (Block Limits VPD)
  */
 
 #ifndef UASP_H
 #define UASP_H
 
 #include <stdint.h>
+#include "usb.h"
 
 #define UAS_IU_COMMAND      0x01
 #define UAS_IU_SENSE        0x03
@@ -17,35 +21,62 @@
 #define UAS_IU_READ_READY   0x06
 #define UAS_IU_WRITE_READY  0x07
 
+/* Pipe Usage descriptor bPipeID (UAS §5.3.3.1) — usb_endpoint_t.pipe_id */
+#define UAS_PIPE_COMMAND    1
+#define UAS_PIPE_STATUS     2
+#define UAS_PIPE_DATA_IN    3
+#define UAS_PIPE_DATA_OUT   4
+
+#define UAS_SENSE_MAX       96      /* sense bytes kept from a Sense IU   */
+
+/* Tags are big-endian on the wire and double as the stream ID */
 #pragma pack(1)
 typedef struct {
-    uint8_t  id;           // IU ID
-    uint8_t  reserved[2];
-    uint8_t  tag;          // Stream tag
-    uint8_t  lun;
-    uint8_t  cmd_len;
-    uint8_t  task_prio;
-    uint8_t  cmd[16];      // SCSI command
+    uint8_t  id;           // UAS_IU_COMMAND
+    uint8_t  reserved;
+    uint8_t  tag[2];
+    uint8_t  prio_attr;    // priority [6:3], task attribute [2:0] (0 = SIMPLE)
+    uint8_t  reserved2;
+    uint8_t  add_cdb_len;  // additional CDB length in dwords, [7:2]
+    uint8_t  reserved3;
+    uint8_t  lun[8];
+    uint8_t  cdb[16];      // SCSI command
 } uas_cmd_iu_t;
 
 typedef struct {
-    uint8_t  id;
-    uint8_t  reserved[2];
-    uint8_t  tag;
-    uint8_t  status;
-    uint8_t  reserved2[3];
-    uint16_t sense_len;
-    uint8_t  sense_data[18];
+    uint8_t  id;           // UAS_IU_SENSE
+    uint8_t  reserved;
+    uint8_t  tag[2];
+    uint8_t  status_qual[2];
+    uint8_t  status;       // SCSI status (0 = GOOD, 2 = CHECK CONDITION)
+    uint8_t  reserved2[7];
+    uint8_t  sense_len[2];
+    uint8_t  sense_data[UAS_SENSE_MAX];
 } uas_sense_iu_t;
 
 typedef struct {
-    uint8_t  id;
-    uint8_t  reserved[2];
-    uint8_t  tag;
-    uint8_t  status;
-    uint8_t  reserved2[3];
-    uint32_t residue;
+    uint8_t  id;           // UAS_IU_RESPONSE
+    uint8_t  reserved;
+    uint8_t  tag[2];
+    uint8_t  add_info[3];
+    uint8_t  code;         // response code (0 = complete, 2 = invalid IU, ...)
 } uas_response_iu_t;
 #pragma pack()
 
+/* boot412: UAS class driver (usb_uas.c).  The mass storage probe offers it
+ * the UAS alternate setting of an interface first; -1 means it left the
+ * interface at alternate 0 with plain bulk rings, ready for BOT.        */
+int uas_probe(usb_device_t *dev, usb_interface_t *intf);
+
+/* Register a disc as the next "usbN" blockdev and classify its media from
+ * VID/PID and the INQUIRY product string (usb_mass_storage.c).          */
+struct blockdev;
+struct blockdev *msc_register_disc(usb_device_t *dev, uint64_t blocks,
+                                   uint32_t block_size, const char *product);
+
+/* boot413: set the blockdev's transfer limits from a Block Limits VPD page
+ * (vpd, 64 bytes, or NULL) and the transport's per-command cap.         */
+void msc_set_limits(struct blockdev *bd, const uint8_t *vpd,
+                    uint32_t xfer_bytes, int rw16);
+
 #endif /* UASP_H */
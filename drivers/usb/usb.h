@@ -40,6 +40,7 @@ typedef struct usb_endpoint {
     uint8_t  max_burst;          /* USB 3.0+ burst size */
     uint16_t max_streams;        /* USB 3.0+ stream support */
     uint8_t  slot_id;            /* xHCI slot owning this endpoint (set by HCD) */
+    uint8_t  pipe_id;            /* UAS Pipe Usage descriptor ID, 0 = none */
 } usb_endpoint_t;
 
 /* USB Interface */
@@ -69,6 +70,8 @@ typedef struct usb_device {
     int num_interfaces;
     void *hcd_private;           /* Host controller private data */
     void *class_private;         /* Class driver private data */
+    uint16_t enum_key;           /* boot419: USB_ENUM_KEY() topology, 0 = none */
+    uint8_t  root_port;          /* boot422: 1-based root port of its tree, 0 = unknown */
 } usb_device_t;
 
 /* USB Class Driver */
@@ -87,6 +90,13 @@ int usb_control_transfer(usb_device_t *dev, uint8_t request_type,
 int usb_bulk_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeout);
 int usb_interrupt_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeout);
 
+/* boot417: keep an interrupt IN endpoint armed; each report is handed to
+ * cb (with the time it arrived, in ms) as soon as its event is drained,
+ * possibly in interrupt context.  -1 if the HCD cannot — poll instead.  */
+typedef void (*usb_int_cb_t)(void *ctx, const uint8_t *data, int len, uint32_t t_ms);
+int  usb_interrupt_start(usb_endpoint_t *ep, size_t len, usb_int_cb_t cb, void *ctx);
+void usb_service_events(void);  /* drain completions now if no IRQ has */
+
 /* For UASP multi-stream */
 int usb_bulk_transfer_stream(usb_endpoint_t *ep, void *data, size_t len,
                              int timeout, uint16_t stream_id);
@@ -108,6 +118,34 @@ int usb_bulk_transfer_stream(usb_endpoint_t *ep, void *data, size_t len,
  */
 int usb_enumerate_device(usb_device_t *dev, int port);
 
+/*
+ * boot419: enumeration engine (usb_core.c).
+ *
+ * Root ports and hub ports enumerate concurrently, each as a state machine
+ * stepped by usb_enum_run().  A port holds a claim on its topology key —
+ * USB_ENUM_KEY(root port, hub port), both 1-based, hub port 0 for a device
+ * on the root port — from the start of enumeration until its device is
+ * handed to usb_enum_ready().  Ready devices bind in key order: none binds
+ * while a lower key is claimed or waiting, so discs get the same usbN on
+ * every boot however their resets race.  Hubs bind at once — their ports
+ * are more enumeration, not consumers.
+ *
+ * The key only has room for one hub tier.  A hub on a hub port (its own
+ * key has a hub-port nibble) gives its children key 0: unordered, bound
+ * as soon as they are ready, and claims on key 0 are ignored.
+ */
+#define USB_ENUM_KEY(root_port, hub_port) \
+    ((uint16_t)(((unsigned)(root_port) << 4) | ((unsigned)(hub_port) & 0xFu)))
+#define USB_ENUM_ON_ROOT(key)   ((key) != 0u && ((key) & 0xFu) == 0u)
+
+void     usb_enum_claim(uint16_t key);
+void     usb_enum_release(uint16_t key);
+void     usb_enum_ready(usb_device_t *dev, int port);  /* key: dev->enum_key */
+void     usb_enum_forget(usb_device_t *dev);           /* torn down unbound */
+void     usb_enum_run(void);
+uint32_t usb_enum_settle(uint32_t timeout_ms);         /* boot: returns ms   */
+uint32_t usb_time_ms(void);
+
 /*
  * usb_hc_ops_t — Host Controller Operations table.
  *
@@ -200,20 +200,41 @@ int usb_interrupt_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeo
     return g_hc_ops->interrupt_transfer(ep, data, len, timeout);
 }
 
+/*
+ * usb_interrupt_start — pre-post an interrupt IN endpoint (boot417).
+ *
+ * xHCI endpoints (slot_id > 0) go straight to xhci_interrupt_start(), as
+ * bulk transfers do; other HCDs have no callback path, so the class
+ * driver keeps polling usb_interrupt_transfer().
+ *
+ * @return 0 once reports will arrive through cb, -1 otherwise
+ */
+int usb_interrupt_start(usb_endpoint_t *ep, size_t len, usb_int_cb_t cb, void *ctx) {
+    if (ep && ep->slot_id > 0)
+        return xhci_interrupt_start(ep, len, cb, ctx);
+    return -1;
+}
+
+/*
+ * usb_service_events — deliver completions the controller has posted,
+ * without waiting.  Callbacks registered by usb_interrupt_start() run
+ * from the xHCI MSI handler; this covers the polled fallback.
+ */
+void usb_service_events(void) {
+    if (xhci_is_ready()) xhci_service_events();
+}
+
 /*
  * usb_bulk_transfer_stream — bulk transfer with stream ID (USB 3.0 UASP).
  *
  * Stream IDs allow multiple outstanding bulk transfers on the same endpoint.
- * Currently a stub — full implementation requires xHCI stream ring support.
+ * boot412: xHCI endpoints given streams by xhci_alloc_streams() run on the
+ * ring of stream_id; stream 0 and other endpoints use plain bulk.
  */
 int usb_bulk_transfer_stream(usb_endpoint_t *ep, void *data, size_t len,
                              int timeout, uint16_t stream_id) {
-    /* TODO: Pass stream_id to HCD bulk_transfer implementation.
-     * For now: fall back to regular bulk (stream_id ignored).
-     * UASP performance will be degraded but SCSI commands will work. */
-    debug_print("[USB] usb_bulk_transfer_stream: stream_id=%u (using regular bulk)\n",
-                stream_id);
-    (void)stream_id;
+    if (ep && ep->slot_id > 0 && stream_id != 0)
+        return xhci_stream_transfer(ep, data, len, timeout, stream_id);
     return usb_bulk_transfer(ep, data, len, timeout);
 }
 
@@ -278,6 +299,171 @@ int usb_enumerate_device(usb_device_t *dev, int port) {
     return 0;
 }
 
+/* ═══════════════════════════════════════════════════════════════════════════
+ * ENUMERATION ENGINE (boot419)
+ * ═══════════════════════════════════════════════════════════════════════════
+ *
+ * The HCD and hub driver run one state machine per port; usb_enum_run()
+ * steps them all and then binds at most one ready device, so a slow class
+ * probe (a disc spinning up) still lets the other ports' timers run
+ * between binds.  Claims and the ready queue are only touched from the
+ * task that runs the engine — kernel_main at boot, wimp_task afterwards.
+ */
+
+#define ENUM_MAX  16
+
+static uint16_t enum_claims[ENUM_MAX];
+static int      enum_nclaims;
+
+static struct {
+    usb_device_t *dev;
+    int           port;
+} enum_queue[ENUM_MAX];
+static int      enum_nqueued;
+static int      enum_running;
+static uint32_t enum_bound;            /* devices handed to class drivers */
+
+/* ARM system counter: CNTPCT_EL0 / CNTFRQ_EL0, in milliseconds */
+uint32_t usb_time_ms(void) {
+    uint64_t cnt, freq;
+    __asm__ volatile("mrs %0, cntpct_el0" : "=r"(cnt));
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return (uint32_t)(cnt / (freq / 1000ULL));
+}
+
+static int enum_is_hub(const usb_device_t *dev)
+{
+    if (dev->bDeviceClass == 0x09) return 1;
+    for (int i = 0; i < dev->num_interfaces; i++)
+        if (dev->interfaces[i].bInterfaceClass == 0x09) return 1;
+    return 0;
+}
+
+static void enum_bind(usb_device_t *dev, int port)
+{
+    usb_enumerate_device(dev, port);
+    enum_bound++;
+}
+
+void usb_enum_claim(uint16_t key)
+{
+    if (key == 0u) return;              /* unordered: nothing to wait for */
+    if (enum_nclaims >= ENUM_MAX) {
+        /* Only ordering is lost: the device still binds when ready */
+        uart_puts("[USB] enum: claim table full\n");
+        return;
+    }
+    enum_claims[enum_nclaims++] = key;
+}
+
+void usb_enum_release(uint16_t key)
+{
+    if (key == 0u) return;
+    for (int i = 0; i < enum_nclaims; i++) {
+        if (enum_claims[i] != key) continue;
+        enum_claims[i] = enum_claims[--enum_nclaims];
+        return;
+    }
+}
+
+/*
+ * usb_enum_ready — an HCD has finished enumerating @dev.
+ *
+ * Hubs and unordered devices (enum_key 0: behind a second-tier hub) bind
+ * straight away; anything else waits in the queue for usb_enum_run() to
+ * bind it in dev->enum_key order.
+ */
+void usb_enum_ready(usb_device_t *dev, int port)
+{
+    if (enum_is_hub(dev) || dev->enum_key == 0u || enum_nqueued >= ENUM_MAX) {
+        enum_bind(dev, port);
+        return;
+    }
+    enum_queue[enum_nqueued].dev  = dev;
+    enum_queue[enum_nqueued].port = port;
+    enum_nqueued++;
+}
+
+/* A queued device was torn down before it bound */
+void usb_enum_forget(usb_device_t *dev)
+{
+    for (int i = 0; i < enum_nqueued; i++) {
+        if (enum_queue[i].dev != dev) continue;
+        enum_queue[i] = enum_queue[--enum_nqueued];
+        return;
+    }
+}
+
+/* Bind the lowest-keyed ready device unless a lower key is still being
+ * enumerated (force: boot timeout — bind regardless).  1 if one bound. */
+static int enum_bind_next(int force)
+{
+    int best = -1;
+    for (int i = 0; i < enum_nqueued; i++)
+        if (best < 0 || enum_queue[i].dev->enum_key < enum_queue[best].dev->enum_key)
+            best = i;
+    if (best < 0) return 0;
+
+    uint16_t key = enum_queue[best].dev->enum_key;
+    if (!force)
+        for (int i = 0; i < enum_nclaims; i++)
+            if (enum_claims[i] < key) return 0;
+
+    usb_device_t *dev  = enum_queue[best].dev;
+    int           port = enum_queue[best].port;
+    enum_queue[best] = enum_queue[--enum_nqueued];
+    enum_bind(dev, port);
+    return 1;
+}
+
+/*
+ * usb_enum_run — step every port state machine, then bind one device.
+ *
+ * Called in a loop by usb_enum_settle() at boot and from the wimp_task
+ * loop afterwards.  Not re-entrant: a class probe that waits on USB
+ * must not find itself stepping the engine.
+ */
+void usb_enum_run(void)
+{
+    extern void xhci_enum_step(void) __attribute__((weak));
+    extern void hub_enum_step(void)  __attribute__((weak));
+
+    if (enum_running) return;
+    enum_running = 1;
+    if (xhci_enum_step) xhci_enum_step();
+    if (hub_enum_step)  hub_enum_step();
+    enum_bind_next(0);
+    enum_running = 0;
+}
+
+/*
+ * usb_enum_settle — run the engine until every port has finished
+ * enumerating and every device is bound, or @timeout_ms passes (then
+ * whatever is ready binds anyway, in key order).  Boot only.
+ *
+ * @return milliseconds taken
+ */
+uint32_t usb_enum_settle(uint32_t timeout_ms)
+{
+    uint32_t t0 = usb_time_ms();
+
+    while (enum_nclaims > 0 || enum_nqueued > 0) {
+        if ((usb_time_ms() - t0) >= timeout_ms) {
+            uart_puts("[USB] enum: settle timeout — binding what is ready\n");
+            enum_running = 1;
+            while (enum_bind_next(1)) { }
+            enum_running = 0;
+            break;
+        }
+        usb_enum_run();
+    }
+
+    uint32_t ms = usb_time_ms() - t0;
+    debug_print("[USB] Enumeration settled: %u device(s) bound in %u ms\n",
+                (unsigned)enum_bound, (unsigned)ms);
+    return ms;
+}
+
 /* ═══════════════════════════════════════════════════════════════════════════
  * SUBSYSTEM INIT
  * ═══════════════════════════════════════════════════════════════════════════ */
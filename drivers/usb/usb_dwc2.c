@@ -1002,7 +1002,6 @@ static void dwc2_enum_hub(int hub_mps, int hub_speed)
 /* Forward declarations for the input layer (defined in input_stub.c) */
 extern void mouse_event(const void *ev);
 extern void keyboard_event(const void *ev);
-extern void con_putc(char c);
 
 /* Process a mouse boot-protocol report: [buttons, dx, dy, wheel?] */
 static void dwc2_proc_mouse(dwc2_hid_t *h, const uint8_t *data, int len)
@@ -1017,10 +1016,11 @@ static void dwc2_proc_mouse(dwc2_hid_t *h, const uint8_t *data, int len)
     /* Only post if something changed */
     if (!dx && !dy && !wh && btn == h->last_report[0]) return;
 
-    /* Inline mouse_event_t (mirrors drivers/input/mouse.h) */
-    struct { int16_t x, y, dx, dy; uint8_t buttons; int8_t wheel; } ev;
+    /* Inline mouse_event_t (mirrors drivers/input/mouse.h; boot417 time_ms) */
+    struct { int16_t x, y, dx, dy; uint8_t buttons; int8_t wheel; uint32_t time_ms; } ev;
     __builtin_memset(&ev, 0, sizeof(ev));
     ev.dx = dx; ev.dy = dy; ev.wheel = wh;
+    ev.time_ms = dwc2_ms();
     if (btn & 0x01) ev.buttons |= 0x04;  /* left   → SELECT */
     if (btn & 0x04) ev.buttons |= 0x02;  /* middle → MENU   */
     if (btn & 0x02) ev.buttons |= 0x01;  /* right  → ADJUST */
@@ -1055,9 +1055,10 @@ static void dwc2_proc_keyboard(dwc2_hid_t *h, const uint8_t *data, int len)
     if (len < 3) return;
     int shift = (data[0] & 0x22) != 0;  /* any Shift key held */
 
-    /* Inline keyboard_event_t (mirrors drivers/input/keyboard.h) */
-    struct { uint8_t key_code, key_char, modifiers, pad; } kev;
+    /* Inline keyboard_event_t (mirrors drivers/input/keyboard.h; boot417 time_ms) */
+    struct { uint8_t key_code, key_char, modifiers, pad; uint32_t time_ms; } kev;
     __builtin_memset(&kev, 0, sizeof(kev));
+    kev.time_ms = dwc2_ms();
     if (data[0] & 0x22) kev.modifiers |= 0x01;  /* MOD_SHIFT */
     if (data[0] & 0x11) kev.modifiers |= 0x02;  /* MOD_CTRL  */
     if (data[0] & 0x44) kev.modifiers |= 0x04;  /* MOD_ALT   */
@@ -1089,8 +1090,7 @@ static void dwc2_proc_keyboard(dwc2_hid_t *h, const uint8_t *data, int len)
                         code,
                         (ch >= 0x20 && ch < 0x7F) ? ch : '.',
                         kev.modifiers);
-            keyboard_event(&kev);
-            if (ch >= 0x20) con_putc(ch);
+            keyboard_event(&kev);    /* boot417: wimp_task echoes it */
         }
     }
 
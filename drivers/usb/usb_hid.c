@@ -5,10 +5,13 @@
  * Reports are decoded into RISC OS keyboard_event_t / mouse_event_t and
  * posted to the input layer via keyboard_event() / mouse_event().
  *
- * Architecture: polled.  hid_poll_all() must be called from the main
- * kernel loop (or a periodic timer task).  When xHCI interrupt delivery
- * is fully working the poll cadence can be replaced with a callback, but
- * the report-decoding and event-posting logic here does not change.
+ * Architecture: event-driven on xHCI since boot417.  The probe pre-posts
+ * the interrupt IN endpoint (usb_interrupt_start) and hid_int_report()
+ * decodes each report as its completion is drained — in the MSI handler
+ * when MSIs arrive — posting timestamped events to the input queues.
+ * hid_poll_all() / hid_poll_mice() then only drain the event ring for the
+ * polled fallback and never wait.  Endpoints that cannot be pre-posted
+ * keep the old polled path (usb_interrupt_transfer with a timeout).
  *
  * R Andrews / prototype merged boot 70 — March 2026
  */
@@ -55,6 +58,7 @@ typedef struct {
     uint8_t          report_id_detected; /* boot281: 1 once format has been auto-detected */
     uint32_t         last_get_report_ms; /* boot261: rate-limit GET_REPORT to 60 Hz */
     uint32_t         mouse_last_ok_ms;   /* boot286: timestamp of last successful mouse data */
+    uint8_t          prepost;            /* boot417: reports arrive via hid_int_report */
 } hid_device_t;
 
 #define HID_MAX_DEVICES 4
@@ -139,7 +143,7 @@ static uint8_t usb_mod_to_riscos(uint8_t usb_mod) {
 
 /* ── Keyboard report processor ────────────────────────────────────────────── */
 
-static void hid_process_keyboard(hid_device_t *hid, const uint8_t *data)
+static void hid_process_keyboard(hid_device_t *hid, const uint8_t *data, uint32_t t_ms)
 {
     hid_keyboard_report_t *report = (hid_keyboard_report_t *)data;
     uint8_t ro_mod = usb_mod_to_riscos(report->modifiers);
@@ -159,6 +163,7 @@ static void hid_process_keyboard(hid_device_t *hid, const uint8_t *data)
         /* Build RISC OS keyboard event */
         keyboard_event_t ev = { 0 };
         ev.modifiers = ro_mod;
+        ev.time_ms   = t_ms;
 
         /* F-keys and cursor keys: use INKEY path */
         if (scancode_to_inkey[code]) {
@@ -175,17 +180,11 @@ static void hid_process_keyboard(hid_device_t *hid, const uint8_t *data)
         }
 
         if (ev.key_code || ev.key_char) {
-            debug_print("[KBD] code=0x%02x inkey=0x%02x char=0x%02x mod=0x%02x\n",
-                        code, ev.key_code, ev.key_char, ev.modifiers);
-
-            /* Post to RISC OS input layer */
+            /* Post to RISC OS input layer.  boot417: the console echo of
+             * printable characters moved to the consumer (wimp_task) —
+             * this may run in the MSI handler, so, as for the mouse, no
+             * per-key log line either.                                  */
             keyboard_event(&ev);
-
-            /* Also echo printable characters directly to the console framebuffer */
-            if (ev.key_char >= 0x20) {
-                extern void con_putc(char c);
-                con_putc((char)ev.key_char);
-            }
         }
     }
 
@@ -196,7 +195,7 @@ static void hid_process_keyboard(hid_device_t *hid, const uint8_t *data)
 
 /* ── Mouse report processor ───────────────────────────────────────────────── */
 
-static void hid_process_mouse(hid_device_t *hid, const uint8_t *data)
+static void hid_process_mouse(hid_device_t *hid, const uint8_t *data, uint32_t t_ms)
 {
     /* boot284: auto-detect report ID prefix — run once on first received report.
      *
@@ -224,6 +223,7 @@ static void hid_process_mouse(hid_device_t *hid, const uint8_t *data)
     hid_mouse_report_t *report = (hid_mouse_report_t *)data;
 
     mouse_event_t ev = { 0 };
+    ev.time_ms = t_ms;
     ev.dx = report->x;
     ev.dy = -report->y;  /* USB Y increases downward; RISC OS Y increases upward */
     ev.wheel = report->wheel;
@@ -233,10 +233,29 @@ static void hid_process_mouse(hid_device_t *hid, const uint8_t *data)
     if (report->buttons & 0x04) ev.buttons |= BUTTON_MENU;    /* middle */
     if (report->buttons & 0x02) ev.buttons |= BUTTON_ADJUST;  /* right  */
 
-    if (ev.dx || ev.dy || ev.buttons || ev.wheel) {
-        debug_print("[MOUSE] dx=%d dy=%d btn=0x%02x wheel=%d\n",
-                    ev.dx, ev.dy, ev.buttons, ev.wheel);
+    /* boot417: no per-report log line — at the mouse's report rate it
+     * would hold the UART, and now the MSI handler, for milliseconds.   */
+    if (ev.dx || ev.dy || ev.buttons || ev.wheel)
         mouse_event(&ev);
+}
+
+/* ── Pre-posted report callback (boot417) ─────────────────────────────────
+ * Runs from the xHCI event drain with interrupts masked: decode and
+ * queue only.  A short report is padded to the 8-byte boot layout.      */
+static void hid_int_report(void *ctx, const uint8_t *data, int len, uint32_t t_ms)
+{
+    hid_device_t *hid = (hid_device_t *)ctx;
+    uint8_t report[8] = { 0 };
+
+    if (len <= 0) return;                       /* NAK'd interval, nothing new */
+    for (int i = 0; i < len && i < 8; i++) report[i] = data[i];
+
+    if (hid->protocol == USB_PROTOCOL_KEYBOARD) {
+        hid_process_keyboard(hid, report, t_ms);
+    } else if (hid->protocol == USB_PROTOCOL_MOUSE) {
+        hid->mouse_last_ok_ms = t_ms;
+        if (len < 3) hid->report_id_detected = 0;   /* boot300 guard */
+        else         hid_process_mouse(hid, report, t_ms);
     }
 }
 
@@ -247,6 +266,8 @@ static void hid_poll(hid_device_t *hid)
     uint8_t report[8] = { 0 };
     int len = -1;
 
+    if (hid->prepost) return;       /* boot417: hid_int_report has it */
+
     /* boot278 polling strategy — interrupt IN for BOTH devices.
      *
      * KEYBOARD — interrupt IN, 8ms timeout.
@@ -307,7 +328,7 @@ static void hid_poll(hid_device_t *hid)
 
     if (len > 0) {
         if (hid->protocol == USB_PROTOCOL_KEYBOARD)
-            hid_process_keyboard(hid, report);
+            hid_process_keyboard(hid, report, hid_time_ms());
         else if (hid->protocol == USB_PROTOCOL_MOUSE) {
             /* boot300: guard against sub-minimum transfers (e.g. the spurious
              * single byte 0x08 delivered by xHCI int_steal / cc=13 Stopped
@@ -317,7 +338,7 @@ static void hid_poll(hid_device_t *hid)
             if (len < 3) {
                 hid->report_id_detected = 0;
             } else {
-                hid_process_mouse(hid, report);
+                hid_process_mouse(hid, report, hid_time_ms());
             }
         }
     }
@@ -402,6 +423,12 @@ static int hid_probe(usb_device_t *dev, usb_interface_t *intf)
     if (hid_device_count < HID_MAX_DEVICES)
         hid_devices[hid_device_count++] = hid;
 
+    /* boot417: keep the interrupt IN endpoint permanently armed */
+    if (hid->int_in && usb_interrupt_start(hid->int_in, 8, hid_int_report, hid) == 0) {
+        hid->prepost = 1;
+        debug_print("[HID] interrupt IN pre-posted — event-driven reports\n");
+    }
+
     if (hid->protocol == USB_PROTOCOL_KEYBOARD)
         debug_print("[HID] USB Keyboard ready (boot protocol)\n");
     else if (hid->protocol == USB_PROTOCOL_MOUSE)
@@ -433,11 +460,14 @@ int hid_init(void)
  * boot285: mice are now polled by hid_poll_mice() at 4 ms non-blocking so
  * that the interrupt TRB is always freshly armed; only keyboards are handled
  * here with the existing 8 ms blocking wait.
+ * boot417: pre-posted keyboards only need the event drain — the 8 ms wait
+ * remains for endpoints that could not be pre-posted.
  * Returns the number of devices polled.
  */
 int hid_poll_all(void)
 {
     int total = 0;
+    usb_service_events();
     for (int i = 0; i < hid_device_count; i++) {
         hid_device_t *hid = hid_devices[i];
         if (!hid) continue;
@@ -460,15 +490,19 @@ int hid_poll_all(void)
  * interval, yielding deltas of ~15–30 counts instead of the 127-clamped
  * values we saw at 16 ms.  The TRB is re-armed on the very next 4 ms poll
  * after it completes, so the endpoint is perpetually queued.
+ *
+ * boot417: pre-posted mice are served by the drain at the top; the loop
+ * below is the fallback for endpoints that could not be pre-posted.
  */
 void hid_poll_mice(void)
 {
     uint32_t now = hid_time_ms();
 
+    usb_service_events();
     for (int i = 0; i < hid_device_count; i++) {
         hid_device_t *hid = hid_devices[i];
         if (!hid || hid->protocol != USB_PROTOCOL_MOUSE) continue;
-        if (!hid->int_in) continue;
+        if (!hid->int_in || hid->prepost) continue;
 
         uint8_t report[8] = { 0 };
         int len;
@@ -488,7 +522,7 @@ void hid_poll_mice(void)
 
         if (len > 0) {
             hid->mouse_last_ok_ms = now;
-            hid_process_mouse(hid, report);
+            hid_process_mouse(hid, report, now);
         }
     }
 }
@@ -499,7 +533,8 @@ void hid_poll_mice(void)
  *
  * Called from xhci_disconnect_slot() (usb_xhci.c) after the slot has been
  * stopped and disabled by the xHCI layer.  At this point the device DMA
- * buffers are invalid and the interrupt endpoint is no longer armed, so we
+ * buffers are invalid and the interrupt endpoint is no longer armed (its
+ * boot417 report callback already unregistered), so we
  * must remove the hid_device_t entries from the poll lists before the next
  * hid_poll_all() / hid_poll_mice() call.
  *
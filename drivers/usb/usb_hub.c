@@ -26,10 +26,25 @@
  * pointer so the hub-child registry (usb_xhci.c) can find the correct slot.
  * SS speed detection updated: USB3 hub uses wPortStatus bits [12:10] for
  * port speed; USB2 hub uses bit9/bit10.
+ *
+ * boot418: Status-change endpoint — hub_probe() arms the hub's interrupt IN
+ * endpoint with usb_interrupt_start(); its callback ORs the change bitmap
+ * (bit 0 = hub, bit n = port n) into hub_state_t.change.  hub_poll_hotplug()
+ * now sends GET_PORT_STATUS only for flagged ports, so an idle hub sees no
+ * control traffic at all.  A hub whose endpoint could not be armed falls
+ * back to the boot178 full scan, still every 500 ms.
+ *
+ * boot419: Concurrent enumeration — hub_probe() powers the ports and
+ * returns; power-good, each port's debounce, reset and settle are timers
+ * stepped by hub_enum_step() from usb_enum_run(), so a hub's ports no
+ * longer hold up the rest of the bus.  One port per hub is reset at a time
+ * (address 0).  Each port claims its USB_ENUM_KEY so class drivers bind
+ * in port order.  Hotplug connects go through the same machine.
  */
 
 #include "usb.h"
 #include "usb_xhci.h"
+#include <string.h>
 
 /* uart_puts is non-static — exported from uart.c */
 extern void uart_puts(const char *s);
@@ -72,6 +87,19 @@ static inline uint32_t hub_ms(void) {
 #define C_PORT_CONNECTION 16
 #define C_PORT_RESET      20
 
+/* Change bit → ClearFeature selector, wPortChange bits 1–7 (boot418):
+ * USB2 C_PORT_ENABLE/SUSPEND/OVER_CURRENT/RESET, USB3 C_BH_PORT_RESET,
+ * C_PORT_LINK_STATE, C_PORT_CONFIG_ERROR.  0 = no such bit.           */
+static const uint8_t hub_c_feat[2][8] = {
+    { 0, 17, 18, 19, 20,  0,  0,  0 },     /* USB2 hub */
+    { 0,  0,  0, 19, 20, 29, 25, 26 },     /* USB3 hub */
+};
+
+/* Hub-level change features (class, device recipient) */
+#define HUB_CLASS_OUT_TYPE  0x20
+#define C_HUB_LOCAL_POWER   0
+#define C_HUB_OVER_CURRENT  1
+
 /* Hub Descriptor types */
 #define USB_DT_HUB      0x29
 #define USB_DT_SS_HUB   0x2A
@@ -103,23 +131,48 @@ static inline uint32_t hub_ms(void) {
 #define XHCI_SPEED_HS  3
 #define XHCI_SPEED_SS  4
 
-/* Helpers */
-static void hub_delay_ms(uint32_t ms) {
-    uint32_t end = hub_ms() + ms;
-    while (hub_ms() < end) { asm volatile("nop"); }
-}
-
 /* ── Persistent hub state (for hotplug polling) ──────────────────────────── */
-#define MAX_HUBS  4
+#define MAX_HUBS        4
+#define HUB_PORTS_MAX   15
+
+/* boot419: per-port enumeration state */
+#define HP_IDLE         0
+#define HP_DEBOUNCE     1       /* connected; waiting HUB_DEBOUNCE_MS        */
+#define HP_RESET        2       /* PORT_RESET sent; polling C_PORT_RESET     */
+#define HP_SETTLE       3       /* reset done; brief settle, then enumerate  */
+
+#define HUB_DEBOUNCE_MS 100     /* USB 2.0 §7.1.7.3 tATTDB                   */
+#define HUB_RESET_MS    500
+
+typedef struct {
+    uint8_t  state;             /* HP_*                                      */
+    uint8_t  speed;             /* xHCI speed code, once reset               */
+    uint32_t deadline;          /* hub_ms() when this state ends             */
+    uint32_t next_poll;         /* HP_RESET: next GET_STATUS                 */
+} hub_port_t;
 
 typedef struct {
     usb_device_t *dev;          /* NULL = free slot                         */
     uint8_t       num_ports;    /* number of downstream ports               */
     uint8_t       is_ss;        /* 1 = USB3 SuperSpeed hub, 0 = USB2        */
+    uint8_t       armed;        /* boot418: status-change endpoint running  */
+    volatile uint32_t change;   /* boot418: bit 0 = hub, bit n = port n     */
+    uint32_t      last_scan;    /* boot418: last full scan (unarmed hubs)   */
+    uint16_t      key;          /* boot419: USB_ENUM_KEY(root port, 0), or
+                                 * 0 below tier 1 — ports bind unordered    */
+    uint8_t       powering;     /* boot419: waiting for power-good          */
+    uint32_t      pwr_deadline; /* boot419: hub_ms() at power-good          */
+    hub_port_t    port[HUB_PORTS_MAX + 1];  /* boot419: [1..num_ports]      */
 } hub_state_t;
 
 static hub_state_t g_hubs[MAX_HUBS];
 
+/* boot422: address-0 token per root-port tree — the hub port holding it
+ * is between PORT_RESET and the end of Address Device.  Index 0 covers
+ * hubs whose root port is unknown.                                     */
+#define HUB_ROOT_PORTS  16
+static hub_port_t *g_addr0[HUB_ROOT_PORTS + 1];
+
 /* ── Hub Descriptor ─────────────────────────────────────────────────────── */
 typedef struct {
     uint8_t  bLength;
@@ -185,10 +238,234 @@ static uint32_t hub_port_speed(uint16_t wPortStatus, int is_ss)
     }
 }
 
+/* ── Status-change endpoint (boot418) ──────────────────────────────────── */
+
+/* Runs from the xHCI event drain (MSI context): only record the bitmap */
+static void hub_status_cb(void *ctx, const uint8_t *data, int len, uint32_t t_ms)
+{
+    hub_state_t *hub = (hub_state_t *)ctx;
+    uint32_t bits = 0;
+    (void)t_ms;
+    for (int i = 0; i < len && i < 4; i++)
+        bits |= (uint32_t)data[i] << (8 * i);
+    if (bits) __atomic_fetch_or(&hub->change, bits, __ATOMIC_RELEASE);
+}
+
+/* Arm the hub's interrupt IN endpoint.  Root-port devices reach the class
+ * drivers without their endpoint rings, so configure them first.  */
+static int hub_arm(hub_state_t *hub, usb_interface_t *intf)
+{
+    usb_endpoint_t *ep = NULL;
+    for (int i = 0; intf && i < intf->endpoint_count; i++) {
+        usb_endpoint_t *e = &intf->endpoints[i];
+        if ((e->bmAttributes & 0x03) == 0x03 && (e->bEndpointAddress & 0x80)) {
+            ep = e; break;
+        }
+    }
+    if (!ep) return -1;
+    if (ep->slot_id == 0 && hub->dev->hcd_private)
+        xhci_configure_endpoints(hub->dev);
+
+    int len = (hub->num_ports + 1 + 7) / 8;
+    hub->change = 0;
+    if (usb_interrupt_start(ep, len, hub_status_cb, hub) != 0) return -1;
+    hub->armed = 1;
+    return 0;
+}
+
+/* Acknowledge a hub-level change so the endpoint stops reporting bit 0 */
+static void hub_clear_hub_change(usb_device_t *dev)
+{
+    uint8_t buf[4] = {0};
+    if (usb_control_transfer(dev, HUB_CLASS_IN_TYPE, USB_REQ_GET_STATUS,
+                             0, 0, buf, 4, 200) < 4) return;
+    uint16_t wHubChange = (uint16_t)(buf[2] | (buf[3] << 8));
+    if (wHubChange & 1U)
+        usb_control_transfer(dev, HUB_CLASS_OUT_TYPE, USB_REQ_CLEAR_FEATURE,
+                             C_HUB_LOCAL_POWER, 0, NULL, 0, 200);
+    if (wHubChange & 2U) {
+        uart_puts("[HUB] Hub over-current change\n");
+        usb_control_transfer(dev, HUB_CLASS_OUT_TYPE, USB_REQ_CLEAR_FEATURE,
+                             C_HUB_OVER_CURRENT, 0, NULL, 0, 200);
+    }
+}
+
+/* ── Port state machine (boot419) ──────────────────────────────────────── */
+
+static uint16_t hub_port_key(const hub_state_t *hub, uint8_t p)
+{
+    return hub->key ? (uint16_t)(hub->key | (p & 0xFu)) : 0u;
+}
+
+/* Start (or restart) a port's debounce; the port claims its key */
+static void hp_start(hub_state_t *hub, uint8_t p)
+{
+    hub_port_t *hp = &hub->port[p];
+    if (hp->state == HP_IDLE) usb_enum_claim(hub_port_key(hub, p));
+    hp->state    = HP_DEBOUNCE;
+    hp->deadline = hub_ms() + HUB_DEBOUNCE_MS;
+}
+
+static hub_port_t **hub_addr0(const hub_state_t *hub)
+{
+    uint8_t rp = hub->dev->root_port;
+    return &g_addr0[rp <= HUB_ROOT_PORTS ? rp : 0];
+}
+
+static void hp_finish(hub_state_t *hub, uint8_t p)
+{
+    hub_port_t **tok = hub_addr0(hub);
+    if (*tok == &hub->port[p]) *tok = NULL;
+    if (hub->port[p].state == HP_IDLE) return;
+    hub->port[p].state = HP_IDLE;
+    usb_enum_release(hub_port_key(hub, p));
+}
+
+/* Power-good has passed: look at every port once and start the connected
+ * ones.  Their connection changes are cleared, so the status-change
+ * endpoint does not report them again.                                 */
+static void hub_scan_ports(hub_state_t *hub)
+{
+    for (uint8_t p = 1; p <= hub->num_ports; p++) {
+        port_status_t ps;
+        if (hub_get_port_status(hub->dev, p, &ps) != 0) {
+            uart_puts("[HUB]   Port "); hub_print_hex(p);
+            uart_puts(": GET_STATUS failed\n");
+            continue;
+        }
+        uart_puts("[HUB]   Port "); hub_print_hex(p);
+        uart_puts(": status="); hub_print_hex(ps.wPortStatus);
+        uart_puts(" change="); hub_print_hex(ps.wPortChange); uart_puts("\n");
+
+        if (!(ps.wPortStatus & PS_CONNECTION)) {
+            uart_puts("[HUB]   Port "); hub_print_hex(p);
+            uart_puts(": not connected\n");
+            continue;
+        }
+
+        /* Clear C_PORT_CONNECTION if set */
+        if (ps.wPortChange & PC_C_CONNECTION)
+            hub_clear_port_feature(hub->dev, p, C_PORT_CONNECTION);
+        hp_start(hub, p);
+    }
+}
+
+/*
+ * hub_port_step — advance one port: debounce → reset → settle → enumerate.
+ *
+ * Only one port per root-port tree is reset and addressed at a time:
+ * until Address Device a freshly reset device answers at address 0, and
+ * two of them anywhere below the same root port — behind one hub or two
+ * chained ones — would both answer.  The port takes its tree's g_addr0
+ * token at PORT_RESET and drops it in hp_finish, after
+ * xhci_enumerate_hub_port returns.  Debounce timers still overlap.
+ */
+static void hub_port_step(hub_state_t *hub, int hi, uint8_t p)
+{
+    hub_port_t   *hp  = &hub->port[p];
+    uint32_t      now = hub_ms();
+    int           due = (int32_t)(now - hp->deadline) >= 0;
+    port_status_t ps  = { 0, 0 };   /* a failed GET_STATUS reads as no change */
+
+    switch (hp->state) {
+    case HP_DEBOUNCE:
+        if (!due || *hub_addr0(hub)) return;
+        if (hub_get_port_status(hub->dev, p, &ps) != 0 ||
+            !(ps.wPortStatus & PS_CONNECTION)) {
+            uart_puts("[HUB]   Port "); hub_print_hex(p);
+            uart_puts(": gone before reset\n");
+            hp_finish(hub, p);
+            return;
+        }
+
+        /* boot287/boot289: Defensive pre-teardown.
+         * If this port already has an active slot (missed disconnect,
+         * spurious C_PORT_CONNECTION, or device briefly bounced its
+         * VBUS), retire the old slot before re-enumerating.
+         * xhci_disconnect_hub_child() returns -1 silently if no slot
+         * was active, so this is safe to call unconditionally.           */
+        xhci_disconnect_hub_child(hub->dev, p);
+
+        hub_set_port_feature(hub->dev, p, PORT_RESET);
+        *hub_addr0(hub) = hp;
+        hp->state      = HP_RESET;
+        hp->deadline   = now + HUB_RESET_MS;
+        hp->next_poll  = now + 10u;
+        return;
+
+    case HP_RESET:
+        /* Poll for C_PORT_RESET every 10 ms, up to HUB_RESET_MS */
+        if ((int32_t)(now - hp->next_poll) < 0) return;
+        hp->next_poll = now + 10u;
+        if (hub_get_port_status(hub->dev, p, &ps) == 0 &&
+            !(ps.wPortChange & PC_C_RESET) && !due)
+            return;
+        if (!(ps.wPortChange & PC_C_RESET)) {
+            uart_puts("[HUB]   Port "); hub_print_hex(p);
+            uart_puts(": reset timeout\n");
+            hp_finish(hub, p);
+            return;
+        }
+        hub_clear_port_feature(hub->dev, p, C_PORT_RESET);
+
+        /* Re-read status after reset */
+        if (hub_get_port_status(hub->dev, p, &ps) != 0) { hp_finish(hub, p); return; }
+        if (!(ps.wPortStatus & PS_ENABLE)) {
+            uart_puts("[HUB]   Port "); hub_print_hex(p);
+            uart_puts(": not enabled after reset\n");
+            hp_finish(hub, p);
+            return;
+        }
+
+        /* ── Determine device speed ──────────────────────────────────── */
+        hp->speed = (uint8_t)hub_port_speed(ps.wPortStatus, hub->is_ss);
+        uart_puts("[HUB]   Port "); hub_print_hex(p);
+        uart_puts(": device connected, speed="); hub_print_hex(hp->speed);
+        uart_puts("\n");
+
+        hp->state    = HP_SETTLE;
+        hp->deadline = now + 10u;     /* brief settle after reset */
+        return;
+
+    case HP_SETTLE:
+        if (!due) return;
+        uart_puts("[HUB] Enumerating hub "); hub_print_hex((uint32_t)hi);
+        uart_puts(" port "); hub_print_hex(p); uart_puts("\n");
+
+        /* ── Enumerate via xHCI ──────────────────────────────────────── */
+        if (xhci_enumerate_hub_port(hub->dev, p, hp->speed) != 0) {
+            uart_puts("[HUB]   Port "); hub_print_hex(p);
+            uart_puts(": enumerate failed\n");
+        }
+        hp_finish(hub, p);
+        return;
+    }
+}
+
+/*
+ * hub_enum_step — advance every hub's power-up and port state machines.
+ * Called from usb_enum_run() (boot419).
+ */
+void hub_enum_step(void)
+{
+    for (int hi = 0; hi < MAX_HUBS; hi++) {
+        hub_state_t *hub = &g_hubs[hi];
+        if (!hub->dev) continue;
+
+        if (hub->powering) {
+            if ((int32_t)(hub_ms() - hub->pwr_deadline) < 0) continue;
+            hub->powering = 0;
+            hub_scan_ports(hub);
+            usb_enum_release(hub->key);     /* ports hold their own now */
+        }
+        for (uint8_t p = 1; p <= hub->num_ports && hub->dev; p++)
+            if (hub->port[p].state != HP_IDLE) hub_port_step(hub, hi, p);
+    }
+}
+
 /* ── probe ──────────────────────────────────────────────────────────────── */
 
 static int hub_probe(usb_device_t *dev, usb_interface_t *intf) {
-    (void)intf;
     uart_puts("[HUB] hub_probe: VID="); hub_print_hex(dev->idVendor);
     uart_puts(" PID="); hub_print_hex(dev->idProduct); uart_puts("\n");
 
@@ -231,81 +508,35 @@ static int hub_probe(usb_device_t *dev, usb_interface_t *intf) {
     uart_puts(" pwrgood_ms="); hub_print_hex(pwrgood_ms);
     uart_puts(" is_ss="); hub_print_hex(is_ss); uart_puts("\n");
 
-    if (num_ports == 0 || num_ports > 15) num_ports = 4;
+    if (num_ports == 0 || num_ports > HUB_PORTS_MAX) num_ports = 4;
     if (pwrgood_ms < 100) pwrgood_ms = 100;  /* spec minimum 100ms */
 
     /* Claim the hub slot */
-    g_hubs[slot].dev       = dev;
-    g_hubs[slot].num_ports = num_ports;
-    g_hubs[slot].is_ss     = (uint8_t)is_ss;
+    hub_state_t *hub = &g_hubs[slot];
+    memset(hub, 0, sizeof(*hub));
+    hub->dev       = dev;
+    hub->num_ports = num_ports;
+    hub->is_ss     = (uint8_t)is_ss;
+    hub->key       = USB_ENUM_ON_ROOT(dev->enum_key) ? dev->enum_key : 0u;
+    hub->last_scan = hub_ms();
 
     /* ── Power on all ports ──────────────────────────────────────────── */
     for (uint8_t p = 1; p <= num_ports; p++)
         hub_set_port_feature(dev, p, PORT_POWER);
 
-    hub_delay_ms(pwrgood_ms);
-
-    /* ── Per-port reset and enumeration ─────────────────────────────── */
-    for (uint8_t p = 1; p <= num_ports; p++) {
-        port_status_t ps;
-        if (hub_get_port_status(dev, p, &ps) != 0) {
-            uart_puts("[HUB]   Port "); hub_print_hex(p);
-            uart_puts(": GET_STATUS failed\n");
-            continue;
-        }
-        uart_puts("[HUB]   Port "); hub_print_hex(p);
-        uart_puts(": status="); hub_print_hex(ps.wPortStatus);
-        uart_puts(" change="); hub_print_hex(ps.wPortChange); uart_puts("\n");
-
-        if (!(ps.wPortStatus & PS_CONNECTION)) {
-            uart_puts("[HUB]   Port "); hub_print_hex(p);
-            uart_puts(": not connected\n");
-            continue;
-        }
-
-        /* Clear C_PORT_CONNECTION if set */
-        if (ps.wPortChange & PC_C_CONNECTION)
-            hub_clear_port_feature(dev, p, C_PORT_CONNECTION);
-
-        /* ── Reset the port ─────────────────────────────────────────── */
-        hub_set_port_feature(dev, p, PORT_RESET);
+    /* boot419: power-good, each port's debounce and reset run as timers
+     * in hub_enum_step(), so the probe returns now and other ports keep
+     * enumerating.  Until power-good the hub holds a claim below all its
+     * ports' keys, so nothing behind it binds out of order meanwhile.  */
+    hub->pwr_deadline = hub_ms() + pwrgood_ms;
+    hub->powering     = 1;
+    usb_enum_claim(hub->key);
 
-        /* Wait up to 500 ms for C_PORT_RESET */
-        int reset_ok = 0;
-        for (int t = 0; t < 50; t++) {
-            hub_delay_ms(10);
-            if (hub_get_port_status(dev, p, &ps) != 0) break;
-            if (ps.wPortChange & PC_C_RESET) { reset_ok = 1; break; }
-        }
-        if (!reset_ok) {
-            uart_puts("[HUB]   Port "); hub_print_hex(p);
-            uart_puts(": reset timeout\n");
-            continue;
-        }
-        hub_clear_port_feature(dev, p, C_PORT_RESET);
-
-        /* Re-read status after reset */
-        if (hub_get_port_status(dev, p, &ps) != 0) continue;
-
-        if (!(ps.wPortStatus & PS_ENABLE)) {
-            uart_puts("[HUB]   Port "); hub_print_hex(p);
-            uart_puts(": not enabled after reset\n");
-            continue;
-        }
-
-        /* ── Determine device speed ──────────────────────────────────── */
-        uint32_t spd = hub_port_speed(ps.wPortStatus, is_ss);
-
-        uart_puts("[HUB]   Port "); hub_print_hex(p);
-        uart_puts(": device connected, speed="); hub_print_hex(spd); uart_puts("\n");
-
-        /* ── Enumerate via xHCI ──────────────────────────────────────── */
-        hub_delay_ms(10);  /* brief settle after reset */
-        if (xhci_enumerate_hub_port(dev, p, spd) != 0) {
-            uart_puts("[HUB]   Port "); hub_print_hex(p);
-            uart_puts(": enumerate failed\n");
-        }
-    }
+    /* boot418: from here on the hub tells us which ports changed */
+    if (hub_arm(hub, intf) == 0)
+        uart_puts("[HUB] status-change endpoint armed\n");
+    else
+        uart_puts("[HUB] status-change endpoint unavailable — polling ports\n");
 
     uart_puts("[HUB] hub_probe done\n");
     return 0;
@@ -314,10 +545,17 @@ static int hub_probe(usb_device_t *dev, usb_interface_t *intf) {
 static void hub_disconnect(usb_device_t *dev) {
     /* Release the hub slot so the entry can be reused */
     for (int i = 0; i < MAX_HUBS; i++) {
-        if (g_hubs[i].dev == dev) {
-            g_hubs[i].dev       = NULL;
-            g_hubs[i].num_ports = 0;
-            g_hubs[i].is_ss     = 0;
+        hub_state_t *hub = &g_hubs[i];
+        if (hub->dev == dev) {
+            /* boot419: drop claims of anything still enumerating */
+            if (hub->powering) usb_enum_release(hub->key);
+            for (uint8_t p = 1; p <= hub->num_ports; p++) hp_finish(hub, p);
+            hub->dev       = NULL;
+            hub->num_ports = 0;
+            hub->is_ss     = 0;
+            hub->armed     = 0;
+            hub->powering  = 0;
+            hub->change    = 0;
             uart_puts("[HUB] hub_disconnect: slot freed\n");
             break;
         }
@@ -325,95 +563,91 @@ static void hub_disconnect(usb_device_t *dev) {
 }
 
 /*
- * hub_poll_hotplug — check all hub ports for connect/disconnect changes.
+ * hub_port_changed — handle a change on one hub port.
  *
- * Called periodically from the wimp_task main loop (boot178).  Issues
- * GET_PORT_STATUS for each port of every registered hub and acts on
- * C_PORT_CONNECTION changes:
- *   connect   → reset the port and enumerate the new device
+ * Reads the port's status and acts on C_PORT_CONNECTION:
+ *   connect   → boot419: start the port's debounce; hub_port_step()
+ *               resets and enumerates it
  *   disconnect → full slot teardown via xhci_disconnect_hub_child()
+ * boot418: every other change bit is cleared too — the hub keeps
+ * reporting a port on its status-change endpoint until they all are.
+ */
+static void hub_port_changed(hub_state_t *hub, int hi, uint8_t p)
+{
+    port_status_t ps;
+
+    /* boot419: a port in reset belongs to hub_port_step(), which must
+     * see its C_PORT_RESET; the hub re-reports any bits left after.   */
+    if (hub->port[p].state == HP_RESET || hub->port[p].state == HP_SETTLE)
+        return;
+    if (hub_get_port_status(hub->dev, p, &ps) != 0) return;
+
+    for (int b = 1; b < 8; b++) {
+        uint8_t feat = hub_c_feat[hub->is_ss ? 1 : 0][b];
+        if ((ps.wPortChange & (1U << b)) && feat)
+            hub_clear_port_feature(hub->dev, p, feat);
+    }
+
+    /* Only act when the connection-change bit is set */
+    if (!(ps.wPortChange & PC_C_CONNECTION)) return;
+
+    /* Clear the C_PORT_CONNECTION change bit */
+    hub_clear_port_feature(hub->dev, p, C_PORT_CONNECTION);
+
+    if (ps.wPortStatus & PS_CONNECTION) {
+        uart_puts("[HUB] Hotplug: device connected on hub ");
+        hub_print_hex(hi);
+        uart_puts(" port "); hub_print_hex(p);
+        uart_puts(" — debouncing\n");
+        hp_start(hub, p);
+    } else {
+        /* ── Device disconnected ─────────────────────────────────────── */
+        uart_puts("[HUB] Hotplug: device disconnected from hub ");
+        hub_print_hex(hi); uart_puts(" port ");
+        hub_print_hex(p); uart_puts("\n");
+        hp_finish(hub, p);
+
+        /* boot287/boot289: Full slot teardown — Stop Endpoints,
+         * Disable Slot, clear hub-child registry entry. */
+        xhci_disconnect_hub_child(hub->dev, p);
+    }
+}
+
+/*
+ * hub_poll_hotplug — act on hub port connect/disconnect changes.
  *
+ * Called from the wimp_task main loop (boot178).
  * boot289: iterates g_hubs[] array to support up to MAX_HUBS concurrent hubs.
- * Rate-limited by the caller (every ~500 ms is sufficient).
+ * boot418: called every pass.  An armed hub is only asked about the ports
+ * its status-change endpoint flagged — nothing at all while idle.  An
+ * unarmed hub gets the old GET_PORT_STATUS sweep of every port, limited
+ * here to every 500 ms.
  */
 void hub_poll_hotplug(void)
 {
+    usb_service_events();           /* run any reports the MSI left queued */
+
     for (int hi = 0; hi < MAX_HUBS; hi++) {
         hub_state_t *hub = &g_hubs[hi];
         if (!hub->dev || hub->num_ports == 0) continue;
+        if (hub->powering) continue;    /* boot419: hub_enum_step() first */
+
+        uint32_t bits;
+        if (hub->armed) {
+            bits = __atomic_exchange_n(&hub->change, 0u, __ATOMIC_ACQUIRE);
+            if (!bits) continue;
+        } else {
+            uint32_t now = hub_ms();
+            if ((now - hub->last_scan) < 500u) continue;
+            hub->last_scan = now;
+            bits = ((1u << hub->num_ports) - 1u) << 1;
+        }
 
+        if (bits & 1u) hub_clear_hub_change(hub->dev);
         for (uint8_t p = 1; p <= hub->num_ports; p++) {
-            port_status_t ps;
-            if (hub_get_port_status(hub->dev, p, &ps) != 0) continue;
-
-            /* Only act when the connection-change bit is set */
-            if (!(ps.wPortChange & PC_C_CONNECTION)) continue;
-
-            /* Clear the C_PORT_CONNECTION change bit */
-            hub_clear_port_feature(hub->dev, p, C_PORT_CONNECTION);
-
-            if (ps.wPortStatus & PS_CONNECTION) {
-                /* ── New device: reset port then enumerate ───────────────── */
-                uart_puts("[HUB] Hotplug: device connected on hub ");
-                hub_print_hex(hi);
-                uart_puts(" port "); hub_print_hex(p);
-                uart_puts(" — resetting...\n");
-
-                /* boot287/boot289: Defensive pre-teardown.
-                 * If this port already has an active slot (missed disconnect,
-                 * spurious C_PORT_CONNECTION, or device briefly bounced its
-                 * VBUS), retire the old slot before re-enumerating.
-                 * xhci_disconnect_hub_child() returns -1 silently if no slot
-                 * was active, so this is safe to call unconditionally.       */
-                xhci_disconnect_hub_child(hub->dev, p);
-
-                hub_set_port_feature(hub->dev, p, PORT_RESET);
-
-                /* Wait for C_PORT_RESET (up to 500 ms) */
-                int reset_ok = 0;
-                for (int t = 0; t < 50; t++) {
-                    hub_delay_ms(10);
-                    if (hub_get_port_status(hub->dev, p, &ps) != 0) break;
-                    if (ps.wPortChange & PC_C_RESET) { reset_ok = 1; break; }
-                }
-                if (!reset_ok) {
-                    uart_puts("[HUB] Hotplug: reset timeout on hub ");
-                    hub_print_hex(hi); uart_puts(" port ");
-                    hub_print_hex(p); uart_puts("\n");
-                    continue;
-                }
-                hub_clear_port_feature(hub->dev, p, C_PORT_RESET);
-
-                if (hub_get_port_status(hub->dev, p, &ps) != 0) continue;
-                if (!(ps.wPortStatus & PS_ENABLE)) {
-                    uart_puts("[HUB] Hotplug: port not enabled after reset\n");
-                    continue;
-                }
-
-                /* Determine speed using correct encoding for hub type */
-                uint32_t spd = hub_port_speed(ps.wPortStatus, hub->is_ss);
-
-                uart_puts("[HUB] Hotplug: enumerating hub ");
-                hub_print_hex(hi); uart_puts(" port ");
-                hub_print_hex(p);
-                uart_puts(" speed="); hub_print_hex(spd); uart_puts("\n");
-
-                hub_delay_ms(10);
-                if (xhci_enumerate_hub_port(hub->dev, p, spd) != 0) {
-                    uart_puts("[HUB] Hotplug: enumerate failed on hub ");
-                    hub_print_hex(hi); uart_puts(" port ");
-                    hub_print_hex(p); uart_puts("\n");
-                }
-            } else {
-                /* ── Device disconnected ─────────────────────────────────── */
-                uart_puts("[HUB] Hotplug: device disconnected from hub ");
-                hub_print_hex(hi); uart_puts(" port ");
-                hub_print_hex(p); uart_puts("\n");
-
-                /* boot287/boot289: Full slot teardown — Stop Endpoints,
-                 * Disable Slot, clear hub-child registry entry. */
-                xhci_disconnect_hub_child(hub->dev, p);
-            }
+            if (!(bits & (1u << p))) continue;
+            hub_port_changed(hub, hi, p);
+            if (!hub->dev) break;   /* hub itself went away mid-pass */
         }
     }
 }
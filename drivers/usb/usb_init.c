@@ -15,6 +15,10 @@
  *   g_hc_ops permanently.  usb_bulk_transfer() now routes xHCI endpoints
  *   directly via ep->slot_id (usb_core.c boot165 fix) so g_hc_ops is only
  *   consulted for non-xHCI bulk (none currently exist on this hardware).
+ *
+ * boot419: xhci_scan_ports() only starts the per-port state machines;
+ *   usb_enum_settle() runs them until every device has bound, and the
+ *   USB-ready time is logged once DWC2 is up as well.
  */
 
 #include "kernel.h"
@@ -27,6 +31,8 @@ extern void uart_puts(const char *s);
 
 int usb_init(void)
 {
+    uint32_t t_start = usb_time_ms();
+
     debug_print("[USB] Initializing USB subsystem\n");
 
     /* ── Step 1: Register class drivers ────────────────────────────────────
@@ -49,8 +55,10 @@ int usb_init(void)
 
     /* ── Step 2: xHCI port scan (VL805, USB-A ports) ───────────────────────
      * xhci_init() was called by pci_init() in step 7 — hardware is ready.
-     * port_scan() was deferred until now so class drivers are available.    */
+     * port_scan() was deferred until now so class drivers are available.
+     * boot419: root ports and hub ports then enumerate concurrently.       */
     xhci_scan_ports();
+    usb_enum_settle(10000);
 
     /* ── Step 3: DWC2 OTG (USB-C port, SoC internal) ───────────────────────
      * boot165: do NOT call usb_register_hc(&g_dwc2_hc_ops) — that overwrites
@@ -66,6 +74,13 @@ int usb_init(void)
         uart_puts("[USB] DWC2 initialization failed\n");
     }
 
+    /* boot419: total USB bring-up, and when that was since power-on */
+    {
+        uint32_t t_ready = usb_time_ms();
+        debug_print("[USB] USB ready in %u ms (t=%u ms)\n",
+                    (unsigned)(t_ready - t_start), (unsigned)t_ready);
+    }
+
     /* boot335: print all registered block devices with their FileCore
      * priority scores — gives a clear picture of what the system found
      * and which device FileCore will prefer for booting.               */
@@ -3,12 +3,18 @@
  * Supports SCSI Transparent Command Set over Bulk-Only Transport (BOT)
  * Integrates with BlockDevice → FileCore
  * Author: R Andrews – 4 Feb 2026
+ * Updated: boot409 – Oct 2026 – native blockdev_submit: per-drive queue + MSCio task
+ * Updated: boot410 – Oct 2026 – zero-copy xHCI bulk; read throughput benchmark
+ * Updated: boot411 – Oct 2026 – pipelined BOT: CBW/data/CSW queued together
+ * Updated: boot412 – Oct 2026 – UAS preferred where offered (usb_uas.c)
+ * Updated: boot413 – Oct 2026 – READ(16)/WRITE(16); Block Limits VPD transfer sizes
  */
 
 #include "kernel.h"
 #include "usb.h"
 #include "blockdriver.h"
 #include "uasp.h"
+#include "usb_xhci.h"
 
 extern void uart_puts(const char *s);
 /* boot297: quiet mode for xHCI timeout log during TUR retries */
@@ -37,6 +43,11 @@ static void print_hex64(uint64_t v) {
 
 #define USB_MAX_LUN         8
 #define USB_TIMEOUT         5000
+#define MSC_BENCH           0     /* boot410: 1 = time reads by size after probe */
+
+/* boot411: run BOT commands through xhci_bot_command (CBW, data and CSW
+ * queued together, next CBW sent ahead).  0 = one stage at a time.     */
+static int msc_pipeline = 1;
 
 /* ── usb_storage_t ────────────────────────────────────────────────────────── */
 typedef struct usb_storage {
@@ -48,7 +59,9 @@ typedef struct usb_storage {
     uint8_t          lun_count;
     uint64_t         capacity[USB_MAX_LUN];   /* sectors per LUN              */
     uint32_t         block_size[USB_MAX_LUN]; /* bytes per sector (from RC10) */
+    uint8_t          rw16[USB_MAX_LUN];       /* boot413: READ/WRITE(16) only */
     blockdev_t      *bdev[USB_MAX_LUN];       /* registered blockdev_t        */
+    blockdev_reqq_t  ioq;                     /* boot409: submitted requests  */
 } usb_storage_t;
 
 static usb_storage_t *usb_drives[16];
@@ -89,11 +102,37 @@ typedef struct {
 #define CBW_SIGNATURE   0x43425355u
 #define CSW_SIGNATURE   0x53425355u
 
-/* ── Generic BOT SCSI command ─────────────────────────────────────────────── *
- * Handles any SCSI CDB over BOT: CBW → [data phase] → CSW.
- * dir_in=1 for device→host data (e.g. READ CAPACITY, READ),
- * dir_in=0 for host→device (e.g. WRITE), buf=NULL/buf_len=0 for no data.
- * Returns 0 on success (CSW status=0), -1 on failure.
+/* ── BOT pipe reset ───────────────────────────────────────────────────────── *
+ * boot335: after a failed CSW the device may have halted both endpoints.
+ * Clear ENDPOINT_HALT on each and rebuild the xHCI rings so the next CBW
+ * succeeds — without this, bulk-OUT stays HALTED and every subsequent CBW
+ * send fails immediately ("CBW send failed").                               */
+static void bot_clear_pipes(usb_storage_t *drive)
+{
+    usb_control_transfer(drive->dev, 0x02u, 0x01u, 0x0000u,
+        drive->bulk_in->bEndpointAddress,  NULL, 0, 200);
+    usb_control_transfer(drive->dev, 0x02u, 0x01u, 0x0000u,
+        drive->bulk_out->bEndpointAddress, NULL, 0, 200);
+    xhci_ep_recover(drive->dev);
+}
+
+static void bot_build_cbw(cbw_t *cbw, int lun, const uint8_t *cdb,
+                          uint8_t cdb_len, uint32_t data_len, int dir_in)
+{
+    memset(cbw, 0, sizeof(*cbw));
+    cbw->signature = CBW_SIGNATURE;
+    cbw->tag       = 0xC0DEC0DEu;
+    cbw->data_len  = data_len;
+    cbw->flags     = dir_in ? 0x80u : 0x00u;
+    cbw->lun       = (uint8_t)lun;
+    cbw->cmd_len   = cdb_len;
+    for (int _i = 0; _i < cdb_len && _i < 16; _i++)
+        cbw->cmd[_i] = cdb[_i];
+}
+
+/* ── One BOT command, one stage at a time ─────────────────────────────────── *
+ * CBW → [data phase] → CSW, each a separate usb_bulk_transfer().  Used for
+ * non-xHCI endpoints and when msc_pipeline is off.
  *
  * boot184 fix: when the data-IN phase stalls (CC=6), BOT spec §6.6.2 requires
  * the host to: (1) clear the ENDPOINT_HALT on bulk-IN, then (2) read the CSW.
@@ -102,24 +141,13 @@ typedef struct {
  * CSW was outstanding → phase error → device stalls again.  Now we always
  * attempt to clear the stall and drain the CSW before returning, leaving the
  * BOT state machine clean for the next command.                               */
-static int bot_scsi_cmd(usb_storage_t *drive, int lun,
-                        const uint8_t *cdb, uint8_t cdb_len,
-                        void *buf, uint32_t buf_len, int dir_in)
+static int bot_exec_serial(usb_storage_t *drive, cbw_t *cbw,
+                           void *buf, uint32_t buf_len, int dir_in)
 {
-    cbw_t cbw = {0};
     csw_t csw = {0};
 
-    cbw.signature = CBW_SIGNATURE;
-    cbw.tag       = 0xC0DEC0DEu;
-    cbw.data_len  = buf_len;
-    cbw.flags     = dir_in ? 0x80u : 0x00u;
-    cbw.lun       = (uint8_t)lun;
-    cbw.cmd_len   = cdb_len;
-    for (int _i = 0; _i < cdb_len && _i < 16; _i++)
-        cbw.cmd[_i] = cdb[_i];
-
     /* Phase 1: Command */
-    if (usb_bulk_transfer(drive->bulk_out, &cbw, 31, USB_TIMEOUT) < 0) {
+    if (usb_bulk_transfer(drive->bulk_out, cbw, 31, USB_TIMEOUT) < 0) {
         uart_puts("[MSC] BOT: CBW send failed\n");
         return -1;
     }
@@ -135,19 +163,12 @@ static int bot_scsi_cmd(usb_storage_t *drive, int lun,
              * NOT returning -1 here keeps the pipe clean for the next command. */
             data_stalled = 1;
             uart_puts("[MSC] BOT: data phase stalled — clearing halt\n");
-            if (dir_in) {
-                usb_control_transfer(drive->dev,
-                    0x02u,   /* bmRequestType: std | ep | host→dev */
-                    0x01u,   /* bRequest: CLEAR_FEATURE             */
-                    0x0000u, /* wValue: ENDPOINT_HALT               */
-                    drive->bulk_in->bEndpointAddress,
-                    NULL, 0, 200);
-            } else {
-                usb_control_transfer(drive->dev,
-                    0x02u, 0x01u, 0x0000u,
-                    drive->bulk_out->bEndpointAddress,
-                    NULL, 0, 200);
-            }
+            usb_control_transfer(drive->dev,
+                0x02u,   /* bmRequestType: std | ep | host→dev */
+                0x01u,   /* bRequest: CLEAR_FEATURE             */
+                0x0000u, /* wValue: ENDPOINT_HALT               */
+                ep->bEndpointAddress,
+                NULL, 0, 200);
             /* Fall through to Phase 3 to drain the CSW */
         }
     }
@@ -155,25 +176,12 @@ static int bot_scsi_cmd(usb_storage_t *drive, int lun,
     /* Phase 3: Status */
     if (usb_bulk_transfer(drive->bulk_in, &csw, 13, USB_TIMEOUT) < 0) {
         uart_puts("[MSC] BOT: CSW recv failed\n");
-        /* boot335: pipe is dirty — clear both endpoints so the next CBW
-         * succeeds.  Without this, bulk-OUT stays HALTED and every
-         * subsequent CBW send fails immediately ("CBW send failed").    */
-        usb_control_transfer(drive->dev, 0x02u, 0x01u, 0x0000u,
-            drive->bulk_in->bEndpointAddress,  NULL, 0, 200);
-        usb_control_transfer(drive->dev, 0x02u, 0x01u, 0x0000u,
-            drive->bulk_out->bEndpointAddress, NULL, 0, 200);
-        xhci_ep_recover(drive->dev);
+        bot_clear_pipes(drive);
         return -1;
     }
     if (csw.signature != CSW_SIGNATURE) {
         uart_puts("[MSC] BOT: bad CSW signature\n");
-        /* boot335: device may have halted both endpoints in error response.
-         * Clear ENDPOINT_HALT + rebuild xHCI rings before the next command. */
-        usb_control_transfer(drive->dev, 0x02u, 0x01u, 0x0000u,
-            drive->bulk_in->bEndpointAddress,  NULL, 0, 200);
-        usb_control_transfer(drive->dev, 0x02u, 0x01u, 0x0000u,
-            drive->bulk_out->bEndpointAddress, NULL, 0, 200);
-        xhci_ep_recover(drive->dev);
+        bot_clear_pipes(drive);
         return -1;
     }
 
@@ -181,6 +189,72 @@ static int bot_scsi_cmd(usb_storage_t *drive, int lun,
     return (csw.status == 0) ? 0 : -1;
 }
 
+/* ── One BOT command, pipelined (boot411) ─────────────────────────────────── *
+ * xhci_bot_command queues CBW, data and CSW together and waits once, so a
+ * 512-byte read costs one event round trip instead of three.  next, if
+ * given, is the CBW the caller will issue next: it goes out the instant
+ * this CSW lands, keeping the bulk pipes busy between commands.
+ *
+ * Failures leave TDs stranded on the rings, so every error path rebuilds
+ * them.  A stalled data phase still gets the §6.6.2 treatment: clear the
+ * halt, then collect the CSW.                                               */
+static int bot_exec(usb_storage_t *drive, cbw_t *cbw, void *buf,
+                    uint32_t buf_len, int dir_in, const cbw_t *next)
+{
+    if (!msc_pipeline || !drive->bulk_out->slot_id)
+        return bot_exec_serial(drive, cbw, buf, buf_len, dir_in);
+
+    csw_t csw = {0};
+    xhci_bot_cmd_t cmd = {
+        .cbw      = cbw,
+        .data     = buf_len ? buf : NULL,
+        .len      = buf ? buf_len : 0,
+        .dir_in   = dir_in,
+        .csw      = &csw,
+        .next_cbw = next,
+    };
+    if (xhci_bot_command(drive->bulk_out, drive->bulk_in, &cmd, USB_TIMEOUT) < 0) {
+        if (cmd.failed == XHCI_BOT_DATA) {
+            usb_endpoint_t *ep = dir_in ? drive->bulk_in : drive->bulk_out;
+            uart_puts("[MSC] BOT: data phase stalled — clearing halt\n");
+            usb_control_transfer(drive->dev, 0x02u, 0x01u, 0x0000u,
+                                 ep->bEndpointAddress, NULL, 0, 200);
+            xhci_ep_recover(drive->dev);    /* drop the stranded CSW TD */
+            memset(&csw, 0, sizeof(csw));
+            if (usb_bulk_transfer(drive->bulk_in, &csw, 13, USB_TIMEOUT) < 0 ||
+                csw.signature != CSW_SIGNATURE) {
+                uart_puts("[MSC] BOT: CSW recv failed\n");
+                bot_clear_pipes(drive);
+            }
+            return -1;
+        }
+        uart_puts(cmd.failed == XHCI_BOT_CBW ? "[MSC] BOT: CBW send failed\n"
+                                             : "[MSC] BOT: CSW recv failed\n");
+        bot_clear_pipes(drive);
+        return -1;
+    }
+    if (csw.signature != CSW_SIGNATURE) {
+        uart_puts("[MSC] BOT: bad CSW signature\n");
+        bot_clear_pipes(drive);
+        return -1;
+    }
+    return (csw.status == 0) ? 0 : -1;
+}
+
+/* ── Generic BOT SCSI command ─────────────────────────────────────────────── *
+ * Handles any SCSI CDB over BOT: CBW → [data phase] → CSW.
+ * dir_in=1 for device→host data (e.g. READ CAPACITY, READ),
+ * dir_in=0 for host→device (e.g. WRITE), buf=NULL/buf_len=0 for no data.
+ * Returns 0 on success (CSW status=0), -1 on failure.                       */
+static int bot_scsi_cmd(usb_storage_t *drive, int lun,
+                        const uint8_t *cdb, uint8_t cdb_len,
+                        void *buf, uint32_t buf_len, int dir_in)
+{
+    cbw_t cbw;
+    bot_build_cbw(&cbw, lun, cdb, cdb_len, buf ? buf_len : 0, dir_in);
+    return bot_exec(drive, &cbw, buf, buf_len, dir_in, NULL);
+}
+
 /* ── Wall-clock helpers (CNTPCT_EL0 @ 54 MHz on BCM2711) ────────────────── */
 static inline uint32_t msc_time_ms(void) {
     uint64_t v;
@@ -284,14 +358,57 @@ static int bot_read_capacity16(usb_storage_t *drive, int lun)
     return 0;
 }
 
-/* ── SCSI READ(10) / WRITE(10) over BOT ───────────────────────────────────── */
-static int usb_bot_rw(usb_storage_t *drive, int lun, uint64_t lba,
-                      uint32_t blocks, void *buffer, int write)
+/* ── Block Limits VPD (boot413) ─────────────────────────────────────────────
+ * INQUIRY EVPD page B0h carries the device's maximum and optimal transfer
+ * lengths and their granularity.  Only asked of SPC-3 or later devices
+ * that list the page in Supported VPD Pages (00h): plenty of USB sticks
+ * stall or return junk for VPD requests they never advertised.
+ * Fills vpd (64 bytes) and returns 0, or -1 if the page is not offered. */
+static int bot_inquiry_vpd(usb_storage_t *drive, int lun, uint8_t page,
+                           uint8_t *buf, uint8_t len)
+{
+    uint8_t cdb[6] = {0x12, 0x01, page, 0, len, 0};   /* INQUIRY, EVPD=1 */
+    memset(buf, 0, len);
+    if (bot_scsi_cmd(drive, lun, cdb, 6, buf, len, 1) < 0) return -1;
+    return (buf[1] == page) ? 0 : -1;
+}
+
+static int bot_block_limits(usb_storage_t *drive, int lun, uint8_t *vpd)
+{
+    uint8_t pages[64];
+    if (bot_inquiry_vpd(drive, lun, 0x00, pages, sizeof(pages)) < 0)
+        return -1;
+    int n = pages[3];
+    if (n > (int)sizeof(pages) - 4) n = (int)sizeof(pages) - 4;
+    for (int i = 0; i < n; i++)
+        if (pages[4 + i] == 0xB0u)
+            return bot_inquiry_vpd(drive, lun, 0xB0, vpd, 64);
+    return -1;
+}
+
+/* ── SCSI READ / WRITE over BOT ───────────────────────────────────────────── *
+ * boot413: the 10-byte CDBs address 2 TiB (512-byte sectors) and move at
+ * most 65535 blocks.  Past either limit — or on a disc READ CAPACITY(16)
+ * sized beyond 32-bit LBAs, where rw16 is set — READ(16)/WRITE(16).     */
+static void bot_rw_cbw(usb_storage_t *drive, int lun, uint64_t lba,
+                       uint32_t blocks, int write, cbw_t *cbw)
 {
     uint32_t bsize = drive->block_size[lun];
     if (bsize == 0) bsize = 512;  /* safety fallback */
 
-    uint8_t cdb[10] = {0};
+    uint8_t cdb[16] = {0};
+    if (drive->rw16[lun] || blocks > 0xFFFFu ||
+        lba + blocks > 0x100000000ull) {
+        cdb[0] = write ? 0x8Au : 0x88u;   /* WRITE(16) : READ(16) */
+        for (int i = 0; i < 8; i++)
+            cdb[2 + i] = (uint8_t)(lba >> (56 - 8 * i));
+        cdb[10] = (uint8_t)(blocks >> 24);
+        cdb[11] = (uint8_t)(blocks >> 16);
+        cdb[12] = (uint8_t)(blocks >>  8);
+        cdb[13] = (uint8_t) blocks;
+        bot_build_cbw(cbw, lun, cdb, 16, blocks * bsize, !write);
+        return;
+    }
     cdb[0] = write ? 0x2Au : 0x28u;   /* WRITE(10) : READ(10) */
     cdb[2] = (uint8_t)(lba >> 24);
     cdb[3] = (uint8_t)(lba >> 16);
@@ -300,8 +417,17 @@ static int usb_bot_rw(usb_storage_t *drive, int lun, uint64_t lba,
     cdb[7] = (uint8_t)(blocks >> 8);
     cdb[8] = (uint8_t) blocks;
 
-    return bot_scsi_cmd(drive, lun, cdb, 10,
-                        buffer, blocks * bsize, !write);
+    bot_build_cbw(cbw, lun, cdb, 10, blocks * bsize, !write);
+}
+
+/* next: CBW of the command that will follow on this drive, or NULL */
+static int usb_bot_rw(usb_storage_t *drive, int lun, uint64_t lba,
+                      uint32_t blocks, void *buffer, int write,
+                      const cbw_t *next)
+{
+    cbw_t cbw;
+    bot_rw_cbw(drive, lun, lba, blocks, write, &cbw);
+    return bot_exec(drive, &cbw, buffer, cbw.data_len, !write, next);
 }
 
 /* ── BOT error recovery ────────────────────────────────────────────────────── *
@@ -371,16 +497,20 @@ static int bot_recover(usb_storage_t *drive)
 }
 
 /* ── blockdev_ops_t callbacks (multi-block: lba + count) ─────────────────── */
-static ssize_t usb_bdev_read(blockdev_t *bdev, uint64_t lba,
-                              uint32_t count, void *buf)
+static ssize_t msc_rw(usb_bdev_priv_t *p, uint64_t lba, uint32_t count,
+                      void *buf, int write, const cbw_t *next)
 {
-    usb_bdev_priv_t *p = (usb_bdev_priv_t *)bdev->private;
-    if (usb_bot_rw(p->drive, p->lun, lba, count, buf, 0) < 0) {
+    if (write) {
+        if (usb_bot_rw(p->drive, p->lun, lba, count, buf, 1, next) < 0)
+            return -1;
+        return (ssize_t)count;
+    }
+    if (usb_bot_rw(p->drive, p->lun, lba, count, buf, 0, next) < 0) {
         /* First read failed — attempt BOT recovery and retry once */
         uart_puts("[MSC] read failed @ LBA "); print_hex32((uint32_t)lba);
         uart_puts(" — attempting BOT recovery\n");
         if (bot_recover(p->drive) == 0) {
-            if (usb_bot_rw(p->drive, p->lun, lba, count, buf, 0) < 0) {
+            if (usb_bot_rw(p->drive, p->lun, lba, count, buf, 0, NULL) < 0) {
                 uart_puts("[MSC] read still failed after recovery\n");
                 return -1;
             }
@@ -392,34 +522,294 @@ static ssize_t usb_bdev_read(blockdev_t *bdev, uint64_t lba,
     return (ssize_t)count;
 }
 
+static ssize_t usb_bdev_read(blockdev_t *bdev, uint64_t lba,
+                              uint32_t count, void *buf)
+{
+    return msc_rw((usb_bdev_priv_t *)bdev->private, lba, count, buf, 0, NULL);
+}
+
 static ssize_t usb_bdev_write(blockdev_t *bdev, uint64_t lba,
                                uint32_t count, const void *buf)
+{
+    return msc_rw((usb_bdev_priv_t *)bdev->private, lba, count, (void *)buf, 1, NULL);
+}
+
+/* ── Read throughput benchmark (boot410) ─────────────────────────────────────
+ * With zero-copy bulk TDs a single READ(10) may now move up to 1 MB.  Reads
+ * MSC_BENCH_TOTAL bytes from LBA 0 at each request size and reports MB/s,
+ * so the per-command overhead of small requests is visible next to the
+ * streaming rate of large ones, then random-read IOPS with and without
+ * BOT pipelining.  Built only when MSC_BENCH is set.                      */
+#if MSC_BENCH
+#define MSC_BENCH_TOTAL     (8u * 1024u * 1024u)
+#define MSC_BENCH_IOS       2000u
+
+static void msc_benchmark(usb_storage_t *drive)
+{
+    static const uint32_t sizes[] = { 4096u, 65536u, 262144u, 1048576u };
+    uint32_t bsize = drive->block_size[0] ? drive->block_size[0] : 512u;
+    uint8_t *buf = kmalloc(sizes[3]);
+    if (!buf) return;
+
+    for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        uint32_t blocks = sizes[i] / bsize;
+        uint32_t reqs   = MSC_BENCH_TOTAL / sizes[i];
+        if ((uint64_t)blocks * reqs > drive->capacity[0]) break;
+
+        uint64_t t0, t1;
+        asm volatile("isb; mrs %0, cntpct_el0" : "=r"(t0) :: "memory");
+        uint32_t n;
+        for (n = 0; n < reqs; n++)
+            if (usb_bot_rw(drive, 0, (uint64_t)n * blocks, blocks, buf, 0, NULL) < 0)
+                break;
+        asm volatile("isb; mrs %0, cntpct_el0" : "=r"(t1) :: "memory");
+
+        uint64_t ticks = (t1 - t0) ? (t1 - t0) : 1;
+        /* KB/s = bytes / 1024 / (ticks / 54 MHz) */
+        uint32_t kbs = (uint32_t)(((uint64_t)n * sizes[i] / 1024u) * 54000000ULL / ticks);
+        debug_print("[MSC] bench: %u KB reads x%u: %u.%u MB/s\n",
+                    sizes[i] / 1024u, n, kbs / 1024u, (kbs % 1024u) * 10u / 1024u);
+    }
+
+    /* boot411: random small reads, one stage at a time vs pipelined with
+     * the next CBW sent ahead — the directory/map-sector access pattern. */
+    static const uint32_t rsizes[] = { 512u, 4096u };
+    for (unsigned i = 0; i < sizeof(rsizes) / sizeof(rsizes[0]); i++) {
+        uint32_t blocks = rsizes[i] > bsize ? rsizes[i] / bsize : 1u;
+        if (drive->capacity[0] <= blocks) break;
+        uint64_t span = drive->capacity[0] - blocks;
+        for (int piped = 0; piped <= 1; piped++) {
+            int saved = msc_pipeline;
+            msc_pipeline = piped;
+            uint32_t seed = 0x2545F491u;
+            uint64_t lba = seed % span, t0, t1;
+            uint32_t n;
+            asm volatile("isb; mrs %0, cntpct_el0" : "=r"(t0) :: "memory");
+            for (n = 0; n < MSC_BENCH_IOS; n++) {
+                seed = seed * 1664525u + 1013904223u;
+                uint64_t nlba = seed % span;
+                cbw_t nx;
+                bot_rw_cbw(drive, 0, nlba, blocks, 0, &nx);
+                int last = (n == MSC_BENCH_IOS - 1);
+                if (usb_bot_rw(drive, 0, lba, blocks, buf, 0,
+                               (piped && !last) ? &nx : NULL) < 0)
+                    break;
+                lba = nlba;
+            }
+            asm volatile("isb; mrs %0, cntpct_el0" : "=r"(t1) :: "memory");
+            msc_pipeline = saved;
+
+            uint64_t ticks = (t1 - t0) ? (t1 - t0) : 1;
+            debug_print("[MSC] bench: %u B random reads, %s: %u IOPS\n",
+                        blocks * bsize, piped ? "pipelined" : "serial",
+                        (uint32_t)((uint64_t)n * 54000000ULL / ticks));
+        }
+    }
+    kfree(buf);
+}
+#endif
+
+/* ── Asynchronous requests (boot409) ─────────────────────────────────────────
+ * Submitted requests queue per drive — a BOT pipe carries one command at a
+ * time — and one MSCio task drains the queues round-robin, so a busy disc
+ * does not starve the others and submitters never wait on the bus.  Before
+ * the scheduler runs (probe, FileCore scan at boot) submit declines and the
+ * block layer performs the request synchronously.                        */
+static task_t *msc_io_task = NULL;
+
+static void msc_io_worker(void)
+{
+    /* Tasks start with IRQs masked; unmask so xHCI event waits can sleep
+     * on the MSI instead of polling (evt_can_block).                    */
+    asm volatile("msr daifclr, #2" ::: "memory");
+
+    for (;;) {
+        int busy = 0;
+        for (int i = 0; i < usb_drive_count; i++) {
+            blockdev_req_t *req = blockdev_reqq_pop(&usb_drives[i]->ioq);
+            if (!req) continue;
+            busy = 1;
+
+            /* boot411: the request behind this one is next on this pipe —
+             * let its CBW go out as soon as this command's CSW arrives.  */
+            cbw_t nx_cbw, *nx = NULL;
+            blockdev_req_t *after =
+                __atomic_load_n(&usb_drives[i]->ioq.head, __ATOMIC_ACQUIRE);
+            if (after) {
+                usb_bdev_priv_t *np = (usb_bdev_priv_t *)after->dev->private;
+                bot_rw_cbw(np->drive, np->lun, after->lba, after->count,
+                           after->op == BLOCKDEV_WRITE, &nx_cbw);
+                nx = &nx_cbw;
+            }
+
+            ssize_t r = msc_rw((usb_bdev_priv_t *)req->dev->private, req->lba,
+                               req->count, req->buf,
+                               req->op == BLOCKDEV_WRITE, nx);
+            blockdev_complete(req, r);
+        }
+        if (busy) continue;
+
+        /* Idle: sleep until usb_bdev_submit queues more work */
+        current_task->state = TASK_BLOCKED;
+        for (int i = 0; i < usb_drive_count; i++)
+            if (__atomic_load_n(&usb_drives[i]->ioq.head, __ATOMIC_ACQUIRE))
+                current_task->state = TASK_RUNNING;
+        if (current_task->state == TASK_BLOCKED) schedule();
+    }
+}
+
+static int usb_bdev_submit(blockdev_t *bdev, blockdev_req_t *req)
 {
     usb_bdev_priv_t *p = (usb_bdev_priv_t *)bdev->private;
-    if (usb_bot_rw(p->drive, p->lun, lba, count, (void *)buf, 1) < 0)
-        return -1;
-    return (ssize_t)count;
+    if (!current_task) return -1;                   /* no scheduler yet */
+    if (!msc_io_task)
+        msc_io_task = task_create("MSCio", msc_io_worker, BLOCKDEV_IO_PRIORITY, 0);
+    if (!msc_io_task) return -1;
+
+    blockdev_reqq_push(&p->drive->ioq, req);
+    task_wakeup(msc_io_task);
+    return 0;
 }
 
 static blockdev_ops_t usb_bdev_ops = {
-    .read  = usb_bdev_read,
-    .write = usb_bdev_write,
-    .trim  = NULL,
-    .poll  = NULL,
-    .close = NULL,
+    .read   = usb_bdev_read,
+    .write  = usb_bdev_write,
+    .trim   = NULL,
+    .poll   = NULL,
+    .close  = NULL,
+    .submit = usb_bdev_submit,
 };
 
+/* ── Disc registration (shared with usb_uas.c, boot412) ─────────────────── */
+static int msc_disc_units = 0;
+
+blockdev_t *msc_register_disc(usb_device_t *dev, uint64_t blocks,
+                              uint32_t block_size, const char *product)
+{
+    /* Build name: usb0, usb1, … (max 15 chars per blockdriver.h)           */
+    char devname[5] = "usb0";
+    devname[3] = (char)('0' + (msc_disc_units & 0x0F));
+
+    /* Register with blockdriver.c — it allocates and owns the blockdev_t   */
+    blockdev_t *bd = blockdev_register(devname, blocks, block_size);
+    if (!bd) {
+        uart_puts("[MSC] blockdev_register failed\n");
+        return NULL;
+    }
+    msc_disc_units++;
+
+    /* ── Media class classification ─────────────────────────────────────────
+     * VID/PID first (definitive); INQUIRY product string as fallback.
+     * Used by FileCore disc scoring: NVMe > SSD > USB-Flash > SD.            */
+    {
+        media_class_t mc   = MEDIA_USB_FLASH;
+        uint16_t      vid  = dev->idVendor;
+        uint16_t      pid  = dev->idProduct;
+
+        /* Known USB-NVMe bridges */
+        if      (vid == 0x0bdau && pid == 0x9210u) mc = MEDIA_NVME; /* RTL9210  */
+        else if (vid == 0x152du && pid == 0x0583u) mc = MEDIA_NVME; /* JMS583   */
+        else if (vid == 0x2109u && pid == 0x0715u) mc = MEDIA_NVME; /* VL716    */
+        /* Known USB-SATA SSD enclosures */
+        else if (vid == 0x174cu && pid == 0x55aau) mc = MEDIA_SSD;  /* ASM1351  */
+        else if (vid == 0x152du && pid == 0x0578u) mc = MEDIA_SSD;  /* JMS580   */
+        else if (vid == 0x0080u && pid == 0x0578u) mc = MEDIA_SSD;  /* Sabrent  */
+        else {
+            /* INQUIRY product string heuristic — simple substring search */
+            static const char * const nvme_keys[] = { "NVMe","NVME","NVM",NULL };
+            static const char * const ssd_keys[]  = { "SSD","M.2",NULL };
+            int matched = 0;
+            for (int _k = 0; nvme_keys[_k] && !matched; _k++) {
+                const char *h = product, *n = nvme_keys[_k];
+                for (int _i = 0; h[_i] && !matched; _i++) {
+                    int _j = 0;
+                    while (n[_j] && h[_i+_j] == n[_j]) _j++;
+                    if (!n[_j]) { mc = MEDIA_NVME; matched = 1; }
+                }
+            }
+            for (int _k = 0; ssd_keys[_k] && !matched; _k++) {
+                const char *h = product, *n = ssd_keys[_k];
+                for (int _i = 0; h[_i] && !matched; _i++) {
+                    int _j = 0;
+                    while (n[_j] && h[_i+_j] == n[_j]) _j++;
+                    if (!n[_j]) { mc = MEDIA_SSD;  matched = 1; }
+                }
+            }
+        }
+        bd->media_class = mc;
+        uart_puts("[MSC] media_class=");
+        uart_puts(mc == MEDIA_NVME ? "NVMe" :
+                  mc == MEDIA_SSD  ? "SSD"  : "USB-Flash");
+        uart_puts("\n");
+    }
+    return bd;
+}
+
+/* ── Transfer limits (boot413, shared with usb_uas.c) ───────────────────────
+ * What one command may move: xfer_bytes is the transport's cap, 65535
+ * blocks the 10-byte CDB's unless rw16, tightened by the Block Limits VPD
+ * page (vpd, or NULL if the device has none).  The block layer splits
+ * larger requests into pieces of a multiple of the optimal length.      */
+void msc_set_limits(blockdev_t *bd, const uint8_t *vpd, uint32_t xfer_bytes,
+                    int rw16)
+{
+    uint32_t bsize = bd->block_size ? bd->block_size : 512u;
+    uint32_t max   = xfer_bytes / bsize;
+    uint32_t opt   = 0, gran = 0;
+    if (!rw16 && max > 0xFFFFu) max = 0xFFFFu;
+    if (max == 0) max = 1;
+
+    if (vpd && vpd[1] == 0xB0u && vpd[3] >= 0x0Cu) {
+        uint32_t vmax = ((uint32_t)vpd[8]  << 24) | ((uint32_t)vpd[9]  << 16) |
+                        ((uint32_t)vpd[10] <<  8) |  (uint32_t)vpd[11];
+        uint32_t vopt = ((uint32_t)vpd[12] << 24) | ((uint32_t)vpd[13] << 16) |
+                        ((uint32_t)vpd[14] <<  8) |  (uint32_t)vpd[15];
+        gran = ((uint32_t)vpd[6] << 8) | vpd[7];
+        if (vmax && vmax < max) max = vmax;
+        if (vopt <= max) opt = vopt;
+        uart_puts("[MSC] Block Limits: max="); print_hex32(vmax);
+        uart_puts(" opt="); print_hex32(vopt);
+        uart_puts(" gran="); print_hex32(gran); uart_puts(" blocks\n");
+    }
+    bd->max_xfer  = max;
+    bd->opt_xfer  = opt;
+    bd->xfer_gran = gran;
+    uart_puts("[MSC] transfer limit "); print_hex32(max);
+    uart_puts(" blocks"); uart_puts(rw16 ? ", READ/WRITE(16)\n" : "\n");
+}
+
 /* ── Probe ────────────────────────────────────────────────────────────────── */
 static int usb_storage_probe(usb_device_t *dev, usb_interface_t *intf)
 {
-    /* Decline UAS — not yet implemented.
-     * The ASMedia ASM1153E presents both UAS (proto=0x62) and BOT (proto=0x50)
-     * alternate interfaces.  Return -1 here so the framework tries the next
-     * interface, which is BOT and will bind successfully.                   */
-    if (intf->bInterfaceProtocol == USB_PROTOCOL_UASP) {
-        uart_puts("[MSC] UAS interface declined (BOT will bind)\n");
+    /* boot412: prefer UAS.
+     * The ASMedia ASM1153E and RTL9210 present BOT (proto=0x50) and UAS
+     * (proto=0x62) as alternate settings of one interface, and the core
+     * probes each alternate in turn.  The first one seen decides for the
+     * interface: UAS if the device has it and the UAS driver gets streams
+     * going, otherwise BOT on the alternate-0 endpoints.  Later alternates
+     * of the same interface are declined.                                 */
+    for (usb_interface_t *o = dev->interfaces; o < intf; o++)
+        if (o->bInterfaceNumber == intf->bInterfaceNumber &&
+            o->bInterfaceClass  == USB_CLASS_MSC)
+            return -1;
+
+    usb_interface_t *uas = NULL;
+    usb_interface_t *bot = (intf->bInterfaceProtocol != USB_PROTOCOL_UASP) ? intf : NULL;
+    for (int i = 0; i < dev->num_interfaces; i++) {
+        usb_interface_t *a = &dev->interfaces[i];
+        if (a->bInterfaceNumber != intf->bInterfaceNumber ||
+            a->bInterfaceClass  != USB_CLASS_MSC) continue;
+        if (a->bInterfaceProtocol == USB_PROTOCOL_UASP && !uas) uas = a;
+        if (a->bInterfaceProtocol == USB_PROTOCOL_BULK && !bot) bot = a;
+    }
+    if (uas && uas_probe(dev, uas) == 0)
+        return 0;
+    if (!bot) {
+        uart_puts("[MSC] no BOT alternate — interface declined\n");
         return -1;
     }
+    if (uas) uart_puts("[MSC] UAS unavailable — binding BOT\n");
+    intf = bot;
 
     usb_storage_t *drive = kmalloc(sizeof(usb_storage_t));
     if (!drive) return -1;
@@ -519,11 +909,13 @@ static int usb_storage_probe(usb_device_t *dev, usb_interface_t *intf)
      * vendor[] / product[] are also used below for media_class scoring.       */
     char msc_vendor[9]  = {0};
     char msc_product[17] = {0};
+    uint8_t scsi_version = 0;
     {
         uint8_t inq_cdb[6] = {0x12, 0, 0, 0, 36, 0};
         uint8_t inq_buf[36] = {0};
         int inq_rc = bot_scsi_cmd(drive, 0, inq_cdb, 6, inq_buf, 36, 1);
         if (inq_rc == 0) {
+            scsi_version = inq_buf[2];
             for (int _i = 0; _i < 8;  _i++) {
                 char _c = (char)(inq_buf[8  + _i] & 0x7Fu);
                 msc_vendor[_i]  = (_c >= 0x20) ? _c : ' ';
@@ -613,7 +1005,19 @@ static int usb_storage_probe(usb_device_t *dev, usb_interface_t *intf)
             drive->capacity[0]   = 0;
             drive->block_size[0] = 512;
         }
+    } else if (drive->capacity[0] > 0xFFFFFFFFull) {
+        /* boot413: RC(10) answers 0xFFFFFFFF for a disc past 2 TiB — the
+         * real size needs RC(16), and its LBAs need READ/WRITE(16).      */
+        uart_puts("[MSC] RC(10) saturated — READ CAPACITY(16)...\n");
+        if (bot_read_capacity16(drive, 0) < 0)
+            xhci_ep_recover(drive->dev);
     }
+    drive->rw16[0] = (drive->capacity[0] > 0xFFFFFFFFull);
+
+    /* boot413: Block Limits VPD — SPC-3 (version 5) and later only */
+    uint8_t vpd_b0[64];
+    int have_b0 = (tur_ok && scsi_version >= 0x05u &&
+                   bot_block_limits(drive, 0, vpd_b0) == 0);
 
     xhci_set_quiet_timeouts(0);   /* boot298: quiet zone ends — all commands log normally from here */
     uart_puts("[MSC] LUN 0: capacity=0x");
@@ -622,16 +1026,9 @@ static int usb_storage_probe(usb_device_t *dev, usb_interface_t *intf)
     print_hex32(drive->block_size[0]);
     uart_puts(" bytes\n");
 
-    /* Build name: usb0, usb1, … (max 15 chars per blockdriver.h)           */
-    char devname[5] = "usb0";
-    devname[3] = (char)('0' + (usb_drive_count & 0x0F));
-
-    /* Register with blockdriver.c — it allocates and owns the blockdev_t   */
-    blockdev_t *bd = blockdev_register(devname,
-                                       drive->capacity[0],
-                                       drive->block_size[0]);
+    blockdev_t *bd = msc_register_disc(dev, drive->capacity[0],
+                                       drive->block_size[0], msc_product);
     if (!bd) {
-        uart_puts("[MSC] blockdev_register failed\n");
         kfree(drive);
         return -1;
     }
@@ -643,51 +1040,8 @@ static int usb_storage_probe(usb_device_t *dev, usb_interface_t *intf)
     priv->lun   = 0;
     bd->private = priv;
     bd->ops     = &usb_bdev_ops;
-
-    /* ── Media class classification ─────────────────────────────────────────
-     * VID/PID first (definitive); INQUIRY product string as fallback.
-     * Used by FileCore disc scoring: NVMe > SSD > USB-Flash > SD.            */
-    {
-        media_class_t mc   = MEDIA_USB_FLASH;
-        uint16_t      vid  = dev->idVendor;
-        uint16_t      pid  = dev->idProduct;
-
-        /* Known USB-NVMe bridges */
-        if      (vid == 0x0bdau && pid == 0x9210u) mc = MEDIA_NVME; /* RTL9210  */
-        else if (vid == 0x152du && pid == 0x0583u) mc = MEDIA_NVME; /* JMS583   */
-        else if (vid == 0x2109u && pid == 0x0715u) mc = MEDIA_NVME; /* VL716    */
-        /* Known USB-SATA SSD enclosures */
-        else if (vid == 0x174cu && pid == 0x55aau) mc = MEDIA_SSD;  /* ASM1351  */
-        else if (vid == 0x152du && pid == 0x0578u) mc = MEDIA_SSD;  /* JMS580   */
-        else if (vid == 0x0080u && pid == 0x0578u) mc = MEDIA_SSD;  /* Sabrent  */
-        else {
-            /* INQUIRY product string heuristic — simple substring search */
-            static const char * const nvme_keys[] = { "NVMe","NVME","NVM",NULL };
-            static const char * const ssd_keys[]  = { "SSD","M.2",NULL };
-            int matched = 0;
-            for (int _k = 0; nvme_keys[_k] && !matched; _k++) {
-                const char *h = msc_product, *n = nvme_keys[_k];
-                for (int _i = 0; h[_i] && !matched; _i++) {
-                    int _j = 0;
-                    while (n[_j] && h[_i+_j] == n[_j]) _j++;
-                    if (!n[_j]) { mc = MEDIA_NVME; matched = 1; }
-                }
-            }
-            for (int _k = 0; ssd_keys[_k] && !matched; _k++) {
-                const char *h = msc_product, *n = ssd_keys[_k];
-                for (int _i = 0; h[_i] && !matched; _i++) {
-                    int _j = 0;
-                    while (n[_j] && h[_i+_j] == n[_j]) _j++;
-                    if (!n[_j]) { mc = MEDIA_SSD;  matched = 1; }
-                }
-            }
-        }
-        bd->media_class = mc;
-        uart_puts("[MSC] media_class=");
-        uart_puts(mc == MEDIA_NVME ? "NVMe" :
-                  mc == MEDIA_SSD  ? "SSD"  : "USB-Flash");
-        uart_puts("\n");
-    }
+    msc_set_limits(bd, have_b0 ? vpd_b0 : NULL, XHCI_BULK_TD_MAX_XFER,
+                   drive->rw16[0]);
 
     drive->bdev[0] = bd;
 
@@ -699,6 +1053,9 @@ static int usb_storage_probe(usb_device_t *dev, usb_interface_t *intf)
     uart_puts("[MSC] USB mass storage registered as '");
     uart_puts(bd->name);
     uart_puts("'\n");
+#if MSC_BENCH
+    msc_benchmark(drive);
+#endif
     return 0;
 }
 
@@ -0,0 +1,671 @@
+/*
+ * usb_uas.c – USB Attached SCSI (UAS) Driver for RISC OS Phoenix
+ * SCSI commands tagged and queued on xHCI bulk streams (UAS r04)
+ * Integrates with BlockDevice → FileCore alongside usb_mass_storage.c
+ * Added: boot412 – Oct 2026
+ * Updated: boot413 – Oct 2026 – READ/WRITE(16); Block Limits VPD transfer sizes
+ * Updated: boot414 – Oct 2026 – block queue depth = tags
+ *
+ * Every command takes a tag, 1..ntags, which is also the stream its data
+ * and status move on.  Starting one queues its status TD on the status
+ * pipe and its data TD on the data pipe — both on the tag's stream — and
+ * then sends the Command IU, so up to ntags commands are outstanding and
+ * the bridge may overlap and reorder them the way an NVMe queue does.  A
+ * tag completes once its status IU and its data have both arrived.
+ *
+ * Whatever the pipes cannot finish on their own — an xHCI error, a failed
+ * command whose data TD is still queued, a timeout — resets all four
+ * pipes, sends LOGICAL UNIT RESET and re-issues what was in flight.
+ *
+ * SuperSpeed stream operation only: high-speed UAS (READ / WRITE READY
+ * IUs instead of streams) is left to BOT.
+ */
+
+#include "kernel.h"
+#include "usb.h"
+#include "blockdriver.h"
+#include "uasp.h"
+#include "usb_xhci.h"
+
+extern void uart_puts(const char *s);
+
+static void print_hex32(uint32_t v) {
+    static const char h[] = "0123456789abcdef";
+    char buf[11] = "0x";
+    for (int i = 9; i >= 2; i--) { buf[i] = h[v & 0xF]; v >>= 4; }
+    buf[10] = '\0';
+    uart_puts(buf);
+}
+
+#define UAS_TAGS        7       /* stream IDs 1..7 (usb_xhci.c STREAM_IDS) */
+#define UAS_MAX_DEVS    4
+#define UAS_TIMEOUT     5000    /* ms per command                          */
+#define UAS_RETRIES     3       /* re-issues before a command fails        */
+
+/* Stages of a command still outstanding */
+#define UAS_P_CMD       0x01
+#define UAS_P_DATA      0x02
+#define UAS_P_STATUS    0x04
+
+/* ── Per-tag command state ────────────────────────────────────────────────── */
+typedef struct {
+    uint8_t          busy;
+    uint8_t          pend;          /* UAS_P_* still to complete            */
+    uint8_t          failed;        /* status IU reported failure           */
+    uint8_t          retry;         /* ... one worth re-issuing (UA)        */
+    uint8_t          retries;
+    uint8_t          dir_in;
+    uint8_t          cdb_len;
+    uint8_t          cdb[16];
+    uint8_t         *buf;
+    uint32_t         len;           /* data bytes of the current command    */
+    uint32_t         deadline;
+    int              result;        /* 0 = GOOD, -1; valid once !busy       */
+    blockdev_req_t  *req;           /* request being run, NULL = one command */
+    uint32_t         done;          /* blocks of req already transferred    */
+    uint32_t         chunk;         /* blocks in the current command        */
+    uas_cmd_iu_t     iu;
+    uas_sense_iu_t   status;        /* Sense or Response IU lands here      */
+} uas_tag_t;
+
+typedef struct {
+    usb_device_t    *dev;
+    usb_interface_t *intf;          /* the UAS alternate setting            */
+    usb_endpoint_t  *pipe[5];       /* indexed by UAS_PIPE_*                */
+    int              ntags;         /* streams granted by xHCI              */
+    int              reset;         /* pipes need uas_reset()               */
+    int              dead;          /* pipes could not be re-established    */
+    int              quiet;         /* no per-command failure logs (probe)  */
+    uint64_t         capacity;      /* sectors                              */
+    uint32_t         block_size;
+    int              rw16;          /* READ/WRITE(16): disc past 2 TiB      */
+    blockdev_t      *bdev;
+    blockdev_reqq_t  ioq;           /* submitted, not yet on a tag          */
+    uas_tag_t        tag[UAS_TAGS + 1];
+} uas_dev_t;
+
+static uas_dev_t *uas_devs[UAS_MAX_DEVS];
+static int uas_dev_count = 0;
+
+/* ── Wall-clock helpers (CNTPCT_EL0 @ 54 MHz on BCM2711) ────────────────── */
+static inline uint32_t uas_time_ms(void) {
+    uint64_t v;
+    asm volatile("isb; mrs %0, cntpct_el0" : "=r"(v) :: "memory");
+    return (uint32_t)(v / 54000ULL);
+}
+
+static void uas_delay_ms(uint32_t ms) {
+    uint32_t deadline = uas_time_ms() + ms;
+    while (uas_time_ms() < deadline)
+        asm volatile("nop");
+}
+
+/* ── Command engine ───────────────────────────────────────────────────────── */
+
+/* Queue status, then data, then the Command IU — the device may answer as
+ * soon as it sees the command, so its status and data TDs go first.      */
+static int uas_start(uas_dev_t *u, int tag)
+{
+    uas_tag_t *t = &u->tag[tag];
+
+    memset(&t->iu, 0, sizeof(t->iu));
+    t->iu.id     = UAS_IU_COMMAND;
+    t->iu.tag[0] = (uint8_t)(tag >> 8);
+    t->iu.tag[1] = (uint8_t)tag;
+    memcpy(t->iu.cdb, t->cdb, t->cdb_len);     /* LUN 0, SIMPLE task */
+    memset(&t->status, 0, sizeof(t->status));
+
+    t->pend     = UAS_P_CMD | UAS_P_STATUS | (t->len ? UAS_P_DATA : 0u);
+    t->failed   = 0;
+    t->retry    = 0;
+    t->deadline = uas_time_ms() + UAS_TIMEOUT;
+
+    usb_endpoint_t *dpipe = u->pipe[t->dir_in ? UAS_PIPE_DATA_IN : UAS_PIPE_DATA_OUT];
+    if (xhci_stream_submit(u->pipe[UAS_PIPE_STATUS], (uint16_t)tag,
+                           &t->status, sizeof(t->status)) < 0)
+        return -1;
+    if (t->len && xhci_stream_submit(dpipe, (uint16_t)tag, t->buf, t->len) < 0)
+        return -1;
+    if (xhci_stream_submit(u->pipe[UAS_PIPE_COMMAND], (uint16_t)tag,
+                           &t->iu, sizeof(t->iu)) < 0)
+        return -1;
+    return 0;
+}
+
+/* Point t at the next chunk of its request: one READ / WRITE of at most
+ * XHCI_STREAM_MAX_XFER bytes, 16-byte CDB when the LBA needs it.        */
+static void uas_rw_setup(uas_dev_t *u, uas_tag_t *t)
+{
+    blockdev_req_t *req = t->req;
+    uint32_t bsize = u->block_size ? u->block_size : 512u;
+    uint32_t max   = XHCI_STREAM_MAX_XFER / bsize;
+    uint32_t n     = req->count - t->done;
+    uint64_t lba   = req->lba + t->done;
+    int write      = (req->op == BLOCKDEV_WRITE);
+    if (max == 0) max = 1;
+    if (n > max) n = max;
+
+    memset(t->cdb, 0, sizeof(t->cdb));
+    if (u->rw16 || lba + n > 0x100000000ull) {
+        t->cdb[0] = write ? 0x8Au : 0x88u; /* WRITE(16) : READ(16) */
+        for (int i = 0; i < 8; i++)
+            t->cdb[2 + i] = (uint8_t)(lba >> (56 - 8 * i));
+        t->cdb[10] = (uint8_t)(n >> 24);
+        t->cdb[11] = (uint8_t)(n >> 16);
+        t->cdb[12] = (uint8_t)(n >>  8);
+        t->cdb[13] = (uint8_t) n;
+        t->cdb_len = 16;
+    } else {
+        t->cdb[0] = write ? 0x2Au : 0x28u; /* WRITE(10) : READ(10) */
+        t->cdb[2] = (uint8_t)(lba >> 24);
+        t->cdb[3] = (uint8_t)(lba >> 16);
+        t->cdb[4] = (uint8_t)(lba >>  8);
+        t->cdb[5] = (uint8_t) lba;
+        t->cdb[7] = (uint8_t)(n >> 8);
+        t->cdb[8] = (uint8_t) n;
+        t->cdb_len = 10;
+    }
+
+    t->chunk  = n;
+    t->buf    = (uint8_t *)req->buf + (size_t)t->done * bsize;
+    t->len    = n * bsize;
+    t->dir_in = write ? 0u : 1u;
+}
+
+/* The command on tag is over.  A request moves on to its next chunk or
+ * completes; a single command hands its result to the waiting caller.   */
+static void uas_end(uas_dev_t *u, int tag, int ok)
+{
+    uas_tag_t *t = &u->tag[tag];
+    blockdev_req_t *req = t->req;
+
+    if (!req) {
+        t->result = ok ? 0 : -1;
+        t->busy   = 0;
+        return;
+    }
+    if (ok) {
+        t->done += t->chunk;
+        if (t->done < req->count) {
+            uas_rw_setup(u, t);
+            t->retries = 0;
+            if (uas_start(u, tag) < 0) u->reset = 1;
+            return;
+        }
+    }
+    t->busy = 0;
+    t->req  = NULL;
+    blockdev_complete(req, ok ? (ssize_t)req->count : -1);
+}
+
+/* A Sense or Response IU arrived: GOOD, or note how the command failed */
+static void uas_status(uas_dev_t *u, int tag, uint32_t actual)
+{
+    uas_tag_t *t = &u->tag[tag];
+    uint16_t itag = (uint16_t)((t->status.tag[0] << 8) | t->status.tag[1]);
+
+    if (actual >= 16u && t->status.id == UAS_IU_SENSE && itag == tag) {
+        if (t->status.status == 0u) return;             /* GOOD */
+        uint16_t slen = (uint16_t)((t->status.sense_len[0] << 8) |
+                                    t->status.sense_len[1]);
+        uint8_t key = (slen >= 3u) ? (t->status.sense_data[2] & 0x0Fu) : 0u;
+        t->failed = 1;
+        t->retry  = (key == 0x06u);                     /* UNIT ATTENTION */
+        if (!u->quiet && !t->retry) {
+            uart_puts("[UAS] tag "); print_hex32((uint32_t)tag);
+            uart_puts(" op="); print_hex32(t->cdb[0]);
+            uart_puts(" status="); print_hex32(t->status.status);
+            uart_puts(" key="); print_hex32(key); uart_puts("\n");
+        }
+        return;
+    }
+    t->failed = 1;
+    if (!u->quiet) {
+        uart_puts("[UAS] tag "); print_hex32((uint32_t)tag);
+        if (t->status.id == UAS_IU_RESPONSE) {
+            uas_response_iu_t *r = (uas_response_iu_t *)&t->status;
+            uart_puts(" response code="); print_hex32(r->code);
+        } else {
+            uart_puts(" bad status IU id="); print_hex32(t->status.id);
+        }
+        uart_puts("\n");
+    }
+}
+
+/* LOGICAL UNIT RESET (UAS §6.2.3) aborts every command the device still
+ * holds, so the re-issued ones cannot collide with tags it thinks live.
+ * Sent on the last tag once the pipes are fresh.  Returns 0 if answered. */
+static int uas_lun_reset(uas_dev_t *u)
+{
+    static uint8_t tmf[16];
+    int tag = u->ntags;
+    uas_tag_t *t = &u->tag[tag];
+    uint32_t actual = 0;
+    int st = -1, cm = -1;
+
+    memset(tmf, 0, sizeof(tmf));
+    tmf[0] = UAS_IU_TASK_MGMT;
+    tmf[2] = (uint8_t)(tag >> 8);
+    tmf[3] = (uint8_t)tag;
+    tmf[4] = 0x08u;                                     /* LOGICAL UNIT RESET */
+    memset(&t->status, 0, sizeof(t->status));
+
+    if (xhci_stream_submit(u->pipe[UAS_PIPE_STATUS], (uint16_t)tag,
+                           &t->status, sizeof(t->status)) < 0 ||
+        xhci_stream_submit(u->pipe[UAS_PIPE_COMMAND], (uint16_t)tag,
+                           tmf, sizeof(tmf)) < 0)
+        return -1;
+
+    uint32_t deadline = uas_time_ms() + 1000u;
+    while ((st == 0 || st == -1 || cm == 0 || cm == -1) &&
+           uas_time_ms() < deadline) {
+        xhci_stream_poll(20);
+        if (cm <= 0) cm = xhci_stream_result(u->pipe[UAS_PIPE_COMMAND], (uint16_t)tag, NULL);
+        if (st <= 0) st = xhci_stream_result(u->pipe[UAS_PIPE_STATUS], (uint16_t)tag, &actual);
+    }
+    if (st <= 0 || cm <= 0) return -1;
+    return (t->status.id == UAS_IU_RESPONSE) ? 0 : -1;
+}
+
+/* Clear halts on all four pipes and rebuild their stream rings, which
+ * drops every queued TD, then run the busy tags again from the start.  */
+static void uas_reset(uas_dev_t *u)
+{
+    u->reset = 0;
+    uart_puts("[UAS] pipe reset\n");
+    for (int p = UAS_PIPE_COMMAND; p <= UAS_PIPE_DATA_OUT; p++)
+        usb_control_transfer(u->dev, 0x02u, 0x01u, 0x0000u,  /* CLEAR_FEATURE(HALT) */
+                             u->pipe[p]->bEndpointAddress, NULL, 0, 200);
+
+    if (xhci_alloc_streams(u->dev, &u->pipe[1], 4, u->ntags) < u->ntags ||
+        (uas_lun_reset(u) < 0 &&
+         xhci_alloc_streams(u->dev, &u->pipe[1], 4, u->ntags) < u->ntags)) {
+        uart_puts("[UAS] pipes lost — device offline\n");
+        u->dead = 1;
+    }
+
+    for (int tag = 1; tag <= u->ntags; tag++) {
+        uas_tag_t *t = &u->tag[tag];
+        if (!t->busy) continue;
+        if (u->dead || (t->failed && !t->retry) || t->retries >= UAS_RETRIES) {
+            uas_end(u, tag, 0);
+            continue;
+        }
+        t->retries++;
+        if (uas_start(u, tag) < 0) uas_end(u, tag, 0);
+    }
+}
+
+/* Collect completed stages; end, retry or time out each busy tag */
+static void uas_service(uas_dev_t *u, int timeout_ms)
+{
+    if (xhci_stream_poll(timeout_ms) < 0) u->reset = 1;
+    uint32_t now = uas_time_ms();
+
+    for (int tag = 1; tag <= u->ntags; tag++) {
+        uas_tag_t *t = &u->tag[tag];
+        if (!t->busy) continue;
+        uint32_t actual = 0;
+        int cc;
+
+        if (t->pend & UAS_P_CMD) {
+            cc = xhci_stream_result(u->pipe[UAS_PIPE_COMMAND], (uint16_t)tag, NULL);
+            if (cc != 0) {
+                t->pend &= (uint8_t)~UAS_P_CMD;
+                if (cc != XHCI_CC_SUCCESS) u->reset = 1;
+            }
+        }
+        if (t->pend & UAS_P_DATA) {
+            usb_endpoint_t *dp = u->pipe[t->dir_in ? UAS_PIPE_DATA_IN : UAS_PIPE_DATA_OUT];
+            cc = xhci_stream_result(dp, (uint16_t)tag, &actual);
+            if (cc != 0) {
+                t->pend &= (uint8_t)~UAS_P_DATA;
+                if (cc != XHCI_CC_SUCCESS && cc != XHCI_CC_SHORT_PKT) u->reset = 1;
+            }
+        }
+        if (t->pend & UAS_P_STATUS) {
+            cc = xhci_stream_result(u->pipe[UAS_PIPE_STATUS], (uint16_t)tag, &actual);
+            if (cc != 0) {
+                t->pend &= (uint8_t)~UAS_P_STATUS;
+                if (cc == XHCI_CC_SUCCESS || cc == XHCI_CC_SHORT_PKT)
+                    uas_status(u, tag, actual);
+                else
+                    u->reset = 1;
+            }
+        }
+        if (u->reset) continue;
+
+        if (!(t->pend & (UAS_P_CMD | UAS_P_STATUS))) {
+            if (!t->failed) {
+                if (!(t->pend & UAS_P_DATA)) uas_end(u, tag, 1);
+            } else if (t->pend & UAS_P_DATA) {
+                u->reset = 1;                   /* its data TD is still queued */
+            } else if (t->retry && t->retries < UAS_RETRIES) {
+                t->retries++;
+                if (uas_start(u, tag) < 0) u->reset = 1;
+            } else {
+                uas_end(u, tag, 0);
+            }
+        }
+        if (t->busy && (int32_t)(now - t->deadline) > 0) {
+            if (!u->quiet) {
+                uart_puts("[UAS] tag "); print_hex32((uint32_t)tag);
+                uart_puts(" timeout, op="); print_hex32(t->cdb[0]); uart_puts("\n");
+            }
+            u->reset = 1;
+        }
+    }
+    if (u->reset) uas_reset(u);
+}
+
+/* Put queued requests on free tags */
+static void uas_dispatch(uas_dev_t *u)
+{
+    blockdev_req_t *req;
+    if (u->dead) {
+        while ((req = blockdev_reqq_pop(&u->ioq)) != NULL)
+            blockdev_complete(req, -1);
+        return;
+    }
+    for (int tag = 1; tag <= u->ntags && u->ioq.head; tag++) {
+        uas_tag_t *t = &u->tag[tag];
+        if (t->busy) continue;
+        if ((req = blockdev_reqq_pop(&u->ioq)) == NULL) break;
+        t->busy    = 1;
+        t->req     = req;
+        t->done    = 0;
+        t->retries = 0;
+        uas_rw_setup(u, t);
+        if (uas_start(u, tag) < 0) u->reset = 1;
+    }
+}
+
+/* Start what fits, reap what finished.  Returns 1 while work remains. */
+static int uas_pump(uas_dev_t *u, int timeout_ms)
+{
+    int busy = 0;
+    uas_dispatch(u);
+    for (int tag = 1; tag <= u->ntags; tag++) busy |= u->tag[tag].busy;
+    if (busy || u->reset) {
+        uas_service(u, timeout_ms);
+        uas_dispatch(u);
+    }
+    busy = 0;
+    for (int tag = 1; tag <= u->ntags; tag++) busy |= u->tag[tag].busy;
+    return busy || __atomic_load_n(&u->ioq.head, __ATOMIC_ACQUIRE) != NULL;
+}
+
+/* One SCSI command on a free tag, waited for.  0 = GOOD, -1 otherwise. */
+static int uas_scsi_cmd(uas_dev_t *u, const uint8_t *cdb, uint8_t cdb_len,
+                        void *buf, uint32_t len, int dir_in)
+{
+    int tag = 0;
+    while (!u->dead) {
+        for (int i = 1; i <= u->ntags && !tag; i++)
+            if (!u->tag[i].busy) tag = i;
+        if (tag) break;
+        uas_pump(u, 20);
+    }
+    if (!tag) return -1;
+
+    uas_tag_t *t = &u->tag[tag];
+    t->busy    = 1;
+    t->req     = NULL;
+    t->retries = 0;
+    t->dir_in  = dir_in ? 1u : 0u;
+    t->buf     = (uint8_t *)buf;
+    t->len     = buf ? len : 0u;
+    t->cdb_len = cdb_len > 16 ? 16 : cdb_len;
+    memset(t->cdb, 0, sizeof(t->cdb));
+    memcpy(t->cdb, cdb, t->cdb_len);
+    if (uas_start(u, tag) < 0) u->reset = 1;
+
+    while (t->busy) uas_pump(u, 20);
+    return t->result;
+}
+
+/* ── blockdev_ops_t callbacks ─────────────────────────────────────────────── */
+
+/* Synchronous I/O rides the same queue as submitted requests */
+static ssize_t uas_rw(blockdev_t *bdev, uint64_t lba, uint32_t count,
+                      void *buf, int write)
+{
+    uas_dev_t *u = (uas_dev_t *)bdev->private;
+    blockdev_req_t req;
+    memset(&req, 0, sizeof(req));
+    req.dev   = bdev;
+    req.op    = write ? BLOCKDEV_WRITE : BLOCKDEV_READ;
+    req.lba   = lba;
+    req.count = count;
+    req.buf   = buf;
+
+    blockdev_reqq_push(&u->ioq, &req);
+    while (!req.done) uas_pump(u, 20);
+    return req.result < 0 ? -1 : (ssize_t)count;
+}
+
+static ssize_t uas_bdev_read(blockdev_t *bdev, uint64_t lba,
+                             uint32_t count, void *buf)
+{
+    return uas_rw(bdev, lba, count, buf, 0);
+}
+
+static ssize_t uas_bdev_write(blockdev_t *bdev, uint64_t lba,
+                              uint32_t count, const void *buf)
+{
+    return uas_rw(bdev, lba, count, (void *)buf, 1);
+}
+
+/* ── Asynchronous requests ────────────────────────────────────────────────
+ * Submitted requests queue per device and the UASio task keeps every
+ * device's tags filled from its queue, yielding between event-ring polls
+ * while commands are in flight and sleeping once all queues are empty.
+ * Before the scheduler runs, submit declines and the block layer calls
+ * read/write instead.                                                    */
+static task_t *uas_io_task = NULL;
+
+static void uas_io_worker(void)
+{
+    asm volatile("msr daifclr, #2" ::: "memory");   /* let evt_wait block */
+
+    for (;;) {
+        int busy = 0;
+        for (int i = 0; i < uas_dev_count; i++)
+            busy |= uas_pump(uas_devs[i], 1);
+        if (busy) { yield(); continue; }
+
+        /* Idle: sleep until uas_bdev_submit queues more work */
+        current_task->state = TASK_BLOCKED;
+        for (int i = 0; i < uas_dev_count; i++)
+            if (__atomic_load_n(&uas_devs[i]->ioq.head, __ATOMIC_ACQUIRE))
+                current_task->state = TASK_RUNNING;
+        if (current_task->state == TASK_BLOCKED) schedule();
+    }
+}
+
+static int uas_bdev_submit(blockdev_t *bdev, blockdev_req_t *req)
+{
+    uas_dev_t *u = (uas_dev_t *)bdev->private;
+    if (!current_task) return -1;                   /* no scheduler yet */
+    if (!uas_io_task)
+        uas_io_task = task_create("UASio", uas_io_worker, BLOCKDEV_IO_PRIORITY, 0);
+    if (!uas_io_task) return -1;
+
+    blockdev_reqq_push(&u->ioq, req);
+    task_wakeup(uas_io_task);
+    return 0;
+}
+
+static blockdev_ops_t uas_bdev_ops = {
+    .read   = uas_bdev_read,
+    .write  = uas_bdev_write,
+    .trim   = NULL,
+    .poll   = NULL,
+    .close  = NULL,
+    .submit = uas_bdev_submit,
+};
+
+/* ── Capacity ─────────────────────────────────────────────────────────────── *
+ * READ CAPACITY(10), then (16) when it stalls or the disc is past 2 TiB.  */
+static int uas_read_capacity(uas_dev_t *u)
+{
+    uint8_t cdb[16] = {0};
+    uint8_t data[32] = {0};
+    uint64_t last_lba = 0xFFFFFFFFull;
+    uint32_t blk_len = 0;
+
+    cdb[0] = 0x25;                                  /* READ CAPACITY(10) */
+    if (uas_scsi_cmd(u, cdb, 10, data, 8, 1) == 0) {
+        last_lba = ((uint32_t)data[0] << 24) | ((uint32_t)data[1] << 16) |
+                   ((uint32_t)data[2] <<  8) |  (uint32_t)data[3];
+        blk_len  = ((uint32_t)data[4] << 24) | ((uint32_t)data[5] << 16) |
+                   ((uint32_t)data[6] <<  8) |  (uint32_t)data[7];
+    }
+    if (last_lba == 0xFFFFFFFFull) {
+        memset(cdb, 0, sizeof(cdb));
+        cdb[0]  = 0x9Eu;                            /* SERVICE ACTION IN(16) */
+        cdb[1]  = 0x10u;                            /* READ CAPACITY         */
+        cdb[13] = 32u;
+        if (uas_scsi_cmd(u, cdb, 16, data, 32, 1) < 0) return -1;
+        last_lba = 0;
+        for (int i = 0; i < 8; i++) last_lba = (last_lba << 8) | data[i];
+        blk_len  = ((uint32_t)data[8]  << 24) | ((uint32_t)data[9]  << 16) |
+                   ((uint32_t)data[10] <<  8) |  (uint32_t)data[11];
+    }
+    if (blk_len == 0 || blk_len > 65536) {
+        uart_puts("[UAS] READ CAPACITY: bad block length, defaulting to 512\n");
+        blk_len = 512;
+    }
+    u->capacity   = last_lba + 1ULL;
+    u->block_size = blk_len;
+    u->rw16       = (u->capacity > 0xFFFFFFFFull);
+    return 0;
+}
+
+/* boot413: Block Limits VPD page, if Supported VPD Pages lists it.  UAS
+ * devices are SPC-4, so no version check; a refusal is a clean CHECK
+ * CONDITION.  Fills vpd (64 bytes); returns 0, or -1 if not offered.   */
+static int uas_block_limits(uas_dev_t *u, uint8_t *vpd)
+{
+    uint8_t cdb[6] = {0x12, 0x01, 0x00, 0, 64, 0};     /* INQUIRY, EVPD=1 */
+    uint8_t pages[64] = {0};
+    if (uas_scsi_cmd(u, cdb, 6, pages, sizeof(pages), 1) < 0 || pages[1] != 0x00u)
+        return -1;
+    int n = pages[3];
+    if (n > (int)sizeof(pages) - 4) n = (int)sizeof(pages) - 4;
+    for (int i = 0; i < n; i++) {
+        if (pages[4 + i] != 0xB0u) continue;
+        cdb[2] = 0xB0u;
+        memset(vpd, 0, 64);
+        if (uas_scsi_cmd(u, cdb, 6, vpd, 64, 1) < 0 || vpd[1] != 0xB0u)
+            return -1;
+        return 0;
+    }
+    return -1;
+}
+
+/* ── Probe ────────────────────────────────────────────────────────────────── */
+int uas_probe(usb_device_t *dev, usb_interface_t *intf)
+{
+    if (uas_dev_count >= UAS_MAX_DEVS) return -1;
+
+    usb_endpoint_t *pipe[5] = {0};
+    for (int i = 0; i < intf->endpoint_count; i++) {
+        usb_endpoint_t *ep = &intf->endpoints[i];
+        if ((ep->bmAttributes & 0x03u) == 0x02u &&
+            ep->pipe_id >= UAS_PIPE_COMMAND && ep->pipe_id <= UAS_PIPE_DATA_OUT)
+            pipe[ep->pipe_id] = ep;
+    }
+    for (int p = UAS_PIPE_COMMAND; p <= UAS_PIPE_DATA_OUT; p++) {
+        if (!pipe[p]) {
+            uart_puts("[UAS] probe: pipe usage descriptors incomplete\n");
+            return -1;
+        }
+    }
+    if (!pipe[UAS_PIPE_STATUS]->max_streams ||
+        !pipe[UAS_PIPE_DATA_IN]->max_streams ||
+        !pipe[UAS_PIPE_DATA_OUT]->max_streams) {
+        uart_puts("[UAS] probe: no bulk streams (not SuperSpeed)\n");
+        return -1;
+    }
+
+    uas_dev_t *u = kmalloc(sizeof(uas_dev_t));
+    if (!u) return -1;
+    memset(u, 0, sizeof(*u));
+    u->dev  = dev;
+    u->intf = intf;
+    for (int p = 0; p < 5; p++) u->pipe[p] = pipe[p];
+
+    /* SET_INTERFACE: switch the interface over to its UAS alternate */
+    uart_puts("[UAS] SET_INTERFACE alt="); print_hex32(intf->bAlternateSetting);
+    uart_puts("\n");
+    if (usb_control_transfer(dev, 0x01u, 0x0Bu, intf->bAlternateSetting,
+                             intf->bInterfaceNumber, NULL, 0, 500) < 0) {
+        uart_puts("[UAS] SET_INTERFACE failed\n");
+        goto revert;
+    }
+    u->ntags = xhci_alloc_streams(dev, &u->pipe[1], 4, UAS_TAGS);
+    if (u->ntags < 1) goto revert;
+
+    /* Same bring-up order as BOT: TUR until GOOD, INQUIRY, READ CAPACITY.
+     * Early failures (not ready, unit attention) are expected — stay quiet. */
+    u->quiet = 1;
+    uas_delay_ms(100);
+    int tur_ok = 0;
+    uint32_t tur_deadline = uas_time_ms() + 5000u;
+    while (!u->dead && uas_time_ms() < tur_deadline) {
+        static const uint8_t tur[6] = {0x00, 0, 0, 0, 0, 0};
+        if (uas_scsi_cmd(u, tur, 6, NULL, 0, 1) == 0) { tur_ok = 1; break; }
+        uas_delay_ms(100);
+    }
+    uart_puts(tur_ok ? "[UAS] Device ready\n" : "[UAS] TUR timeout\n");
+
+    char product[17] = {0};
+    {
+        uint8_t inq_cdb[6] = {0x12, 0, 0, 0, 36, 0};
+        uint8_t inq_buf[36] = {0};
+        if (uas_scsi_cmd(u, inq_cdb, 6, inq_buf, 36, 1) == 0) {
+            for (int i = 0; i < 16; i++) {
+                char c = (char)(inq_buf[16 + i] & 0x7Fu);
+                product[i] = (c >= 0x20) ? c : ' ';
+            }
+            uart_puts("[UAS] INQUIRY OK  product='"); uart_puts(product);
+            uart_puts("'\n");
+        }
+    }
+    if (u->dead || uas_read_capacity(u) < 0) {
+        uart_puts("[UAS] READ CAPACITY failed\n");
+        goto revert;
+    }
+    uint8_t vpd_b0[64];
+    int have_b0 = (uas_block_limits(u, vpd_b0) == 0);
+    u->quiet = 0;
+
+    uart_puts("[UAS] capacity="); print_hex32((uint32_t)(u->capacity >> 32));
+    print_hex32((uint32_t)u->capacity);
+    uart_puts(" sectors, block_size="); print_hex32(u->block_size);
+    uart_puts(", tags="); print_hex32((uint32_t)u->ntags); uart_puts("\n");
+
+    blockdev_t *bd = msc_register_disc(dev, u->capacity, u->block_size, product);
+    if (!bd) goto revert;
+    bd->private = u;
+    bd->ops     = &uas_bdev_ops;
+    u->bdev     = bd;
+    msc_set_limits(bd, have_b0 ? vpd_b0 : NULL, XHCI_STREAM_MAX_XFER, u->rw16);
+    bd->qdepth  = (uint32_t)u->ntags;   /* boot414: keep every tag busy */
+
+    uas_devs[uas_dev_count++] = u;
+    dev->class_private = u;
+    uart_puts("[UAS] USB Attached SCSI registered as '");
+    uart_puts(bd->name);
+    uart_puts("'\n");
+    return 0;
+
+revert:
+    /* Back to alternate 0 and plain bulk rings for BOT */
+    usb_control_transfer(dev, 0x01u, 0x0Bu, 0x0000u, intf->bInterfaceNumber,
+                         NULL, 0, 500);
+    xhci_configure_endpoints(dev);
+    kfree(u);
+    return -1;
+}
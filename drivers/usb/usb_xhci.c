@@ -84,6 +84,54 @@
  *   Expected if hypothesis correct: scratchpad canaries changed, event ring
  *   written, No-op CCE received, MFINDEX running, settle hse drops to 0.
  *   Expected if hypothesis wrong: identical failure — need new theory.
+ *
+ * boot410 zero-copy bulk (search "boot410"):
+ *   xhci_bulk_transfer builds CH-linked Normal TRB chains straight onto the
+ *   caller's buffer (split on 64 KB boundaries, cache-maintained by hand)
+ *   instead of copying through the 6 KB per-slot bounce buffer.
+ *
+ * boot411 pipelined BOT (search "boot411"):
+ *   xhci_bot_command queues CBW, data and CSW TDs together and sends the
+ *   next command's CBW the moment the CSW lands.
+ *
+ * boot412 bulk streams (search "boot412"):
+ *   xhci_alloc_streams gives a UAS device's pipes Stream Context Arrays
+ *   and per-stream rings; xhci_stream_submit/poll/result track one TD per
+ *   (endpoint, stream) so many tagged commands can be in flight at once.
+ *   Config parsing now reads SuperSpeed companion and UAS pipe-usage
+ *   descriptors.
+ *
+ * boot415 interrupt-driven events (search "boot415"):
+ *   xhci_irq_handler is registered on INTID 180 again.  It drains the
+ *   event ring into software queues — Transfer Events per slot, all else
+ *   on a controller queue — and waiters take from those instead of racing
+ *   each other for the ring.  Waits yield to other tasks instead of
+ *   spinning; with no MSI they drain the ring themselves (polled
+ *   fallback).  Command ring and EP0 users serialise on xhci_ctl_lock.
+ *
+ * boot416 per-endpoint completions (search "boot416"):
+ *   Transfer Events queue per (slot, DCI) from a shared node pool, and
+ *   EP0 and interrupt waits also match the event's TRB pointer against
+ *   the TRBs they queued; the interrupt path's 8-entry stash is gone.
+ *   The event ring gains a second 64-TRB segment (0x41C00) when ERST Max
+ *   allows, so a burst of stream completions cannot overrun it.
+ *
+ * boot417 pre-posted interrupt IN (search "boot417"):
+ *   xhci_interrupt_start() keeps INT_PREPOST TRBs queued on an interrupt
+ *   endpoint and evt_drain() hands each completion to the owner's
+ *   callback, re-posting the TRB at once; HID no longer polls with
+ *   timeouts.  xhci_service_events() drains for the polled fallback.
+ *
+ * boot418 event-driven hotplug (search "boot418"):
+ *   Port Status Change Events queue on evq_port; xhci_check_hotplug()
+ *   returns at once when it is empty and reads PORTSC only for the ports
+ *   the events name.  usb_hub.c arms each hub's status-change endpoint.
+ *
+ * boot419 concurrent enumeration (search "boot419"):
+ *   enumerate_port() is split into a per-root-port state machine (debounce,
+ *   reset, recovery as deadlines, stepped by xhci_enum_step()) and
+ *   port_address().  Finished devices go to usb_enum_ready(), which binds
+ *   class drivers in port order (usb_core.c).
  */
 
 #include "kernel.h"
@@ -117,10 +165,22 @@ static int cmd_address_device(uint8_t slot_id, uint8_t rh_port_1based,
                                uint32_t route, uint32_t speed,
                                uint8_t tt_hub_slot, uint8_t tt_port);
 static int ep0_get_device_descriptor(uint8_t slot_id, uint8_t *buf, int len);
-static void enumerate_port(int port);
+static void port_address(int port, uint32_t speed);
 static uint64_t cmd_ring_submit(uint32_t dw0, uint32_t dw1, uint32_t dw2, uint32_t type, uint32_t dw3_extra);
 static int xhci_wait_event(uint32_t ev[4], int timeout_ms);
+static int xhci_wait_eps(uint8_t slot_id, uint32_t dci_mask, uint32_t ev[4],
+                         int timeout_ms);
+static int xhci_poll_eps(uint8_t slot_id, uint32_t dci_mask, uint32_t ev[4],
+                         int timeout_ms);
+static int xhci_wait_trb(uint8_t slot_id, uint8_t dci, uint64_t lo, uint64_t hi,
+                         uint32_t ev[4], int timeout_ms, int quiet);
 static int evt_ring_poll(uint32_t ev[4]);
+static void evq_flush_slot(uint8_t slot_id);
+static void evq_flush_ep(uint8_t slot_id, uint8_t dci);
+static int int_event(uint8_t slot_id, uint8_t dci, const uint32_t ev[4]);
+static void evq_flush_ctl(void);
+static void xhci_ctl_lock(void);
+static void xhci_ctl_unlock(void);
 
 /* ── All defines/globals from your original file ─────────────────────────── */
 #define CAP_CAPLENGTH   0x00
@@ -185,6 +245,7 @@ static int evt_ring_poll(uint32_t ev[4]);
 #define PORTSC_CCS      (1U <<  0)
 #define PORTSC_PED      (1U <<  1)
 #define PORTSC_PP       (1U <<  9)
+#define PORTSC_CSC      (1U << 17)      /* boot418: Connect Status Change */
 #define PORTSC_WIC      0x00FE0000U
 
 #define TRB_CYCLE           (1U <<  0)
@@ -196,6 +257,7 @@ static int evt_ring_poll(uint32_t ev[4]);
 #define TRB_TYPE_NOOP_CMD     23  /* xHCI §6.4.3.9 Command No-op — MCU keepalive ping */
 #define TRB_TYPE_RESET_EP     14  /* xHCI §6.4.3.8 Reset Endpoint — Halted → Stopped  */
 #define TRB_TYPE_STOP_EP      15  /* xHCI §6.4.3.7 Stop Endpoint Command              */
+#define TRB_TYPE_SET_TR_DEQ   16  /* xHCI §6.4.3.9 Set TR Dequeue Pointer             */
 #define TRB_TYPE_PORT_CHNG_EVT 34
 
 #define CC_SUCCESS          1
@@ -213,9 +275,14 @@ static int evt_ring_poll(uint32_t ev[4]);
 #define DMA_ERST_OFF          0x1040  /* was 0x1000 – moved to avoid MSI BAR collision */
 #define DMA_SCRATCH_OFF       0x1080  /* was 0x1040 */
 #define DMA_SCRATCH_PAGES_OFF 0x2000
+/* boot416: second event ring segment in the 1 KB left free after the
+ * stream area (0x41C00–0x42000); the first keeps 0x0C00–0x1000.        */
+#define DMA_EVT_SEG1_OFF      0x41C00
 
 #define CMD_RING_TRBS    64
-#define EVT_RING_TRBS    64
+#define EVT_SEG_TRBS     64     /* boot416: one 1 KB segment              */
+#define EVT_RING_SEGS    2      /* boot416: was a single 64-TRB segment   */
+#define EVT_RING_TRBS    (EVT_SEG_TRBS * EVT_RING_SEGS)
 #define MAX_SCRATCH_PAGES 64
 
 extern char __xhci_dma_start[];
@@ -223,9 +290,16 @@ extern char __xhci_dma_start[];
 
 static volatile uint64_t *dcbaa;
 static volatile uint32_t *cmd_ring;
-static volatile uint32_t *evt_ring;
+static volatile uint32_t *evt_ring;      /* segment 0 */
 static volatile uint64_t *erst;
 
+/* boot416: event ring segments.  evt_nsegs is EVT_RING_SEGS unless the
+ * controller's ERST Max allows fewer; evt_dequeue indexes the ring as a
+ * whole, segment after segment.                                        */
+static volatile uint32_t *evt_seg[EVT_RING_SEGS];
+static uint64_t evt_seg_dma[EVT_RING_SEGS];
+static uint32_t evt_nsegs = 1;
+
 static uint32_t evt_dequeue = 0;
 static uint8_t  evt_cycle   = 1;  /* xHCI spec §4.9.3: event ring PCS/CCS = 1 after reset.
                                     * Ring is zeroed (all TRBs cycle=0). With CCS=1, zero TRBs
@@ -248,9 +322,9 @@ static uint32_t cmd_enqueue = 0;
 /* boot147: g_slot_id scalar replaced by g_slot_ids[port] array (below) */
 
 /* boot87: pending_event / pending_event_ready removed.
- * xhci_wait_event now uses pure CNTPCT_EL0 tight-poll — no WFI,
- * no IRQ-staged fast path.  VL805 MSI→GIC confirmed non-functional
- * on BCM2711 after 86 boots; polling is the definitive approach.    */
+ * xhci_wait_event used a pure CNTPCT_EL0 tight-poll — no WFI, no
+ * IRQ-staged fast path.  boot415 brings the IRQ path back as software
+ * event queues fed by xhci_irq_handler — see "Event ring + IRQ + MSI". */
 
 /*
  * msi_fire_count — incremented every time xhci_irq_handler is entered.
@@ -260,6 +334,9 @@ static uint32_t cmd_enqueue = 0;
  */
 static volatile uint32_t msi_fire_count = 0;
 
+/* boot415: xhci_irq_handler may drain the event ring (set by xhci_init) */
+static volatile int evt_irq_ready = 0;
+
 /* boot297: TUR quiet mode — suppresses [xHCI] timeout lines during the
  * TEST UNIT READY retry loop so slow devices (Toshiba, cold-start bridges)
  * don't flood the log.  Set/cleared by xhci_set_quiet_timeouts().
@@ -512,6 +589,8 @@ static int read_caps(void) {
     xhci_ctrl.ac64 = (hcc1 >> 0) & 1;
     xhci_ctrl.csz  = (hcc1 >> 2) & 1;
     xhci_ctrl.xecp = (uint16_t)((hcc1 >> 16) & 0xFFFF);
+    xhci_ctrl.max_psa = (uint8_t)((hcc1 >> 12) & 0xF);   /* boot412: streams */
+    xhci_ctrl.erst_max = (uint8_t)((hcs2 >> 4) & 0xF);  /* boot416: segments */
 
     uint32_t rtsoff = readl(base + CAP_RTSOFF) & ~0x1FU;
     uint32_t dboff  = readl(base + CAP_DBOFF)  & ~0x03U;
@@ -672,8 +751,8 @@ static int setup_event_ring(void) {
     evt_ring = (volatile uint32_t *)(xhci_dma_buf + DMA_EVT_RING_OFF);
     erst     = (volatile uint64_t *)(xhci_dma_buf + DMA_ERST_OFF);
 
-    dma_zero(evt_ring, EVT_RING_TRBS * 16);
-    dma_zero(erst, 16);
+    dma_zero(evt_ring, EVT_SEG_TRBS * 16);
+    dma_zero(erst, 16 * EVT_RING_SEGS);
 
     uint64_t evt_phys  = (uint64_t)virt_to_phys((void *)evt_ring);
     uint64_t erst_phys = (uint64_t)virt_to_phys((void *)erst);
@@ -681,6 +760,17 @@ static int setup_event_ring(void) {
     uint64_t erst_dma  = phys_to_dma(erst_phys);
     evt_ring_dma  = evt_dma;
 
+    /* boot416: further segments, as many as ERST Max (2^n entries) allows */
+    evt_nsegs = (xhci_ctrl.erst_max >= 1) ? EVT_RING_SEGS : 1;
+    evt_seg[0]     = evt_ring;
+    evt_seg_dma[0] = evt_dma;
+    for (uint32_t i = 1; i < EVT_RING_SEGS; i++) {
+        evt_seg[i] = (volatile uint32_t *)(xhci_dma_buf + DMA_EVT_SEG1_OFF
+                                           + (i - 1) * EVT_SEG_TRBS * 16);
+        dma_zero(evt_seg[i], EVT_SEG_TRBS * 16);
+        evt_seg_dma[i] = phys_to_dma((uint64_t)virt_to_phys((void *)evt_seg[i]));
+    }
+
     /*
      * ERSTBA: boot 47 analysis — switch to real DMA address.
      *
@@ -711,22 +801,25 @@ static int setup_event_ring(void) {
 
     /* ERST entry in Normal-NC DMA buffer (primary: MCU reads from here) */
     volatile uint32_t *erst32 = (volatile uint32_t *)erst;
-    erst32[0] = (uint32_t)(evt_dma & 0xFFFFFFFFULL);
-    erst32[1] = (uint32_t)(evt_dma >> 32);
-    erst32[2] = EVT_RING_TRBS;
-    erst32[3] = 0;
+    for (uint32_t i = 0; i < evt_nsegs; i++) {
+        erst32[i * 4 + 0] = (uint32_t)(evt_seg_dma[i] & 0xFFFFFFFFULL);
+        erst32[i * 4 + 1] = (uint32_t)(evt_seg_dma[i] >> 32);
+        erst32[i * 4 + 2] = EVT_SEG_TRBS;
+        erst32[i * 4 + 3] = 0;
+    }
     asm volatile("dsb sy" ::: "memory");
 
     /* Also write ERST at physical address 0 (fallback if MCU truly ignores
      * ERSTBA MMIO and always reads from PCIe 0 — boot 27 behaviour).
-     * Cache-flush so any PCIe DMA-read at address 0 sees coherent data.  */
+     * Cache-flush so any PCIe DMA-read at address 0 sees coherent data.
+     * boot416: segment 0's entry only — the rest of the page is armstub. */
     {
         uintptr_t pa = 0;
         asm volatile("" : "+r"(pa));   /* opaque barrier: prevent GCC UB trap */
         volatile uint32_t *p = (volatile uint32_t *)pa;
         p[0] = (uint32_t)(evt_dma & 0xFFFFFFFFULL);
         p[1] = (uint32_t)(evt_dma >> 32);
-        p[2] = (uint32_t)EVT_RING_TRBS;
+        p[2] = (uint32_t)EVT_SEG_TRBS;
         p[3] = 0;
         /* dsb sy sufficient — phys 0 is Normal memory, no dc civac needed */
         asm volatile("dsb sy; isb" ::: "memory");
@@ -754,7 +847,8 @@ static int setup_event_ring(void) {
     uart_puts("[xHCI]   evt_ring DMA="); print_hex32((uint32_t)evt_dma);
     uart_puts("  erst_buf DMA="); print_hex32((uint32_t)erst_dma);
     uart_puts("  ERSTBA stored="); print_hex32((uint32_t)erst_dma_addr);
-    uart_puts("  size="); print_hex32(EVT_RING_TRBS); uart_puts("\n");
+    uart_puts("  size="); print_hex32(EVT_SEG_TRBS);
+    uart_puts(" x "); print_hex32(evt_nsegs); uart_puts(" segs\n");
 
     /* Readback verification */
     {
@@ -884,7 +978,7 @@ static int run_controller(void) {
      * "zero segments" and never consulting the event ring at all.  Circle
      * and Linux both set ERSTSZ before writing ERSTBA so the MCU always
      * sees a valid segment count when it reads the base address.           */
-    writel(1U, ir0 + IR_ERSTSZ);                       /* boot142: ERSTSZ first */
+    writel(evt_nsegs, ir0 + IR_ERSTSZ);                       /* boot142: ERSTSZ first */
     asm volatile("dsb sy; isb" ::: "memory");
     reg_write64(ir0, IR_ERSTBA_LO, erstba_dma);         /* then ERSTBA          */
     asm volatile("dsb sy; isb" ::: "memory");
@@ -1029,7 +1123,7 @@ static int run_controller(void) {
                     writel(cfg_val, op + OP_CONFIG);
                     reg_write64(op, OP_CRCR_LO, crcr_val);
                     asm volatile("dsb sy; isb" ::: "memory");
-                    writel(1U, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
+                    writel(evt_nsegs, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
                     asm volatile("dsb sy; isb" ::: "memory");
                     reg_write64(ir0, IR_ERSTBA_LO, erstba_dma); /* then ERSTBA */
                     asm volatile("dsb sy; isb" ::: "memory");
@@ -1169,7 +1263,7 @@ static int run_controller(void) {
             writel(cfg_val, op + OP_CONFIG);
             reg_write64(op, OP_CRCR_LO, crcr_val);
             asm volatile("dsb sy; isb" ::: "memory");
-            writel(1U, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
+            writel(evt_nsegs, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
             asm volatile("dsb sy; isb" ::: "memory");
             reg_write64(ir0, IR_ERSTBA_LO, erstba_dma); /* then ERSTBA */
             asm volatile("dsb sy; isb" ::: "memory");
@@ -1373,7 +1467,7 @@ static int run_controller(void) {
         writel(cfg_val, op + OP_CONFIG);
         reg_write64(op, OP_CRCR_LO, crcr_val);
         asm volatile("dsb sy; isb" ::: "memory");
-        writel(1U, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
+        writel(evt_nsegs, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
         asm volatile("dsb sy; isb" ::: "memory");
         reg_write64(ir0, IR_ERSTBA_LO, erstba_dma); /* then ERSTBA */
         asm volatile("dsb sy; isb" ::: "memory");
@@ -1405,7 +1499,7 @@ static int run_controller(void) {
                 reg_write64(op, OP_DCBAAP_LO, dcbaa_dma);
                 reg_write64(op, OP_CRCR_LO, crcr_val);
                 asm volatile("dsb sy; isb" ::: "memory");
-                writel(1U, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
+                writel(evt_nsegs, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
                 asm volatile("dsb sy; isb" ::: "memory");
                 reg_write64(ir0, IR_ERSTBA_LO, erstba_dma); /* then ERSTBA */
                 asm volatile("dsb sy; isb" ::: "memory");
@@ -1527,7 +1621,7 @@ static int run_controller(void) {
                 writel(0U, _ir0 + IR_ERSTSZ);
                 reg_write64(_ir0, IR_ERSTBA_LO, erst_dma_addr);
                 asm volatile("dsb sy; isb" ::: "memory");
-                writel(1U, _ir0 + IR_ERSTSZ);
+                writel(evt_nsegs, _ir0 + IR_ERSTSZ);
                 asm volatile("dsb sy; isb" ::: "memory");
                 ERDP_REARM(_ir0, evt_ring_dma); /* boot107: EHB=0 arms interrupter */
                 evt_dequeue = 0; evt_cycle = 1;
@@ -1544,7 +1638,7 @@ static int run_controller(void) {
     /* Step 5: Power up ports.
      * Boot 39 finding: writing PP=1 to Port 1 (companion, DR=1) triggered
      * HSE with ~3ms delay, killing the Enable Slot window.  Skip the
-     * companion port here — enumerate_port() already skips it for WPR /
+     * companion port here — port_reset_start() already skips it for WPR /
      * device enumeration, so this write was always unnecessary.           */
     for (int p = 0; p < (int)xhci_ctrl.max_ports; p++) {
         uint32_t ps5 = readl(op + 0x400 + p * 0x10);
@@ -1595,7 +1689,7 @@ static int run_controller(void) {
             writel(cfg_val, op + OP_CONFIG);
             reg_write64(op, OP_CRCR_LO, crcr_val);
             asm volatile("dsb sy; isb" ::: "memory");
-            writel(1U, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
+            writel(evt_nsegs, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
             asm volatile("dsb sy; isb" ::: "memory");
             reg_write64(ir0, IR_ERSTBA_LO, erstba_dma); /* then ERSTBA */
             asm volatile("dsb sy; isb" ::: "memory");
@@ -1620,6 +1714,11 @@ static int run_controller(void) {
         uint32_t _dev[4];
         int _drained = 0;
         while (evt_ring_poll(_dev)) _drained++;
+        /* boot415: and any the No-op wait queued.  This also empties
+         * evq_port, which is safe only because it runs before any port
+         * scan — nothing after this point discards PSCEs wholesale;
+         * xhci_check_hotplug() filters them by CSC and port state.    */
+        evq_flush_ctl();
 #if XHCI_VERBOSE
         uart_puts("[xHCI] PSCEv drain: ");
         print_hex32((uint32_t)_drained);
@@ -1644,7 +1743,7 @@ static int run_controller(void) {
         writel(cfg_val, op + OP_CONFIG);
         reg_write64(op, OP_CRCR_LO, crcr_val);
         asm volatile("dsb sy; isb" ::: "memory");
-        writel(1U, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
+        writel(evt_nsegs, ir0 + IR_ERSTSZ);               /* boot142: ERSTSZ first */
         asm volatile("dsb sy; isb" ::: "memory");
         reg_write64(ir0, IR_ERSTBA_LO, erstba_dma); /* then ERSTBA */
         asm volatile("dsb sy; isb" ::: "memory");
@@ -1714,7 +1813,7 @@ static int run_controller(void) {
         uart_puts("[xHCI] [RING-DUMP] Full event ring (64 TRBs):\n");
         asm volatile("dsb sy; isb" ::: "memory");
         int any_mcu_wrote = 0;
-        for (int ti = 0; ti < EVT_RING_TRBS; ti++) {
+        for (int ti = 0; ti < EVT_SEG_TRBS; ti++) {
             uint32_t t0 = evt_trb0[ti * 4 + 0];
             uint32_t t1 = evt_trb0[ti * 4 + 1];
             uint32_t t2 = evt_trb0[ti * 4 + 2];
@@ -1753,7 +1852,7 @@ static int run_controller(void) {
         asm volatile("dsb sy; isb" ::: "memory"); /* phys 0 = Normal memory */
         /* Verify against expected values — only report on error */
         uint32_t exp0 = (uint32_t)(evt_dma & 0xFFFFFFFFULL);
-        uint32_t exp2 = EVT_RING_TRBS;
+        uint32_t exp2 = EVT_SEG_TRBS;
         if (p[0] != exp0 || p[2] != exp2) {
             uart_puts("[xHCI] *** PHYS 0 CORRUPTED! ***\n");
             uart_puts("[xHCI]   expected[0]="); print_hex32(exp0);
@@ -1957,6 +2056,10 @@ int xhci_init(void *base_addr) {
     usb_register_hc(&g_xhci_hc_ops);
     xhci_ctrl.initialized = 1;
 
+    /* boot415: the ring belongs to evt_drain() from here on — let the
+     * MSI handler feed the software queues.                            */
+    evt_irq_ready = 1;
+
     /* boot157: port_scan() removed from xhci_init().
      * pci_init() calls xhci_init() directly (step 7) before usb_init()
      * registers class drivers (step 8).  Calling port_scan() here means
@@ -2013,15 +2116,30 @@ int xhci_init(void *base_addr) {
  * Each slot gets BULK_STRIDE = 0x2000 (8KB):
  *   +0x000  Bulk OUT ring  (BULK_RING_TRBS × 16 = 1024 B)
  *   +0x400  Bulk IN  ring  (BULK_RING_TRBS × 16 = 1024 B)
- *   +0x800  DMA bounce buf (6144 B — covers 4K-native sectors)
+ *   +0x800  DMA bounce buf (4096 B — covers 4K-native sectors)
+ *   +0x1800 IN edge lines  (2 × 64 B — zero-copy head/tail, boot410)
+ *   +0x1900 CBW staging    (2 × 64 B — current + next command, boot411)
+ *   +0x1A00 CSW buffer     (64 B, boot411)
  * 8 slots × 0x2000 = 0x10000 → tops at 0x3A000 < 0x42000 DMA budget. */
 #define DMA_BULK_BASE_OFF    0x2A000
 #define BULK_STRIDE          0x2000
 #define BULK_OUT_RING_OFF    0x000
 #define BULK_IN_RING_OFF     0x400
 #define BULK_DATA_OFF        0x800
+#define BULK_EDGE_OFF        0x1800
+#define BULK_CBW_OFF(sel)    (0x1900u + (uint32_t)(sel) * 0x40u)
+#define BULK_CSW_OFF         0x1A00
 #define BULK_RING_TRBS       64
-#define BULK_MAX_XFER        6144u   /* max single transfer through bounce buf */
+#define BULK_MAX_XFER        4096u   /* max single transfer through bounce buf */
+/* boot410: zero-copy bulk TDs.  A TRB may not cross a 64 KB boundary
+ * (xHCI §4.11.7.1), so a 1 MB TD needs at most 17 data TRBs plus two
+ * bounce-buffer edge TRBs — well inside the 63 usable slots of a ring.
+ * Only phys 0–1 GB is reachable through the RC_BAR2 inbound window
+ * (PCIe 0xC0000000–0xFFFFFFFF); buffers above it fall back to bounce.   */
+#define BULK_TD_MAX_XFER     XHCI_BULK_TD_MAX_XFER
+#define BULK_TD_MAX_TRBS     24
+#define BULK_DIRECT_MIN      512u    /* below this the bounce copy is cheaper */
+#define BULK_DMA_LIMIT       0x40000000ULL
 
 /* boot253: per-slot interrupt endpoint rings (HID keyboard + mouse).
  * Placed immediately after the bulk area (0x3A000).
@@ -2035,12 +2153,34 @@ int xhci_init(void *base_addr) {
 #define INT_RING_TRBS        16    /* 16 × 16B = 256B per ring           */
 #define INT_REPORT_SIZE      64    /* max HID report (boot protocol = 8) */
 #define MAX_INT_EPS          2     /* interrupt endpoints per slot        */
+#define INT_PREPOST          4     /* boot417: TRBs kept queued = 0x100 / 64 */
+
+/* boot412: bulk streams for one UAS device (xHCI §4.12).
+ * Placed immediately after the interrupt area (0x3C000):
+ *   +0x0000  Stream Context Arrays (3 × 0x100; 8 entries × 16 B each)
+ *   +0x0400  stream rings (3 endpoints × 8 streams × 0x100, 16 TRBs each)
+ *   +0x1C00  per-stream aux (4 endpoints × 8 streams × 0x200):
+ *            384 B bounce + 2 × 64 B IN edge lines
+ * Ends at 0x41C00 < 0x42000 DMA budget.  Stream ID 0 is reserved, so an
+ * 8-entry Primary Stream Array gives IDs 1..7.  A 256 KB TD needs at most
+ * 5 data TRBs plus the 2 edge TRBs — inside the 15 usable ring slots.   */
+#define DMA_STREAM_BASE_OFF  0x3C000
+#define STREAM_IDS           8
+#define STREAM_RINGED_EPS    3       /* endpoints with stream rings        */
+#define STREAM_EPS           4       /* endpoints incl. plain (UAS command) */
+#define STREAM_CTX_OFF(r)    ((uint32_t)(r) * 0x100u)
+#define STREAM_RING_OFF(r, s) (0x400u + ((uint32_t)(r) * STREAM_IDS + (uint32_t)(s)) * 0x100u)
+#define STREAM_AUX_OFF(e, s)  (0x1C00u + ((uint32_t)(e) * STREAM_IDS + (uint32_t)(s)) * 0x200u)
+#define STREAM_EDGE_OFF      0x180u
+#define STREAM_BOUNCE        384u
+#define STREAM_RING_TRBS     16
 /* boot149: CTX_SIZE is no longer a compile-time constant.
  * CSZ bit in HCCPARAMS1 determines whether entries are 32 or 64 bytes.
  * read_caps() populates xhci_ctrl.csz; this macro reads it at runtime.  */
 #define CTX_SIZE  (xhci_ctrl.csz ? 64U : 32U)
 
 #define TRB_TYPE_NORMAL    1
+#define TRB_TYPE_NOOP_XFER 8     /* xHCI §6.4.1.4 No Op Transfer TRB */
 #define TRB_TYPE_SETUP     2
 #define TRB_TYPE_DATA      3
 #define TRB_TYPE_STATUS    4
@@ -2052,6 +2192,7 @@ int xhci_init(void *base_addr) {
 #define TRB_IDT    (1U << 6)
 #define TRB_IOC    (1U << 5)
 #define TRB_CHAIN  (1U << 4)   /* xHCI §6.4.1.2 DW3[4]: Chain — link to next TRB in same TD */
+#define TRB_ISP    (1U << 2)   /* xHCI §6.4.1.1 DW3[2]: Interrupt on Short Packet */
 #define TRB_DIR_IN (1U << 16)
 
 #define CC_SHORT_PKT  13
@@ -2079,6 +2220,18 @@ static uint32_t bulk_out_enq[MAX_SLOTS_ALLOC + 1]   = {0};
 static uint8_t  bulk_in_cycle[MAX_SLOTS_ALLOC + 1]  = {0};
 static uint32_t bulk_in_enq[MAX_SLOTS_ALLOC + 1]    = {0};
 
+/* boot411: pipelined BOT — a CBW sent ahead of its command (see
+ * xhci_bot_command).  Cleared whenever the slot's bulk rings are rebuilt. */
+static struct {
+    uint8_t  valid;         /* cbw[] already went out ahead of its command */
+    uint8_t  sel;           /* CBW bounce slot the next queued CBW uses    */
+    uint8_t  cbw[31];
+} bot_stage[MAX_SLOTS_ALLOC + 1];
+
+/* boot412: slot whose bulk pipes currently run streams, 0 = none.  Cleared
+ * whenever xhci_configure_endpoints() puts plain rings back.             */
+static uint8_t stream_slot = 0;
+
 /* boot253: per-slot interrupt IN endpoint state.
  * [slot][idx] where idx = 0 or 1 (up to MAX_INT_EPS per slot).
  * int_ep_dci[s][i]       — DCI of the i-th interrupt IN endpoint.
@@ -2090,56 +2243,19 @@ static uint8_t  int_ep_dci[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS];
 static uint8_t  int_ep_cycle[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS];
 static uint32_t int_ep_enq[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS];
 static uint8_t  int_ep_submitted[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS];
+static uint64_t int_ep_trb[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS];   /* boot416: armed TRB */
 static int      int_ep_count[MAX_SLOTS_ALLOC + 1];
 
-/* ── Interrupt Transfer Event Stash ──────────────────────────────────────
- * When polling for endpoint A, a Transfer Event for endpoint B (same slot)
- * can arrive first.  evt_ring_poll() consumes it (advances ERDP) — if we
- * discard it, the next poll for B finds the ring empty.  We stash stolen
- * Transfer Events here and return them to the right caller.               */
-#define EVT_STASH_SIZE 8
-static struct {
-    uint8_t  valid;
-    uint8_t  slot;
-    uint8_t  dci;
-    uint32_t ev[4];
-} evt_stash[EVT_STASH_SIZE];
-
-static void evt_stash_put(uint8_t slot, uint8_t dci, const uint32_t ev[4])
-{
-    /* Update in place if already stashed for same (slot,dci) */
-    for (int i = 0; i < EVT_STASH_SIZE; i++) {
-        if (evt_stash[i].valid && evt_stash[i].slot == slot && evt_stash[i].dci == dci) {
-            evt_stash[i].ev[0] = ev[0]; evt_stash[i].ev[1] = ev[1];
-            evt_stash[i].ev[2] = ev[2]; evt_stash[i].ev[3] = ev[3];
-            return;
-        }
-    }
-    for (int i = 0; i < EVT_STASH_SIZE; i++) {
-        if (!evt_stash[i].valid) {
-            evt_stash[i].valid = 1;
-            evt_stash[i].slot  = slot;
-            evt_stash[i].dci   = dci;
-            evt_stash[i].ev[0] = ev[0]; evt_stash[i].ev[1] = ev[1];
-            evt_stash[i].ev[2] = ev[2]; evt_stash[i].ev[3] = ev[3];
-            return;
-        }
-    }
-    /* Stash full — drop the event (rare, 8 slots should be enough) */
-}
+/* boot417: pre-posted endpoints (xhci_interrupt_start).  A non-NULL
+ * int_ep_cb routes the endpoint's completions to the owner's callback
+ * from evt_drain(); int_ep_slice[] records which INT_REPORT_SIZE slice of
+ * the data area each ring entry's TRB reads into.  All under evq_lock.  */
+static xhci_int_cb_t int_ep_cb[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS];
+static void    *int_ep_ctx[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS];
+static uint16_t int_ep_len[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS];
+static uint8_t  int_ep_posted[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS];
+static uint8_t  int_ep_slice[MAX_SLOTS_ALLOC + 1][MAX_INT_EPS][INT_RING_TRBS];
 
-static int evt_stash_get(uint8_t slot, uint8_t dci, uint32_t ev[4])
-{
-    for (int i = 0; i < EVT_STASH_SIZE; i++) {
-        if (evt_stash[i].valid && evt_stash[i].slot == slot && evt_stash[i].dci == dci) {
-            ev[0] = evt_stash[i].ev[0]; ev[1] = evt_stash[i].ev[1];
-            ev[2] = evt_stash[i].ev[2]; ev[3] = evt_stash[i].ev[3];
-            evt_stash[i].valid = 0;
-            return 1;
-        }
-    }
-    return 0;
-}
 static uint8_t  g_slot_ids[16] = {0};   /* root-hub: indexed by port0 (0-based) */
 static usb_device_t g_devs[MAX_SLOTS_ALLOC + 1];  /* indexed by slot_id     */
 
@@ -2236,6 +2352,21 @@ static inline volatile uint8_t *slot_bulk_data(uint8_t s) {
                                 + (uint32_t)(s - 1) * BULK_STRIDE
                                 + BULK_DATA_OFF);
 }
+static inline volatile uint8_t *slot_bulk_edge(uint8_t s) {
+    return (volatile uint8_t *)(xhci_dma_buf + DMA_BULK_BASE_OFF
+                                + (uint32_t)(s - 1) * BULK_STRIDE
+                                + BULK_EDGE_OFF);
+}
+static inline volatile uint8_t *slot_bulk_cbw(uint8_t s, int sel) {
+    return (volatile uint8_t *)(xhci_dma_buf + DMA_BULK_BASE_OFF
+                                + (uint32_t)(s - 1) * BULK_STRIDE
+                                + BULK_CBW_OFF(sel));
+}
+static inline volatile uint8_t *slot_bulk_csw(uint8_t s) {
+    return (volatile uint8_t *)(xhci_dma_buf + DMA_BULK_BASE_OFF
+                                + (uint32_t)(s - 1) * BULK_STRIDE
+                                + BULK_CSW_OFF);
+}
 
 /* boot253: interrupt endpoint ring and data buffer helpers (idx = 0 or 1) */
 static inline volatile uint32_t *slot_int_ring(uint8_t s, int idx) {
@@ -2267,10 +2398,12 @@ static void ep0_ring_init(uint8_t sid) {
 }
 
 /* boot147: ep0_enq uses active_slot to index the correct per-slot EP0 ring.
- * Caller must set active_slot = slot_id before the first ep0_enq() call.   */
-static void ep0_enq(uint32_t dw0, uint32_t dw1, uint32_t dw2, uint32_t type, uint32_t flags) {
+ * Caller must set active_slot = slot_id before the first ep0_enq() call.
+ * boot416: returns the TRB's bus address, for xhci_wait_trb().           */
+static uint64_t ep0_enq(uint32_t dw0, uint32_t dw1, uint32_t dw2, uint32_t type, uint32_t flags) {
     volatile uint32_t *ring = slot_ep0_ring(active_slot);
     uint32_t b = ep0_enqueue_s[active_slot] * 4;
+    uint64_t trb = phys_to_dma((uint64_t)virt_to_phys((void *)&ring[b]));
     ring[b + 0] = dw0;
     ring[b + 1] = dw1;
     ring[b + 2] = dw2;
@@ -2285,6 +2418,7 @@ static void ep0_enq(uint32_t dw0, uint32_t dw1, uint32_t dw2, uint32_t type, uin
         ep0_cycle_s[active_slot] ^= 1;
         ep0_enqueue_s[active_slot] = 0;
     }
+    return trb;
 }
 
 static void ep0_doorbell(uint8_t slot) {
@@ -2560,9 +2694,9 @@ static int ep0_get_device_descriptor(uint8_t slot_id, uint8_t *buf, int len) {
     uint32_t setup_lo = 0x80U | (USB_REQ_GET_DESCRIPTOR << 8) | ((uint32_t)USB_DESC_DEVICE << 24);
     uint32_t setup_hi = (uint32_t)len << 16;
 
-    ep0_enq(setup_lo, setup_hi, 8, TRB_TYPE_SETUP, TRB_IDT | (3U << 16));
-    ep0_enq((uint32_t)data_dma, (uint32_t)(data_dma >> 32), (uint32_t)len, TRB_TYPE_DATA, TRB_IOC | TRB_DIR_IN);
-    ep0_enq(0, 0, 0, TRB_TYPE_STATUS, TRB_IOC);
+    uint64_t td_lo  = ep0_enq(setup_lo, setup_hi, 8, TRB_TYPE_SETUP, TRB_IDT | (3U << 16));
+    uint64_t td_dat = ep0_enq((uint32_t)data_dma, (uint32_t)(data_dma >> 32), (uint32_t)len, TRB_TYPE_DATA, TRB_IOC | TRB_DIR_IN);
+    uint64_t td_sts = ep0_enq(0, 0, 0, TRB_TYPE_STATUS, TRB_IOC);
 
     ep0_doorbell(slot_id);
 
@@ -2574,6 +2708,8 @@ static int ep0_get_device_descriptor(uint8_t slot_id, uint8_t *buf, int len) {
      * completion, leaving the DMA buffer filled with zeroes from dma_zero().
      *
      * Filter loop: discard any event whose type != 32 or slot != slot_id.
+     * boot416: xhci_wait_trb() also drops completions for TRBs outside
+     * this TD, left on EP0 by an earlier request that timed out.
      * Use a 250ms outer deadline — FS/LS split transactions via a TT hub
      * take longer than HS direct transfers (bus speed 12 Mbps vs 480 Mbps).
      *
@@ -2588,7 +2724,7 @@ static int ep0_get_device_descriptor(uint8_t slot_id, uint8_t *buf, int len) {
     uint32_t deadline = get_time_ms() + 250U;
 
     while (get_time_ms() < deadline) {
-        if (xhci_wait_event(ev, 10) != 0) continue;
+        if (xhci_wait_trb(slot_id, 1, td_lo, td_dat, ev, 10, 0) != 0) continue;
         uint8_t etype = (ev[3] >> 10) & 0x3FU;
         uint8_t eslot = (ev[3] >> 24) & 0xFFU;
         if (etype == TRB_TYPE_XFER_EVT && eslot == slot_id) {
@@ -2620,7 +2756,7 @@ static int ep0_get_device_descriptor(uint8_t slot_id, uint8_t *buf, int len) {
 
     /* Drain the STATUS-stage TRB event (don't wait long — not critical). */
     uint32_t ev2[4];
-    xhci_wait_event(ev2, 20);
+    xhci_wait_trb(slot_id, 1, td_sts, td_sts, ev2, 20, 0);
 
     asm volatile("dsb sy; isb" ::: "memory");  /* DMA barrier before CPU read */
 
@@ -2648,7 +2784,62 @@ static int ep0_get_device_descriptor(uint8_t slot_id, uint8_t *buf, int len) {
     return actual;
 }
 
-static void enumerate_port(int port) {
+/* boot412: descriptors that trail an endpoint descriptor and describe it —
+ * the SuperSpeed Endpoint Companion (burst, bulk streams) and the UAS Pipe
+ * Usage descriptor.  Both config parsers pass every other descriptor here. */
+static void parse_ep_trailer(usb_interface_t *intf, const uint8_t *d)
+{
+    if (!intf || intf->endpoint_count == 0) return;
+    usb_endpoint_t *ep = &intf->endpoints[intf->endpoint_count - 1];
+
+    if (d[1] == 0x30u && d[0] >= 6u) {                 /* SS companion */
+        ep->max_burst = d[2];
+        if ((ep->bmAttributes & 0x03u) == 0x02u && (d[3] & 0x1Fu))
+            ep->max_streams = (uint16_t)(1u << (d[3] & 0x1Fu));
+    } else if (d[1] == 0x24u && d[0] == 4u &&
+               intf->bInterfaceClass == USB_CLASS_MSC) {  /* UAS pipe usage */
+        ep->pipe_id = d[2];
+    }
+}
+
+/* ── Root-port enumeration (boot419) ──────────────────────────────────────────
+ * Each root port runs its own state machine, stepped by xhci_enum_step()
+ * from usb_enum_run(): connect debounce, port reset and reset recovery are
+ * deadlines checked on every pass instead of delay loops, so all ports
+ * reset at once and one slow device no longer holds up the rest.  Each
+ * root port is its own bus, so resets can overlap freely.  Only the
+ * command ring / EP0 part, port_address() (Enable Slot onward), runs start
+ * to finish, under xhci_ctl_lock.  A port holds a usb_enum_claim() on its
+ * topology key from start to finish so class drivers bind in port order.
+ */
+#define RP_IDLE         0
+#define RP_DEBOUNCE     1       /* hotplug: CCS must hold RP_DEBOUNCE_MS      */
+#define RP_RESET        2       /* WPR (USB3) or PR (USB2 companion) running  */
+#define RP_PR_WAIT      3       /* USB3: WPR done, internal PR still running  */
+#define RP_RECOVER      4       /* reset recovery before Enable Slot          */
+
+#define RP_DEBOUNCE_MS  100     /* USB 2.0 §7.1.7.3 tATTDB                    */
+#define RP_RESET_MS     300
+#define RP_PR_MS        200
+#define RP_RECOVER_MS   100     /* boot142: 10 ms spec, 100 ms (Circle)       */
+
+typedef struct {
+    uint8_t  state;             /* RP_*                                       */
+    uint8_t  usb2;              /* USB2 companion: PR, not WPR                */
+    uint32_t deadline;          /* get_time_ms() when this state ends         */
+} rp_enum_t;
+
+static rp_enum_t rp_enum[16];   /* indexed like g_slot_ids[]                  */
+
+/*
+ * port_reset_start — check a root port and issue its reset.
+ *
+ * Returns 0 once a reset is running (*usb2 says which kind), -1 when the
+ * port has nothing to enumerate.  The CCS=0 link-recovery path (WPR, then
+ * a PP power cycle) still waits in place: it only runs on a port whose
+ * SS link dropped during cold-boot init.
+ */
+static int port_reset_start(int port, uint8_t *usb2) {
     void *op = xhci_ctrl.op_regs;
     uint32_t portsc = readl(op + 0x400 + port * 0x10);
 
@@ -2662,7 +2853,7 @@ static void enumerate_port(int port) {
     if (is_usb2_companion && !(portsc & PORTSC_CCS)) {
         uart_puts(": empty companion (DR=1, CCS=0, skipped)  PORTSC=");
         print_hex32(portsc); uart_puts("\n");
-        return;
+        return -1;
     }
     if (is_usb2_companion)
         uart_puts(": USB2 companion fallback (DR=1, CCS=1)");
@@ -2715,38 +2906,27 @@ static void enumerate_port(int port) {
             if (!(portsc & PORTSC_CCS)) {
                 uart_puts(": device not recovered after WPR+PP  PORTSC=");
                 print_hex32(portsc); uart_puts("\n");
-                return;
+                return -1;
             }
             uart_puts(": device RECOVERED  PORTSC=");
             print_hex32(portsc); uart_puts("\n");
             /* Fall through to the normal WPR + Enable Slot path below */
         } else {
             uart_puts(": not connected (PORTSC="); print_hex32(portsc); uart_puts(")\n");
-            return;
+            return -1;
         }
     }
 
     uart_puts(": CONNECTED  PORTSC=");
     print_hex32(portsc); uart_puts("\n");
 
-    uint32_t ps = portsc;
+    *usb2 = (uint8_t)is_usb2_companion;
     if (is_usb2_companion) {
         /* USB2 companion port: Port Reset (PR, bit 4) — WPR is SS-only.
          * boot80: device fell back from failed USB3 link to this USB2 port.
          * PR brings the port to Enabled (PED=1) with speed in bits[13:10]. */
         uart_puts("[xHCI] USB2 companion: issuing PR (bit 4)...\n");
         writel(PORTSC_PP | (1U << 4), op + 0x400 + port * 0x10);
-        asm volatile("dsb sy" ::: "memory");
-        for (int t = 0; t < 300; t++) {
-            fast_delay_ms(1);
-            ps = readl(op + 0x400 + port * 0x10);
-            if (!(ps & (1U << 4))) break;   /* PR cleared → reset done */
-        }
-        uart_puts("[xHCI] PR done. PORTSC="); print_hex32(ps); uart_puts("\n");
-        if (!(ps & PORTSC_CCS)) {
-            uart_puts("[xHCI] Device lost after PR — aborting\n");
-            return;
-        }
     } else {
         /* USB3: Warm Port Reset (WPR, bit 31) — triggers an internal PR.   */
         uart_puts("[xHCI] Issuing single WPR...\n");
@@ -2755,52 +2935,135 @@ static void enumerate_port(int port) {
          * Clean write only: do NOT copy snapshot bits (W1C bits in snapshot
          * can re-trigger change events and generate extra MCU PSCEv).         */
         writel((1U << 31) | PORTSC_PP, op + 0x400 + port * 0x10);
-        asm volatile("dsb sy" ::: "memory");
+    }
+    asm volatile("dsb sy" ::: "memory");
+    return 0;
+}
 
-        for (int t = 0; t < 300; t++) {
-            fast_delay_ms(1);
-            ps = readl(op + 0x400 + port * 0x10);
-            /* Boot 54: waiting for WPR=0 AND PED=1 caused 300ms timeout when
-             * link training failed (PED never became 1 — PR stuck at 1).
-             * Fix: break as soon as WPR bit (bit 31) clears — reset completed
-             * regardless of whether USB3 link trained.  PED=1 is checked after
-             * the speed read to decide if enumeration can proceed.            */
-            if (!(ps & (1U << 31))) break;
+/* Leave the state machine; the port's device, if any, is queued by now */
+static void rp_finish(int port)
+{
+    rp_enum[port].state = RP_IDLE;
+    usb_enum_release(USB_ENUM_KEY(port + 1, 0));
+}
+
+/* Start (or restart) enumeration of a root port.  debounce: a hotplug
+ * connect — wait for the contact to settle before resetting.         */
+static void rp_start(int port, int debounce)
+{
+    rp_enum_t *rp = &rp_enum[port];
+
+    if (port < 0 || port >= 16) return;
+    if (rp->state == RP_IDLE)
+        usb_enum_claim(USB_ENUM_KEY(port + 1, 0));
+    if (debounce) {
+        rp->state    = RP_DEBOUNCE;
+        rp->deadline = get_time_ms() + RP_DEBOUNCE_MS;
+        return;
+    }
+    if (port_reset_start(port, &rp->usb2) != 0) { rp_finish(port); return; }
+    rp->state    = RP_RESET;
+    rp->deadline = get_time_ms() + RP_RESET_MS;
+}
+
+/* Abandon a port's enumeration — its device went away */
+static void rp_stop(int port)
+{
+    if (port >= 0 && port < 16 && rp_enum[port].state != RP_IDLE)
+        rp_finish(port);
+}
+
+static void rp_step(int port)
+{
+    rp_enum_t *rp  = &rp_enum[port];
+    void      *op  = xhci_ctrl.op_regs;
+    uint32_t   now = get_time_ms();
+    int        due = (int32_t)(now - rp->deadline) >= 0;
+    uint32_t   ps  = readl(op + 0x400 + port * 0x10);
+
+    switch (rp->state) {
+    case RP_DEBOUNCE:
+        if (!(ps & PORTSC_CCS)) {
+            uart_puts("[xHCI] Port "); print_hex32(port + 1);
+            uart_puts(": connect bounced — ignored\n");
+            rp_finish(port);
+            return;
         }
-        uart_puts("[xHCI] WPR done. PORTSC="); print_hex32(ps); uart_puts("\n");
+        if (!due) return;
+        if (port_reset_start(port, &rp->usb2) != 0) { rp_finish(port); return; }
+        rp->state    = RP_RESET;
+        rp->deadline = now + RP_RESET_MS;
+        return;
 
+    case RP_RESET:
+        /* Boot 54: break as soon as WPR (bit 31) / PR (bit 4) clears —
+         * reset completed whether or not the USB3 link trained; PED is
+         * judged by Address Device.                                     */
+        if ((ps & (rp->usb2 ? (1U << 4) : (1U << 31))) && !due) return;
+        uart_puts(rp->usb2 ? "[xHCI] PR done. PORTSC=" : "[xHCI] WPR done. PORTSC=");
+        print_hex32(ps); uart_puts("\n");
         if (!(ps & PORTSC_CCS)) {
-            uart_puts("[xHCI] Device lost after WPR — aborting\n");
+            uart_puts(rp->usb2 ? "[xHCI] Device lost after PR — aborting\n"
+                               : "[xHCI] Device lost after WPR — aborting\n");
+            rp_finish(port);
             return;
         }
 
         /* Clear W1C change bits with clean write (WRC, CSC, PRC etc.).
          * Do NOT copy snapshot: PED is RW1C on USB3 and snapshot copy
-         * would disable the port.                                             */
+         * would disable the port.  boot419: on the companion port too —
+         * a CSC left set there would replay as a plug in
+         * xhci_check_hotplug().                                          */
         writel(PORTSC_WIC | PORTSC_PP, op + 0x400 + port * 0x10);
         asm volatile("dsb sy" ::: "memory");
 
-        /* Boot 54: speed=0 because PR bit (bit 4) was still set when speed was
-         * read (port reset still in progress).  Wait for PR=0 — up to 200ms —
-         * before reading speed.  PR clears when the standard port reset (that
-         * follows WPR internally) completes and port is addressed.            */
-        for (int t = 0; t < 200; t++) {
-            fast_delay_ms(1);
-            ps = readl(op + 0x400 + port * 0x10);
-            if (!(ps & (1U << 4))) break;   /* PR cleared */
+        /* Boot 54: speed=0 because PR bit (bit 4) was still set when speed
+         * was read.  After WPR wait for PR=0 — up to 200ms — before reading
+         * speed.  PR clears when the standard port reset (that follows WPR
+         * internally) completes.                                          */
+        rp->state    = rp->usb2 ? RP_RECOVER : RP_PR_WAIT;
+        rp->deadline = now + (rp->usb2 ? RP_RECOVER_MS : RP_PR_MS);
+        return;
+
+    case RP_PR_WAIT:
+        if ((ps & (1U << 4)) && !due) return;
+        rp->state    = RP_RECOVER;
+        rp->deadline = now + RP_RECOVER_MS;
+        return;
+
+    case RP_RECOVER:
+        /* boot142: USB 2.0 reset recovery = 10ms minimum (spec) / 100ms
+         * (Circle) before Enable Slot, so the device is ready and the MCU
+         * has posted any pending PSCEv TRBs.                             */
+        if (!due) return;
+        {
+            uint32_t speed = (ps >> 10) & 0xF;
+            uart_puts("[xHCI] Port reset done. PORTSC="); print_hex32(ps);
+            uart_puts("  speed="); print_hex32(speed); uart_puts("\n");
+            xhci_ctl_lock();
+            port_address(port, speed);
+            xhci_ctl_unlock();
         }
+        rp_finish(port);
+        return;
     }
+}
 
-    ps = readl(op + 0x400 + port * 0x10);
-    uint32_t speed = (ps >> 10) & 0xF;
-    uart_puts("[xHCI] Port reset done. PORTSC="); print_hex32(ps);
-    uart_puts("  speed="); print_hex32(speed); uart_puts("\n");
-
-    /* boot142: USB 2.0 reset recovery = 10ms minimum (spec) / 100ms (Circle).
-     * Wait here before issuing Enable Slot so the device has time to become
-     * ready and so the MCU has time to post any pending PSCEv TRBs.       */
-    for (int t = 0; t < 100; t++) fast_delay_ms(1);
+/* xhci_enum_step — advance every root port being enumerated (boot419) */
+void xhci_enum_step(void)
+{
+    if (!xhci_ctrl.initialized) return;
+    for (int p = 0; p < (int)xhci_ctrl.max_ports && p < 16; p++)
+        if (rp_enum[p].state != RP_IDLE) rp_step(p);
+}
 
+/*
+ * port_address — Enable Slot, Address Device and descriptor fetch for a
+ * root port whose reset has completed (boot419: was the back half of
+ * enumerate_port()).  The device is queued with usb_enum_ready(); the
+ * class drivers bind from usb_enum_run() in port order.
+ */
+static void port_address(int port, uint32_t speed) {
     /* ── Step 1: Enable Slot ─────────────────────────────────────────── */
     /* boot144: wait for Enable Slot CCE so we get the real MCU-assigned slot_id.
      * boot145 fixes:
@@ -2841,6 +3104,7 @@ static void enumerate_port(int port) {
     /* boot147: track per-port slot_id; set active_slot for ep0_enq() */
     g_slot_ids[(uint8_t)port] = slot_id;
     active_slot = slot_id;
+    evq_flush_slot(slot_id);        /* boot415: nothing stale from a previous owner */
     uart_puts("[xHCI] Using slot_id="); print_hex32(slot_id); uart_puts("\n");
 
     /* ── Step 2: Address Device ──────────────────────────────────────── */
@@ -2853,12 +3117,13 @@ static void enumerate_port(int port) {
     /* Build a minimal usb_device_t so control transfers work via g_hc_ops.
      * boot147: use g_devs[slot_id] (per-slot) instead of a single g_dev.
      * Store slot_id in hcd_private so xhci_control_transfer can find the ring. */
-    extern int usb_enumerate_device(usb_device_t *dev, int port);
     usb_device_t *dev = &g_devs[slot_id];
     memset(dev, 0, sizeof(*dev));
     dev->speed       = (uint8_t)speed;
     dev->address     = slot_id; /* xHCI assigns USB address via Address Device */
     dev->hcd_private = (void *)(uintptr_t)slot_id;
+    dev->enum_key    = USB_ENUM_KEY(port + 1, 0);   /* boot419 */
+    dev->root_port   = (uint8_t)(port + 1);         /* boot422 */
 
     /* ── Step 3: GET_DESCRIPTOR (Device, 18 bytes) ───────────────────── */
     /* VL805 quirk: MCU never writes transfer completion events.
@@ -2940,9 +3205,9 @@ static void enumerate_port(int port) {
          * Use slot-filtered event wait: the MSC on slot 2 may be generating
          * bulk Transfer Events concurrently — discard any event whose slot_id
          * field (DW3[31:24]) does not match our slot.                         */
-        ep0_enq(setup_lo, setup_hi, 8, TRB_TYPE_SETUP, TRB_IDT | (3U << 16));
-        ep0_enq((uint32_t)data_dma, (uint32_t)(data_dma >> 32), 9, TRB_TYPE_DATA, TRB_IOC | TRB_DIR_IN);
-        ep0_enq(0, 0, 0, TRB_TYPE_STATUS, TRB_IOC);
+        uint64_t td_lo  = ep0_enq(setup_lo, setup_hi, 8, TRB_TYPE_SETUP, TRB_IDT | (3U << 16));
+        uint64_t td_dat = ep0_enq((uint32_t)data_dma, (uint32_t)(data_dma >> 32), 9, TRB_TYPE_DATA, TRB_IOC | TRB_DIR_IN);
+        uint64_t td_sts = ep0_enq(0, 0, 0, TRB_TYPE_STATUS, TRB_IOC);
         ep0_doorbell(slot_id);
 
         /* Slot-filtered wait: data stage */
@@ -2950,7 +3215,7 @@ static void enumerate_port(int port) {
             int cfg9_found = 0;
             uint32_t cfg9_deadline = get_time_ms() + 250U;
             while (get_time_ms() < cfg9_deadline) {
-                if (xhci_wait_event(ev, 10) != 0) continue;
+                if (xhci_wait_trb((uint8_t)slot_id, 1, td_lo, td_dat, ev, 10, 0) != 0) continue;
                 uint8_t etype = (ev[3] >> 10) & 0x3FU;
                 uint8_t eslot = (ev[3] >> 24) & 0xFFU;
                 if (etype == TRB_TYPE_XFER_EVT && eslot == (uint8_t)slot_id) {
@@ -2967,7 +3232,7 @@ static void enumerate_port(int port) {
         {
             uint32_t cfg9s_deadline = get_time_ms() + 50U;
             while (get_time_ms() < cfg9s_deadline) {
-                if (xhci_wait_event(ev, 10) != 0) break;
+                if (xhci_wait_trb((uint8_t)slot_id, 1, td_sts, td_sts, ev, 10, 0) != 0) break;
                 uint8_t etype = (ev[3] >> 10) & 0x3FU;
                 uint8_t eslot = (ev[3] >> 24) & 0xFFU;
                 if (etype == TRB_TYPE_XFER_EVT && eslot == (uint8_t)slot_id) break;
@@ -2982,9 +3247,9 @@ static void enumerate_port(int port) {
         /* Fetch full config descriptor (slot-filtered) */
         dma_zero(ep0_data, 256);
         setup_hi = (uint32_t)total_len << 16;
-        ep0_enq(setup_lo, setup_hi, 8, TRB_TYPE_SETUP, TRB_IDT | (3U << 16));
-        ep0_enq((uint32_t)data_dma, (uint32_t)(data_dma >> 32), total_len, TRB_TYPE_DATA, TRB_IOC | TRB_DIR_IN);
-        ep0_enq(0, 0, 0, TRB_TYPE_STATUS, TRB_IOC);
+        td_lo  = ep0_enq(setup_lo, setup_hi, 8, TRB_TYPE_SETUP, TRB_IDT | (3U << 16));
+        td_dat = ep0_enq((uint32_t)data_dma, (uint32_t)(data_dma >> 32), total_len, TRB_TYPE_DATA, TRB_IOC | TRB_DIR_IN);
+        td_sts = ep0_enq(0, 0, 0, TRB_TYPE_STATUS, TRB_IOC);
         ep0_doorbell(slot_id);
 
         /* Slot-filtered wait: data stage */
@@ -2992,7 +3257,7 @@ static void enumerate_port(int port) {
             int cfgf_found = 0;
             uint32_t cfgf_deadline = get_time_ms() + 500U;  /* FS split = up to ~500ms */
             while (get_time_ms() < cfgf_deadline) {
-                if (xhci_wait_event(ev, 10) != 0) continue;
+                if (xhci_wait_trb((uint8_t)slot_id, 1, td_lo, td_dat, ev, 10, 0) != 0) continue;
                 uint8_t etype = (ev[3] >> 10) & 0x3FU;
                 uint8_t eslot = (ev[3] >> 24) & 0xFFU;
                 if (etype == TRB_TYPE_XFER_EVT && eslot == (uint8_t)slot_id) {
@@ -3008,7 +3273,7 @@ static void enumerate_port(int port) {
         {
             uint32_t cfgfs_deadline = get_time_ms() + 50U;
             while (get_time_ms() < cfgfs_deadline) {
-                if (xhci_wait_event(ev, 10) != 0) break;
+                if (xhci_wait_trb((uint8_t)slot_id, 1, td_sts, td_sts, ev, 10, 0) != 0) break;
                 uint8_t etype = (ev[3] >> 10) & 0x3FU;
                 uint8_t eslot = (ev[3] >> 24) & 0xFFU;
                 if (etype == TRB_TYPE_XFER_EVT && eslot == (uint8_t)slot_id) break;
@@ -3061,6 +3326,8 @@ static void enumerate_port(int port) {
                     ep->bInterval        = cfgbuf[pos + 6];
                     cur_intf->endpoint_count++;
                 }
+            } else {
+                parse_ep_trailer(cur_intf, &cfgbuf[pos]);
             }
             pos += bLen;
         }
@@ -3071,7 +3338,7 @@ static void enumerate_port(int port) {
 
 probe:
     /* ── Step 5: Hand off to USB core for class driver probe ─────────── */
-    usb_enumerate_device(dev, port);
+    usb_enum_ready(dev, port);          /* boot419: binds in port order */
 }
 
 static void port_scan(void) {
@@ -3112,10 +3379,12 @@ static void port_scan(void) {
     asm volatile("dsb sy" ::: "memory");
     uart_puts("[xHCI] DCBAA pre-allocation done.\n");
 
+    /* boot419: start every port's state machine; usb_enum_settle() runs
+     * them (the resets overlap) until the last device has bound.       */
     uart_puts("[xHCI] Port scan ("); print_hex32(n); uart_puts(" port(s)):\n");
-    for (int p = 0; p < n; p++)
-        enumerate_port(p);
-    uart_puts("[xHCI] Port scan complete\n");
+    for (int p = 0; p < n && p < 16; p++)
+        rp_start(p, 0);
+    uart_puts("[xHCI] Port scan: resets issued\n");
 }
 
 /* HCD callbacks */
@@ -3127,7 +3396,9 @@ int xhci_is_ready(void) { return xhci_ctrl.initialized; }
  */
 int xhci_scan_ports(void) {
     if (!xhci_ctrl.initialized) return 0;
+    xhci_ctl_lock();
     port_scan();
+    xhci_ctl_unlock();
     return 0;
 }
 
@@ -3140,7 +3411,7 @@ int xhci_scan_ports(void) {
  *   - Stores slot_id in ep->slot_id so xhci_bulk_transfer can find it
  *   - Builds the endpoint context (EP type, MPS, ring pointer)
  * Issues Configure Endpoint TRB (type 12) and waits for CCE.             */
-int xhci_configure_endpoints(usb_device_t *dev)
+static int configure_endpoints(usb_device_t *dev)
 {
     uint8_t slot_id = (uint8_t)(uintptr_t)dev->hcd_private;
     if (slot_id == 0 || slot_id > MAX_SLOTS_ALLOC) return -1;
@@ -3160,6 +3431,8 @@ int xhci_configure_endpoints(usb_device_t *dev)
     uint32_t add_flags = (1u << 0);/* bit0 = always include Slot context   */
     uint32_t max_dci   = 1;
 
+    if (stream_slot == slot_id) stream_slot = 0;   /* boot412: back to plain rings */
+
     /* Scan all interfaces for bulk and interrupt IN endpoints */
     for (int ii = 0; ii < dev->num_interfaces; ii++) {
         usb_interface_t *intf = &dev->interfaces[ii];
@@ -3199,6 +3472,7 @@ int xhci_configure_endpoints(usb_device_t *dev)
             dma_zero(ring, BULK_RING_TRBS * 16);
             *cycle_p = 1;
             *enq_p   = 0;
+            bot_stage[slot_id].valid = 0;
             uint64_t ring_dma = phys_to_dma((uint64_t)virt_to_phys((void *)ring));
             uint32_t li = (BULK_RING_TRBS - 1) * 4;
             ring[li + 0] = (uint32_t)(ring_dma);
@@ -3256,6 +3530,8 @@ int xhci_configure_endpoints(usb_device_t *dev)
                     if (i_dci > max_dci) max_dci = i_dci;
 
                     /* Initialise the interrupt transfer ring */
+                    int_ep_cb[slot_id][i_idx] = NULL;   /* boot417: TRBs gone */
+                    int_ep_posted[slot_id][i_idx] = 0u;
                     volatile uint32_t *iring = slot_int_ring(slot_id, i_idx);
                     dma_zero(iring, INT_RING_TRBS * 16);
                     uint64_t ird = phys_to_dma((uint64_t)virt_to_phys((void *)iring));
@@ -3343,6 +3619,14 @@ int xhci_configure_endpoints(usb_device_t *dev)
     return 0;
 }
 
+int xhci_configure_endpoints(usb_device_t *dev)
+{
+    xhci_ctl_lock();
+    int rc = configure_endpoints(dev);
+    xhci_ctl_unlock();
+    return rc;
+}
+
 /*
  * xhci_ep_recover — recover a USB mass storage device's bulk endpoints.
  *
@@ -3357,7 +3641,7 @@ int xhci_configure_endpoints(usb_device_t *dev)
  * The device-side CLEAR_HALT and BOT Mass Storage Reset are issued via EP0
  * (control transfers) by the MSC layer before calling this function.
  */
-int xhci_ep_recover(usb_device_t *dev)
+static int ep_recover(usb_device_t *dev)
 {
     uint8_t slot_id = (uint8_t)(uintptr_t)dev->hcd_private;
     if (slot_id == 0 || slot_id > MAX_SLOTS_ALLOC) return -1;
@@ -3398,6 +3682,14 @@ int xhci_ep_recover(usb_device_t *dev)
     return xhci_configure_endpoints(dev);
 }
 
+int xhci_ep_recover(usb_device_t *dev)
+{
+    xhci_ctl_lock();
+    int rc = ep_recover(dev);
+    xhci_ctl_unlock();
+    return rc;
+}
+
 /*
  * xhci_enumerate_hub_port — enumerate a device on a downstream hub port.
  *
@@ -3410,8 +3702,8 @@ int xhci_ep_recover(usb_device_t *dev)
  *
  * Returns 0 on success, -1 on failure.
  */
-int xhci_enumerate_hub_port(usb_device_t *hub_dev, uint8_t hub_port,
-                             uint32_t dev_speed) {
+static int enumerate_hub_port(usb_device_t *hub_dev, uint8_t hub_port,
+                               uint32_t dev_speed) {
     uint8_t hub_slot = (uint8_t)(uintptr_t)hub_dev->hcd_private;
     /* Root Hub Port of the new device = same as the hub's root hub port.
      * The hub's slot context DW1[21:16] holds the hub's root-hub port number. */
@@ -3456,6 +3748,7 @@ int xhci_enumerate_hub_port(usb_device_t *hub_dev, uint8_t hub_port,
 
     hc_reg(hub_slot, hub_port, slot_id);  /* register in hub-child registry */
     active_slot = slot_id;
+    evq_flush_slot(slot_id);              /* boot415 */
 
     /* ── Address Device ─────────────────────────────────────────────── */
     if (cmd_address_device(slot_id, rh_port, route, dev_speed,
@@ -3471,6 +3764,11 @@ int xhci_enumerate_hub_port(usb_device_t *hub_dev, uint8_t hub_port,
     dev->speed       = (uint8_t)dev_speed;
     dev->address     = slot_id;
     dev->hcd_private = (void *)(uintptr_t)slot_id;
+    /* boot419: keyed only behind a hub on a root port — deeper tiers
+     * would collide with their parent hub's key (see usb.h)          */
+    dev->enum_key    = (USB_ENUM_ON_ROOT(hub_dev->enum_key) && hub_port <= 15u)
+                     ? USB_ENUM_KEY(hub_dev->enum_key >> 4, hub_port) : 0u;
+    dev->root_port   = rh_port;                     /* boot422 */
 
     uint8_t ddesc[18];
     int got = ep0_get_device_descriptor(slot_id, ddesc, 18);
@@ -3548,6 +3846,7 @@ int xhci_enumerate_hub_port(usb_device_t *hub_dev, uint8_t hub_port,
                 if (dev->num_interfaces < USB_MAX_INTERFACES) {
                     cur_intf = &dev->interfaces[dev->num_interfaces++];
                     cur_intf->bInterfaceNumber   = cfgbuf[off+2];
+                    cur_intf->bAlternateSetting  = cfgbuf[off+3];
                     cur_intf->bInterfaceClass    = cfgbuf[off+5];
                     cur_intf->bInterfaceSubClass = cfgbuf[off+6];
                     cur_intf->bInterfaceProtocol = cfgbuf[off+7];
@@ -3564,9 +3863,12 @@ int xhci_enumerate_hub_port(usb_device_t *hub_dev, uint8_t hub_port,
                     ep->bInterval        = cfgbuf[off+6];
                     cur_intf->endpoint_count++;
                 }
+            } else if (off + blen <= tlen) {
+                /* boot412: SS companion (0x30) and UAS pipe usage (0x24)
+                 * fill in the endpoint before them; HID 0x21 etc. are
+                 * skipped as before.                                   */
+                parse_ep_trailer(cur_intf, &cfgbuf[off]);
             }
-            /* All other descriptor types (SS companion 0x30, HID 0x21, etc.)
-             * are skipped safely — we just advance by blen.               */
             off += blen;
         }
     }
@@ -3602,13 +3904,21 @@ int xhci_enumerate_hub_port(usb_device_t *hub_dev, uint8_t hub_port,
      * BEFORE handing the device to the USB class driver layer.         */
     xhci_configure_endpoints(dev);
 
-    extern int usb_enumerate_device(usb_device_t *dev, int port);
-    usb_enumerate_device(dev, (int)hub_port);
+    usb_enum_ready(dev, (int)hub_port);     /* boot419: binds in port order */
     return 0;
 }
 
+int xhci_enumerate_hub_port(usb_device_t *hub_dev, uint8_t hub_port,
+                            uint32_t dev_speed)
+{
+    xhci_ctl_lock();
+    int rc = enumerate_hub_port(hub_dev, hub_port, dev_speed);
+    xhci_ctl_unlock();
+    return rc;
+}
+
 int xhci_enumerate_device(usb_device_t *dev, int port) {
-    /* Address Device already done inline in enumerate_port().
+    /* Address Device already done inline in port_address().
      * dev->address is set; EP0 ring is ready.
      * Nothing more to do here — control transfers go via
      * xhci_control_transfer() which uses ep0_enq/doorbell. */
@@ -3624,9 +3934,9 @@ int xhci_enumerate_device(usb_device_t *dev, int port) {
  *
  * Direction: bmRequestType bit 7. 1=IN (device->host), 0=OUT (host->device).
  */
-int xhci_control_transfer(usb_device_t *dev, uint8_t req_type, uint8_t request,
-                           uint16_t value, uint16_t index, void *data,
-                           uint16_t length, int timeout) {
+static int control_transfer(usb_device_t *dev, uint8_t req_type, uint8_t request,
+                             uint16_t value, uint16_t index, void *data,
+                             uint16_t length, int timeout) {
     if (!dev) return -1;
     uint8_t slot_id = (uint8_t)(uintptr_t)dev->hcd_private;
     if (slot_id == 0) return -1;
@@ -3654,7 +3964,8 @@ int xhci_control_transfer(usb_device_t *dev, uint8_t req_type, uint8_t request,
      *   0=No Data, 2=OUT Data, 3=IN Data */
     uint32_t xfer_type = (length == 0) ? 0U : (dir_in ? 3U : 2U);
 
-    ep0_enq(setup_lo, setup_hi, 8, TRB_TYPE_SETUP, TRB_IDT | (xfer_type << 16));
+    uint64_t td_lo  = ep0_enq(setup_lo, setup_hi, 8, TRB_TYPE_SETUP, TRB_IDT | (xfer_type << 16));
+    uint64_t td_dat = td_lo;        /* boot416: last TRB of the data stage */
 
     if (length > 0) {
         if (dir_in && length > 8U) {
@@ -3686,21 +3997,22 @@ int xhci_control_transfer(usb_device_t *dev, uint8_t req_type, uint8_t request,
                     8U,
                     TRB_TYPE_DATA,
                     TRB_DIR_IN | TRB_CHAIN);              /* TRB1: 8 bytes, chain on */
-            ep0_enq((uint32_t)(data_dma + 8ULL),
+            td_dat = ep0_enq((uint32_t)(data_dma + 8ULL),
                     (uint32_t)((data_dma + 8ULL) >> 32),
                     (uint32_t)(length - 8U),
                     TRB_TYPE_DATA,
                     TRB_DIR_IN | TRB_IOC);                /* TRB2: remainder, event here */
         } else {
             uint32_t data_flags = TRB_IOC | (dir_in ? TRB_DIR_IN : 0);
-            ep0_enq((uint32_t)data_dma, (uint32_t)(data_dma >> 32),
+            td_dat = ep0_enq((uint32_t)data_dma, (uint32_t)(data_dma >> 32),
                     (uint32_t)length, TRB_TYPE_DATA, data_flags);
         }
     }
 
     /* Status TRB direction is opposite to data phase */
     uint32_t status_flags = TRB_IOC | (dir_in ? 0 : TRB_DIR_IN);
-    ep0_enq(0, 0, 0, TRB_TYPE_STATUS, status_flags);
+    uint64_t td_sts = ep0_enq(0, 0, 0, TRB_TYPE_STATUS, status_flags);
+    if (length == 0) td_dat = td_sts;   /* no data stage: Status carries the IOC */
 
     ep0_doorbell(slot_id);
 
@@ -3714,7 +4026,8 @@ int xhci_control_transfer(usb_device_t *dev, uint8_t req_type, uint8_t request,
      *
      * The VL805 may still fire per-packet CC=1/residual≠0 intermediate events
      * for non-split HS transfers; we consume those and keep waiting.
-     * Events for other slots are silently discarded.
+     * Events for other slots are silently discarded, and since boot416 so
+     * are events for TRBs outside this TD's setup/data stages.
      */
     uint32_t ev[4]    = {0,0,0,0};
     uint8_t  cc       = 0;
@@ -3723,7 +4036,7 @@ int xhci_control_transfer(usb_device_t *dev, uint8_t req_type, uint8_t request,
     uint32_t ct_deadline = get_time_ms() + (uint32_t)(timeout > 0 ? timeout : 500);
 
     while (get_time_ms() < ct_deadline) {
-        if (xhci_wait_event(ev, 10) != 0) continue;
+        if (xhci_wait_trb(slot_id, 1, td_lo, td_dat, ev, 10, 0) != 0) continue;
         uint8_t etype = (ev[3] >> 10) & 0x3FU;
         uint8_t eslot = (ev[3] >> 24) & 0xFFU;
         if (etype != TRB_TYPE_XFER_EVT || eslot != slot_id) continue; /* discard */
@@ -3762,7 +4075,7 @@ int xhci_control_transfer(usb_device_t *dev, uint8_t req_type, uint8_t request,
         uint32_t ev2[4];
         uint32_t drain_dl = get_time_ms() + 50U;
         while (get_time_ms() < drain_dl) {
-            if (xhci_wait_event(ev2, 10) != 0) break;
+            if (xhci_wait_trb(slot_id, 1, td_sts, td_sts, ev2, 10, 0) != 0) break;
             uint8_t et2 = (ev2[3] >> 10) & 0x3FU;
             uint8_t es2 = (ev2[3] >> 24) & 0xFFU;
             if (et2 == TRB_TYPE_XFER_EVT && es2 == slot_id) break; /* consumed */
@@ -3780,149 +4093,954 @@ int xhci_control_transfer(usb_device_t *dev, uint8_t req_type, uint8_t request,
     return (int)length;
 }
 
-/* boot159: Full bulk transfer implementation.
- *
- * Uses the per-slot DMA bounce buffer (slot_bulk_data) so all data the
- * VL805 MCU DMA's to/from is within the xhci_dma region.  Callers may
- * pass any buffer (stack, heap) — the copy is handled here.
- *
- * Direction is determined by bEndpointAddress bit 7:
- *   OUT (bit7=0): copy data→DMA buf, enqueue Normal TRB, ring doorbell
- *   IN  (bit7=1): enqueue Normal TRB, ring doorbell, copy DMA buf→data
- *
- * Maximum single transfer: BULK_MAX_XFER = 6144 bytes.
- */
-int xhci_bulk_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeout)
+int xhci_control_transfer(usb_device_t *dev, uint8_t req_type, uint8_t request,
+                          uint16_t value, uint16_t index, void *data,
+                          uint16_t length, int timeout)
 {
-    if (!ep || !data || len == 0) return -1;
-    if (len > BULK_MAX_XFER) {
-        uart_puts("[xHCI] bulk_transfer: transfer exceeds DMA bounce buffer\n");
-        return -1;
+    xhci_ctl_lock();
+    int rc = control_transfer(dev, req_type, request, value, index, data,
+                              length, timeout);
+    xhci_ctl_unlock();
+    return rc;
+}
+
+/* ── Bulk DMA cache maintenance (boot410) ────────────────────────────────
+ * Zero-copy TRBs point at ordinary cacheable kernel memory rather than the
+ * Normal-NC .xhci_dma region, so coherency with the VL805 is kept by hand:
+ * clean before the controller reads, clean+invalidate before it writes (no
+ * dirty line may later be evicted over incoming data), and invalidate again
+ * afterwards to drop any line the CPU speculatively refilled meanwhile.   */
+static void bulk_dcache_clean(uintptr_t a, uintptr_t end)
+{
+    for (a &= ~63UL; a < end; a += 64)
+        asm volatile("dc cvac, %0" :: "r"(a) : "memory");
+    asm volatile("dsb sy" ::: "memory");
+}
+static void bulk_dcache_flush(uintptr_t a, uintptr_t end)
+{
+    for (a &= ~63UL; a < end; a += 64)
+        asm volatile("dc civac, %0" :: "r"(a) : "memory");
+    asm volatile("dsb sy" ::: "memory");
+}
+static void bulk_dcache_inval(uintptr_t a, uintptr_t end)
+{
+    for (a &= ~63UL; a < end; a += 64)
+        asm volatile("dc ivac, %0" :: "r"(a) : "memory");
+    asm volatile("dsb sy" ::: "memory");
+}
+
+/* One Normal TRB's worth of a TD: bus address + length (≤ 64 KB, never
+ * crossing a 64 KB boundary).  idx is filled in with its ring slot.      */
+typedef struct {
+    uint64_t dma;
+    uint32_t len;
+    uint32_t idx;
+} bulk_seg_t;
+
+/* boot411: one queued bulk TD — its TRBs, where its bytes really live and
+ * how it completed.  Several may be outstanding on a slot at once (BOT
+ * pipelining), so each carries everything needed to match its event and
+ * to copy back / invalidate once it is done.                             */
+typedef struct {
+    usb_endpoint_t   *ep;
+    uint8_t           dci;
+    uint8_t           dir_in;
+    int               nseg;
+    bulk_seg_t        seg[BULK_TD_MAX_TRBS];
+    uint8_t          *buf;          /* caller's buffer                      */
+    uint32_t          len;          /* bytes this TD covers                 */
+    volatile uint8_t *bounce;       /* whole TD staged here, or NULL        */
+    volatile uint8_t *edge;         /* IN head/tail lines (zero-copy path)  */
+    uintptr_t         mid_s, mid_e; /* IN line-aligned middle (zero-copy)   */
+    uint32_t          head, tail;
+    uint64_t          ring_dma;     /* ring it was queued on (boot412)      */
+    uint32_t          actual;       /* bytes moved, valid once cc >= 0      */
+    int               cc;           /* completion code; -1 while pending    */
+} bulk_td_t;
+
+/* Append [dma, dma+len) to seg[], splitting on 64 KB boundaries */
+static int bulk_seg_add(bulk_seg_t *seg, int n, uint64_t dma, uint32_t len)
+{
+    while (len && n < BULK_TD_MAX_TRBS) {
+        uint32_t room = 0x10000u - (uint32_t)(dma & 0xFFFFu);
+        uint32_t take = (len < room) ? len : room;
+        seg[n].dma = dma;
+        seg[n].len = take;
+        n++;
+        dma += take;
+        len -= take;
     }
+    return n;
+}
 
-    uint8_t slot_id = ep->slot_id;
-    if (slot_id == 0 || slot_id > MAX_SLOTS_ALLOC) return -1;
+static volatile uint32_t *bulk_ring(uint8_t slot_id, int dir_in,
+                                    uint8_t **cycle_p, uint32_t **enq_p)
+{
+    if (!dir_in) {
+        *cycle_p = &bulk_out_cycle[slot_id];
+        *enq_p   = &bulk_out_enq[slot_id];
+        return slot_bulk_out_ring(slot_id);
+    }
+    *cycle_p = &bulk_in_cycle[slot_id];
+    *enq_p   = &bulk_in_enq[slot_id];
+    return slot_bulk_in_ring(slot_id);
+}
 
+/* Lay out up to len bytes of buf as one TD and return how many it covers.
+ *
+ * Short transfers (CBW/CSW, descriptors) that fit in bounce and buffers
+ * above the inbound DMA window are staged through bounce (at most cap
+ * bytes).  Everything else
+ * goes zero-copy, up to BULK_TD_MAX_XFER: OUT buffers are cleaned to PoC;
+ * for IN, the partial cache lines at either end are received into edge
+ * instead — invalidating a line the caller shares with other data would
+ * lose that data — and only the line-aligned middle is DMA'd in place.   */
+static uint32_t bulk_td_prep(bulk_td_t *td, usb_endpoint_t *ep, uint8_t *buf,
+                             size_t len, volatile uint8_t *bounce, uint32_t cap,
+                             volatile uint8_t *edge)
+{
     uint8_t ep_num = ep->bEndpointAddress & 0x0Fu;
-    uint8_t dir_in = (ep->bEndpointAddress & 0x80u) ? 1u : 0u;
-    uint8_t dci    = (uint8_t)(ep_num * 2u + dir_in);
-    if (dci < 2 || dci > 31) return -1;
+    uint64_t phys  = (uint64_t)virt_to_phys(buf);
+    uint32_t n;
+
+    td->ep     = ep;
+    td->dir_in = (ep->bEndpointAddress & 0x80u) ? 1u : 0u;
+    td->dci    = (uint8_t)(ep_num * 2u + td->dir_in);
+    td->buf    = buf;
+    td->bounce = NULL;
+    td->edge   = NULL;
+    td->head   = td->tail = 0;
+    td->mid_s  = td->mid_e = 0;
+    td->nseg   = 0;
+
+    if ((len < BULK_DIRECT_MIN && len <= cap) || phys + len > BULK_DMA_LIMIT) {
+        n = (len > cap) ? cap : (uint32_t)len;
+        td->bounce = bounce;
+        if (!td->dir_in) dma_copy_to(bounce, buf, n);   /* host → device  */
+        else             dma_zero(bounce, n);           /* clear recv buf */
+        td->nseg = bulk_seg_add(td->seg, 0,
+                       phys_to_dma((uint64_t)virt_to_phys((void *)bounce)), n);
+    } else {
+        n = (len > BULK_TD_MAX_XFER) ? BULK_TD_MAX_XFER : (uint32_t)len;
+        uintptr_t s = (uintptr_t)buf, e = s + n;
+        uint64_t  s_dma = phys_to_dma(phys);
 
-    volatile uint8_t *dma_buf = slot_bulk_data(slot_id);
+        if (!td->dir_in) {
+            bulk_dcache_clean(s, e);
+            td->nseg = bulk_seg_add(td->seg, 0, s_dma, n);
+        } else {
+            uint64_t edge_dma = phys_to_dma((uint64_t)virt_to_phys((void *)edge));
+            td->edge  = edge;
+            td->mid_s = (s + 63u) & ~(uintptr_t)63u;
+            td->mid_e = e & ~(uintptr_t)63u;
+            td->head  = (uint32_t)(td->mid_s - s);
+            td->tail  = (uint32_t)(e - td->mid_e);
+            if (td->head)
+                td->nseg = bulk_seg_add(td->seg, td->nseg, edge_dma, td->head);
+            bulk_dcache_flush(td->mid_s, td->mid_e);
+            td->nseg = bulk_seg_add(td->seg, td->nseg, s_dma + td->head,
+                                    (uint32_t)(td->mid_e - td->mid_s));
+            if (td->tail)
+                td->nseg = bulk_seg_add(td->seg, td->nseg, edge_dma + 64u, td->tail);
+        }
+    }
+    td->len    = n;
+    td->actual = 0;
+    td->cc     = -1;
+    return n;
+}
 
-    if (!dir_in) {
-        dma_copy_to(dma_buf, data, len);        /* OUT: host → device  */
+/* Whether bulk_td_prep() would lay out all len bytes as a single TD */
+static int bulk_td_fits(const void *buf, size_t len)
+{
+    uint64_t phys = (uint64_t)virt_to_phys((void *)buf);
+    if (len < BULK_DIRECT_MIN || phys + len > BULK_DMA_LIMIT)
+        return len <= BULK_MAX_XFER;
+    return len <= BULK_TD_MAX_XFER;
+}
+
+/* Copy an IN TD's staged bytes back to the caller and drop stale lines */
+static void bulk_td_finish(bulk_td_t *td)
+{
+    if (!td->dir_in) return;
+    if (td->mid_e > td->mid_s)
+        bulk_dcache_inval(td->mid_s, td->mid_e);
+    if (td->cc != CC_SUCCESS && td->cc != CC_SHORT_PKT) return;
+    if (td->bounce) {
+        dma_copy_from(td->buf, td->bounce, td->actual);
     } else {
-        dma_zero(dma_buf, len);                 /* IN:  clear recv buf */
+        if (td->head) dma_copy_from(td->buf, td->edge, td->head);
+        if (td->tail) dma_copy_from((void *)td->mid_e, td->edge + 64u, td->tail);
     }
+}
 
-    uint64_t buf_dma = phys_to_dma((uint64_t)virt_to_phys((void *)dma_buf));
+/* Queue a prepared TD (a CH-linked chain of Normal TRBs) on its ring.
+ *
+ * Every TRB but the last carries CH; the last carries IOC.  IN TRBs also
+ * carry ISP so a short packet mid-chain completes the TD with an event
+ * naming the TRB it stopped in.  TD Size (DW2[21:17]) counts the packets
+ * still to come, as xHCI §4.11.2.4 requires.  A Link TRB that falls inside
+ * the chain keeps CH set so the controller does not end the TD there.
+ * The first TRB's cycle bit is written inverted and flipped once the rest
+ * of the chain is in place, so the VL805 never runs a partial TD; with
+ * handover = 0 it stays inverted (a staged TD) until bulk_td_release().
+ * Returns the ring slot of the first TRB.
+ * boot412: the ring is explicit so stream rings (ntrbs long) can share it. */
+static uint32_t bulk_td_queue_on(volatile uint32_t *ring, uint32_t ntrbs,
+                                 uint8_t *cycle_p, uint32_t *enq_p,
+                                 bulk_td_t *td, int handover)
+{
+    uint16_t mps = td->ep->wMaxPacketSize ? td->ep->wMaxPacketSize : 512u;
+    uint32_t first = *enq_p, done = 0;
+    uint32_t packets = (td->len + mps - 1u) / mps;
+
+    for (int i = 0; i < td->nseg; i++) {
+        int last = (i == td->nseg - 1);
+        done += td->seg[i].len;
+        uint32_t td_size = last ? 0u : packets - done / mps;
+        if (td_size > 31u) td_size = 31u;
+
+        uint32_t b = (*enq_p) * 4;
+        td->seg[i].idx = *enq_p;
+        ring[b + 0] = (uint32_t)td->seg[i].dma;
+        ring[b + 1] = (uint32_t)(td->seg[i].dma >> 32);
+        ring[b + 2] = (td->seg[i].len & 0x1FFFFu) | (td_size << 17);
+        ring[b + 3] = (TRB_TYPE_NORMAL << TRB_TYPE_SHIFT)
+                    | (last ? TRB_IOC : TRB_CHAIN)
+                    | (td->dir_in ? TRB_ISP : 0u)
+                    | (i == 0 ? (*cycle_p ^ 1u) : *cycle_p);
+
+        (*enq_p)++;
+        if (*enq_p >= ntrbs - 1) {
+            *enq_p = 0;
+            /* Link TRB with the CURRENT cycle bit, then toggle (boot189) */
+            uint32_t li = (ntrbs - 1) * 4;
+            ring[li + 3] = (TRB_TYPE_LINK << TRB_TYPE_SHIFT) | TRB_TC
+                         | (last ? 0u : TRB_CHAIN) | (*cycle_p);
+            *cycle_p ^= 1u;
+        }
+    }
+    asm volatile("dsb sy" ::: "memory");
+    if (handover) {
+        ring[first * 4 + 3] ^= TRB_CYCLE;
+        asm volatile("dsb sy" ::: "memory");
+    }
+    td->ring_dma = phys_to_dma((uint64_t)virt_to_phys((void *)ring));
+    return first;
+}
 
-    volatile uint32_t *ring;
+/* Queue a prepared TD on the slot's bulk ring for its direction */
+static uint32_t bulk_td_queue(uint8_t slot_id, bulk_td_t *td, int handover)
+{
     uint8_t  *cycle_p;
     uint32_t *enq_p;
-    if (!dir_in) {
-        ring    = slot_bulk_out_ring(slot_id);
-        cycle_p = &bulk_out_cycle[slot_id];
-        enq_p   = &bulk_out_enq[slot_id];
-    } else {
-        ring    = slot_bulk_in_ring(slot_id);
-        cycle_p = &bulk_in_cycle[slot_id];
-        enq_p   = &bulk_in_enq[slot_id];
-    }
+    volatile uint32_t *ring = bulk_ring(slot_id, td->dir_in, &cycle_p, &enq_p);
+    return bulk_td_queue_on(ring, BULK_RING_TRBS, cycle_p, enq_p, td, handover);
+}
 
-    /* Enqueue Normal TRB (xHCI §6.4.1.1, TRB type = 1) */
-    uint32_t b = (*enq_p) * 4;
-    ring[b + 0] = (uint32_t)buf_dma;
-    ring[b + 1] = (uint32_t)(buf_dma >> 32);
-    ring[b + 2] = (uint32_t)(len & 0x1FFFFu);
-    ring[b + 3] = TRB_IOC | (1u << TRB_TYPE_SHIFT) | (*cycle_p);
+/* Hand a staged TD to the controller.  With cancel set, its first TRB is
+ * turned into a Transfer No-op instead, so the ring stays consumable.
+ * Only single-TRB TDs (CBWs) are ever staged.                            */
+static void bulk_td_release(uint8_t slot_id, int dir_in, uint32_t first, int cancel)
+{
+    uint8_t  *cycle_p;
+    uint32_t *enq_p;
+    volatile uint32_t *ring = bulk_ring(slot_id, dir_in, &cycle_p, &enq_p);
+    uint32_t b = first * 4;
+    if (cancel)
+        ring[b + 3] = (ring[b + 3] & TRB_CYCLE) | (TRB_TYPE_NOOP_XFER << TRB_TYPE_SHIFT);
     asm volatile("dsb sy" ::: "memory");
+    ring[b + 3] ^= TRB_CYCLE;
+    asm volatile("dsb sy" ::: "memory");
+}
 
-    /* bulk_xfer chatty log suppressed — path is proven stable (boot254).
-     * Re-enable by restoring uart_puts calls if bulk issues recur.      */
-
-    (*enq_p)++;
-    if (*enq_p >= BULK_RING_TRBS - 1) {
-        *enq_p = 0;
-        /* Write Link TRB with the CURRENT cycle bit so hardware matches CCS,
-         * then toggle cycle for subsequent TRBs (boot189 fix: was toggling
-         * before writing, giving hardware the wrong cycle bit on every wrap). */
-        uint32_t li = (BULK_RING_TRBS - 1) * 4;
-        ring[li + 3] = (TRB_TYPE_LINK << TRB_TYPE_SHIFT) | TRB_TC | (*cycle_p);
-        *cycle_p ^= 1u;
-    }
-
-    /* Ring doorbell for this slot's endpoint */
+/* target: DCI, plus the stream ID in bits 31:16 for stream pipes */
+static void bulk_doorbell(uint8_t slot_id, uint32_t target)
+{
     volatile uint32_t *db = (volatile uint32_t *)xhci_ctrl.doorbell_regs;
     asm volatile("dsb sy" ::: "memory");
-    db[slot_id] = dci;
+    db[slot_id] = target;
     asm volatile("dsb sy" ::: "memory");
+}
 
-    /* Drain events until Transfer Event (type=0x20) for this endpoint */
+/* Credit a Transfer Event (already matched by slot and DCI) to td if the
+ * TRB it names is one of td's; fills in actual and cc.  Returns 1 if so. */
+static int bulk_td_credit(bulk_td_t *d, const uint32_t ev[4])
+{
+    uint64_t ptr = ((uint64_t)ev[1] << 32) | ev[0];
+    if (d->cc >= 0 || ptr < d->ring_dma) return 0;
+    uint32_t idx = (uint32_t)((ptr - d->ring_dma) / 16u);
+    uint32_t before = 0;
+    int i;
+    for (i = 0; i < d->nseg && d->seg[i].idx != idx; i++)
+        before += d->seg[i].len;
+    if (i == d->nseg) return 0;                 /* stale: not this TD */
+
+    uint32_t residual = ev[2] & 0xFFFFFFu;
+    if (residual > d->seg[i].len) residual = d->seg[i].len;
+    d->actual = before + d->seg[i].len - residual;
+    d->cc     = (ev[2] >> 24) & 0xFF;
+    return 1;
+}
+
+/* Wait for the Transfer Events of n outstanding TDs on one slot.  Only
+ * their own endpoints' queues are read (boot416).
+ *
+ * An event is credited to the TD on the same DCI whose TRBs contain the
+ * event's TRB pointer; anything else (a late event for an earlier short
+ * TD, PSCEs, CCEs from concurrent commands) is discarded as before.  Each
+ * TD's actual byte count is derived from the TRB the event names and its
+ * residual.  Returns 0 once all complete, the completion code of the first
+ * TD to fail (its successors are left pending), or -1 on timeout.        */
+static int bulk_wait(uint8_t slot_id, bulk_td_t **td, int n, int timeout)
+{
     uint32_t ev[4];
     uint32_t ms = (timeout > 0 && timeout < 30000) ? (uint32_t)timeout : 5000U;
     uint32_t deadline = get_time_ms() + ms;
-    while (get_time_ms() < deadline) {
-        if (xhci_wait_event(ev, 20) != 0) continue;
-        uint32_t ev_type = (ev[3] >> 10) & 0x3Fu;
-        if (ev_type == 0x20u) {                 /* Transfer Event */
-            uint8_t cc = (ev[2] >> 24) & 0xFF;
-            if (cc == CC_SUCCESS || cc == CC_SHORT_PKT) {
-                if (dir_in)
-                    dma_copy_from(data, dma_buf, len);
-                return 0;
-            }
-            uart_puts("[xHCI] bulk_transfer: CC=");
-            print_hex32(cc); uart_puts("\n");
-            return -1;
+    int pending = 0;
+    uint32_t dcis = 0;
+    for (int t = 0; t < n; t++) {
+        if (td[t]->cc < 0) pending++;
+        dcis |= 1u << td[t]->dci;
+    }
+
+    while (pending && get_time_ms() < deadline) {
+        if (xhci_wait_eps(slot_id, dcis, ev, 20) != 0) continue;
+        if (((ev[3] >> 10) & 0x3Fu) != 0x20u) continue;     /* not a Transfer Event */
+        if (((ev[3] >> 24) & 0xFFu) != slot_id) continue;
+        uint8_t  dci = (uint8_t)((ev[3] >> 16) & 0x1Fu);
+
+        for (int t = 0; t < n; t++) {
+            bulk_td_t *d = td[t];
+            if (d->dci != dci || !bulk_td_credit(d, ev)) continue;
+            pending--;
+            if (d->cc != CC_SUCCESS && d->cc != CC_SHORT_PKT) return d->cc;
+            break;
         }
-        /* Discard other events (PSCEs, CCEs from concurrent commands) */
     }
+    if (!pending) return 0;
     uart_puts("[xHCI] bulk_transfer: TIMEOUT\n");
     return -1;
 }
 
-/*
- * xhci_interrupt_transfer — poll an HID interrupt IN endpoint (Build 253).
+/* Issue an endpoint command on (slot, dci) and await its Command
+ * Completion Event.  Returns the completion code, -1 if none came.      */
+static int bulk_ep_cmd(uint32_t type, uint64_t ptr, uint8_t slot_id, uint8_t dci)
+{
+    uint32_t ev[4];
+    uint32_t dl = get_time_ms() + 500U;
+
+    cmd_ring_submit((uint32_t)ptr, (uint32_t)(ptr >> 32), 0, type,
+                    ((uint32_t)slot_id << 24) | ((uint32_t)dci << 16));
+    while (get_time_ms() < dl) {
+        if (xhci_wait_event(ev, 20) != 0) break;
+        if (((ev[3] >> 10) & 0x3FU) == 0x21U)
+            return (int)((ev[2] >> 24) & 0xFFU);
+    }
+    return -1;
+}
+
+/* Take back the TDs still armed on a bulk ring after a failed wait.
  *
- * Uses the interrupt transfer rings configured by xhci_configure_endpoints.
- * Protocol:
- *   1. If no TRB is in flight, enqueue a Normal TRB on the endpoint's ring
- *      and ring the doorbell.
- *   2. Poll the event ring for a Transfer Event matching this slot + DCI.
- *   3. On CC_SUCCESS or CC_SHORT_PKT: copy data from DMA buffer, return
- *      actual byte count, and clear the submitted flag so the next call
- *      re-arms the ring.
- *   4. On timeout (NAK — device has nothing yet): return 0.  This is NOT
- *      an error; the HID driver treats 0 as "no new report."
- *   5. Return -1 only for hard errors (unconfigured endpoint, bad slot).
+ * boot422: a timed-out or errored TD stays on the ring, so the controller
+ * could later DMA into a buffer its caller has freed, or land the next
+ * TD's data (a CSW) in it.  Stop the endpoint (Reset it if it halted),
+ * then Set TR Dequeue to the software enqueue point so everything queued
+ * so far is skipped, and drop the endpoint's stale events.              */
+static void bulk_ep_abort(uint8_t slot_id, uint8_t dci)
+{
+    uint8_t  *cycle_p;
+    uint32_t *enq_p;
+    volatile uint32_t *ring = bulk_ring(slot_id, dci & 1u, &cycle_p, &enq_p);
+
+    xhci_ctl_lock();
+    volatile uint32_t *epc =
+        (volatile uint32_t *)(slot_out_ctx(slot_id) + (uint32_t)dci * CTX_SIZE);
+    uint32_t state = epc[0] & 7u;               /* 1 Running, 2 Halted */
+    if (state == 2u)
+        bulk_ep_cmd(TRB_TYPE_RESET_EP, 0, slot_id, dci);
+    else if (state == 1u)
+        bulk_ep_cmd(TRB_TYPE_STOP_EP, 0, slot_id, dci);
+
+    uint64_t deq = phys_to_dma((uint64_t)virt_to_phys((void *)ring))
+                 + (uint64_t)(*enq_p) * 16u;
+    int cc = bulk_ep_cmd(TRB_TYPE_SET_TR_DEQ, deq | (uint64_t)(*cycle_p),
+                         slot_id, dci);
+    xhci_ctl_unlock();
+    evq_flush_ep(slot_id, dci);
+
+    if (cc != CC_SUCCESS) {
+        uart_puts("[xHCI] bulk abort: Set TR Dequeue dci="); print_hex32(dci);
+        uart_puts(" cc="); print_hex32((uint32_t)cc); uart_puts("\n");
+    }
+}
+
+/* boot159: Full bulk transfer implementation.
+ * boot410: zero-copy scatter-gather; the 6 KB per-call limit is gone.
  *
- * Thread safety: single-CPU polling loop — no locking needed.
+ * Issues len bytes as successive TDs laid out by bulk_td_prep(): large
+ * buffers inside the VL805's inbound DMA window go zero-copy, up to
+ * BULK_TD_MAX_XFER per TD; short transfers and buffers above the window
+ * go through the per-slot bounce buffer, BULK_MAX_XFER bytes per TD.
+ *
+ * Direction is determined by bEndpointAddress bit 7.  A short packet on
+ * IN ends the transfer early and is not an error, as before.
  */
-int xhci_interrupt_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeout)
+int xhci_bulk_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeout)
 {
     if (!ep || !data || len == 0) return -1;
 
     uint8_t slot_id = ep->slot_id;
     if (slot_id == 0 || slot_id > MAX_SLOTS_ALLOC) return -1;
 
-    uint8_t ep_num = ep->bEndpointAddress & 0x0Fu;
-    uint8_t dci    = (uint8_t)(ep_num * 2u + 1u);  /* interrupt IN: dir_in=1 */
+    uint8_t dci = (uint8_t)((ep->bEndpointAddress & 0x0Fu) * 2u
+                            + ((ep->bEndpointAddress & 0x80u) ? 1u : 0u));
+    if (dci < 2 || dci > 31) return -1;
 
-    /* Find the matching interrupt endpoint index for this slot */
-    int i_idx = -1;
-    for (int k = 0; k < int_ep_count[slot_id]; k++) {
-        if (int_ep_dci[slot_id][k] == dci) { i_idx = k; break; }
+    uint8_t *p = (uint8_t *)data;
+    bulk_td_t td, *tdp = &td;
+    size_t off = 0;
+    while (off < len) {
+        uint32_t n = bulk_td_prep(&td, ep, p + off, len - off,
+                                  slot_bulk_data(slot_id), BULK_MAX_XFER,
+                                  slot_bulk_edge(slot_id));
+        bulk_td_queue(slot_id, &td, 1);
+        bulk_doorbell(slot_id, dci);
+        int rc = bulk_wait(slot_id, &tdp, 1, timeout);
+        if (rc != 0) bulk_ep_abort(slot_id, dci);   /* before buf is reused */
+        bulk_td_finish(&td);
+
+        if (rc < 0) return -1;
+        if (rc > 0) {
+            uart_puts("[xHCI] bulk_transfer: CC=");
+            print_hex32((uint32_t)rc); uart_puts("\n");
+            return -1;
+        }
+        off += n;
+        if (td.cc == CC_SHORT_PKT || td.actual < n) break;  /* device ended early */
     }
-    if (i_idx < 0) {
-        /* Endpoint not configured via xhci_configure_endpoints — not an xHCI ring */
+    return 0;
+}
+
+/* ── Pipelined Bulk-Only Transport (boot411) ─────────────────────────────
+ * A BOT command is three TDs — CBW out, data, CSW in.  Issued one by one
+ * each stage costs a full event round trip; here all three are queued and
+ * their doorbells rung together, so the device streams data and status
+ * back-to-back and the host waits on the event ring once per command.
+ *
+ * The caller may also pass the next command's CBW.  BOT (§5.3) forbids
+ * sending it before this command's CSW, so it is written to the OUT ring
+ * as a staged TD — built but not handed over — and released the moment
+ * the CSW event lands, without returning to the class driver first.  The
+ * following xhci_bot_command() recognises the identical CBW as already
+ * sent and queues only its data and CSW.
+ *
+ * CBWs alternate between two 64-byte bounce slots so a staged CBW never
+ * overwrites one the device may still be fetching; the CSW has its own.
+ * If a stage fails the staged CBW is cancelled (turned into a No-op) and
+ * cmd->failed names the stage, so the caller can run BOT recovery.       */
+int xhci_bot_command(usb_endpoint_t *out, usb_endpoint_t *in,
+                     xhci_bot_cmd_t *cmd, int timeout)
+{
+    if (!out || !in || !cmd || !cmd->cbw || !cmd->csw) return -1;
+    uint8_t slot_id = out->slot_id;
+    if (slot_id == 0 || slot_id > MAX_SLOTS_ALLOC || in->slot_id != slot_id)
         return -1;
+
+    uint8_t out_dci = (uint8_t)((out->bEndpointAddress & 0x0Fu) * 2u);
+    uint8_t in_dci  = (uint8_t)((in->bEndpointAddress & 0x0Fu) * 2u + 1u);
+    cmd->failed = 0;
+    cmd->actual = 0;
+
+    bulk_td_t cbw, data, csw, next;
+    bulk_td_t *wait[3];
+    int nwait = 0, kick_out = 0;
+
+    /* ── Stage 1: CBW (unless it went out ahead of us) ─────────────────── */
+    int sent = bot_stage[slot_id].valid &&
+               memcmp(bot_stage[slot_id].cbw, cmd->cbw, 31) == 0;
+    if (bot_stage[slot_id].valid && !sent)
+        uart_puts("[xHCI] BOT: staged CBW superseded\n");
+    bot_stage[slot_id].valid = 0;
+    if (!sent) {
+        uint8_t sel = bot_stage[slot_id].sel;
+        bot_stage[slot_id].sel ^= 1u;
+        bulk_td_prep(&cbw, out, (uint8_t *)cmd->cbw, 31,
+                     slot_bulk_cbw(slot_id, sel), 64, NULL);
+        bulk_td_queue(slot_id, &cbw, 1);
+        wait[nwait++] = &cbw;
+        kick_out = 1;
     }
 
-    /* ── Submit Normal TRB if none is currently in flight ───────────────── *
-     *
-     * boot285: Submit TRB whenever the endpoint is not already armed,
+    /* ── Stage 2: data.  A single TD rides the pipeline; anything larger
+     *    waits for the CBW and then runs through the plain path.  ──────── */
+    usb_endpoint_t *dep = cmd->dir_in ? in : out;
+    int data_piped = 0;
+    if (cmd->data && cmd->len) {
+        if (bulk_td_fits(cmd->data, cmd->len)) {
+            bulk_td_prep(&data, dep, (uint8_t *)cmd->data, cmd->len,
+                         slot_bulk_data(slot_id), BULK_MAX_XFER,
+                         slot_bulk_edge(slot_id));
+            bulk_td_queue(slot_id, &data, 1);
+            wait[nwait++] = &data;
+            if (!cmd->dir_in) kick_out = 1;
+            data_piped = 1;
+        } else {
+            if (kick_out) {
+                bulk_doorbell(slot_id, out_dci);
+                kick_out = 0;
+                if (bulk_wait(slot_id, wait, nwait, timeout)) {
+                    bulk_ep_abort(slot_id, out_dci);
+                    cmd->failed = XHCI_BOT_CBW;
+                    return -1;
+                }
+                nwait = 0;
+            }
+            if (xhci_bulk_transfer(dep, cmd->data, cmd->len, timeout) < 0) {
+                cmd->failed = XHCI_BOT_DATA;
+                return -1;
+            }
+            cmd->actual = cmd->len;
+        }
+    }
+
+    /* ── Stage 3: CSW, plus the next command's CBW held back ──────────── */
+    bulk_td_prep(&csw, in, (uint8_t *)cmd->csw, 13,
+                 slot_bulk_csw(slot_id), 64, NULL);
+    bulk_td_queue(slot_id, &csw, 1);
+    wait[nwait++] = &csw;
+
+    uint32_t next_first = 0;
+    if (cmd->next_cbw) {
+        uint8_t sel = bot_stage[slot_id].sel;
+        bot_stage[slot_id].sel ^= 1u;
+        bulk_td_prep(&next, out, (uint8_t *)cmd->next_cbw, 31,
+                     slot_bulk_cbw(slot_id, sel), 64, NULL);
+        next_first = bulk_td_queue(slot_id, &next, 0);
+    }
+
+    if (kick_out) bulk_doorbell(slot_id, out_dci);
+    bulk_doorbell(slot_id, in_dci);
+
+    int rc = bulk_wait(slot_id, wait, nwait, timeout);
+
+    if (cmd->next_cbw) {
+        if (rc == 0) {
+            /* CSW is in: the device is ready for the next CBW right now */
+            bulk_td_release(slot_id, 0, next_first, 0);
+            bulk_doorbell(slot_id, out_dci);
+            memcpy(bot_stage[slot_id].cbw, cmd->next_cbw, 31);
+            bot_stage[slot_id].valid = 1;
+        } else {
+            bulk_td_release(slot_id, 0, next_first, 1);
+        }
+    }
+    if (rc != 0) {                      /* nothing may stay armed on cmd's buffers */
+        bulk_ep_abort(slot_id, out_dci);
+        bulk_ep_abort(slot_id, in_dci);
+    }
+
+    if (data_piped) {
+        bulk_td_finish(&data);
+        cmd->actual = data.actual;
+    }
+    bulk_td_finish(&csw);
+    if (rc == 0) return 0;
+
+    if (!sent && cbw.cc != CC_SUCCESS)
+        cmd->failed = XHCI_BOT_CBW;
+    else if (data_piped && data.cc != CC_SUCCESS && data.cc != CC_SHORT_PKT)
+        cmd->failed = XHCI_BOT_DATA;
+    else
+        cmd->failed = XHCI_BOT_CSW;
+    if (rc > 0) {
+        uart_puts("[xHCI] BOT: CC="); print_hex32((uint32_t)rc); uart_puts("\n");
+    }
+    return -1;
+}
+
+/* ── Bulk streams (boot412) ───────────────────────────────────────────────
+ * A UAS device tags each command and moves its data and status on the
+ * stream of that tag, so every (endpoint, stream) pair gets its own ring
+ * and here one outstanding TD.  Endpoints without streams (the UAS
+ * command pipe) keep the per-slot ring; the stream ID then only picks the
+ * completion slot.  Only one device at a time runs streams.             */
+static struct {
+    int             n;                            /* endpoints in use       */
+    uint8_t         nstreams;                     /* IDs 1..nstreams        */
+    usb_endpoint_t *ep[STREAM_EPS];
+    uint8_t         dci[STREAM_EPS];
+    int8_t          ring[STREAM_EPS];             /* ring set, -1 = plain   */
+    uint8_t         cycle[STREAM_RINGED_EPS][STREAM_IDS];
+    uint32_t        enq[STREAM_RINGED_EPS][STREAM_IDS];
+    uint8_t         busy[STREAM_EPS][STREAM_IDS];
+    bulk_td_t       td[STREAM_EPS][STREAM_IDS];
+} strm;
+
+static inline volatile uint32_t *stream_ctx_array(int r) {
+    return (volatile uint32_t *)(xhci_dma_buf + DMA_STREAM_BASE_OFF
+                                 + STREAM_CTX_OFF(r));
+}
+static inline volatile uint32_t *stream_ring(int r, int s) {
+    return (volatile uint32_t *)(xhci_dma_buf + DMA_STREAM_BASE_OFF
+                                 + STREAM_RING_OFF(r, s));
+}
+static inline volatile uint8_t *stream_aux(int e, int s) {
+    return (volatile uint8_t *)(xhci_dma_buf + DMA_STREAM_BASE_OFF
+                                + STREAM_AUX_OFF(e, s));
+}
+
+/* Zero a transfer ring and close it with a toggle-cycle Link TRB */
+static uint64_t xfer_ring_init(volatile uint32_t *ring, uint32_t ntrbs)
+{
+    dma_zero(ring, ntrbs * 16u);
+    uint64_t dma = phys_to_dma((uint64_t)virt_to_phys((void *)ring));
+    uint32_t li = (ntrbs - 1u) * 4u;
+    ring[li + 0] = (uint32_t)dma;
+    ring[li + 1] = (uint32_t)(dma >> 32);
+    ring[li + 2] = 0u;
+    ring[li + 3] = (TRB_TYPE_LINK << TRB_TYPE_SHIFT) | TRB_TC | 1u;
+    return dma;
+}
+
+static int stream_ep_index(usb_endpoint_t *ep)
+{
+    if (!stream_slot || !ep || ep->slot_id != stream_slot) return -1;
+    for (int e = 0; e < strm.n; e++)
+        if (strm.ep[e] == ep) return e;
+    return -1;
+}
+
+/* Re-add the device's pipes with stream rings: one Configure Endpoint that
+ * drops and adds each DCI.  Streamed endpoints get MaxPStreams / LSA and
+ * a Primary Stream Array whose entries (SCT = 1, primary transfer ring)
+ * point at per-stream rings; the TR Dequeue Pointer field then holds the
+ * array address with DCS clear (xHCI §6.2.3).  MaxBurst from the SS
+ * companion goes in DW1 so the pipes burst as advertised.               */
+static int alloc_streams(usb_device_t *dev, usb_endpoint_t **eps, int n,
+                         int nstreams)
+{
+    uint8_t slot_id = (uint8_t)(uintptr_t)dev->hcd_private;
+    if (slot_id == 0 || slot_id > MAX_SLOTS_ALLOC || n < 1 || n > STREAM_EPS)
+        return -1;
+    if (stream_slot && stream_slot != slot_id) {
+        uart_puts("[xHCI] streams: already in use by slot ");
+        print_hex32(stream_slot); uart_puts("\n");
+        return -1;
+    }
+    if (xhci_ctrl.max_psa == 0) {
+        uart_puts("[xHCI] streams: not supported (MaxPSASize=0)\n");
+        return -1;
+    }
+
+    /* Primary Stream Array of 2^(psa+1) entries, at most STREAM_IDS */
+    uint32_t psa = (xhci_ctrl.max_psa < 2u) ? xhci_ctrl.max_psa : 2u;
+    int granted  = (1 << (psa + 1u)) - 1;
+    int ringed   = 0;
+    if (nstreams < granted) granted = nstreams;
+    for (int e = 0; e < n; e++) {
+        if (!eps[e] || (eps[e]->bmAttributes & 0x03u) != 0x02u) return -1;
+        if (!eps[e]->max_streams) continue;
+        if (eps[e]->max_streams < granted) granted = eps[e]->max_streams;
+        ringed++;
+    }
+    if (ringed == 0 || ringed > STREAM_RINGED_EPS || granted < 1) return -1;
+
+    stream_slot = 0;
+    uint32_t cs = CTX_SIZE;
+    volatile uint8_t *in_ctx  = slot_input_ctx(slot_id);
+    volatile uint8_t *out_ctx = slot_out_ctx(slot_id);
+    dma_zero(in_ctx, 34 * cs);
+    volatile uint32_t *in_slot  = (volatile uint32_t *)(in_ctx + cs);
+    volatile uint32_t *out_slot = (volatile uint32_t *)out_ctx;
+    for (uint32_t i = 0; i < cs / 4; i++) in_slot[i] = out_slot[i];
+
+    uint32_t flags   = 0;
+    uint32_t max_dci = (in_slot[0] >> 27) & 0x1Fu;
+    int r = 0;
+    memset(&strm, 0, sizeof(strm));
+    for (int e = 0; e < n; e++) {
+        usb_endpoint_t *ep = eps[e];
+        uint8_t dir_in = (ep->bEndpointAddress & 0x80u) ? 1u : 0u;
+        uint8_t dci    = (uint8_t)((ep->bEndpointAddress & 0x0Fu) * 2u + dir_in);
+        ep->slot_id  = slot_id;
+        strm.ep[e]   = ep;
+        strm.dci[e]  = dci;
+        flags |= 1u << dci;
+        if (dci > max_dci) max_dci = dci;
+
+        volatile uint32_t *ep_ctx =
+            (volatile uint32_t *)(in_ctx + (uint32_t)(dci + 1u) * cs);
+        uint32_t mps = ep->wMaxPacketSize & 0x7FFu;
+        ep_ctx[1] = (mps << 16)
+                  | ((uint32_t)ep->max_burst << 8)      /* Max Burst Size   */
+                  | ((dir_in ? 6u : 2u) << 3)           /* Bulk IN / OUT    */
+                  | (3u << 1);                          /* CErr = 3         */
+        ep_ctx[4] = mps;
+
+        uint64_t deq;
+        if (ep->max_streams) {
+            volatile uint32_t *sca = stream_ctx_array(r);
+            dma_zero(sca, 0x100u);
+            for (int s = 1; s <= granted; s++) {
+                uint64_t rd = xfer_ring_init(stream_ring(r, s), STREAM_RING_TRBS);
+                sca[s * 4 + 0] = (uint32_t)rd | (1u << 1) | 1u;  /* SCT=1, DCS=1 */
+                sca[s * 4 + 1] = (uint32_t)(rd >> 32);
+                strm.cycle[r][s] = 1u;
+            }
+            ep_ctx[0] = (1u << 15) | (psa << 10);       /* LSA, MaxPStreams */
+            deq = phys_to_dma((uint64_t)virt_to_phys((void *)sca));
+            strm.ring[e] = (int8_t)r++;
+        } else {
+            uint8_t  *cycle_p;
+            uint32_t *enq_p;
+            volatile uint32_t *ring = bulk_ring(slot_id, dir_in, &cycle_p, &enq_p);
+            deq = xfer_ring_init(ring, BULK_RING_TRBS) | 1u;   /* + DCS */
+            *cycle_p = 1u;
+            *enq_p   = 0u;
+            ep_ctx[0] = 0u;
+            strm.ring[e] = -1;
+        }
+        ep_ctx[2] = (uint32_t)deq;
+        ep_ctx[3] = (uint32_t)(deq >> 32);
+    }
+    strm.n        = n;
+    strm.nstreams = (uint8_t)granted;
+    bot_stage[slot_id].valid = 0;
+
+    in_slot[0] = (in_slot[0] & ~(0x1Fu << 27)) | (max_dci << 27);
+    volatile uint32_t *icc = (volatile uint32_t *)in_ctx;
+    icc[0] = flags;                 /* drop ...                         */
+    icc[1] = flags | 1u;            /* ... and re-add, with Slot context */
+
+    uint64_t in_dma = phys_to_dma((uint64_t)virt_to_phys((void *)in_ctx));
+    cmd_ring_submit((uint32_t)in_dma, (uint32_t)(in_dma >> 32), 0,
+                    TRB_TYPE_CONFIGURE_EP, (uint32_t)slot_id << 24);
+
+    uint32_t ev[4], cc = 0;
+    int got_cce = 0;
+    uint32_t deadline = get_time_ms() + 500U;
+    while (get_time_ms() < deadline) {
+        if (xhci_wait_event(ev, 20) != 0) continue;
+        if (((ev[3] >> 10) & 0x3Fu) != 0x21u) continue;
+        cc = (ev[2] >> 24) & 0xFF;
+        got_cce = 1;
+        break;
+    }
+    if (!got_cce || cc != CC_SUCCESS) {
+        uart_puts("[xHCI] streams: ConfigureEP ");
+        if (got_cce) { uart_puts("CC="); print_hex32(cc); }
+        else           uart_puts("TIMEOUT");
+        uart_puts("\n");
+        return -1;
+    }
+    stream_slot = slot_id;
+    uart_puts("[xHCI] streams: slot="); print_hex32(slot_id);
+    uart_puts(" pipes="); print_hex32((uint32_t)n);
+    uart_puts(" streams="); print_hex32((uint32_t)granted); uart_puts("\n");
+    return granted;
+}
+
+int xhci_alloc_streams(usb_device_t *dev, usb_endpoint_t **eps, int n,
+                       int nstreams)
+{
+    xhci_ctl_lock();
+    int rc = alloc_streams(dev, eps, n, nstreams);
+    xhci_ctl_unlock();
+    return rc;
+}
+
+int xhci_stream_submit(usb_endpoint_t *ep, uint16_t stream, void *data,
+                       size_t len)
+{
+    int e = stream_ep_index(ep);
+    if (e < 0 || stream == 0 || stream > strm.nstreams || !data || !len)
+        return -1;
+    if (strm.busy[e][stream]) return -1;
+
+    /* One TD per stream: no larger than its ring holds, and buffers outside
+     * the DMA window only as far as the bounce goes.                    */
+    uint64_t phys = (uint64_t)virt_to_phys(data);
+    if (len > XHCI_STREAM_MAX_XFER ||
+        (phys + len > BULK_DMA_LIMIT && len > STREAM_BOUNCE))
+        return -1;
+
+    volatile uint8_t *aux = stream_aux(e, stream);
+    bulk_td_t *td = &strm.td[e][stream];
+    bulk_td_prep(td, ep, (uint8_t *)data, len, aux, STREAM_BOUNCE,
+                 aux + STREAM_EDGE_OFF);
+
+    uint32_t target = strm.dci[e];
+    int r = strm.ring[e];
+    if (r >= 0) {
+        bulk_td_queue_on(stream_ring(r, stream), STREAM_RING_TRBS,
+                         &strm.cycle[r][stream], &strm.enq[r][stream], td, 1);
+        target |= (uint32_t)stream << 16;
+    } else {
+        bulk_td_queue(stream_slot, td, 1);
+    }
+    strm.busy[e][stream] = 1u;
+    bulk_doorbell(stream_slot, target);
+    return 0;
+}
+
+int xhci_stream_poll(int timeout_ms)
+{
+    if (!stream_slot) return -1;
+    uint32_t ms = (timeout_ms > 0 && timeout_ms < 30000) ? (uint32_t)timeout_ms : 0u;
+    uint32_t deadline = get_time_ms() + ms;
+    int done = 0, fault = 0;
+    uint32_t dcis = 0;
+    for (int e = 0; e < strm.n; e++) dcis |= 1u << strm.dci[e];
+
+    for (;;) {
+        uint32_t ev[4];
+        if (xhci_poll_eps(stream_slot, dcis, ev, (done || fault) ? 0 : 1) != 0) {
+            if (done || fault || get_time_ms() >= deadline) break;
+            continue;
+        }
+        if (((ev[3] >> 10) & 0x3Fu) != 0x20u) continue;     /* not a Transfer Event */
+        if (((ev[3] >> 24) & 0xFFu) != stream_slot) continue;
+        uint8_t dci = (uint8_t)((ev[3] >> 16) & 0x1Fu);
+        int hit = 0;
+
+        for (int e = 0; e < strm.n && !hit; e++) {
+            if (strm.dci[e] != dci) continue;
+            for (int s = 1; s <= strm.nstreams; s++) {
+                bulk_td_t *d = &strm.td[e][s];
+                if (!strm.busy[e][s] || !bulk_td_credit(d, ev)) continue;
+                bulk_td_finish(d);
+                hit = 1;
+                break;
+            }
+        }
+        if (hit) { done++; continue; }
+
+        /* Unmatched error: a halted pipe or a rejected stream ID */
+        uint32_t cc = (ev[2] >> 24) & 0xFF;
+        if (cc != CC_SUCCESS && cc != CC_SHORT_PKT) {
+            uart_puts("[xHCI] streams: dci="); print_hex32(dci);
+            uart_puts(" CC="); print_hex32(cc); uart_puts("\n");
+            fault = 1;
+        }
+    }
+    return fault ? -1 : done;
+}
+
+int xhci_stream_result(usb_endpoint_t *ep, uint16_t stream, uint32_t *actual)
+{
+    int e = stream_ep_index(ep);
+    if (e < 0 || stream == 0 || stream > strm.nstreams || !strm.busy[e][stream])
+        return -1;
+    bulk_td_t *td = &strm.td[e][stream];
+    if (td->cc < 0) return 0;
+    if (actual) *actual = td->actual;
+    strm.busy[e][stream] = 0u;
+    return td->cc;
+}
+
+int xhci_stream_transfer(usb_endpoint_t *ep, void *data, size_t len,
+                         int timeout, uint16_t stream)
+{
+    uint32_t ms = (timeout > 0 && timeout < 30000) ? (uint32_t)timeout : 5000U;
+    uint32_t deadline = get_time_ms() + ms;
+    uint32_t actual = 0;
+    int cc = 0;
+
+    if (xhci_stream_submit(ep, stream, data, len) < 0) return -1;
+    while ((cc = xhci_stream_result(ep, stream, &actual)) == 0 &&
+           get_time_ms() < deadline)
+        xhci_stream_poll(20);
+    if (cc == 0) {
+        uart_puts("[xHCI] stream_transfer: TIMEOUT\n");
+        return -1;
+    }
+    if (cc != CC_SUCCESS && cc != CC_SHORT_PKT) return -1;
+    return (int)actual;
+}
+
+/* Queue one Normal TRB on interrupt endpoint (slot, idx) reading len bytes
+ * into data slice k, and return its bus address.  No doorbell.          */
+static uint64_t int_queue_trb(uint8_t slot_id, int idx, int k, uint32_t len)
+{
+    volatile uint32_t *iring = slot_int_ring(slot_id, idx);
+    volatile uint8_t  *ibuf  = slot_int_data(slot_id, idx) + k * INT_REPORT_SIZE;
+    uint64_t buf_dma = phys_to_dma((uint64_t)virt_to_phys((void *)ibuf));
+    uint32_t e   = int_ep_enq[slot_id][idx];
+    uint32_t b   = e * 4u;
+    uint8_t  cyc = int_ep_cycle[slot_id][idx];
+
+    iring[b + 0] = (uint32_t)buf_dma;
+    iring[b + 1] = (uint32_t)(buf_dma >> 32);
+    iring[b + 2] = len;
+    iring[b + 3] = TRB_IOC | (TRB_TYPE_NORMAL << TRB_TYPE_SHIFT) | cyc;
+    asm volatile("dsb sy" ::: "memory");
+    int_ep_slice[slot_id][idx][e] = (uint8_t)k;
+
+    /* Advance enqueue pointer; wrap with Link TRB if needed */
+    int_ep_enq[slot_id][idx]++;
+    if (int_ep_enq[slot_id][idx] >= INT_RING_TRBS - 1u) {
+        uint32_t li = (INT_RING_TRBS - 1u) * 4u;
+        iring[li + 3] = (TRB_TYPE_LINK << TRB_TYPE_SHIFT) | TRB_TC | cyc;
+        asm volatile("dsb sy" ::: "memory");
+        int_ep_enq[slot_id][idx]   = 0u;
+        int_ep_cycle[slot_id][idx] ^= 1u;
+    }
+    return phys_to_dma((uint64_t)virt_to_phys((void *)&iring[b]));
+}
+
+/* Ring the doorbell for a slot's interrupt endpoint */
+static void int_doorbell(uint8_t slot_id, uint8_t dci)
+{
+    volatile uint32_t *db = (volatile uint32_t *)xhci_ctrl.doorbell_regs;
+    asm volatile("dsb sy" ::: "memory");
+    db[slot_id] = (uint32_t)dci;
+    asm volatile("dsb sy" ::: "memory");
+}
+
+/*
+ * xhci_interrupt_transfer — poll an HID interrupt IN endpoint (Build 253).
+ *
+ * Uses the interrupt transfer rings configured by xhci_configure_endpoints.
+ * Protocol:
+ *   1. If no TRB is in flight, enqueue a Normal TRB on the endpoint's ring
+ *      and ring the doorbell.
+ *   2. Poll the event ring for a Transfer Event matching this slot + DCI.
+ *   3. On CC_SUCCESS or CC_SHORT_PKT: copy data from DMA buffer, return
+ *      actual byte count, and clear the submitted flag so the next call
+ *      re-arms the ring.
+ *   4. On timeout (NAK — device has nothing yet): return 0.  This is NOT
+ *      an error; the HID driver treats 0 as "no new report."
+ *   5. Return -1 only for hard errors (unconfigured endpoint, bad slot).
+ *
+ * Thread safety: single-CPU polling loop — no locking needed.
+ * boot417: an endpoint started with xhci_interrupt_start() always
+ * returns 0 here; its reports go to the callback instead.
+ */
+int xhci_interrupt_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeout)
+{
+    if (!ep || !data || len == 0) return -1;
+
+    uint8_t slot_id = ep->slot_id;
+    if (slot_id == 0 || slot_id > MAX_SLOTS_ALLOC) return -1;
+
+    uint8_t ep_num = ep->bEndpointAddress & 0x0Fu;
+    uint8_t dci    = (uint8_t)(ep_num * 2u + 1u);  /* interrupt IN: dir_in=1 */
+
+    /* Find the matching interrupt endpoint index for this slot */
+    int i_idx = -1;
+    for (int k = 0; k < int_ep_count[slot_id]; k++) {
+        if (int_ep_dci[slot_id][k] == dci) { i_idx = k; break; }
+    }
+    if (i_idx < 0) {
+        /* Endpoint not configured via xhci_configure_endpoints — not an xHCI ring */
+        return -1;
+    }
+    if (int_ep_cb[slot_id][i_idx]) return 0;    /* boot417: reports go to the callback */
+
+    /* ── Submit Normal TRB if none is currently in flight ───────────────── *
+     *
+     * boot285: Submit TRB whenever the endpoint is not already armed,
      * regardless of timeout.  Previously (boot261) we required timeout > 0
      * to avoid consuming the delta accumulator before GET_REPORT could read
      * it.  We no longer use GET_REPORT for mice — interrupt IN is the sole
@@ -3931,7 +5049,6 @@ int xhci_interrupt_transfer(usb_endpoint_t *ep, void *data, size_t len, int time
      * eliminating the 16 ms re-arm gap that caused delta accumulation and
      * cursor jerkiness.                                                      */
     if (int_ep_submitted[slot_id][i_idx] == 0u) {
-        volatile uint32_t *iring = slot_int_ring(slot_id, i_idx);
         volatile uint8_t  *ibuf  = slot_int_data(slot_id, i_idx);
         uint32_t req_len = (uint32_t)(len > INT_REPORT_SIZE ? INT_REPORT_SIZE : len);
 
@@ -3944,93 +5061,24 @@ int xhci_interrupt_transfer(usb_endpoint_t *ep, void *data, size_t len, int time
         }
 
         dma_zero(ibuf, req_len);
-        uint64_t buf_dma = phys_to_dma((uint64_t)virt_to_phys((void *)ibuf));
-
-        uint32_t b   = int_ep_enq[slot_id][i_idx] * 4u;
-        uint8_t  cyc = int_ep_cycle[slot_id][i_idx];
-
-        iring[b + 0] = (uint32_t)buf_dma;
-        iring[b + 1] = (uint32_t)(buf_dma >> 32);
-        iring[b + 2] = req_len;
-        iring[b + 3] = TRB_IOC | (TRB_TYPE_NORMAL << TRB_TYPE_SHIFT) | cyc;
-        asm volatile("dsb sy" ::: "memory");
-
-        /* Advance enqueue pointer; wrap with Link TRB if needed */
-        int_ep_enq[slot_id][i_idx]++;
-        if (int_ep_enq[slot_id][i_idx] >= INT_RING_TRBS - 1u) {
-            uint32_t li = (INT_RING_TRBS - 1u) * 4u;
-            iring[li + 3] = (TRB_TYPE_LINK << TRB_TYPE_SHIFT) | TRB_TC | cyc;
-            asm volatile("dsb sy" ::: "memory");
-            int_ep_enq[slot_id][i_idx]   = 0u;
-            int_ep_cycle[slot_id][i_idx] ^= 1u;
-        }
-
-        /* Ring the doorbell for this slot's interrupt endpoint */
-        volatile uint32_t *db = (volatile uint32_t *)xhci_ctrl.doorbell_regs;
-        asm volatile("dsb sy" ::: "memory");
-        db[slot_id] = (uint32_t)dci;
-        asm volatile("dsb sy" ::: "memory");
+        int_ep_trb[slot_id][i_idx] = int_queue_trb(slot_id, i_idx, 0, req_len);
+        int_doorbell(slot_id, dci);
 
         int_ep_submitted[slot_id][i_idx] = 1u;
     }
 
-    /* ── Poll event ring for Transfer Event for this slot/endpoint ───────── */
+    /* ── Take the armed TRB's Transfer Event off this endpoint's queue ──── *
+     *
+     * boot416: events arrive already sorted by (slot, DCI), so a sibling
+     * endpoint's completion never passes through here and the boot-era
+     * 8-entry stash is gone; matching the TRB pointer drops the late
+     * completion of a TRB the DMA fallback below gave up on.
+     * boot261: timeout == 0 is a single immediate check — the HID driver
+     * calls us that way so WIMP is never stalled.                         */
     uint32_t ev[4];
-
-    /* Check stash first — a previous poll for a sibling endpoint may have
-     * consumed our event and saved it here.                                */
-    int found = evt_stash_get(slot_id, dci, ev);
-
-    if (!found) {
-        if (timeout == 0) {
-            /* boot261: Non-blocking path — single immediate event ring check.
-             * Returns at once with found=0 if nothing is there.  The HID
-             * driver calls us with timeout=0 so WIMP is never stalled.       */
-            asm volatile("dsb sy; isb" ::: "memory");
-            if (evt_ring_poll(ev)) {
-                uint32_t ev_type  = (ev[3] >> 10) & 0x3Fu;
-                uint8_t  ev_slot  = (uint8_t)((ev[3] >> 24) & 0xFFu);
-                uint8_t  ev_ep_id = (uint8_t)((ev[3] >> 16) & 0x1Fu);
-                if (ev_type == 0x20u) {
-                    if (ev_slot == slot_id && ev_ep_id == dci) {
-                        found = 1;
-                    } else {
-                        /* Transfer Event for sibling endpoint — stash it */
-                        uart_puts("[xHCI] int_steal: slot="); print_hex32(ev_slot);
-                        uart_puts(" dci="); print_hex32(ev_ep_id);
-                        uart_puts(" cc="); print_hex32((ev[2] >> 24) & 0xFFu);
-                        uart_puts("\n");
-                        evt_stash_put(ev_slot, ev_ep_id, ev);
-                    }
-                }
-            }
-        } else {
-            /* Blocking path — wait up to timeout ms for our Transfer Event */
-            uint32_t ms       = (timeout < 5000) ? (uint32_t)timeout : 10U;
-            uint32_t deadline = get_time_ms() + ms;
-            while (get_time_ms() < deadline) {
-                asm volatile("dsb sy; isb" ::: "memory");
-                if (!evt_ring_poll(ev)) continue;
-
-                uint32_t ev_type  = (ev[3] >> 10) & 0x3Fu;
-                uint8_t  ev_slot  = (uint8_t)((ev[3] >> 24) & 0xFFu);
-                uint8_t  ev_ep_id = (uint8_t)((ev[3] >> 16) & 0x1Fu);
-
-                if (ev_type == 0x20u) {
-                    if (ev_slot == slot_id && ev_ep_id == dci) {
-                        found = 1; break;      /* our event — process below */
-                    }
-                    /* Transfer Event for a different endpoint: stash for its caller */
-                    uart_puts("[xHCI] int_steal: slot="); print_hex32(ev_slot);
-                    uart_puts(" dci="); print_hex32(ev_ep_id);
-                    uart_puts(" cc="); print_hex32((ev[2] >> 24) & 0xFFu);
-                    uart_puts("\n");
-                    evt_stash_put(ev_slot, ev_ep_id, ev);
-                }
-                /* Non-Transfer Events (CCE, PSCE) already logged by evt_ring_poll */
-            }
-        }
-    }
+    uint64_t trb = int_ep_trb[slot_id][i_idx];
+    uint32_t ms  = (timeout <= 0) ? 0u : (timeout < 5000) ? (uint32_t)timeout : 10U;
+    int found = (xhci_wait_trb(slot_id, dci, trb, trb, ev, (int)ms, 1) == 0);
 
     if (!found) {
         /* boot262 diagnostic: read DMA buffer directly on timeout.
@@ -4108,22 +5156,33 @@ static usb_hc_ops_t g_xhci_hc_ops = {
 
 /* ── Event ring + IRQ + MSI ──────────────────────────────────────────────── */
 
+/* ERDP for ring index i: the TRB's address plus its segment in DESI [2:0] */
+static uint64_t evt_erdp(uint32_t i)
+{
+    uint32_t seg = i / EVT_SEG_TRBS;
+    return (evt_seg_dma[seg] + (uint64_t)(i % EVT_SEG_TRBS) * 16) | seg;
+}
+
 /*
  * evt_ring_poll — read one event directly from the event ring.
  *
- * This is the AUTHORITATIVE event consumer.  It is called by both
- * xhci_wait_event (polling path) and xhci_irq_handler (MSI path).
+ * This is the AUTHORITATIVE hardware consumer.  Once xhci_init() has
+ * finished it is only called through evt_drain() (boot415), which holds
+ * evq_lock so the IRQ handler and a polling waiter never both advance
+ * ERDP; the init-time loops in run_controller() call it directly.
  *
  * Returns 1 if an event was consumed into ev[], 0 if ring is empty.
  *
  * The cycle bit protocol:
  *   The controller writes TRBs into the ring and toggles the cycle
- *   bit on each full pass.  We track evt_cycle which starts at 1 (per
- *   xHCI spec §4.9.3: event ring PCS/CCS initialises to 1 after reset).
+ *   bit on each full pass (boot416: through every segment).  We track
+ *   evt_cycle which starts at 1 (per xHCI spec §4.9.3: event ring
+ *   PCS/CCS initialises to 1 after reset).
  *   A TRB belongs to us iff (dword3 & 1) == evt_cycle.
  */
 static int evt_ring_poll(uint32_t ev[4]) {
-    volatile uint32_t *slot = (volatile uint32_t *)(evt_ring + evt_dequeue * 4);
+    volatile uint32_t *slot = evt_seg[evt_dequeue / EVT_SEG_TRBS]
+                            + (evt_dequeue % EVT_SEG_TRBS) * 4;
 
     /* Memory barrier — ensure we see the controller's write */
     asm volatile("dsb sy; isb" ::: "memory");
@@ -4153,7 +5212,7 @@ static int evt_ring_poll(uint32_t ev[4]) {
     ev[3] = slot[3];
 
     evt_dequeue++;
-    if (evt_dequeue >= EVT_RING_TRBS) {
+    if (evt_dequeue >= evt_nsegs * EVT_SEG_TRBS) {   /* boot416: last segment */
         evt_dequeue = 0;
         evt_cycle ^= 1;
     }
@@ -4164,23 +5223,420 @@ static int evt_ring_poll(uint32_t ev[4]) {
      * In polling mode we just advance the pointer clean; the MCU can write
      * the next event immediately.  Also W1C IMAN IP. */
     void *ir0 = ir_base(0);
-    uint64_t new_erdp = evt_ring_dma + (uint64_t)evt_dequeue * 16;
-    ERDP_REARM(ir0, new_erdp);
+    ERDP_REARM(ir0, evt_erdp(evt_dequeue));
     writel(readl(ir0 + IR_IMAN) | 1U, ir0 + IR_IMAN);
     asm volatile("dsb sy; isb" ::: "memory");
 
     return 1;
 }
 
+/* ── Software event queues (boot415, per endpoint since boot416) ─────────────
+ * evt_drain() empties the hardware ring into these: a Transfer Event goes
+ * to the queue of its (slot, DCI), everything else (Command Completion,
+ * Port Status Change, Host Controller) to evq_ctl.  A waiter only ever
+ * takes events meant for its own endpoints, so a HID poll can no longer
+ * swallow a UAS stream completion, nor a BOT data phase a keyboard report,
+ * and the ring is emptied as soon as the MSI arrives even when nobody is
+ * waiting.
+ *
+ * boot416: the boot415 per-slot arrays (and the interrupt path's 8-entry
+ * stash for sibling endpoints) gave way to lists drawn from one node
+ * pool: 9 slots × 31 DCIs of fixed queues would not fit.  A queue holding
+ * EVQ_EP_MAX events, or a request when the pool is empty, drops its own
+ * oldest event — one busy endpoint cannot starve the others.
+ *
+ * boot418: Port Status Change Events get a queue of their own, evq_port,
+ * read only by xhci_check_hotplug() — a command waiter discarding stray
+ * events from evq_ctl can no longer lose a plug, and an idle hotplug
+ * check is one look at evq_port.count.
+ *
+ * boot420: a queue also records the task blocked in evt_wait() on it;
+ * evq_put() wakes that task, so a waiter sleeps until the MSI handler
+ * delivers its event instead of yielding round a poll loop.            */
+#define EVQ_POOL     512                /* 4 × EVT_RING_TRBS                   */
+#define EVQ_EP_MAX   64                 /* per endpoint                        */
+#define EVQ_CTL_MAX  128                /* command / HC events                 */
+#define EVQ_PORT_MAX 32                 /* boot418: Port Status Change         */
+
+typedef struct evq_node {
+    uint32_t         ev[4];
+    uint32_t         seq;               /* arrival order across queues         */
+    struct evq_node *next;
+} evq_node_t;
+
+typedef struct {
+    evq_node_t *head;                   /* next to take                        */
+    evq_node_t *tail;
+    uint32_t    count;
+    task_t     *waiter;                 /* boot420: blocked in evt_wait()      */
+} evq_t;
+
+static evq_node_t  evq_pool[EVQ_POOL];
+static uint32_t    evq_pool_used;       /* nodes ever handed out               */
+static evq_node_t *evq_free;
+static evq_t       evq_ctl;
+static evq_t       evq_port;            /* boot418                             */
+static evq_t       evq_ep[MAX_SLOTS_ALLOC + 1][32];     /* [slot][DCI]         */
+static spinlock_t  evq_lock = SPINLOCK_INIT;
+static uint32_t    evq_seq;
+static uint32_t    evq_dropped;
+static uint32_t    evq_stale;           /* completions for abandoned TRBs      */
+
+/* Unlink the oldest node of q — caller holds evq_lock */
+static evq_node_t *evq_pop(evq_t *q)
+{
+    evq_node_t *n = q->head;
+    if (!n) return NULL;
+    q->head = n->next;
+    if (!q->head) q->tail = NULL;
+    q->count--;
+    return n;
+}
+
+static void evq_release(evq_node_t *n)
+{
+    n->next  = evq_free;
+    evq_free = n;
+}
+
+static void evq_put(evq_t *q, uint32_t max, const uint32_t ev[4])
+{
+    evq_node_t *n = NULL;
+
+    if (q->count >= max) {
+        n = evq_pop(q);                 /* full: lose the oldest         */
+        evq_dropped++;
+    } else if (evq_free) {
+        n = evq_free;
+        evq_free = n->next;
+    } else if (evq_pool_used < EVQ_POOL) {
+        n = &evq_pool[evq_pool_used++];
+    } else if ((n = evq_pop(q)) != NULL) {
+        evq_dropped++;                  /* pool empty: recycle our own   */
+    } else {
+        evq_dropped++;
+        return;
+    }
+    n->ev[0] = ev[0]; n->ev[1] = ev[1]; n->ev[2] = ev[2]; n->ev[3] = ev[3];
+    n->seq   = evq_seq++;
+    n->next  = NULL;
+    if (q->tail) q->tail->next = n; else q->head = n;
+    q->tail = n;
+    q->count++;
+    if (q->waiter) task_wakeup(q->waiter);          /* boot420 */
+}
+
+/* Move everything the controller has posted into the software queues */
+static void evt_drain(void)
+{
+    unsigned long flags;
+    uint32_t ev[4];
+
+    spin_lock_irqsave(&evq_lock, &flags);
+    while (evt_ring_poll(ev)) {
+        uint32_t type = (ev[3] >> 10) & 0x3Fu;
+        uint8_t  slot = (uint8_t)((ev[3] >> 24) & 0xFFu);
+        uint8_t  dci  = (uint8_t)((ev[3] >> 16) & 0x1Fu);
+        if (type == 0x20u && slot > 0u && slot <= (uint8_t)MAX_SLOTS_ALLOC && dci > 0u) {
+            if (!int_event(slot, dci, ev))          /* boot417: pre-posted */
+                evq_put(&evq_ep[slot][dci], EVQ_EP_MAX, ev);
+        } else if (type == 0x22u)
+            evq_put(&evq_port, EVQ_PORT_MAX, ev);   /* boot418 */
+        else
+            evq_put(&evq_ctl, EVQ_CTL_MAX, ev);
+    }
+    spin_unlock_irqrestore(&evq_lock, flags);
+}
+
+/* Take the oldest event queued for slot_id's endpoints in dci_mask, or
+ * from evq_ctl when slot_id is 0 — caller holds evq_lock.               */
+static int evq_take_locked(uint8_t slot_id, uint32_t dci_mask, uint32_t ev[4])
+{
+    evq_t *q = NULL;
+
+    if (slot_id == 0u) {
+        q = &evq_ctl;
+    } else {
+        for (uint32_t d = 1; d < 32; d++) {
+            evq_t *c = &evq_ep[slot_id][d];
+            if (!(dci_mask & (1u << d)) || !c->head) continue;
+            if (!q || (int32_t)(c->head->seq - q->head->seq) < 0) q = c;
+        }
+    }
+    evq_node_t *n = q ? evq_pop(q) : NULL;
+    if (n) {
+        ev[0] = n->ev[0]; ev[1] = n->ev[1]; ev[2] = n->ev[2]; ev[3] = n->ev[3];
+        evq_release(n);
+    }
+    return n != NULL;
+}
+
+static int evq_take(uint8_t slot_id, uint32_t dci_mask, uint32_t ev[4])
+{
+    unsigned long flags;
+
+    if (slot_id > (uint8_t)MAX_SLOTS_ALLOC) return 0;
+    spin_lock_irqsave(&evq_lock, &flags);
+    int got = evq_take_locked(slot_id, dci_mask, ev);
+    spin_unlock_irqrestore(&evq_lock, flags);
+    return got;
+}
+
+/* boot420: make t the waiter on every queue evq_take() would read for
+ * (slot_id, dci_mask), or with t NULL drop old's registrations there —
+ * caller holds evq_lock.                                                */
+static void evq_set_waiter(uint8_t slot_id, uint32_t dci_mask, task_t *t,
+                           task_t *old)
+{
+    if (slot_id == 0u) {
+        if (t || evq_ctl.waiter == old) evq_ctl.waiter = t;
+        return;
+    }
+    for (uint32_t d = 1; d < 32; d++) {
+        evq_t *q = &evq_ep[slot_id][d];
+        if ((dci_mask & (1u << d)) && (t || q->waiter == old)) q->waiter = t;
+    }
+}
+
+static void evq_flush(evq_t *q)
+{
+    evq_node_t *n;
+    while ((n = evq_pop(q)) != NULL) evq_release(n);
+}
+
+/* Forget a slot's leftover Transfer Events — on Enable and Disable Slot */
+static void evq_flush_slot(uint8_t slot_id)
+{
+    unsigned long flags;
+
+    if (slot_id == 0u || slot_id > (uint8_t)MAX_SLOTS_ALLOC) return;
+    spin_lock_irqsave(&evq_lock, &flags);
+    for (int d = 1; d < 32; d++) evq_flush(&evq_ep[slot_id][d]);
+    spin_unlock_irqrestore(&evq_lock, flags);
+}
+
+/* Forget one endpoint's leftover Transfer Events — after bulk_ep_abort */
+static void evq_flush_ep(uint8_t slot_id, uint8_t dci)
+{
+    unsigned long flags;
+
+    if (slot_id == 0u || slot_id > (uint8_t)MAX_SLOTS_ALLOC || dci >= 32u) return;
+    spin_lock_irqsave(&evq_lock, &flags);
+    evq_flush(&evq_ep[slot_id][dci]);
+    spin_unlock_irqrestore(&evq_lock, flags);
+}
+
+static void evq_flush_ctl(void)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&evq_lock, &flags);
+    evq_flush(&evq_ctl);
+    evq_flush(&evq_port);               /* boot418: port_scan() covers these */
+    spin_unlock_irqrestore(&evq_lock, flags);
+}
+
+/* boot418: take the oldest Port Status Change Event */
+static int evq_take_port(uint32_t ev[4])
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&evq_lock, &flags);
+    evq_node_t *n = evq_pop(&evq_port);
+    if (n) {
+        ev[0] = n->ev[0]; ev[1] = n->ev[1]; ev[2] = n->ev[2]; ev[3] = n->ev[3];
+        evq_release(n);
+    }
+    spin_unlock_irqrestore(&evq_lock, flags);
+    return n != NULL;
+}
+
+/* Transfer Event TRB pointer (DW0–DW1) */
+static uint64_t evt_trb_ptr(const uint32_t ev[4])
+{
+    return ((uint64_t)ev[1] << 32) | (ev[0] & ~0xFu);
+}
+
 /*
- * xhci_wait_event — wait for a command/transfer completion event.
+ * xhci_interrupt_start — keep an interrupt IN endpoint permanently armed
+ * (boot417).
  *
- * boot87: Pure tight-poll using CNTPCT_EL0 for real wall-clock timeouts.
+ * Queues INT_PREPOST Normal TRBs of len bytes, one per INT_REPORT_SIZE
+ * slice of the endpoint's data area.  From then on int_event() hands
+ * every completion to cb — from the MSI handler when MSIs arrive, else
+ * from whoever next drains the event ring (xhci_service_events) — and
+ * queues the TRB again at once, so the controller always has a buffer
+ * for the device's next report.  A TRB the single-TRB path left armed
+ * is adopted rather than doubled.  Idempotent once running.
+ */
+int xhci_interrupt_start(usb_endpoint_t *ep, size_t len, xhci_int_cb_t cb, void *ctx)
+{
+    if (!ep || !cb || len == 0) return -1;
+
+    uint8_t slot_id = ep->slot_id;
+    if (slot_id == 0 || slot_id > MAX_SLOTS_ALLOC) return -1;
+    uint8_t dci = (uint8_t)((ep->bEndpointAddress & 0x0Fu) * 2u + 1u);
+
+    int i_idx = -1;
+    for (int k = 0; k < int_ep_count[slot_id]; k++) {
+        if (int_ep_dci[slot_id][k] == dci) { i_idx = k; break; }
+    }
+    if (i_idx < 0) return -1;
+
+    unsigned long flags;
+    spin_lock_irqsave(&evq_lock, &flags);
+    if (int_ep_cb[slot_id][i_idx]) {
+        spin_unlock_irqrestore(&evq_lock, flags);
+        return 0;
+    }
+    uint32_t req_len = (uint32_t)(len > INT_REPORT_SIZE ? INT_REPORT_SIZE : len);
+    int_ep_cb[slot_id][i_idx]  = cb;
+    int_ep_ctx[slot_id][i_idx] = ctx;
+    int_ep_len[slot_id][i_idx] = (uint16_t)req_len;
+    for (int k = 0; k < INT_PREPOST; k++) {
+        if (k == 0 && int_ep_submitted[slot_id][i_idx]) continue;   /* slice 0 armed */
+        dma_zero(slot_int_data(slot_id, i_idx) + k * INT_REPORT_SIZE, req_len);
+        int_queue_trb(slot_id, i_idx, k, req_len);
+    }
+    int_ep_posted[slot_id][i_idx]    = INT_PREPOST;
+    int_ep_submitted[slot_id][i_idx] = 0u;
+    int_doorbell(slot_id, dci);
+    spin_unlock_irqrestore(&evq_lock, flags);
+
+    uart_puts("[xHCI] int_start: slot="); print_hex32(slot_id);
+    uart_puts(" dci="); print_hex32(dci);
+    uart_puts(" trbs="); print_hex32(INT_PREPOST); uart_puts("\n");
+    return 0;
+}
+
+/* Complete a Transfer Event on a started interrupt endpoint — evt_drain(),
+ * evq_lock held.  Returns 0 if (slot, dci) is not a started endpoint.   */
+static int int_event(uint8_t slot_id, uint8_t dci, const uint32_t ev[4])
+{
+    int i_idx = -1;
+    for (int k = 0; k < int_ep_count[slot_id] && k < MAX_INT_EPS; k++) {
+        if (int_ep_dci[slot_id][k] == dci && int_ep_cb[slot_id][k]) { i_idx = k; break; }
+    }
+    if (i_idx < 0) return 0;
+
+    uint64_t ring_dma = phys_to_dma((uint64_t)virt_to_phys((void *)slot_int_ring(slot_id, i_idx)));
+    uint64_t off      = evt_trb_ptr(ev) - ring_dma;
+    if (off >= (uint64_t)(INT_RING_TRBS - 1u) * 16u) {
+        evq_stale++;                                /* not one of our TRBs */
+        return 1;
+    }
+    int      k   = int_ep_slice[slot_id][i_idx][off / 16u];
+    uint8_t  cc  = (uint8_t)((ev[2] >> 24) & 0xFFu);
+    uint32_t req = int_ep_len[slot_id][i_idx];
+
+    if (cc != CC_SUCCESS && cc != CC_SHORT_PKT) {
+        /* Halted or stopped: this TRB is not re-posted.  Stop Endpoint
+         * (CC 26/27) during teardown is expected and stays quiet.       */
+        if (int_ep_posted[slot_id][i_idx]) int_ep_posted[slot_id][i_idx]--;
+        if (cc != 26u && cc != 27u) {
+            uart_puts("[xHCI] int_event: CC="); print_hex32(cc);
+            uart_puts(" slot="); print_hex32(slot_id);
+            uart_puts(" dci="); print_hex32(dci);
+            uart_puts(" armed="); print_hex32(int_ep_posted[slot_id][i_idx]);
+            uart_puts("\n");
+        }
+        return 1;
+    }
+
+    uint32_t residual = ev[2] & 0x00FFFFFFu;
+    uint32_t actual   = (residual < req) ? req - residual : 0u;
+    uint8_t  report[INT_REPORT_SIZE];
+    volatile uint8_t *ibuf = slot_int_data(slot_id, i_idx) + k * INT_REPORT_SIZE;
+    asm volatile("dsb sy; isb" ::: "memory");
+    dma_copy_from(report, ibuf, actual);
+
+    /* Re-post before the callback: the device's next report has a buffer
+     * while this one is being decoded.                                  */
+    dma_zero(ibuf, req);
+    int_queue_trb(slot_id, i_idx, k, req);
+    int_doorbell(slot_id, dci);
+
+    int_ep_cb[slot_id][i_idx](int_ep_ctx[slot_id][i_idx], report, (int)actual,
+                              get_time_ms());
+    return 1;
+}
+
+/* Forget a slot's interrupt callbacks — its rings are being reset */
+static void int_stop_slot(uint8_t slot_id)
+{
+    unsigned long flags;
+
+    spin_lock_irqsave(&evq_lock, &flags);
+    for (int i = 0; i < MAX_INT_EPS; i++) {
+        int_ep_cb[slot_id][i]     = NULL;
+        int_ep_ctx[slot_id][i]    = NULL;
+        int_ep_posted[slot_id][i] = 0u;
+    }
+    spin_unlock_irqrestore(&evq_lock, flags);
+}
+
+/* xhci_service_events — drain the event ring without waiting (boot417).
+ * Runs the pre-posted interrupt callbacks when no MSI did.              */
+void xhci_service_events(void)
+{
+    if (evt_irq_ready) evt_drain();
+}
+
+/*
+ * evt_block — sleep on the queues for (slot_id, dci_mask) for up to ms
+ * (boot420).  The waiter is registered and the task marked blocked under
+ * evq_lock, so an MSI that lands before schedule() just leaves it ready.
+ * Returns 1 with the event in ev[] if one was queued already.
+ */
+#define EVT_BLOCK_SLICE_MS  10          /* bounds the cost of a lost MSI       */
+
+static int evt_block(uint8_t slot_id, uint32_t dci_mask, uint32_t ev[4], uint32_t ms)
+{
+    task_t       *self = current_task;
+    unsigned long flags;
+
+    spin_lock_irqsave(&evq_lock, &flags);
+    if (evq_take_locked(slot_id, dci_mask, ev)) {
+        spin_unlock_irqrestore(&evq_lock, flags);
+        return 1;
+    }
+    evq_set_waiter(slot_id, dci_mask, self, NULL);
+    task_wake_after(ms);
+    self->state = TASK_BLOCKED;
+    spin_unlock_irqrestore(&evq_lock, flags);
+
+    schedule();
+
+    spin_lock_irqsave(&evq_lock, &flags);
+    evq_set_waiter(slot_id, dci_mask, NULL, self);
+    self->wake_at = 0;
+    spin_unlock_irqrestore(&evq_lock, flags);
+    return 0;
+}
+
+/* Blocking needs a task, a live MSI path (the handler has fired at least
+ * once since the ring went to evt_drain()) and IRQs unmasked here.      */
+static int evt_can_block(void)
+{
+    uint64_t daif;
+    if (!current_task || !evt_irq_ready || msi_fire_count == 0u) return 0;
+    asm volatile("mrs %0, daif" : "=r"(daif));
+    return !(daif & (1u << 7));
+}
+
+/*
+ * evt_wait — take the next event from slot_id's endpoints in dci_mask (bit
+ * n = DCI n), or from the command queue when slot_id is 0, waiting up to
+ * timeout_ms.
  *
- * After 86 boots the VL805 MSI→GIC path on BCM2711 is confirmed broken:
- * msi_fire_count stays 0 regardless of INTR2/MSI_INTR0 configuration.
- * WFI-based waiting is gone.  We busy-poll the event ring cycle bit at
- * full CPU speed (limited only by the DSB barrier per iteration).
+ * boot87 made this a pure CNTPCT_EL0 tight-poll: the VL805 MSI → GIC path
+ * had never delivered.  boot415: the handler feeds the queues when MSIs
+ * do arrive, but every pass still calls evt_drain() itself, so a lost or
+ * never-wired MSI costs latency, not events.  boot420: when evt_can_block()
+ * the task sleeps on its queues (evt_block) and the MSI handler wakes it;
+ * each sleep is at most EVT_BLOCK_SLICE_MS (task_wake_after), after which
+ * the pass drains the ring itself as before.  Otherwise a task yields each
+ * pass, and before the scheduler runs it spins exactly as before.
  *
  * BCM2711 system counter (CNTPCT_EL0) runs at 54 MHz → 54,000 ticks/ms.
  * The 32-bit millisecond counter wraps every ~49.7 days — fine here.
@@ -4189,16 +5645,30 @@ static int evt_ring_poll(uint32_t ev[4]) {
  * We clear HSE and re-assert RS=1 on every HSE seen during the poll,
  * just as the settle and retry loops do.
  */
-static int xhci_wait_event(uint32_t ev[4], int timeout_ms) {
-    /* Immediate check — event may already be in the ring */
-    if (evt_ring_poll(ev)) return 0;
+static int evt_wait(uint8_t slot_id, uint32_t dci_mask, uint32_t ev[4],
+                    int timeout_ms, int quiet)
+{
+    /* Immediate check — event may already be queued or in the ring */
+    if (evq_take(slot_id, dci_mask, ev)) return 0;
+    evt_drain();
+    if (evq_take(slot_id, dci_mask, ev)) return 0;
 
     uint32_t t0 = get_time_ms();
     void *_op   = xhci_ctrl.op_regs;
 
     while ((get_time_ms() - t0) < (uint32_t)timeout_ms) {
+        if (evt_can_block()) {
+            uint32_t left = (uint32_t)timeout_ms - (get_time_ms() - t0);
+            if (evt_block(slot_id, dci_mask, ev,
+                          left < EVT_BLOCK_SLICE_MS ? left : EVT_BLOCK_SLICE_MS))
+                return 0;
+        } else if (current_task) {
+            yield();
+        }
         asm volatile("dsb sy; isb" ::: "memory");
-        if (evt_ring_poll(ev)) return 0;
+        if (evq_take(slot_id, dci_mask, ev)) return 0;
+        evt_drain();
+        if (evq_take(slot_id, dci_mask, ev)) return 0;
 
         /* VL805 HSE watchdog keepalive — full ring re-arm on HSE.
          *
@@ -4208,6 +5678,8 @@ static int xhci_wait_event(uint32_t ev[4], int timeout_ms) {
         if (readl(_op + OP_USBSTS) & STS_HSE) {
             void *_ir0 = ir_base(0);
             uint64_t _crcr  = (cmd_ring_dma & ~0x3FULL) | (uint64_t)cmd_cycle;
+            unsigned long flags;
+            spin_lock_irqsave(&evq_lock, &flags);   /* boot415: vs handler's ERDP */
             writel(STS_HSE | STS_EINT | STS_PCD, _op + OP_USBSTS);
             asm volatile("dsb sy; isb" ::: "memory");
             reg_write64(_op, OP_DCBAAP_LO,
@@ -4217,23 +5689,27 @@ static int xhci_wait_event(uint32_t ev[4], int timeout_ms) {
             writel(0U, _ir0 + IR_ERSTSZ);
             reg_write64(_ir0, IR_ERSTBA_LO, erst_dma_addr);
             asm volatile("dsb sy; isb" ::: "memory");
-            writel(1U, _ir0 + IR_ERSTSZ);
+            writel(evt_nsegs, _ir0 + IR_ERSTSZ);
             asm volatile("dsb sy; isb" ::: "memory");
-            ERDP_REARM(_ir0, evt_ring_dma + (uint64_t)evt_dequeue * 16); /* boot107 */
+            ERDP_REARM(_ir0, evt_erdp(evt_dequeue)); /* boot107 */
             writel(0x00000002U, _ir0 + IR_IMAN);
             asm volatile("dsb sy; isb" ::: "memory");
             writel(CMD_RS | CMD_INTE, _op + OP_USBCMD);
             asm volatile("dsb sy; isb" ::: "memory");
+            spin_unlock_irqrestore(&evq_lock, flags);
         }
     }
 
     /* Timeout — single consolidated line to keep the log readable.
      * Suppressed during TUR retry loop (xhci_quiet_timeouts != 0) because
      * slow devices generate many expected timeouts before becoming ready.    */
-    if (!xhci_quiet_timeouts) {
+    if (!xhci_quiet_timeouts && !quiet && timeout_ms > 0) {
         uart_puts("[xHCI] timeout("); print_hex32((uint32_t)timeout_ms);
         uart_puts("ms) USBSTS="); print_hex32(readl(_op + OP_USBSTS));
         uart_puts(" INTR2="); print_hex32(readl(pcie_base + 0x4300U));
+        uart_puts(" MSI="); print_hex32(msi_fire_count);
+        uart_puts(" lost="); print_hex32(evq_dropped);      /* boot416 */
+        uart_puts(" stale="); print_hex32(evq_stale);
         uart_puts(" TRB0=["); print_hex32(((volatile uint32_t *)evt_ring)[0]);
         uart_puts(","); print_hex32(((volatile uint32_t *)evt_ring)[3]);
         uart_puts("]\n");
@@ -4242,20 +5718,94 @@ static int xhci_wait_event(uint32_t ev[4], int timeout_ms) {
 }
 
 /*
- * xhci_irq_handler — stub kept for linker symbol resolution.
+ * xhci_wait_event — wait for a command completion or other non-transfer
+ * event (Port Status Change, Host Controller).  Transfer Events are not
+ * returned here since boot415: use xhci_wait_eps() with the endpoints.
+ */
+static int xhci_wait_event(uint32_t ev[4], int timeout_ms) {
+    return evt_wait(0, 0, ev, timeout_ms, 0);
+}
+
+/* xhci_wait_eps — wait for the next Transfer Event on any of slot_id's
+ * endpoints in dci_mask (bit n = DCI n) (boot416)                        */
+static int xhci_wait_eps(uint8_t slot_id, uint32_t dci_mask, uint32_t ev[4],
+                         int timeout_ms) {
+    if (slot_id == 0u || slot_id > (uint8_t)MAX_SLOTS_ALLOC) return -1;
+    return evt_wait(slot_id, dci_mask, ev, timeout_ms, 0);
+}
+
+/* xhci_poll_eps — the same, silent on timeout: for stream and interrupt
+ * polling, where finding nothing is the normal idle answer.             */
+static int xhci_poll_eps(uint8_t slot_id, uint32_t dci_mask, uint32_t ev[4],
+                         int timeout_ms) {
+    if (slot_id == 0u || slot_id > (uint8_t)MAX_SLOTS_ALLOC) return -1;
+    return evt_wait(slot_id, dci_mask, ev, timeout_ms, 1);
+}
+
+/*
+ * xhci_wait_trb — wait for the Transfer Event on (slot_id, dci) whose TRB
+ * pointer lies in [lo, hi], the bus addresses of a TD's first and last
+ * TRB (lo > hi when the TD runs through the ring's Link TRB).  Anything
+ * else on the endpoint is the completion of a TRB its owner gave up on —
+ * a timed-out control stage, an interrupt TRB left behind by the DMA
+ * fallback — and is counted and discarded rather than taken for ours.
+ */
+static int xhci_wait_trb(uint8_t slot_id, uint8_t dci, uint64_t lo, uint64_t hi,
+                         uint32_t ev[4], int timeout_ms, int quiet)
+{
+    uint32_t t0 = get_time_ms();
+
+    for (;;) {
+        uint32_t spent = get_time_ms() - t0;
+        int left = (spent < (uint32_t)timeout_ms) ? timeout_ms - (int)spent : 0;
+        if (slot_id == 0u || slot_id > (uint8_t)MAX_SLOTS_ALLOC ||
+            evt_wait(slot_id, 1u << dci, ev, left, quiet) != 0)
+            return -1;
+        uint64_t p = evt_trb_ptr(ev);
+        if (lo <= hi ? (p >= lo && p <= hi) : (p >= lo || p <= hi)) return 0;
+        evq_stale++;
+    }
+}
+
+/*
+ * xhci_irq_handler — VL805 MSI (GIC INTID 180), registered by pci.c.
  *
- * GIC registration was removed in boot87 (xHCI polling mode).
- * This handler should never be called.  If it somehow fires,
- * count it and clear the interrupt sources to prevent re-delivery.
+ * GIC registration was removed in boot87 (polling mode) and restored in
+ * boot415.  Ack the RC first so an event posted during the drain raises
+ * a fresh MSI, then move the ring into the software queues.  Until
+ * xhci_init() has finished, run_controller() owns the ring (it re-arms
+ * ERDP and resets evt_dequeue), so an early MSI is only counted.
  */
 void xhci_irq_handler(int vector, void *data) {
     (void)vector; (void)data;
     msi_fire_count++;
-    /* Clear both PCIe interrupt levels defensively */
     writel(0xFFFFFFFFU, pcie_base + 0x4508U);  /* PCIE_MSI_INTR0_CLR  W1C */
     writel(0xFFFFFFFFU, pcie_base + 0x4308U);  /* PCIE_INTR2_CPU_CLEAR W1C */
     asm volatile("dsb sy; isb" ::: "memory");
+    if (evt_irq_ready) evt_drain();
+}
+
+/* ── Control lock (boot415) ───────────────────────────────────────────────────
+ * The command ring and EP0 (active_slot, the enumeration sequence) carry
+ * state across their event waits, and those waits now yield — so two
+ * tasks issuing commands could take each other's Command Completion.
+ * Every public entry point that uses them holds this lock.  It is
+ * recursive (a probe run under xhci_check_hotplug issues control
+ * transfers); before the scheduler it is a no-op.  boot421: contenders
+ * sleep on it instead of yielding — a yield from a higher-priority task
+ * re-selects that task, so the holder could never run to release it.  */
+static sleeplock_t xhci_ctl = SLEEPLOCK_INIT;
+
+static void xhci_ctl_lock(void)
+{
+    sleeplock_lock(&xhci_ctl);
+}
+
+static void xhci_ctl_unlock(void)
+{
+    sleeplock_unlock(&xhci_ctl);
 }
+
 /* xhci_dma_phys — return physical base address of the xHCI DMA buffer.
  * Called by pci.c xhci_setup_msi() to compute the PCIe MSI target address. */
 uint64_t xhci_dma_phys(void) {
@@ -4335,12 +5885,14 @@ static void xhci_slot_teardown(uint8_t slot_id)
         }
         if (!got) uart_puts("[USB] Disable Slot: no CCE (timeout)\n");
     }
+    evq_flush_slot(slot_id);    /* boot415: drop its undelivered Transfer Events */
 
     /* ── 3. Zero DCBAA entry ─────────────────────────────────────────────── */
     dcbaa[slot_id] = 0ULL;
     asm volatile("dsb sy" ::: "memory");
 
     /* ── 4. Reset all ring-state arrays for this slot ────────────────────── */
+    int_stop_slot(slot_id);     /* boot417: before hid_device_disconnect frees */
     for (int i = 0; i < MAX_INT_EPS; i++) {
         int_ep_submitted[slot_id][i] = 0u;
         int_ep_enq[slot_id][i]       = 0u;
@@ -4354,10 +5906,13 @@ static void xhci_slot_teardown(uint8_t slot_id)
     bulk_out_enq[slot_id]   = 0u;
     bulk_in_cycle[slot_id]  = 1u;
     bulk_in_enq[slot_id]    = 0u;
+    bot_stage[slot_id].valid = 0u;
+    if (stream_slot == slot_id) stream_slot = 0u;
 
     /* ── 5. Notify HID layer ─────────────────────────────────────────────── */
     extern void hid_device_disconnect(uint8_t sid) __attribute__((weak));
     if (hid_device_disconnect) hid_device_disconnect(slot_id);
+    usb_enum_forget(&g_devs[slot_id]);  /* boot419: gone before it bound */
 
     uart_puts("[USB] Slot teardown complete.\n");
 }
@@ -4409,24 +5964,35 @@ int xhci_disconnect_hub_child(usb_device_t *hub_dev, uint8_t hub_port)
     uart_puts(" hub_port="); print_hex32(hub_port);
     uart_puts(" slot="); print_hex32(sid); uart_puts("\n");
 
+    xhci_ctl_lock();
     xhci_slot_teardown(sid);
+    xhci_ctl_unlock();
     hc_remove(hub_slot, hub_port);   /* free entry for re-enumeration */
     return 0;
 }
 
 /*
- * xhci_check_hotplug — drain the event ring for Port Status Change Events.
+ * xhci_check_hotplug — take Port Status Change Events off the controller
+ * event queue.
+ *
+ * Called from the wimp_task main loop (boot178).  boot415: Transfer Events
+ * sit in their slots' queues, so this can no longer eat an I/O task's
+ * completion; holding xhci_ctl_lock keeps it from eating a Command
+ * Completion another task is waiting for.
  *
- * Called from the wimp_task main loop (boot178) when no bulk/control
- * transfers are in flight.  The event ring is safe to consume here because
- * we are single-threaded polled: all prior transfers have already consumed
- * their completion events before wimp_task runs.
+ * boot418: PSCEs arrive on evq_port, filled from the MSI handler, so this
+ * runs on every wimp_task pass: with no port change queued it returns
+ * without touching the controller or taking the lock, and a plug is seen
+ * within one pass instead of up to 500 ms later.
  *
  * For each PSCE (TRB type 0x22 = 34):
  *   – Extract the root-hub port number from DW2 bits[31:24]
  *   – Read PORTSC to see whether a device connected or disconnected
  *   – Clear the change bits (W1C via PORTSC_WIC)
- *   – On connect: call enumerate_port() to enumerate the new device
+ *   – boot418: skip it unless CSC was set (reset completions also post)
+ *   – boot419: and a connect on a port whose state machine is running
+ *   – On connect: boot419: rp_start() — debounce, reset and enumerate
+ *     from the port's state machine (xhci_enum_step)
  *   – On disconnect: boot287: xhci_disconnect_slot() for full slot teardown
  *
  * Returns number of PSCE events processed.
@@ -4438,33 +6004,45 @@ int xhci_check_hotplug(void)
     uint32_t ev[4];
     int found = 0;
 
-    while (evt_ring_poll(ev)) {
-        uint32_t type = (ev[3] >> 10) & 0x3FU;
-        if (type != 0x22U) {
-            /* Not a PSCE — discard (unexpected mid-idle event) */
-            continue;
-        }
+    if (!evt_irq_ready) return 0;
+    evt_drain();                        /* in case the MSI went missing */
+    if (evq_port.count == 0u) return 0;
+
+    xhci_ctl_lock();
+    while (evq_take_port(ev)) {
 
         /* PSCE: port number is in DW2 bits[31:24], 1-indexed */
         uint32_t port1 = (ev[2] >> 24) & 0xFFU;
         if (port1 == 0 || port1 > (uint32_t)xhci_ctrl.max_ports) continue;
-        int port0 = (int)(port1 - 1u);   /* 0-indexed for enumerate_port() */
+        int port0 = (int)(port1 - 1u);   /* 0-indexed for rp_start() */
 
         void    *op     = xhci_ctrl.op_regs;
         uint32_t portsc = readl(op + 0x400 + port0 * 0x10);
 
-        /* Clear all W1C change bits, preserve PP and other RW bits */
-        writel((portsc & ~(PORTSC_CCS | PORTSC_PED)) | PORTSC_WIC,
+        /* Clear all W1C change bits, preserve PP and other RW bits.
+         * boot419: and never write back PR — the port's state machine
+         * may have a reset running.                                    */
+        writel((portsc & ~(PORTSC_CCS | PORTSC_PED | (1U << 4))) | PORTSC_WIC,
                op + 0x400 + port0 * 0x10);
         asm volatile("dsb sy" ::: "memory");
 
+        /* boot418: our own port resets post PSCEs too (PRC/WRC/PEC) —
+         * once nothing discards them, only a connect change is a plug. */
+        if (!(portsc & PORTSC_CSC)) continue;
+
         if (portsc & PORTSC_CCS) {
+            /* boot419: a port whose state machine is running is its own —
+             * a WPR can re-train the link and set CSC, and restarting
+             * the machine here would abort that enumeration.  The machine
+             * re-reads CCS at every step, so a real re-plug is not lost. */
+            if (port0 < 16 && rp_enum[port0].state != RP_IDLE) continue;
             uart_puts("[USB] Root-hub hotplug: device connected on port ");
             print_hex32(port1); uart_puts("\n");
-            enumerate_port(port0);
+            rp_start(port0, 1);
         } else {
             uart_puts("[USB] Root-hub hotplug: device disconnected from port ");
             print_hex32(port1); uart_puts("\n");
+            rp_stop(port0);             /* boot419: mid-enumeration */
 
             /* boot287: Full slot teardown — Stop Endpoints, Disable Slot,
              * clear ring state, notify HID layer.                          */
@@ -4476,5 +6054,6 @@ int xhci_check_hotplug(void)
         }
         found++;
     }
+    xhci_ctl_unlock();
     return found;
 }
@@ -88,6 +88,8 @@ typedef struct xhci_controller {
     uint8_t   ac64;          /**< 64-bit addressing capable */
     uint8_t   csz;           /**< Context size: 0=32B, 1=64B */
     uint16_t  xecp;          /**< xECP: HCCPARAMS1[31:16], xHCI Ext Cap Ptr (DWORDs from cap_regs) */
+    uint8_t   max_psa;       /**< MaxPSASize: HCCPARAMS1[15:12], 0 = no streams */
+    uint8_t   erst_max;      /**< ERST Max: HCSPARAMS2[7:4], log2 event ring segments */
 
     uint32_t *dcbaa;         /**< Device Context Base Address Array */
     uint64_t  dcbaa_phys;    /**< Physical address of DCBAA */
@@ -130,8 +132,8 @@ xhci_controller_t *xhci_get_controller(void);
 /**
  * @brief Scan USB ports for connected devices
  *
- * Checks all ports and enumerates newly connected devices.
- * Should be called after initialization and on port change interrupts.
+ * Starts enumeration of every connected port (boot419: the resets run
+ * concurrently from xhci_enum_step(); usb_enum_settle() waits for them).
  *
  * @return Number of devices found, or negative on error
  * @since v56
@@ -189,6 +191,101 @@ int xhci_control_transfer(usb_device_t *dev,
  */
 int xhci_bulk_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeout);
 
+/* boot411: one pipelined Bulk-Only Transport command (xhci_bot_command) */
+#define XHCI_BOT_CBW    1       /* failed stage: command wrapper          */
+#define XHCI_BOT_DATA   2       /*               data phase (e.g. STALL)  */
+#define XHCI_BOT_CSW    3       /*               status wrapper           */
+
+typedef struct xhci_bot_cmd {
+    const void *cbw;            /* 31-byte Command Block Wrapper          */
+    void       *data;           /* data phase buffer, NULL for none       */
+    uint32_t    len;
+    int         dir_in;         /* data phase direction                   */
+    void       *csw;            /* 13-byte Command Status Wrapper (out)   */
+    const void *next_cbw;       /* next command's CBW to send ahead, or NULL */
+    uint32_t    actual;         /* out: data bytes moved                  */
+    int         failed;         /* out: XHCI_BOT_* stage, 0 on success    */
+} xhci_bot_cmd_t;
+
+/**
+ * @brief Run a BOT command with CBW, data and CSW queued together.
+ *
+ * If next_cbw is set it is sent as soon as this command's CSW arrives; the
+ * next call must then pass that same CBW, which is recognised as already
+ * sent.  On failure the bulk rings need xhci_ep_recover() before reuse.
+ *
+ * @return 0 on success, -1 with cmd->failed set on error or timeout
+ * @since boot411
+ */
+int xhci_bot_command(usb_endpoint_t *out, usb_endpoint_t *in,
+                     xhci_bot_cmd_t *cmd, int timeout);
+
+/* boot413: the most one plain bulk TD moves zero-copy — larger transfers
+ * are split into several TDs and lose BOT pipelining.                   */
+#define XHCI_BULK_TD_MAX_XFER   (1024u * 1024u)
+
+/* boot412: bulk streams (UAS).  One device at a time; a stream TD moves at
+ * most XHCI_STREAM_MAX_XFER bytes.                                        */
+#define XHCI_STREAM_MAX_XFER    (256u * 1024u)
+#define XHCI_CC_SUCCESS         1       /* completion codes (xHCI §6.4.5) */
+#define XHCI_CC_SHORT_PKT       13
+
+/**
+ * @brief Give a device's bulk pipes stream rings.
+ *
+ * Re-adds each of the n endpoints with a Configure Endpoint command.  Those
+ * with max_streams set get a Primary Stream Array and one ring per stream
+ * ID; the rest keep a plain ring.  Calling it again resets every pipe and
+ * drops all outstanding TDs.  xhci_configure_endpoints() undoes it.
+ *
+ * @return streams granted (IDs 1..n), or -1 if the controller or the
+ *         endpoints cannot do streams
+ * @since boot412
+ */
+int xhci_alloc_streams(usb_device_t *dev, usb_endpoint_t **eps, int n,
+                       int nstreams);
+
+/**
+ * @brief Queue one TD on a stream and ring its doorbell.
+ *
+ * On an endpoint without streams the ID only names the completion slot.
+ * Each (endpoint, stream) takes one TD at a time; its result is collected
+ * with xhci_stream_result() after xhci_stream_poll() has reaped it.
+ *
+ * @return 0 if queued, -1 if the slot is busy or the buffer unsuitable
+ * @since boot412
+ */
+int xhci_stream_submit(usb_endpoint_t *ep, uint16_t stream, void *data,
+                       size_t len);
+
+/**
+ * @brief Reap Transfer Events for the stream device.
+ *
+ * Waits up to timeout_ms for the first event, then drains the rest.
+ *
+ * @return TDs completed (0 on timeout), or -1 if the controller reported
+ *         an error no TD could be matched to (pipe needs resetting)
+ * @since boot412
+ */
+int xhci_stream_poll(int timeout_ms);
+
+/**
+ * @brief Collect a stream TD's completion and free its slot.
+ *
+ * @return the completion code, 0 while still pending, -1 if none queued
+ * @since boot412
+ */
+int xhci_stream_result(usb_endpoint_t *ep, uint16_t stream, uint32_t *actual);
+
+/**
+ * @brief Synchronous transfer on one stream.
+ *
+ * @return bytes transferred, or -1 on error or timeout
+ * @since boot412
+ */
+int xhci_stream_transfer(usb_endpoint_t *ep, void *data, size_t len,
+                         int timeout, uint16_t stream);
+
 /**
  * @brief USB interrupt transfer stub.
  *
@@ -204,6 +301,52 @@ int xhci_bulk_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeout);
  */
 int xhci_interrupt_transfer(usb_endpoint_t *ep, void *data, size_t len, int timeout);
 
+/**
+ * @brief Completion callback of a pre-posted interrupt IN endpoint.
+ *
+ * Called with the event lock held and interrupts masked, possibly from
+ * the MSI handler: decode and queue, do not block or transfer.
+ *
+ * @param ctx   Caller's pointer from xhci_interrupt_start()
+ * @param data  Report bytes (valid only during the call)
+ * @param len   Bytes received
+ * @param t_ms  get_time_ms() when the completion was taken off the ring
+ * @since boot417
+ */
+typedef usb_int_cb_t xhci_int_cb_t;
+
+/**
+ * @brief Keep an interrupt IN endpoint armed with several TRBs and deliver
+ *        each report to a callback.
+ *
+ * Once started, xhci_interrupt_transfer() on the endpoint returns 0.
+ *
+ * @param ep   Interrupt IN endpoint configured by xhci_configure_endpoints()
+ * @param len  Report size (at most 64)
+ * @param cb   Completion callback
+ * @param ctx  Passed to cb
+ * @return 0 on success (or already started), -1 if not an xHCI endpoint
+ * @since boot417
+ */
+int xhci_interrupt_start(usb_endpoint_t *ep, size_t len, xhci_int_cb_t cb, void *ctx);
+
+/**
+ * @brief Drain the event ring without waiting.
+ *
+ * Runs pre-posted endpoint callbacks when MSIs are not being delivered.
+ * @since boot417
+ */
+void xhci_service_events(void);
+
+/**
+ * @brief Advance the root-port enumeration state machines.
+ *
+ * Called from usb_enum_run(); each call moves every port whose debounce,
+ * reset or recovery deadline has passed on to its next step.
+ * @since boot419
+ */
+void xhci_enum_step(void);
+
 /**
  * @brief Enumerate a USB device on a given port.
  *
@@ -4,11 +4,15 @@
  * (NVMe, USB Mass Storage, SATA AHCI, MMC/SD, etc.)
  * Integrates with VFS and FileCore
  * Author: R Andrews – 06 Feb 2026
+ * Updated: boot409 – Oct 2026 – asynchronous submit/complete requests
+ * Updated: boot413 – Oct 2026 – split requests to device transfer limits
+ * Updated: boot414 – Oct 2026 – request queue: merge, deadline elevator, counters
  */
 
 #include "kernel.h"
 #include "blockdriver.h"
 #include "vfs.h"
+#include "spinlock.h"
 // // #include <string.h> /* removed - use kernel.h */ /* removed - use kernel.h */
 
 #define MAX_BLOCKDEVS   16
@@ -44,6 +48,12 @@ blockdev_t *blockdev_register(const char *name, uint64_t size, uint32_t block_si
     dev->unit = blockdev_count;
     dev->private = NULL;
     dev->ops = NULL;
+    dev->next_tag = 0;
+    dev->max_xfer = 0;
+    dev->opt_xfer = 0;
+    dev->xfer_gran = 0;
+    dev->qdepth = 0;
+    memset(&dev->queue, 0, sizeof(dev->queue));
 
     blockdev_list[blockdev_count++] = dev;
 
@@ -76,6 +86,67 @@ blockdev_t *blockdev_get(const char *name, int unit)
     return NULL;
 }
 
+/* ── Request splitting (boot413) ─────────────────────────────────────────────
+ * Drivers fill max_xfer / opt_xfer / xfer_gran from what the device reports
+ * (SCSI Block Limits VPD, NVMe MDTS, ...) and what their transport moves
+ * in one go.  A request the device takes whole passes through untouched;
+ * a larger one is cut into pieces of the largest multiple of opt_xfer
+ * that fits max_xfer, each ending on an xfer_gran boundary, so a long
+ * sequential transfer runs at the size the device does best.            */
+static uint32_t blockdev_piece(const blockdev_t *dev, uint64_t lba, uint32_t count)
+{
+    uint32_t n = dev->max_xfer;
+    if (!n || count <= n) return count;
+    if (dev->opt_xfer && dev->opt_xfer <= n)
+        n -= n % dev->opt_xfer;
+    if (dev->xfer_gran > 1u) {
+        uint32_t over = (uint32_t)((lba + n) % dev->xfer_gran);
+        if (over < n) n -= over;
+    }
+    return n;
+}
+
+static ssize_t blockdev_rw_direct(blockdev_t *dev, uint64_t lba, uint32_t count,
+                                  void *buf, int write)
+{
+    if (blockdev_piece(dev, lba, count) == count)
+        return write ? dev->ops->write(dev, lba, count, buf)
+                     : dev->ops->read(dev, lba, count, buf);
+
+    uint8_t *p = (uint8_t *)buf;
+    for (uint32_t done = 0; done < count; ) {
+        uint32_t n = blockdev_piece(dev, lba + done, count - done);
+        ssize_t r = write ? dev->ops->write(dev, lba + done, n, p)
+                          : dev->ops->read(dev, lba + done, n, p);
+        if (r < 0) return -1;
+        done += n;
+        p    += (size_t)n * dev->block_size;
+    }
+    return (ssize_t)count;
+}
+
+/* boot414: devices with a submit op take synchronous I/O through their
+ * request queue too, so it merges with everyone else's; the caller just
+ * waits for it.  Without a scheduler the queue is bypassed.            */
+static int blkq_queue(blockdev_req_t *req);
+
+static ssize_t blockdev_rw(blockdev_t *dev, uint64_t lba, uint32_t count,
+                           void *buf, int write)
+{
+    if (dev->ops->submit && current_task) {
+        blockdev_req_t req;
+        memset(&req, 0, sizeof(req));
+        req.dev   = dev;
+        req.op    = write ? BLOCKDEV_WRITE : BLOCKDEV_READ;
+        req.lba   = lba;
+        req.count = count;
+        req.buf   = buf;
+        if (blockdev_submit(&req) == 0)
+            return blockdev_wait(&req) < 0 ? -1 : (ssize_t)count;
+    }
+    return blockdev_rw_direct(dev, lba, count, buf, write);
+}
+
 /* Read from block device (VFS wrapper) */
 ssize_t blockdev_read(blockdev_t *dev, uint64_t lba, uint32_t count, void *buf)
 {
@@ -83,7 +154,7 @@ ssize_t blockdev_read(blockdev_t *dev, uint64_t lba, uint32_t count, void *buf)
         debug_print("BlockDriver: No read operation for %s\n", dev ? dev->name : "NULL");
         return -1;
     }
-    return dev->ops->read(dev, lba, count, buf);
+    return blockdev_rw(dev, lba, count, buf, 0);
 }
 
 /* Write to block device */
@@ -93,7 +164,501 @@ ssize_t blockdev_write(blockdev_t *dev, uint64_t lba, uint32_t count, const void
         debug_print("BlockDriver: No write operation for %s\n", dev ? dev->name : "NULL");
         return -1;
     }
-    return dev->ops->write(dev, lba, count, buf);
+    return blockdev_rw(dev, lba, count, (void *)buf, 1);
+}
+
+/* ── Asynchronous requests (boot409) ─────────────────────────────────────────
+ * Drivers with a submit op queue the request and finish it from their own
+ * I/O task, so the caller is free until it chooses to wait.  Anything the
+ * driver declines — no submit op, or no scheduler yet — runs synchronously
+ * here and is complete when blockdev_submit() returns.  req_lock orders
+ * the done/waiter hand-off between blockdev_wait and blockdev_complete. */
+static spinlock_t req_lock = SPINLOCK_INIT;
+
+/* boot413: each piece of a split request is a request of its own; the
+ * original completes when the last piece does.                         */
+static void blockdev_piece_done(blockdev_req_t *piece)
+{
+    blockdev_req_t *req = piece->parent;
+    if (piece->result < 0)
+        __atomic_store_n(&req->failed, 1, __ATOMIC_RELAXED);
+    kfree(piece);
+    if (__atomic_sub_fetch(&req->pieces, 1u, __ATOMIC_ACQ_REL) == 0)
+        blockdev_complete(req, req->failed ? -1 : (ssize_t)req->count);
+}
+
+/* Queue req as pieces that fit the device.  -1 (nothing queued) if the
+ * pieces cannot be allocated.                                          */
+static int blockdev_submit_split(blockdev_req_t *req)
+{
+    blockdev_t *dev = req->dev;
+    blockdev_req_t *list = NULL, **tail = &list;
+    uint32_t pieces = 0;
+
+    for (uint32_t done = 0; done < req->count; pieces++) {
+        uint32_t n = blockdev_piece(dev, req->lba + done, req->count - done);
+        blockdev_req_t *p = kmalloc(sizeof(blockdev_req_t));
+        if (!p) {
+            while (list) { p = list->next; kfree(list); list = p; }
+            return -1;
+        }
+        memset(p, 0, sizeof(*p));
+        p->dev     = dev;
+        p->op      = req->op;
+        p->lba     = req->lba + done;
+        p->count   = n;
+        p->buf     = (uint8_t *)req->buf + (size_t)done * dev->block_size;
+        p->done_fn = blockdev_piece_done;
+        p->parent  = req;
+        *tail = p;
+        tail  = &p->next;
+        done += n;
+    }
+
+    req->failed = 0;
+    req->pieces = pieces;
+    while (list) {
+        blockdev_req_t *p = list;
+        list = p->next;
+        blockdev_submit(p);
+    }
+    return 0;
+}
+
+/* ── Request queue (boot414) ─────────────────────────────────────────────────
+ * Requests for a device with a submit op wait on dev->queue, and the BlkQ
+ * task turns them into driver commands, keeping qdepth in flight:
+ *
+ *  - a command starts from the oldest request once its deadline has
+ *    passed, otherwise from the lowest LBA at or after the elevator
+ *    position (one-way sweep, wrapping back to the lowest);
+ *  - waiting requests in the same direction that touch it — adjacent,
+ *    or for reads overlapping — join it, up to max_xfer blocks, staged
+ *    through one bounce buffer unless their buffers already line up;
+ *  - only requests ahead of the first conflict — one overlapping an
+ *    earlier waiting or in-flight request, with a write on either side —
+ *    are candidates, so nothing overtakes a write it depends on.
+ *
+ * Batching window: while a device already has a command in flight, a
+ * request is held until it is BLKQ_BATCH_MS old (BlkQ sleeps with
+ * task_wake_after), so submitters at any priority get to queue behind it
+ * and merge.  An idle device is fed at once — holding a lone synchronous
+ * read back would only add latency.  A command that cannot be allocated
+ * is retried after BLKQ_RETRY_MS rather than waiting for another kick.  */
+#define BLKQ_DEPTH          2u      /* qdepth when the driver sets none        */
+#define BLKQ_SCAN           32      /* waiting requests considered per command */
+#define BLKQ_MERGE_MAX      256u    /* blocks per command without max_xfer     */
+#define BLKQ_READ_DL_MS     50u
+#define BLKQ_WRITE_DL_MS    500u
+#define BLKQ_BATCH_MS       1u
+#define BLKQ_RETRY_MS       10u
+
+typedef struct blkq_cmd {
+    blockdev_req_t   req;           /* what the driver sees — keep first   */
+    blockdev_req_t  *parts;         /* requests it carries, in LBA order   */
+    uint8_t         *bounce;        /* merged buffer, or NULL              */
+    struct blkq_cmd *active_next;   /* queue->active link                  */
+} blkq_cmd_t;
+
+static task_t *blkq_task = NULL;
+
+static inline uint64_t blkq_ticks(void)
+{
+    uint64_t t;
+    __asm__ volatile("isb; mrs %0, cntpct_el0" : "=r"(t) :: "memory");
+    return t;
+}
+
+static inline uint64_t blkq_freq(void)
+{
+    uint64_t f;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(f));
+    return f ? f : 1u;
+}
+
+static int blkq_conflict(const blockdev_req_t *a, const blockdev_req_t *b)
+{
+    if (a->op != BLOCKDEV_WRITE && b->op != BLOCKDEV_WRITE) return 0;
+    return a->lba < b->lba + b->count && b->lba < a->lba + a->count;
+}
+
+/* Take the next command's requests off q and wrap them; NULL if nothing
+ * can go yet, with *nomem set if that was for lack of memory.  Called
+ * with q->lock held.                                                    */
+static blkq_cmd_t *blkq_build(blockdev_t *dev, int *nomem)
+{
+    blockdev_queue_t *q = &dev->queue;
+    blockdev_req_t *cand[BLKQ_SCAN];
+    uint8_t taken[BLKQ_SCAN];
+    int n = 0;
+
+    for (blockdev_req_t *r = q->head; r && n < BLKQ_SCAN; r = r->next) {
+        int blocked = 0;
+        for (int i = 0; i < n && !blocked; i++)
+            blocked = blkq_conflict(cand[i], r);
+        for (blkq_cmd_t *a = (blkq_cmd_t *)q->active; a && !blocked; a = a->active_next)
+            blocked = blkq_conflict(&a->req, r);
+        if (blocked) break;
+        taken[n] = 0;
+        cand[n++] = r;
+    }
+    if (n == 0) return NULL;
+
+    /* First request: the oldest if overdue, else the elevator's next */
+    int pick = 0, expired = 0;
+    uint64_t dl_ms = (cand[0]->op == BLOCKDEV_WRITE) ? BLKQ_WRITE_DL_MS : BLKQ_READ_DL_MS;
+    if (blkq_ticks() - cand[0]->t_queued > dl_ms * (blkq_freq() / 1000u)) {
+        expired = 1;
+    } else {
+        int ahead = -1, lowest = 0;
+        for (int i = 0; i < n; i++) {
+            if (cand[i]->lba < cand[lowest]->lba) lowest = i;
+            if (cand[i]->lba >= q->pos &&
+                (ahead < 0 || cand[i]->lba < cand[ahead]->lba)) ahead = i;
+        }
+        pick = (ahead >= 0) ? ahead : lowest;
+    }
+
+    /* Grow [lo, hi) with touching requests of the same direction */
+    int op = cand[pick]->op, parts = 1;
+    uint64_t lo = cand[pick]->lba, hi = lo + cand[pick]->count;
+    uint32_t cap = dev->max_xfer ? dev->max_xfer : BLKQ_MERGE_MAX;
+    if (cap < cand[pick]->count) cap = cand[pick]->count;
+    taken[pick] = 1;
+    for (int grew = 1; grew; ) {
+        grew = 0;
+        for (int i = 0; i < n; i++) {
+            blockdev_req_t *r = cand[i];
+            if (taken[i] || r->op != op) continue;
+            if (r->lba > hi || r->lba + r->count < lo) continue;
+            uint64_t nlo = (r->lba < lo) ? r->lba : lo;
+            uint64_t nhi = (r->lba + r->count > hi) ? r->lba + r->count : hi;
+            if (nhi - nlo > cap) continue;
+            lo = nlo; hi = nhi;
+            taken[i] = 1;
+            parts++;
+            grew = 1;
+        }
+    }
+
+    blkq_cmd_t *c = kmalloc(sizeof(blkq_cmd_t));
+    if (!c) { *nomem = 1; return NULL; }
+    memset(c, 0, sizeof(*c));
+
+    /* One buffer for the command: the parts' own if they tile it in order */
+    uint32_t bs = dev->block_size;
+    uint8_t *base = NULL;
+    int tiled = 1;
+    for (int i = 0; i < n; i++) {
+        if (!taken[i]) continue;
+        if (cand[i]->lba == lo && !base) base = (uint8_t *)cand[i]->buf;
+    }
+    for (int i = 0; i < n && tiled; i++)
+        for (int j = i + 1; j < n && tiled; j++)
+            if (taken[i] && taken[j] &&
+                cand[i]->lba < cand[j]->lba + cand[j]->count &&
+                cand[j]->lba < cand[i]->lba + cand[i]->count)
+                tiled = 0;                              /* overlapping reads */
+    for (int i = 0; i < n && tiled; i++)
+        if (taken[i] && (uint8_t *)cand[i]->buf != base + (size_t)(cand[i]->lba - lo) * bs)
+            tiled = 0;
+    if (!tiled) {
+        c->bounce = kmalloc((size_t)(hi - lo) * bs);
+        if (!c->bounce) {                       /* no memory: just the pick */
+            for (int i = 0; i < n; i++) taken[i] = (i == pick);
+            lo = cand[pick]->lba;
+            hi = lo + cand[pick]->count;
+            base = (uint8_t *)cand[pick]->buf;
+            parts = 1;
+        }
+    }
+
+    /* Unlink the taken requests; c->parts keeps them sorted by LBA */
+    for (int i = 0; i < n; i++) {
+        if (!taken[i]) continue;
+        blockdev_req_t *r = cand[i], **pp = &q->head, *prev = NULL;
+        while (*pp != r) { prev = *pp; pp = &(*pp)->next; }
+        *pp = r->next;
+        if (q->tail == r) q->tail = prev;
+        q->depth--;
+
+        blockdev_req_t **ins = &c->parts;
+        while (*ins && (*ins)->lba <= r->lba) ins = &(*ins)->next;
+        r->next = *ins;
+        *ins = r;
+        if (c->bounce && op == BLOCKDEV_WRITE)
+            memcpy(c->bounce + (size_t)(r->lba - lo) * bs, r->buf, (size_t)r->count * bs);
+    }
+
+    c->req.dev    = dev;
+    c->req.op     = op;
+    c->req.lba    = lo;
+    c->req.count  = (uint32_t)(hi - lo);
+    c->req.buf    = c->bounce ? c->bounce : base;
+    c->req.tag    = __atomic_fetch_add(&dev->next_tag, 1u, __ATOMIC_RELAXED);
+    c->req.result = -1;
+
+    c->active_next = (blkq_cmd_t *)q->active;
+    q->active = &c->req;
+    q->inflight++;
+    q->pos = hi;
+    q->stats.commands++;
+    q->stats.merged  += (uint64_t)(parts - 1);
+    q->stats.expired += (uint64_t)expired;
+    return c;
+}
+
+/* The driver finished a command: hand each request its part */
+static void blkq_cmd_done(blockdev_req_t *req)
+{
+    blkq_cmd_t *c = (blkq_cmd_t *)req;
+    blockdev_t *dev = req->dev;
+    blockdev_queue_t *q = &dev->queue;
+    uint32_t bs = dev->block_size;
+    int ok = (req->result >= 0);
+    uint64_t now = blkq_ticks(), freq = blkq_freq();
+    unsigned long flags;
+
+    spin_lock_irqsave(&q->lock, &flags);
+    blkq_cmd_t **pp = (blkq_cmd_t **)&q->active;
+    while (*pp && *pp != c) pp = &(*pp)->active_next;
+    if (*pp) *pp = c->active_next;
+    q->inflight--;
+    q->kick = 1;
+    for (blockdev_req_t *p = c->parts; p; p = p->next) {
+        uint32_t us = (uint32_t)((now - p->t_queued) * 1000000u / freq);
+        q->stats.completed++;
+        q->stats.lat_sum_us += us;
+        if (us > q->stats.lat_max_us) q->stats.lat_max_us = us;
+    }
+    spin_unlock_irqrestore(&q->lock, flags);
+
+    blockdev_req_t *p = c->parts;
+    while (p) {
+        blockdev_req_t *nx = p->next;           /* p may be freed below */
+        if (ok && c->bounce && p->op == BLOCKDEV_READ)
+            memcpy(p->buf, c->bounce + (size_t)(p->lba - req->lba) * bs,
+                   (size_t)p->count * bs);
+        p->next = NULL;
+        blockdev_complete(p, ok ? (ssize_t)p->count : -1);
+        p = nx;
+    }
+    if (c->bounce) kfree(c->bounce);
+    kfree(c);
+    if (blkq_task) task_wakeup(blkq_task);
+}
+
+/* Fill the device's free command slots; -1 if a command could not be
+ * allocated and requests were left waiting.                            */
+static int blkq_dispatch(blockdev_t *dev)
+{
+    blockdev_queue_t *q = &dev->queue;
+    uint32_t depth = dev->qdepth ? dev->qdepth : BLKQ_DEPTH;
+    unsigned long flags;
+    int nomem = 0;
+
+    for (;;) {
+        blkq_cmd_t *c = NULL;
+        spin_lock_irqsave(&q->lock, &flags);
+        if (q->inflight < depth && q->head) c = blkq_build(dev, &nomem);
+        spin_unlock_irqrestore(&q->lock, flags);
+        if (!c) return nomem ? -1 : 0;
+
+        c->req.done_fn = blkq_cmd_done;
+        if (dev->ops->submit(dev, &c->req) == 0) continue;
+        ssize_t r = blockdev_rw_direct(dev, c->req.lba, c->req.count, c->req.buf,
+                                       c->req.op == BLOCKDEV_WRITE);
+        blockdev_complete(&c->req, r < 0 ? -1 : (ssize_t)c->req.count);
+    }
+}
+
+/* How long the batching window still holds the kicked queues back: 0 as
+ * soon as any of them is idle or has a request older than BLKQ_BATCH_MS */
+static uint32_t blkq_window_ms(void)
+{
+    uint64_t now = blkq_ticks(), freq = blkq_freq();
+    uint64_t win = BLKQ_BATCH_MS * (freq / 1000u), wait = 0;
+    unsigned long flags;
+
+    for (int i = 0; i < blockdev_count; i++) {
+        blockdev_t *dev = blockdev_list[i];
+        if (!dev || !__atomic_load_n(&dev->queue.kick, __ATOMIC_ACQUIRE)) continue;
+        blockdev_queue_t *q = &dev->queue;
+        uint64_t left = 0;
+        int waiting;
+        spin_lock_irqsave(&q->lock, &flags);
+        waiting = (q->head != NULL);
+        if (waiting && q->inflight > 0 && now - q->head->t_queued < win)
+            left = win - (now - q->head->t_queued);
+        spin_unlock_irqrestore(&q->lock, flags);
+        if (waiting && left == 0) return 0;
+        if (left > wait) wait = left;
+    }
+    return (uint32_t)((wait * 1000u + freq - 1u) / freq);
+}
+
+static void blkq_worker(void)
+{
+    /* Drivers' submit ops may wait on completion IRQs; tasks start masked */
+    asm volatile("msr daifclr, #2" ::: "memory");
+
+    for (;;) {
+        /* Batching window: see above.  Woken early by a submit or a
+         * completion, re-check — the device may have gone idle.        */
+        uint32_t ms;
+        while ((ms = blkq_window_ms()) != 0) {
+            task_wake_after(ms);
+            current_task->state = TASK_BLOCKED;
+            schedule();
+        }
+        current_task->wake_at = 0;
+
+        int retry = 0;
+        for (int i = 0; i < blockdev_count; i++) {
+            blockdev_t *dev = blockdev_list[i];
+            if (dev && __atomic_exchange_n(&dev->queue.kick, 0, __ATOMIC_ACQ_REL) &&
+                blkq_dispatch(dev) < 0)
+                retry = 1;
+        }
+
+        /* Idle: sleep until a submit or a completion kicks a queue, or
+         * until it is time to retry a failed allocation               */
+        current_task->state = TASK_BLOCKED;
+        if (retry) task_wake_after(BLKQ_RETRY_MS);
+        for (int i = 0; i < blockdev_count; i++)
+            if (blockdev_list[i] &&
+                __atomic_load_n(&blockdev_list[i]->queue.kick, __ATOMIC_ACQUIRE))
+                current_task->state = TASK_RUNNING;
+        if (current_task->state == TASK_BLOCKED) schedule();
+        current_task->wake_at = 0;
+
+        if (retry)
+            for (int i = 0; i < blockdev_count; i++)
+                if (blockdev_list[i] && blockdev_list[i]->queue.head)
+                    __atomic_store_n(&blockdev_list[i]->queue.kick, 1, __ATOMIC_RELEASE);
+    }
+}
+
+/* Queue req for BlkQ; -1 before the scheduler runs */
+static int blkq_queue(blockdev_req_t *req)
+{
+    blockdev_t *dev = req->dev;
+    blockdev_queue_t *q = &dev->queue;
+    unsigned long flags;
+
+    if (!current_task) return -1;
+    if (!blkq_task)
+        blkq_task = task_create("BlkQ", blkq_worker, BLOCKDEV_IO_PRIORITY, 0);
+    if (!blkq_task) return -1;
+
+    req->t_queued = blkq_ticks();
+    req->next = NULL;
+    spin_lock_irqsave(&q->lock, &flags);
+    if (q->tail) q->tail->next = req;
+    else         q->head = req;
+    q->tail = req;
+    q->depth++;
+    q->stats.queued++;
+    if (q->depth > q->stats.depth_max) q->stats.depth_max = q->depth;
+    q->kick = 1;
+    spin_unlock_irqrestore(&q->lock, flags);
+
+    task_wakeup(blkq_task);
+    return 0;
+}
+
+int blockdev_submit(blockdev_req_t *req)
+{
+    if (!req || !req->dev || !req->dev->ops || !req->buf) return -1;
+    blockdev_t *dev = req->dev;
+
+    req->tag    = __atomic_fetch_add(&dev->next_tag, 1u, __ATOMIC_RELAXED);
+    req->result = -1;
+    req->done   = 0;
+    req->waiter = NULL;
+    req->next   = NULL;
+
+    if (dev->ops->submit) {
+        if (blockdev_piece(dev, req->lba, req->count) < req->count) {
+            if (blockdev_submit_split(req) == 0) return 0;
+        } else if (blkq_queue(req) == 0 || dev->ops->submit(dev, req) == 0) {
+            return 0;
+        }
+    }
+
+    /* Drivers' sync ops report blocks or bytes — both mean "all of it" */
+    int write = (req->op == BLOCKDEV_WRITE);
+    ssize_t r = -1;
+    if (write ? dev->ops->write != NULL : dev->ops->read != NULL)
+        r = blockdev_rw_direct(dev, req->lba, req->count, req->buf, write);
+    blockdev_complete(req, r < 0 ? -1 : (ssize_t)req->count);
+    return 0;
+}
+
+/* Called by the driver exactly once per accepted request */
+void blockdev_complete(blockdev_req_t *req, ssize_t result)
+{
+    unsigned long flags;
+    req->result = result;
+
+    if (req->done_fn) {                 /* callback owns req from here */
+        req->done = 1;
+        req->done_fn(req);
+        return;
+    }
+
+    spin_lock_irqsave(&req_lock, &flags);
+    req->done = 1;
+    task_t *w = req->waiter;
+    spin_unlock_irqrestore(&req_lock, flags);
+    if (w) task_wakeup(w);
+}
+
+/* Sleep until req completes; spins before the scheduler is running */
+ssize_t blockdev_wait(blockdev_req_t *req)
+{
+    unsigned long flags;
+    for (;;) {
+        spin_lock_irqsave(&req_lock, &flags);
+        if (req->done) {
+            spin_unlock_irqrestore(&req_lock, flags);
+            return req->result;
+        }
+        task_t *self = current_task;
+        if (self) {
+            req->waiter = self;
+            self->state = TASK_BLOCKED;
+        }
+        spin_unlock_irqrestore(&req_lock, flags);
+        if (self) schedule();
+    }
+}
+
+void blockdev_reqq_push(blockdev_reqq_t *q, blockdev_req_t *req)
+{
+    unsigned long flags;
+    req->next = NULL;
+    spin_lock_irqsave(&q->lock, &flags);
+    if (q->tail) q->tail->next = req;
+    else         q->head = req;
+    q->tail = req;
+    q->depth++;
+    spin_unlock_irqrestore(&q->lock, flags);
+}
+
+blockdev_req_t *blockdev_reqq_pop(blockdev_reqq_t *q)
+{
+    unsigned long flags;
+    spin_lock_irqsave(&q->lock, &flags);
+    blockdev_req_t *req = q->head;
+    if (req) {
+        q->head = req->next;
+        if (!q->head) q->tail = NULL;
+        q->depth--;
+        req->next = NULL;
+    }
+    spin_unlock_irqrestore(&q->lock, flags);
+    return req;
 }
 
 /* TRIM / DISCARD */
@@ -185,3 +750,19 @@ void blockdev_print_all(void)
     }
     debug_print("[Devices] ---\n");
 }
+
+/* boot414: request-queue counters, one line per device that has used it */
+void blockdev_print_stats(void)
+{
+    for (int i = 0; i < blockdev_count; i++) {
+        blockdev_t *d = blockdev_list[i];
+        if (!d || !d->queue.stats.queued) continue;
+        blockdev_qstats_t *st = &d->queue.stats;
+        uint32_t pct = (uint32_t)(st->merged * 100u / st->queued);
+        uint32_t avg = st->completed ? (uint32_t)(st->lat_sum_us / st->completed) : 0u;
+        debug_print("[BlkQ] %s: %u reqs -> %u cmds, %u%% merged, %u expired, "
+                    "depth max %u, latency avg %u us max %u us\n",
+                    d->name, (uint32_t)st->queued, (uint32_t)st->commands, pct,
+                    (uint32_t)st->expired, st->depth_max, avg, st->lat_max_us);
+    }
+}
@@ -3,6 +3,9 @@
  * Defines the standard block device API used by NVMe, USB, SATA, MMC, etc.
  * Integrates with VFS and FileCore
  * Author: R Andrews – 06 Feb 2026
+ * Updated: boot409 – Oct 2026 – asynchronous blockdev_submit() / completion
+ * Updated: boot413 – Oct 2026 – per-device transfer limits, request splitting
+ * Updated: boot414 – Oct 2026 – request queue: merging, deadline elevator, counters
  */
 
 #ifndef BLOCKDRIVER_H
@@ -12,6 +15,7 @@
 
 /* Block device structure */
 typedef struct blockdev blockdev_t;
+typedef struct blockdev_req blockdev_req_t;
 
 /* Block device operations */
 typedef struct blockdev_ops {
@@ -29,8 +33,80 @@ typedef struct blockdev_ops {
 
     /* Shutdown / cleanup */
     void (*close)(blockdev_t *dev);
+
+    /* Queue a request (optional, boot409).  Return 0 once accepted — the
+     * driver then calls blockdev_complete() — or -1 to have the block
+     * layer run it synchronously through read/write instead.            */
+    int (*submit)(blockdev_t *dev, blockdev_req_t *req);
 } blockdev_ops_t;
 
+/* ── Asynchronous requests (boot409) ─────────────────────────────────────────
+ * Fill dev/op/lba/count/buf (and optionally done_fn/cookie), then
+ * blockdev_submit().  Completion is either the done_fn callback, run in
+ * the driver's I/O task, or blockdev_wait() — not both: a request with a
+ * done_fn may be freed by it.  The request must stay valid until then.  */
+#define BLOCKDEV_READ   0
+#define BLOCKDEV_WRITE  1
+
+#define BLOCKDEV_IO_PRIORITY  20        /* driver I/O tasks (above Wimp) */
+
+struct blockdev_req {
+    blockdev_t      *dev;
+    int              op;                /* BLOCKDEV_READ / BLOCKDEV_WRITE  */
+    uint64_t         lba;
+    uint32_t         count;             /* blocks                          */
+    void            *buf;
+    void           (*done_fn)(blockdev_req_t *req);
+    void            *cookie;            /* caller's, untouched             */
+
+    /* Set by the block layer */
+    uint32_t         tag;               /* per-device sequence number      */
+    ssize_t          result;            /* blocks transferred, or -1       */
+    volatile int     done;
+    task_t          *waiter;
+    blockdev_req_t  *next;              /* driver queue link               */
+    blockdev_req_t  *parent;            /* boot413: split piece's original */
+    uint32_t         pieces;            /* boot413: split pieces in flight */
+    int              failed;            /* boot413: a split piece failed   */
+    uint64_t         t_queued;          /* boot414: cntpct when queued     */
+};
+
+/* FIFO of submitted requests — a driver's per-pipe / per-host queue */
+typedef struct {
+    spinlock_t      lock;
+    blockdev_req_t *head;
+    blockdev_req_t *tail;
+    uint32_t        depth;
+} blockdev_reqq_t;
+
+/* ── Request queue (boot414) ─────────────────────────────────────────────────
+ * Sits between blockdev_read/write/submit and a driver's submit op: it
+ * merges adjacent requests into one command, orders the rest by LBA with
+ * a deadline so none starves, and keeps up to qdepth commands in flight.
+ * Owned by blockdriver.c; drivers only set blockdev_t.qdepth.           */
+typedef struct {
+    uint64_t        queued;         /* requests accepted                      */
+    uint64_t        commands;       /* commands sent to the driver            */
+    uint64_t        merged;         /* requests that rode in another's command */
+    uint64_t        expired;        /* dispatched because their deadline hit  */
+    uint64_t        completed;
+    uint64_t        lat_sum_us;     /* queue → completion, summed             */
+    uint32_t        lat_max_us;
+    uint32_t        depth_max;      /* most requests waiting at once          */
+} blockdev_qstats_t;
+
+typedef struct {
+    spinlock_t         lock;
+    blockdev_req_t    *head;        /* waiting, arrival order                 */
+    blockdev_req_t    *tail;
+    uint32_t           depth;
+    blockdev_req_t    *active;      /* commands with the driver               */
+    uint32_t           inflight;
+    uint64_t           pos;         /* elevator: LBA after the last command   */
+    int                kick;        /* dispatcher should look at this queue   */
+    blockdev_qstats_t  stats;
+} blockdev_queue_t;
+
 /* ── Media class — set by each driver at registration time ───────────────────
  * Used by FileCore disc scoring to prefer faster / more reliable boot media.
  * Scoring order (highest to lowest): NVME > SSD > USB_FLASH > SD > UNKNOWN  */
@@ -51,6 +127,18 @@ struct blockdev {
     media_class_t   media_class;    /* Media type — set by registering driver    */
     void           *private;        /* Driver private data                       */
     blockdev_ops_t *ops;            /* Operations table                          */
+    uint32_t        next_tag;       /* boot409: request tag sequence             */
+
+    /* boot413: transfer limits in blocks, 0 = none.  Set by the driver at
+     * registration; blockdev_read/write/submit split larger requests.    */
+    uint32_t        max_xfer;       /* most blocks one driver call may move      */
+    uint32_t        opt_xfer;       /* pieces are a multiple of this             */
+    uint32_t        xfer_gran;      /* piece boundaries fall on multiples of this */
+
+    /* boot414: request queue.  qdepth = commands the driver usefully holds
+     * at once (0 = 2: one running, one for the driver to pipeline).      */
+    uint32_t        qdepth;
+    blockdev_queue_t queue;
 };
 
 /* Register a new block device */
@@ -59,9 +147,24 @@ blockdev_t *blockdev_register(const char *name, uint64_t size, uint32_t block_si
 /* Get block device by name and unit */
 blockdev_t *blockdev_get(const char *name, int unit);
 
+/* Synchronous I/O — returns the driver's read/write result, or the block
+ * count when the request was split to fit the device's limits (boot413) */
+ssize_t blockdev_read(blockdev_t *dev, uint64_t lba, uint32_t count, void *buf);
+ssize_t blockdev_write(blockdev_t *dev, uint64_t lba, uint32_t count, const void *buf);
+
+/* boot409: asynchronous I/O */
+int     blockdev_submit(blockdev_req_t *req);
+ssize_t blockdev_wait(blockdev_req_t *req);
+void    blockdev_complete(blockdev_req_t *req, ssize_t result);
+void    blockdev_reqq_push(blockdev_reqq_t *q, blockdev_req_t *req);
+blockdev_req_t *blockdev_reqq_pop(blockdev_reqq_t *q);
+
 /* Print all registered devices with their type, size, and FileCore score */
 void blockdev_print_all(void);
 
+/* boot414: print each device's request-queue counters */
+void blockdev_print_stats(void);
+
 /* Global list of registered block devices */
 extern blockdev_t *blockdev_list[];
 extern int blockdev_count;
@@ -1,97 +1,694 @@
 /*
- * dl.c – Dynamic Linker Stub for RISC OS Phoenix
+ * dl.c – Dynamic Linker for RISC OS Phoenix
  * Supports dlopen, dlsym, dlclose for ELF64 shared libraries
  * Author: R Andrews – 06 Feb 2026
+ * Updated: boot403 – Oct 2026 – real loader: PT_LOAD image, DT_GNU_HASH /
+ *          DT_HASH lookup with bloom filter, single-pass RELA, optional
+ *          lazy PLT binding, per-library resolution benchmark
+ *          Libraries are matched on their full path and hold a reference
+ *          on every library they were linked or bound against (DT_NEEDED
+ *          and global-scope hits alike); dlclose runs DT_FINI_ARRAY/DT_FINI
+ *          and frees a library only when nothing references it.
  */
 
 #include "kernel.h"
 #include "vfs.h"
 #include "elf64.h"
-// // #include <string.h> /* removed - use kernel.h */ /* removed - use kernel.h */
+#include "dl.h"
+#include "errno.h"
 
 #define MAX_LIBS  32
 
 typedef struct loaded_lib {
-    char path[256];
-    Elf64_Dyn *dynamic;
-    Elf64_Sym *symtab;
-    char *strtab;
-    Elf64_Rela *rela;
-    uint64_t *got;
+    char            path[256];
+    uint8_t        *image_raw;      /* kmalloc'd block (for kfree)          */
+    uint8_t        *image;          /* page-aligned start of first PT_LOAD  */
+    uint64_t        image_size;
+    uint64_t        base;           /* load bias: runtime = base + vaddr    */
+    Elf64_Dyn      *dynamic;
+    Elf64_Sym      *symtab;
+    char           *strtab;
+    uint64_t        strsz;
+    Elf64_Rela     *rela;
+    uint64_t        relasz;
+    Elf64_Rela     *jmprel;
+    uint64_t        pltrelsz;
+    uint64_t       *got;
+    const uint32_t *hash;           /* DT_HASH (SysV)                        */
+    const uint32_t *gnu_hash;       /* DT_GNU_HASH — preferred               */
+    uint32_t        nsyms;
+    uint64_t       *symcache;       /* resolved address per symbol, 0 = not yet */
+    uint64_t        init;
+    uint64_t        fini;
+    uint64_t       *init_array;     /* DT_INIT_ARRAY, run in order          */
+    uint64_t        init_arraysz;
+    uint64_t       *fini_array;     /* DT_FINI_ARRAY, run in reverse        */
+    uint64_t        fini_arraysz;
+    int             refs;
+    int             lazy;
+    /* Libraries this one holds a reference on: DT_NEEDED entries plus any
+     * library a relocation or lazy PLT slot resolved into.  Released when
+     * this library is unloaded.                                          */
+    struct loaded_lib *deps[MAX_LIBS];
+    int             ndeps;
 } loaded_lib_t;
 
-static loaded_lib_t loaded_libs[MAX_LIBS];
+/* Global scope, in load order */
+static loaded_lib_t *loaded_libs[MAX_LIBS];
 static int num_libs = 0;
 
-/* Simple symbol resolver (stub) */
-uint64_t resolve_symbol(const char *name) {
-    if (strcmp(name, "printf") == 0) return (uint64_t)debug_print;
+/* ── Hash functions ──────────────────────────────────────────────────────── */
+
+static uint32_t dl_gnu_hash(const char *name)
+{
+    uint32_t h = 5381;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++)
+        h = h * 33u + *p;
+    return h;
+}
+
+static uint32_t dl_elf_hash(const char *name)
+{
+    uint32_t h = 0, g;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h = (h << 4) + *p;
+        g = h & 0xF0000000u;
+        if (g) h ^= g >> 24;
+        h &= ~g;
+    }
+    return h;
+}
+
+/* Both hashes of one name, computed once per lookup across all libraries */
+typedef struct {
+    const char *name;
+    uint32_t    gnu;
+    uint32_t    elf;
+    int         have_elf;
+} dl_key_t;
+
+static void dl_key_init(dl_key_t *k, const char *name)
+{
+    k->name     = name;
+    k->gnu      = dl_gnu_hash(name);
+    k->have_elf = 0;
+}
+
+static int dl_sym_ok(const loaded_lib_t *lib, const Elf64_Sym *s, const char *name)
+{
+    if (s->st_shndx == SHN_UNDEF || s->st_name >= lib->strsz) return 0;
+    int bind = ELF64_ST_BIND(s->st_info);
+    if (bind != STB_GLOBAL && bind != STB_WEAK) return 0;
+    return strcmp(lib->strtab + s->st_name, name) == 0;
+}
+
+/* ── Per-library lookup ──────────────────────────────────────────────────────
+ * DT_GNU_HASH: the bloom filter rejects most absent names with one load;
+ * otherwise one bucket and a short chain compared by hash before strcmp.
+ * DT_HASH is the fallback for objects linked without --hash-style=gnu.    */
+static const Elf64_Sym *dl_lookup(const loaded_lib_t *lib, dl_key_t *k)
+{
+    if (lib->gnu_hash) {
+        const uint32_t *gh    = lib->gnu_hash;
+        uint32_t nbuckets     = gh[0];
+        uint32_t symoffset    = gh[1];
+        uint32_t bloom_size   = gh[2];
+        uint32_t bloom_shift  = gh[3];
+        const uint64_t *bloom = (const uint64_t *)(gh + 4);
+        const uint32_t *bkt   = (const uint32_t *)(bloom + bloom_size);
+        const uint32_t *chain = bkt + nbuckets;
+        if (!nbuckets || !bloom_size) return NULL;
+
+        uint64_t word = bloom[(k->gnu / 64u) % bloom_size];
+        uint64_t mask = (1ULL << (k->gnu % 64u)) |
+                        (1ULL << ((k->gnu >> bloom_shift) % 64u));
+        if ((word & mask) != mask) return NULL;
+
+        uint32_t i = bkt[k->gnu % nbuckets];
+        if (i < symoffset) return NULL;
+        for (;; i++) {
+            uint32_t h2 = chain[i - symoffset];
+            if ((k->gnu | 1u) == (h2 | 1u) &&
+                dl_sym_ok(lib, &lib->symtab[i], k->name))
+                return &lib->symtab[i];
+            if (h2 & 1u) return NULL;
+        }
+    }
+
+    if (lib->hash) {
+        if (!k->have_elf) { k->elf = dl_elf_hash(k->name); k->have_elf = 1; }
+        uint32_t nbucket = lib->hash[0];
+        const uint32_t *bucket = lib->hash + 2;
+        const uint32_t *chain  = bucket + nbucket;
+        if (!nbucket) return NULL;
+        for (uint32_t i = bucket[k->elf % nbucket]; i; i = chain[i])
+            if (dl_sym_ok(lib, &lib->symtab[i], k->name))
+                return &lib->symtab[i];
+    }
+    return NULL;
+}
+
+static uint32_t dl_count_syms(const loaded_lib_t *lib)
+{
+    if (lib->hash) return lib->hash[1];             /* nchain == nsyms */
+    if (!lib->gnu_hash) return 0;
+
+    const uint32_t *gh    = lib->gnu_hash;
+    uint32_t nbuckets     = gh[0];
+    uint32_t symoffset    = gh[1];
+    const uint32_t *bkt   = (const uint32_t *)((const uint64_t *)(gh + 4) + gh[2]);
+    const uint32_t *chain = bkt + nbuckets;
+
+    uint32_t last = 0;
+    for (uint32_t b = 0; b < nbuckets; b++)
+        if (bkt[b] > last) last = bkt[b];
+    if (last < symoffset) return symoffset;
+    while (!(chain[last - symoffset] & 1u)) last++;
+    return last + 1;
+}
+
+/* ── Kernel exports ──────────────────────────────────────────────────────────
+ * The last stop in the global scope.  Hashed on first use so relocation
+ * against kernel symbols costs the same as against a library.             */
+typedef struct {
+    const char *name;
+    void       *addr;
+    uint32_t    gnu;
+} dl_export_t;
+
+static dl_export_t dl_kernel_exports[] = {
+    { "printf",  (void *)debug_print, 0 },
+    { "malloc",  (void *)kmalloc,     0 },
+    { "calloc",  (void *)kcalloc,     0 },
+    { "free",    (void *)kfree,       0 },
+    { "memcpy",  (void *)memcpy,      0 },
+    { "memset",  (void *)memset,      0 },
+    { "memcmp",  (void *)memcmp,      0 },
+    { "strlen",  (void *)strlen,      0 },
+    { "strcmp",  (void *)strcmp,      0 },
+    { "strncmp", (void *)strncmp,     0 },
+};
+#define DL_NEXPORTS  (sizeof(dl_kernel_exports) / sizeof(dl_kernel_exports[0]))
+
+static uint64_t dl_kernel_lookup(const dl_key_t *k)
+{
+    static int hashed = 0;
+    if (!hashed) {
+        for (uint32_t i = 0; i < DL_NEXPORTS; i++)
+            dl_kernel_exports[i].gnu = dl_gnu_hash(dl_kernel_exports[i].name);
+        hashed = 1;
+    }
+    for (uint32_t i = 0; i < DL_NEXPORTS; i++)
+        if (dl_kernel_exports[i].gnu == k->gnu &&
+            strcmp(dl_kernel_exports[i].name, k->name) == 0)
+            return (uint64_t)dl_kernel_exports[i].addr;
+    return 0;
+}
+
+/* Global scope: loaded libraries in load order, then the kernel.  *owner
+ * is the defining library, NULL for a kernel export or no match.         */
+static uint64_t dl_resolve_global(dl_key_t *k, loaded_lib_t **owner)
+{
+    *owner = NULL;
+    for (int i = 0; i < num_libs; i++) {
+        const Elf64_Sym *s = dl_lookup(loaded_libs[i], k);
+        if (s) { *owner = loaded_libs[i]; return loaded_libs[i]->base + s->st_value; }
+    }
+    return dl_kernel_lookup(k);
+}
+
+uint64_t resolve_symbol(const char *name)
+{
+    if (!name) return 0;
+    dl_key_t k;
+    loaded_lib_t *owner;
+    dl_key_init(&k, name);
+    return dl_resolve_global(&k, &owner);
+}
+
+/* lib now points into dep: take a reference unless it already holds one */
+static int dl_add_dep(loaded_lib_t *lib, loaded_lib_t *dep)
+{
+    if (!dep || dep == lib) return 0;
+    for (int i = 0; i < lib->ndeps; i++)
+        if (lib->deps[i] == dep) return 0;
+    if (lib->ndeps >= MAX_LIBS) return -ENOMEM;
+    lib->deps[lib->ndeps++] = dep;
+    dep->refs++;
     return 0;
 }
 
+/* Address of symbol index symi as referenced from lib (cached per lib) */
+static uint64_t dl_sym_addr(loaded_lib_t *lib, uint32_t symi, int *weak)
+{
+    const Elf64_Sym *s = &lib->symtab[symi];
+    *weak = ELF64_ST_BIND(s->st_info) == STB_WEAK;
+    if (ELF64_ST_BIND(s->st_info) == STB_LOCAL && s->st_shndx != SHN_UNDEF)
+        return lib->base + s->st_value;
+    if (lib->symcache && symi < lib->nsyms && lib->symcache[symi])
+        return lib->symcache[symi];
+
+    dl_key_t k;
+    loaded_lib_t *owner;
+    dl_key_init(&k, lib->strtab + s->st_name);
+    uint64_t addr = dl_resolve_global(&k, &owner);
+    if (addr && dl_add_dep(lib, owner) != 0) return 0;   /* can't pin it */
+    if (addr && lib->symcache && symi < lib->nsyms) lib->symcache[symi] = addr;
+    return addr;
+}
+
+/* ── Relocation ──────────────────────────────────────────────────────────────
+ * One pass over each table.  JUMP_SLOTs are left pointing at PLT0 (plus
+ * load bias) when binding lazily; dl_runtime_resolve fills them on first
+ * call.                                                                    */
+static int dl_relocate(loaded_lib_t *lib, const Elf64_Rela *r, uint64_t n,
+                       int lazy)
+{
+    for (uint64_t i = 0; i < n; i++, r++) {
+        uint64_t *where = (uint64_t *)(lib->base + r->r_offset);
+        uint32_t  type  = ELF64_R_TYPE(r->r_info);
+        uint32_t  symi  = ELF64_R_SYM(r->r_info);
+        uint64_t  s;
+        int       weak;
+
+        switch (type) {
+        case R_AARCH64_NONE:
+            break;
+        case R_AARCH64_RELATIVE:
+            *where = lib->base + (uint64_t)r->r_addend;
+            break;
+        case R_AARCH64_JUMP_SLOT:
+            if (lazy) { *where += lib->base; break; }
+            /* fall through */
+        case R_AARCH64_ABS64:
+        case R_AARCH64_GLOB_DAT:
+            s = dl_sym_addr(lib, symi, &weak);
+            if (!s && !weak) {
+                debug_print("dlopen: %s: undefined symbol '%s'\n", lib->path,
+                            lib->strtab + lib->symtab[symi].st_name);
+                return -ENOENT;
+            }
+            *where = s ? s + (uint64_t)r->r_addend : 0;
+            break;
+        default:
+            debug_print("dlopen: %s: unsupported relocation %u\n",
+                        lib->path, type);
+            return -ENOEXEC;
+        }
+    }
+    return 0;
+}
+
+/* ── Lazy PLT binding ────────────────────────────────────────────────────────
+ * PLT0 does "stp x16, x30, [sp, #-16]!" with x16 = &GOT[n] from PLTn, then
+ * branches to GOT[2] with x16 = &GOT[2].  GOT[1] holds the loaded_lib_t.
+ * The trampoline saves the argument registers, asks dl_fixup() for the
+ * target (which also patches the slot) and tail-jumps to it.              */
+uint64_t dl_fixup(loaded_lib_t *lib, uint64_t idx);
+extern void dl_runtime_resolve(void);
+
+__asm__(
+    ".text\n"
+    ".global dl_runtime_resolve\n"
+    ".type dl_runtime_resolve, %function\n"
+    ".align 4\n"
+    "dl_runtime_resolve:\n"
+    "    stp  x0, x1, [sp, #-80]!\n"
+    "    stp  x2, x3, [sp, #16]\n"
+    "    stp  x4, x5, [sp, #32]\n"
+    "    stp  x6, x7, [sp, #48]\n"
+    "    str  x8,     [sp, #64]\n"
+    "    ldr  x0, [x16, #-8]\n"          /* GOT[1] = lib                */
+    "    ldr  x1, [sp, #80]\n"           /* &GOT[n] saved by PLT0       */
+    "    sub  x1, x1, x16\n"
+    "    sub  x1, x1, #8\n"
+    "    lsr  x1, x1, #3\n"              /* n - 3 = JMPREL index        */
+    "    bl   dl_fixup\n"
+    "    mov  x17, x0\n"
+    "    ldr  x8,     [sp, #64]\n"
+    "    ldp  x6, x7, [sp, #48]\n"
+    "    ldp  x4, x5, [sp, #32]\n"
+    "    ldp  x2, x3, [sp, #16]\n"
+    "    ldp  x0, x1, [sp], #80\n"
+    "    ldp  x16, x30, [sp], #16\n"
+    "    br   x17\n"
+);
+
+uint64_t dl_fixup(loaded_lib_t *lib, uint64_t idx)
+{
+    uint64_t  nrel = lib->pltrelsz / sizeof(Elf64_Rela);
+    uint64_t *slot = &lib->got[3 + idx];
+    const Elf64_Rela *r = NULL;
+
+    /* JMPREL is normally in GOT order; search only if it is not */
+    if (idx < nrel && lib->base + lib->jmprel[idx].r_offset == (uint64_t)slot)
+        r = &lib->jmprel[idx];
+    for (uint64_t i = 0; !r && i < nrel; i++)
+        if (lib->base + lib->jmprel[i].r_offset == (uint64_t)slot)
+            r = &lib->jmprel[i];
+    if (!r) {
+        debug_print("dl_fixup: %s: no JUMP_SLOT for GOT[%llu]\n",
+                    lib->path, (unsigned long long)(3 + idx));
+        halt_system();
+    }
+
+    int weak;
+    uint64_t s = dl_sym_addr(lib, ELF64_R_SYM(r->r_info), &weak);
+    if (!s) {
+        debug_print("dl_fixup: %s: undefined symbol '%s'\n", lib->path,
+                    lib->strtab + lib->symtab[ELF64_R_SYM(r->r_info)].st_name);
+        halt_system();
+    }
+    *slot = s + (uint64_t)r->r_addend;
+    return *slot;
+}
+
+/* ── Image helpers ───────────────────────────────────────────────────────── */
+
+static void dl_sync_icache(uint8_t *p, uint64_t len)
+{
+    uintptr_t a   = (uintptr_t)p & ~(uintptr_t)63u;
+    uintptr_t end = (uintptr_t)p + len;
+    for (uintptr_t x = a; x < end; x += 64u)
+        __asm__ volatile("dc cvau, %0" :: "r"(x) : "memory");
+    __asm__ volatile("dsb ish" ::: "memory");
+    for (uintptr_t x = a; x < end; x += 64u)
+        __asm__ volatile("ic ivau, %0" :: "r"(x) : "memory");
+    __asm__ volatile("dsb ish\nisb" ::: "memory");
+}
+
+static int dlclose_lib(loaded_lib_t *lib);
+
+/* Drop every reference lib holds (on unload or a failed dlopen) */
+static void dl_put_deps(loaded_lib_t *lib)
+{
+    while (lib->ndeps > 0)
+        dlclose_lib(lib->deps[--lib->ndeps]);
+}
+
+static void dl_free_lib(loaded_lib_t *lib)
+{
+    if (lib->symcache)  kfree(lib->symcache);
+    if (lib->image_raw) kfree(lib->image_raw);
+    kfree(lib);
+}
+
+static void dl_unregister(loaded_lib_t *lib)
+{
+    for (int i = 0; i < num_libs; i++) {
+        if (loaded_libs[i] != lib) continue;
+        for (int j = i; j < num_libs - 1; j++) loaded_libs[j] = loaded_libs[j + 1];
+        num_libs--;
+        return;
+    }
+}
+
+/* Full-path match: two libraries sharing a leaf name are distinct */
+static loaded_lib_t *dl_find_loaded(const char *path)
+{
+    for (int i = 0; i < num_libs; i++)
+        if (strcmp(loaded_libs[i]->path, path) == 0)
+            return loaded_libs[i];
+    return NULL;
+}
+
+/* Read the whole object in one pass — FileCore re-reads on every vfs_read */
+static uint8_t *dl_read_file(const char *filename, uint64_t *size_out)
+{
+    file_t *file = vfs_open(filename, O_RDONLY);
+    if (!file) return NULL;
+    uint64_t size = file->f_inode ? file->f_inode->i_size : 0;
+    uint8_t *buf  = size ? kmalloc(size) : NULL;
+    uint64_t got  = 0;
+    while (buf && got < size) {
+        ssize_t n = vfs_read(file, buf + got, size - got);
+        if (n <= 0) break;
+        got += (uint64_t)n;
+    }
+    vfs_close(file);
+    if (buf && got != size) { kfree(buf); buf = NULL; }
+    *size_out = size;
+    return buf;
+}
+
+/* DT_NEEDED: opened from the requesting library's directory (dlopen finds
+ * an already loaded copy by that full path).  The reference dlopen takes
+ * is recorded in lib->deps and dropped when lib is unloaded.             */
+static int dl_load_needed(loaded_lib_t *lib, const char *name, int flags)
+{
+    char path[256];
+    size_t dir = 0;
+    for (size_t i = 0; lib->path[i]; i++)
+        if (lib->path[i] == '.' || lib->path[i] == '/') dir = i + 1;
+    if (dir + strlen(name) >= sizeof(path)) return -ENAMETOOLONG;
+    memcpy(path, lib->path, dir);
+    strncpy(path + dir, name, sizeof(path) - dir - 1);
+    path[sizeof(path) - 1] = '\0';
+
+    loaded_lib_t *dep = (loaded_lib_t *)dlopen(path, flags);
+    if (!dep) return -ENOENT;
+    int rc = dl_add_dep(lib, dep);      /* takes its own reference */
+    dlclose_lib(dep);                   /* ... so drop dlopen's     */
+    return rc;
+}
+
+/* DT_INIT then DT_INIT_ARRAY in order; DT_FINI_ARRAY in reverse then
+ * DT_FINI.  0 and -1 array entries are placeholders and skipped.        */
+static void dl_run_array(const uint64_t *arr, uint64_t sz, int reverse)
+{
+    uint64_t n = arr ? sz / sizeof(uint64_t) : 0;
+    for (uint64_t i = 0; i < n; i++) {
+        uint64_t fn = arr[reverse ? n - 1 - i : i];
+        if (fn && fn != ~0ULL) ((void (*)(void))fn)();
+    }
+}
+
+static void dl_run_init(loaded_lib_t *lib)
+{
+    if (lib->init) ((void (*)(void))lib->init)();
+    dl_run_array(lib->init_array, lib->init_arraysz, 0);
+}
+
+static void dl_run_fini(loaded_lib_t *lib)
+{
+    dl_run_array(lib->fini_array, lib->fini_arraysz, 1);
+    if (lib->fini) ((void (*)(void))lib->fini)();
+}
+
 /* dlopen – load shared library */
 void *dlopen(const char *filename, int flags) {
     if (!filename) return NULL;
 
-    file_t *file = vfs_open(filename, O_RDONLY);
-    if (!file) return NULL;
+    loaded_lib_t *lib = dl_find_loaded(filename);
+    if (lib) { lib->refs++; return lib; }
+    if (num_libs >= MAX_LIBS) return NULL;
+
+    uint64_t fsize = 0;
+    uint8_t *fbuf = dl_read_file(filename, &fsize);
+    if (!fbuf) return NULL;
 
-    Elf64_Ehdr ehdr;
-    if (vfs_read(file, &ehdr, sizeof(ehdr)) != sizeof(ehdr)) {
-        vfs_close(file);
+    Elf64_Ehdr *ehdr = (Elf64_Ehdr *)fbuf;
+    if (fsize < sizeof(*ehdr) ||
+        memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr->e_ident[EI_CLASS] != ELFCLASS64 ||
+        ehdr->e_machine != EM_AARCH64 || ehdr->e_type != ET_DYN ||
+        ehdr->e_phoff + (uint64_t)ehdr->e_phnum * sizeof(Elf64_Phdr) > fsize) {
+        kfree(fbuf);
         return NULL;
     }
 
-    if (memcmp(ehdr.e_ident, ELFMAG, SELFMAG) != 0 || ehdr.e_type != ET_DYN) {
-        vfs_close(file);
-        return NULL;
+    /* Span of all PT_LOAD segments */
+    Elf64_Phdr *ph = (Elf64_Phdr *)(fbuf + ehdr->e_phoff);
+    uint64_t lo = ~0ULL, hi = 0, dyn_vaddr = 0;
+    for (int i = 0; i < ehdr->e_phnum; i++) {
+        if (ph[i].p_type == PT_DYNAMIC) dyn_vaddr = ph[i].p_vaddr;
+        if (ph[i].p_type != PT_LOAD) continue;
+        if (ph[i].p_offset + ph[i].p_filesz > fsize) { kfree(fbuf); return NULL; }
+        if (ph[i].p_vaddr < lo) lo = ph[i].p_vaddr;
+        if (ph[i].p_vaddr + ph[i].p_memsz > hi) hi = ph[i].p_vaddr + ph[i].p_memsz;
     }
+    if (hi <= lo || !dyn_vaddr) { kfree(fbuf); return NULL; }
+    lo &= ~(uint64_t)(PAGE_SIZE - 1);
+    hi  = (hi + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1);
 
-    loaded_lib_t *lib = kmalloc(sizeof(loaded_lib_t));
+    lib = kcalloc(1, sizeof(loaded_lib_t));
+    if (!lib) { kfree(fbuf); return NULL; }
     strncpy(lib->path, filename, 255);
+    lib->image_size = hi - lo;
+    lib->image_raw  = kmalloc(lib->image_size + PAGE_SIZE);
+    if (!lib->image_raw) { kfree(fbuf); kfree(lib); return NULL; }
+    lib->image = (uint8_t *)(((uintptr_t)lib->image_raw + PAGE_SIZE - 1)
+                             & ~(uintptr_t)(PAGE_SIZE - 1));
+    memset(lib->image, 0, lib->image_size);
+    lib->base = (uint64_t)lib->image - lo;
 
-    // Parse PT_DYNAMIC (stub – simplified)
-    Elf64_Phdr phdr;
-    for (int i = 0; i < ehdr.e_phnum; i++) {
-        vfs_seek(file, ehdr.e_phoff + i * ehdr.e_phentsize, SEEK_SET);
-        vfs_read(file, &phdr, sizeof(phdr));
-        if (phdr.p_type == PT_DYNAMIC) {
-            lib->dynamic = kmalloc(phdr.p_filesz);
-            vfs_seek(file, phdr.p_offset, SEEK_SET);
-            vfs_read(file, lib->dynamic, phdr.p_filesz);
-            break;
+    for (int i = 0; i < ehdr->e_phnum; i++)
+        if (ph[i].p_type == PT_LOAD)
+            memcpy((void *)(lib->base + ph[i].p_vaddr), fbuf + ph[i].p_offset,
+                   ph[i].p_filesz);
+    kfree(fbuf);
+
+    /* Dynamic section */
+    int bind_now = (flags & RTLD_NOW) || !(flags & RTLD_LAZY);
+    lib->dynamic = (Elf64_Dyn *)(lib->base + dyn_vaddr);
+    for (Elf64_Dyn *d = lib->dynamic; d->d_tag != DT_NULL; d++) {
+        uint64_t p = lib->base + d->d_un.d_ptr;
+        switch (d->d_tag) {
+        case DT_SYMTAB:   lib->symtab   = (Elf64_Sym *)p;       break;
+        case DT_STRTAB:   lib->strtab   = (char *)p;            break;
+        case DT_STRSZ:    lib->strsz    = d->d_un.d_val;        break;
+        case DT_HASH:     lib->hash     = (const uint32_t *)p;  break;
+        case DT_GNU_HASH: lib->gnu_hash = (const uint32_t *)p;  break;
+        case DT_RELA:     lib->rela     = (Elf64_Rela *)p;      break;
+        case DT_RELASZ:   lib->relasz   = d->d_un.d_val;        break;
+        case DT_JMPREL:   lib->jmprel   = (Elf64_Rela *)p;      break;
+        case DT_PLTRELSZ: lib->pltrelsz = d->d_un.d_val;        break;
+        case DT_PLTGOT:   lib->got      = (uint64_t *)p;        break;
+        case DT_INIT:     lib->init     = p;                    break;
+        case DT_FINI:     lib->fini     = p;                    break;
+        case DT_INIT_ARRAY:   lib->init_array   = (uint64_t *)p;  break;
+        case DT_INIT_ARRAYSZ: lib->init_arraysz = d->d_un.d_val;  break;
+        case DT_FINI_ARRAY:   lib->fini_array   = (uint64_t *)p;  break;
+        case DT_FINI_ARRAYSZ: lib->fini_arraysz = d->d_un.d_val;  break;
+        case DT_BIND_NOW: bind_now = 1;                         break;
+        case DT_FLAGS:    if (d->d_un.d_val & DF_BIND_NOW) bind_now = 1; break;
+        default: break;
         }
     }
+    if (!lib->symtab || !lib->strtab || (!lib->hash && !lib->gnu_hash)) {
+        debug_print("dlopen: %s: no symbol hash table\n", filename);
+        dl_free_lib(lib);
+        return NULL;
+    }
+    lib->nsyms    = dl_count_syms(lib);
+    lib->symcache = lib->nsyms ? kcalloc(lib->nsyms, sizeof(uint64_t)) : NULL;
+    lib->lazy     = !bind_now && lib->got && lib->jmprel;
+    lib->refs     = 1;
 
-    vfs_close(file);
+    /* Register first so the library can resolve against itself */
+    loaded_libs[num_libs++] = lib;
+
+    for (Elf64_Dyn *d = lib->dynamic; d->d_tag != DT_NULL; d++) {
+        if (d->d_tag != DT_NEEDED) continue;
+        if (dl_load_needed(lib, lib->strtab + d->d_un.d_val, flags) != 0) {
+            debug_print("dlopen: %s: cannot load '%s'\n", filename,
+                        lib->strtab + d->d_un.d_val);
+            goto fail;
+        }
+    }
 
-    // Register library
-    if (num_libs < MAX_LIBS) {
-        loaded_libs[num_libs++] = *lib;
+    if (dl_relocate(lib, lib->rela, lib->relasz / sizeof(Elf64_Rela), 0) != 0 ||
+        dl_relocate(lib, lib->jmprel, lib->pltrelsz / sizeof(Elf64_Rela),
+                    lib->lazy) != 0)
+        goto fail;
+    if (lib->lazy) {
+        lib->got[1] = (uint64_t)lib;
+        lib->got[2] = (uint64_t)dl_runtime_resolve;
     }
+    dl_sync_icache(lib->image, lib->image_size);
 
-    debug_print("dlopen: Loaded %s\n", filename);
+    dl_run_init(lib);
+
+    debug_print("dlopen: Loaded %s (%u syms, %s, %s binding)\n", filename,
+                lib->nsyms, lib->gnu_hash ? "GNU hash" : "SysV hash",
+                lib->lazy ? "lazy" : "immediate");
     return lib;
+
+fail:
+    dl_unregister(lib);
+    dl_put_deps(lib);
+    dl_free_lib(lib);
+    return NULL;
 }
 
 /* dlsym – lookup symbol */
 void *dlsym(void *handle, const char *symbol) {
+    if (!symbol) return NULL;
+    if (handle == RTLD_DEFAULT) return (void *)resolve_symbol(symbol);
+
     loaded_lib_t *lib = (loaded_lib_t*)handle;
-    if (!lib) return NULL;
+    dl_key_t k;
+    dl_key_init(&k, symbol);
+    const Elf64_Sym *s = dl_lookup(lib, &k);
+    return s ? (void *)(lib->base + s->st_value) : NULL;
+}
 
-    Elf64_Sym *sym = lib->symtab;
-    while (sym->st_name) {
-        if (strcmp(lib->strtab + sym->st_name, symbol) == 0) {
-            return (void*)sym->st_value;
-        }
-        sym++;
-    }
-    return NULL;
+/* Drop one reference; the last one runs the finalisers, unloads the
+ * library and then releases the libraries it held.                      */
+static int dlclose_lib(loaded_lib_t *lib)
+{
+    if (--lib->refs > 0) return 0;
+
+    dl_run_fini(lib);
+    dl_unregister(lib);
+    debug_print("dlclose: %s unloaded\n", lib->path);
+    dl_put_deps(lib);
+    dl_free_lib(lib);
+    return 0;
 }
 
 /* dlclose – unload library */
 int dlclose(void *handle) {
-    // Stub – free memory
-    debug_print("dlclose called\n");
-    return 0;
+    loaded_lib_t *lib = (loaded_lib_t*)handle;
+    if (!lib || lib->refs <= 0) return -1;
+    return dlclose_lib(lib);
+}
+
+/* ── dl_bench ────────────────────────────────────────────────────────────────
+ * Resolution cost per library: every defined global symbol looked up
+ * 'iters' times through the hash table, then by a linear symtab scan (the
+ * pre-boot403 method), plus absent names to exercise the bloom filter.   */
+static uint64_t dl_now_ns(void)
+{
+    uint64_t cnt, freq;
+    __asm__ volatile("mrs %0, cntpct_el0" : "=r"(cnt));
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return freq ? (cnt * 1000ULL) / (freq / 1000000ULL) : 0;
+}
+
+void dl_bench(void *handle, uint32_t iters)
+{
+    loaded_lib_t *lib = (loaded_lib_t *)handle;
+    static const char *absent[] = {
+        "__phx_absent_a", "__phx_absent_b", "__phx_absent_c", "__phx_absent_d"
+    };
+    if (!lib || !iters) return;
+
+    uint32_t nlookup = 0, found = 0;
+    uint64_t t0 = dl_now_ns();
+    for (uint32_t it = 0; it < iters; it++) {
+        for (uint32_t i = 1; i < lib->nsyms; i++) {
+            const Elf64_Sym *s = &lib->symtab[i];
+            if (s->st_shndx == SHN_UNDEF) continue;
+            if (dlsym(lib, lib->strtab + s->st_name)) found++;
+            nlookup++;
+        }
+    }
+    uint64_t t_hash = dl_now_ns() - t0;
+
+    t0 = dl_now_ns();
+    for (uint32_t it = 0; it < iters; it++) {
+        for (uint32_t i = 1; i < lib->nsyms; i++) {
+            const char *name = lib->strtab + lib->symtab[i].st_name;
+            if (lib->symtab[i].st_shndx == SHN_UNDEF) continue;
+            for (uint32_t j = 1; j < lib->nsyms; j++)
+                if (dl_sym_ok(lib, &lib->symtab[j], name)) break;
+        }
+    }
+    uint64_t t_linear = dl_now_ns() - t0;
+
+    uint32_t nmiss = 0;
+    t0 = dl_now_ns();
+    for (uint32_t it = 0; it < iters; it++)
+        for (uint32_t i = 0; i < sizeof(absent) / sizeof(absent[0]); i++, nmiss++)
+            (void)dlsym(lib, absent[i]);
+    uint64_t t_miss = dl_now_ns() - t0;
+
+    debug_print("dl_bench: %s  syms=%u  lookups=%u (found %u)\n",
+                lib->path, lib->nsyms, nlookup, found);
+    debug_print("  hashed %llu ns/lookup   linear %llu ns/lookup   "
+                "absent %llu ns/lookup\n",
+                (unsigned long long)(nlookup ? t_hash / nlookup : 0),
+                (unsigned long long)(nlookup ? t_linear / nlookup : 0),
+                (unsigned long long)(nmiss ? t_miss / nmiss : 0));
 }
@@ -0,0 +1,24 @@
+/*
+ * dl.h – Dynamic Linker interface for RISC OS Phoenix
+ * boot403: flags, RTLD_DEFAULT and the resolution benchmark
+ */
+
+#ifndef DL_H
+#define DL_H
+
+#include <stdint.h>
+
+#define RTLD_LAZY       0x0001  /* bind PLT slots on first call        */
+#define RTLD_NOW        0x0002  /* bind every slot at dlopen time      */
+#define RTLD_DEFAULT    ((void *)0)   /* dlsym: global scope search    */
+
+void    *dlopen(const char *filename, int flags);
+void    *dlsym(void *handle, const char *symbol);
+int      dlclose(void *handle);
+uint64_t resolve_symbol(const char *name);
+
+/* Time 'iters' rounds of dlsym over every symbol a library defines
+ * (hashed vs linear scan) and print per-lookup cost to the debug log. */
+void     dl_bench(void *handle, uint32_t iters);
+
+#endif /* DL_H */
@@ -93,6 +93,16 @@ typedef struct {
 #define DT_RELENT       19
 #define DT_PLTREL       20
 #define DT_JMPREL       23
+#define DT_BIND_NOW     24
+#define DT_INIT_ARRAY   25
+#define DT_FINI_ARRAY   26
+#define DT_INIT_ARRAYSZ 27
+#define DT_FINI_ARRAYSZ 28
+#define DT_FLAGS        30
+#define DT_GNU_HASH     0x6ffffef5
+#define DT_PLTRELSZ     2
+
+#define DF_BIND_NOW     0x8
 
 typedef struct {
     int64_t d_tag;              // Dynamic entry type
@@ -102,17 +112,29 @@ typedef struct {
     } d_un;
 } Elf64_Dyn;
 
+/* boot403: r_info is 64-bit in ELF64 (sym << 32 | type); Elf64_Rela
+ * previously lacked it, so no RELA table could be walked.              */
 typedef struct {
     uint64_t r_offset;          // Address offset
-    uint32_t r_info;            // Relocation type and symbol index
+    uint64_t r_info;            // Relocation type and symbol index
 } Elf64_Rel;
 
 typedef struct {
     uint64_t r_offset;          // Address offset
-    uint32_t r_type;            // Relocation type
+    uint64_t r_info;            // Relocation type and symbol index
     int64_t  r_addend;          // Constant addend
 } Elf64_Rela;
 
+#define ELF64_R_SYM(i)          ((uint32_t)((i) >> 32))
+#define ELF64_R_TYPE(i)         ((uint32_t)((i) & 0xFFFFFFFFu))
+
+/* AArch64 relocation types used by shared objects */
+#define R_AARCH64_NONE          0
+#define R_AARCH64_ABS64         257
+#define R_AARCH64_GLOB_DAT      1025
+#define R_AARCH64_JUMP_SLOT     1026
+#define R_AARCH64_RELATIVE      1027
+
 typedef struct {
     uint32_t st_name;           // Symbol name index in string table
     uint8_t  st_info;           // Type and binding
@@ -122,4 +144,11 @@ typedef struct {
     uint64_t st_size;           // Symbol size
 } Elf64_Sym;
 
+#define ELF64_ST_BIND(i)        ((i) >> 4)
+#define ELF64_ST_TYPE(i)        ((i) & 0xF)
+#define STB_LOCAL               0
+#define STB_GLOBAL              1
+#define STB_WEAK                2
+#define SHN_UNDEF               0
+
 #endif /* ELF64_H */
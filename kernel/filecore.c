@@ -82,7 +82,7 @@
  *   can have a bad checksum on full-disc Castle drives (NVMe) — it reads an empty
  *   disc_name ('') even though the zone mid DiscRec holds the real name ('NVMe').
  *   After filecore_list_root reads the mid-zone Full DiscRec, if the zone name is
- *   non-empty and the stored name is empty, g_dr_disc_name is updated.  Similarly,
+ *   non-empty and the stored name is empty, FCM->disc_name is updated.  Similarly,
  *   root_dir_size is updated from the zone DiscRec so Step 2B can use the canonical
  *   value directly (no longer needs the two-phase peek as primary source).
  *
@@ -172,11 +172,21 @@
  * Updated: boot219 – Apr 2026 – full 2048-byte dir dump; NewDir header parse
  * Updated: boot220 – Apr 2026 – clean SBPr NewDir parser; formatted dir list
  * Updated: boot292 – May 2026 – zone DiscRec name probe in scan + multi-disc scoring
+ * Updated: boot395 – Oct 2026 – per-device probe tasks with deadlines + latency report
+ * Updated: boot396 – Oct 2026 – mount snapshot keyed by cycle_id + map checksum
+ * Updated: boot397 – Oct 2026 – Step 6 registers disc modules lazily (header only)
+ * Updated: boot400 – Oct 2026 – multi-block file reads + filecore_read_file_into()
+ * Updated: boot401 – Oct 2026 – filecore_read_file_range() for demand paging
+ * Updated: boot407 – Oct 2026 – parsed-directory cache + batched filecore_getdents()
+ * Updated: boot408 – Oct 2026 – per-disc mounts (fc_mount_t); "ADFS::disc" path prefixes
+ * Updated: boot413 – Oct 2026 – file reads as one request, split by the block layer
+ * Updated: boot414 – Oct 2026 – disc I/O via blockdev_read/write (request queue)
  */
 
 #include "kernel.h"
 #include "vfs.h"
 #include "blockdriver.h"
+#include "module.h"        /* boot397: module_register_lazy, MODULE_LAZY_HEAD_BYTES */
 #include "errno.h"
 
 /* boot387: compile-time verbose flag for FileCore/IDA diagnostics.
@@ -189,29 +199,117 @@ extern void uart_puts(const char *s);
 extern blockdev_t *blockdev_list[];
 extern int blockdev_count;
 
-/* ── Module state ─────────────────────────────────────────────────────────── */
-blockdev_t *g_fc_bdev     = NULL;
-uint32_t    g_fc_lba_base = 0;
-uint32_t    g_fc_sectors  = 0;
-uint8_t     g_fc_type     = 0;
 
-/* ── VFS root entry cache (populated during root dir parse) ──────────────── */
+/* ── Resolved-IDA cache (boot396) ────────────────────────────────────────────
+ * (parent dir SIN, leaf name) → object, filled by fc_find_in_dir.  The boot
+ * path walks ($.!Boot.Choices.Boot.PreDesk, $.!Boot.Resources.!System …)
+ * hit this on every repeat lookup and it is persisted in the mount snapshot,
+ * so a warm boot resolves !Boot paths without re-reading each directory.
+ * Compact 64-byte entries — the same layout the snapshot stores on disc.   */
+#define FC_IDA_CACHE_MAX   24
+#define FC_SNAP_NAME_MAX   40
+
+typedef struct __attribute__((packed)) {
+    uint32_t parent_sin;
+    uint32_t sin;
+    uint32_t load_addr;
+    uint32_t exec_addr;
+    uint32_t size;
+    uint8_t  type;
+    uint8_t  pad[3];
+    char     name[FC_SNAP_NAME_MAX];
+} fc_snap_ent_t;
+
+/* ── Mount state (boot408) ──────────────────────────────────────────────────
+ * Everything FileCore knows about one disc lives in an fc_mount_t: the
+ * partition, its disc record, and the root / resolved-IDA / directory
+ * caches.  Mount 0 is the boot disc picked by filecore_init's scoring;
+ * every other disc that probed as FileCore becomes a further mount.
+ * Code in this file reaches the active disc through FCM, which follows
+ * the calling task's fs_ctx (set by filecore_enter), so tasks working on
+ * different discs never share mutable state.                             */
 #define FC_ROOT_CACHE_MAX  32
-static vfs_dirent_t  g_root_cache[FC_ROOT_CACHE_MAX];
-static uint32_t      g_root_cache_count = 0u;
-static int           g_root_cache_valid = 0;
-
-/* Disc record parameters (populated from boot DiscRec at LBA 6) */
-static uint8_t  g_dr_log2ss     = 9;    /* log2 sector size → 512 B       */
-static uint8_t  g_dr_log2bpmb   = 10;   /* log2 bytes per map bit → 1024  */
-static uint16_t g_dr_zone_spare = 32;   /* spare bits per zone             */
-static uint8_t  g_dr_id_len     = 19;   /* map entry width (bits)          */
-static uint8_t  g_dr_nzones     = 0;    /* nzones (low byte from DiscRec)  */
-static uint8_t  g_dr_nzones_hi  = 0;    /* nzones high byte (big_flag ext) */
-static uint8_t  g_dr_big_flag   = 0;
-static uint32_t g_dr_root_dir      = 0;    /* IDA of root directory           */
-static uint32_t g_dr_root_dir_size = 0;    /* root dir size from DiscRec +48  */
-static char     g_dr_disc_name[11] = {0};
+#define FC_MOUNT_MAX       4
+
+typedef struct {
+    blockdev_t   *bdev;
+    uint32_t      lba_base;
+    uint32_t      sectors;
+    uint8_t       type;
+    char          name[24];         /* "ADFS::HardDisc4", "SDFS::Boot"     */
+
+    /* Disc record parameters (populated from the DiscRec at probe time) */
+    uint8_t       log2ss;           /* log2 sector size → 512 B            */
+    uint8_t       log2bpmb;         /* log2 bytes per map bit → 1024       */
+    uint16_t      zone_spare;       /* spare bits per zone                 */
+    uint8_t       id_len;           /* map entry width (bits)              */
+    uint8_t       nzones;           /* nzones (low byte from DiscRec)      */
+    uint8_t       nzones_hi;        /* nzones high byte (big_flag ext)     */
+    uint8_t       big_flag;
+    uint32_t      root_dir;         /* IDA of root directory               */
+    uint32_t      root_dir_size;    /* root dir size from DiscRec +48      */
+    char          disc_name[11];
+
+    /* VFS root entry cache (populated during root dir parse) */
+    vfs_dirent_t  root_cache[FC_ROOT_CACHE_MAX];
+    uint32_t      root_cache_count;
+    int           root_cache_valid;
+
+    fc_snap_ent_t ida_cache[FC_IDA_CACHE_MAX];
+    uint32_t      ida_cache_count;
+
+    /* Parsed-directory cache (boot407) */
+    uint8_t      *dirbuf;
+    uint32_t      dirbuf_sin;
+    uint32_t      dirbuf_size;
+    int           dirbuf_valid;
+
+    /* boot421: guards dirbuf and the root / IDA caches — fc_load_dir
+     * sleeps in blockdev_read, so another task could refill them under
+     * a reader.  Held from the load until entries are copied out.      */
+    sleeplock_t   dir_lock;
+} fc_mount_t;
+
+static fc_mount_t g_fc_mounts[FC_MOUNT_MAX] = {
+    { .log2ss = 9, .log2bpmb = 10, .zone_spare = 32, .id_len = 19 },
+};
+static int        g_fc_mount_count = 0;
+static int        g_fc_scan_pending = 0;    /* warm boot: others not probed */
+
+static void      *g_fc_boot_ctx    = NULL;   /* fs_ctx before the scheduler */
+
+static inline fc_mount_t *fc_cur(void)
+{
+    void *ctx = current_task ? current_task->fs_ctx : g_fc_boot_ctx;
+    return ctx ? (fc_mount_t *)ctx : &g_fc_mounts[0];
+}
+#define FCM (fc_cur())
+
+static inline fc_mount_t *fc_dir_lock(void)
+{
+    fc_mount_t *m = FCM;
+    sleeplock_lock(&m->dir_lock);
+    return m;
+}
+
+static inline void fc_dir_unlock(fc_mount_t *m)
+{
+    sleeplock_unlock(&m->dir_lock);
+}
+
+/* Make mount the calling task's active disc; returns the previous one so
+ * the caller can restore it.  NULL selects the boot disc.               */
+void *filecore_enter(void *mount)
+{
+    void **slot = current_task ? &current_task->fs_ctx : &g_fc_boot_ctx;
+    void  *prev = *slot;
+    *slot = mount;
+    return prev;
+}
+
+
+/* Set when filecore_init restored the mount from a snapshot (boot396). */
+static int           g_fc_snap_hit     = 0;
 
 /* ── Tiny uart helpers ────────────────────────────────────────────────────── */
 static void fc_hex8(uint8_t v) {
@@ -377,7 +475,7 @@ static int fc_try_boot_discrec(blockdev_t *bd, uint32_t lba_base, uint8_t *buf,
     uart_puts("[FileCore]   boot_lba="); fc_hex32((uint32_t)boot_lba);
     uart_puts(" boot_off="); fc_hex32(boot_off); uart_puts("\n");
 
-    if (bd->ops->read(bd, boot_lba, 1, buf) < 0) {
+    if (blockdev_read(bd, boot_lba, 1, buf) < 0) {
         uart_puts("[FileCore]   read error\n");
         return -1;
     }
@@ -395,7 +493,7 @@ static int fc_try_boot_discrec(blockdev_t *bd, uint32_t lba_base, uint8_t *buf,
          * Only attempt this when the standard probe was at the expected location. */
         if (boot_off == 0x1C0u && boot_lba == (uint64_t)lba_base + 6u) {
             uart_puts("[FileCore]   Trying NVMe offset 0xDC0 at LBA 0...\n");
-            if (bd->ops->read(bd, (uint64_t)lba_base, 1, buf) >= 0) {
+            if (blockdev_read(bd, (uint64_t)lba_base, 1, buf) >= 0) {
                 dr = (filecore_disc_rec_t *)(buf + 0xDC0u);
                 if (fc_discrec_plausible(dr)) {
                     uart_puts("[FileCore]   NVMe DiscRec valid at offset 0xDC0\n");
@@ -423,7 +521,7 @@ fc_boot_dr_valid:;
 static int fc_try_zone0_discrec(blockdev_t *bd, uint32_t lba_base, uint8_t *buf,
                                  filecore_disc_rec_t *dr_out)
 {
-    if (bd->ops->read(bd, (uint64_t)lba_base, 1, buf) < 0) {
+    if (blockdev_read(bd, (uint64_t)lba_base, 1, buf) < 0) {
         uart_puts("[FileCore]   zone-0 read error\n");
         return -1;
     }
@@ -523,7 +621,7 @@ static int fc_read_zone_discrec(blockdev_t *bd, uint32_t zone,
     uart_puts("[FileCore]   Zone "); fc_dec(zone);
     uart_puts(" LBA="); fc_hex32(lba); uart_puts("\n");
 
-    if (bd->ops->read(bd, (uint64_t)lba, 1, buf) < 0) {
+    if (blockdev_read(bd, (uint64_t)lba, 1, buf) < 0) {
         uart_puts("[FileCore]   read error\n");
         return -1;
     }
@@ -549,7 +647,7 @@ static int fc_scan_gpt(blockdev_t *bd, uint8_t *buf,
                         uint32_t *out_lba, uint32_t *out_sec)
 {
     uart_puts("[FileCore] GPT: reading header at LBA 1...\n");
-    if (bd->ops->read(bd, 1ULL, 1, buf) < 0) {
+    if (blockdev_read(bd, 1ULL, 1, buf) < 0) {
         uart_puts("[FileCore] GPT: LBA 1 read error\n"); return -1;
     }
 
@@ -582,7 +680,7 @@ static int fc_scan_gpt(blockdev_t *bd, uint8_t *buf,
     if (sectors_needed > 32u) sectors_needed = 32u;
 
     for (uint32_t s = 0u; s < sectors_needed; s++) {
-        if (bd->ops->read(bd, (uint64_t)(part_entry_lba + s), 1, gpt_buf) < 0) break;
+        if (blockdev_read(bd, (uint64_t)(part_entry_lba + s), 1, gpt_buf) < 0) break;
         for (uint32_t e = 0u; e < entries_per_sector; e++) {
             uint8_t *entry = gpt_buf + e * part_entry_size;
             int empty = 1;
@@ -603,7 +701,7 @@ static int fc_scan_gpt(blockdev_t *bd, uint8_t *buf,
             uart_puts("[FileCore] GPT part: start="); fc_hex32(plba);
             uart_puts("  size="); fc_dec(psec); uart_puts("\n");
 
-            if (bd->ops->read(bd, (uint64_t)(plba + 6u), 1, gpt_buf) >= 0) {
+            if (blockdev_read(bd, (uint64_t)(plba + 6u), 1, gpt_buf) >= 0) {
                 filecore_disc_rec_t *dr = (filecore_disc_rec_t *)(gpt_buf + 0x1C0u);
                 if (fc_discrec_plausible(dr)) {
                     uart_puts("[FileCore] GPT: FileCore disc record found!\n");
@@ -622,9 +720,473 @@ static int fc_scan_gpt(blockdev_t *bd, uint8_t *buf,
     return -1;
 }
 
-/* ── filecore_init ───────────────────────────────────────────────────────────
- * Exactly mirrors PartMgr's detection sequence.
- * For each block device:
+/* ── Mount snapshot (boot396) ────────────────────────────────────────────────
+ * Every cold boot re-probes each device, re-reads the zone DiscRecs, parses
+ * the root SBPr directory into FCM->root_cache and walks $.!Boot component by
+ * component.  On an unchanged disc all of that produces the same answer, so
+ * the result is persisted as a 4 KB snapshot in a reserved area of the boot
+ * medium and trusted on the next boot when the disc has not been written.
+ *
+ * Key:   cycle_id from the Full DiscRec in zone 0 of map copy 1
+ *        (DiscReader: increments on every write) + FNV-1a over the zone
+ *        check byte of every zone's map sector.  A changed cycle_id misses
+ *        after the one zone-0 read; the check bytes are only read when it
+ *        matches, one 512-byte block per zone.
+ *        On a hit the root directory is also re-read and its FNV-1a checked
+ *        against the saved one (its master sequence number is in the image),
+ *        so a directory rewrite that leaves the map alone still misses.
+ * Body:  device identity, lba_base/part size, DiscRec (with the boot239/292
+ *        name + root_dir_size overrides applied), root cache, IDA cache.
+ *
+ * Storage: LBAs FC_SNAP_LBA..+7 of the SD card — the Pi's boot medium — when
+ * it has a plain MBR whose partitions all start beyond the area: the gap
+ * every SD-card partitioning tool leaves before partition 1.  No other
+ * attached disc is ever written.  GPT cards, full-disc FileCore overlays
+ * (LBA 40 is zone-0 data there) and gaps holding anything other than zeros
+ * or an older snapshot (GRUB core.img etc.) are left alone.               */
+#define FC_SNAP_MAGIC     0x4E534346u   /* "FCSN" */
+#define FC_SNAP_VERSION   3u            /* 3: zone check-byte key + root sum */
+#define FC_SNAP_LBA       40u
+#define FC_SNAP_SECTORS   8u            /* 4 KB  */
+#define FC_SNAP_MAP_CHUNK 64u           /* map sectors per read (32 KB)    */
+
+typedef struct __attribute__((packed)) {
+    uint32_t            magic;
+    uint32_t            version;
+    uint32_t            length;         /* sizeof(fc_snapshot_t)            */
+    uint32_t            checksum;       /* FNV-1a over bytes [16..length)   */
+    char                dev_name[16];
+    uint64_t            dev_size;
+    uint32_t            dev_block_size;
+    uint32_t            cycle_id;
+    uint32_t            map_lba;        /* zone 0 of map copy 1             */
+    uint32_t            map_sum;        /* FNV-1a over the zone check bytes */
+    uint32_t            root_sum;       /* FNV-1a over the root directory   */
+    uint32_t            lba_base;
+    uint32_t            part_sec;
+    uint32_t            nroot;
+    uint32_t            nida;
+    filecore_disc_rec_t dr;
+    fc_snap_ent_t       root[FC_ROOT_CACHE_MAX];
+    fc_snap_ent_t       ida[FC_IDA_CACHE_MAX];
+} fc_snapshot_t;
+
+typedef char fc_snapshot_fits[(sizeof(fc_snapshot_t) <= FC_SNAP_SECTORS * 512u)
+                              ? 1 : -1];
+
+#define FC_FNV_INIT  0x811C9DC5u
+
+static uint32_t fc_fnv32_add(uint32_t h, const uint8_t *p, uint32_t n) {
+    for (uint32_t i = 0u; i < n; i++) { h ^= p[i]; h *= 0x01000193u; }
+    return h;
+}
+
+static uint32_t fc_fnv32(const uint8_t *p, uint32_t n) {
+    return fc_fnv32_add(FC_FNV_INIT, p, n);
+}
+
+static uint32_t fc_snap_nzones(const filecore_disc_rec_t *dr) {
+    uint32_t tnz = dr->nzones;
+    if (dr->big_flag) tnz += (uint32_t)dr->nzones_hi << 8;
+    return tnz;
+}
+
+/* LBA of zone 0 of map copy 1 (mid-zone data start, holds the Full DiscRec) */
+static uint32_t fc_snap_map_lba(const filecore_disc_rec_t *dr, uint32_t lba_base) {
+    uint32_t ss    = 1u << dr->log2_sector_size;
+    uint32_t spl   = (1u << dr->log2_bpmb) / ss;
+    uint32_t ubits = ss * 8u - dr->zone_spare;
+    return fc_zone_lba(fc_snap_nzones(dr) / 2u, lba_base, ubits, 60u * 8u, spl);
+}
+
+/* Map key: cycle_id from the zone-0 DiscRec + FNV-1a of every zone's check
+ * byte (byte 0 of its map sector).  With expect != NULL the walk stops after
+ * zone 0 when the cycle_id already differs.  buf = 512-byte scratch.
+ * 0 = ok, 1 = cycle_id mismatch, -1 = read error.                        */
+static int fc_snap_map_key(blockdev_t *bd, uint32_t map_lba,
+                            const filecore_disc_rec_t *geom, uint8_t *buf,
+                            const uint32_t *expect,
+                            uint32_t *cycle_id, uint32_t *map_sum) {
+    uint32_t nzones = fc_snap_nzones(geom);
+    uint32_t log2ss = geom->log2_sector_size;
+    if (nzones == 0u) return -1;
+    if (blockdev_read(bd, (uint64_t)map_lba, 1, buf) < 0) return -1;
+    filecore_disc_rec_t *dr = (filecore_disc_rec_t *)(buf + FC_ZONE_DR_OFFSET);
+    if (!fc_discrec_plausible(dr)) return -1;
+    *cycle_id = dr->cycle_id;
+    if (expect && *cycle_id != *expect) return 1;
+
+    uint32_t h = fc_fnv32(buf, 1u);
+    if (nzones > 1u) {
+        /* Sectors <= 512 bytes: zones are packed, read FC_SNAP_MAP_CHUNK
+         * blocks at a time.  Larger sectors: one block per zone suffices. */
+        uint32_t span = (log2ss <= 9u) ? FC_SNAP_MAP_CHUNK : 1u;
+        uint32_t last = (uint32_t)(((uint64_t)(nzones - 1u) << log2ss) >> 9);
+        uint8_t *chunk = (uint8_t *)kmalloc(span * 512u);
+        uint32_t cs = 0u, cn = 0u;          /* blocks held in chunk */
+        if (!chunk) return -1;
+        for (uint32_t z = 1u; z < nzones; z++) {
+            uint64_t off = (uint64_t)z << log2ss;
+            uint32_t blk = (uint32_t)(off >> 9);
+            if (cn == 0u || blk < cs || blk >= cs + cn) {
+                uint32_t n = last - blk + 1u;
+                if (n > span) n = span;
+                if (blockdev_read(bd, (uint64_t)(map_lba + blk), n, chunk) < 0) {
+                    kfree(chunk);
+                    return -1;
+                }
+                cs = blk;
+                cn = n;
+            }
+            h = fc_fnv32_add(h, chunk + ((blk - cs) << 9) + (off & 511u), 1u);
+        }
+        kfree(chunk);
+    }
+    *map_sum = h;
+    return 0;
+}
+
+static const uint8_t *fc_load_dir(uint32_t dir_sin, uint32_t *dir_size_out);
+static void fc_mount_reset(fc_mount_t *m);
+
+/* FNV-1a of the current mount's root directory image.  0 = ok.           */
+static int fc_snap_root_sum(uint32_t *sum) {
+    uint32_t size = 0u;
+    fc_mount_t *m = fc_dir_lock();
+    const uint8_t *dir = fc_load_dir(m->root_dir, &size);
+    if (dir) *sum = fc_fnv32(dir, size);
+    fc_dir_unlock(m);
+    return dir ? 0 : -1;
+}
+
+static void fc_snap_ent_from(fc_snap_ent_t *s, uint32_t parent, const vfs_dirent_t *d) {
+    memset(s, 0, sizeof(*s));
+    s->parent_sin = parent;
+    s->sin        = d->sin;
+    s->load_addr  = d->load_addr;
+    s->exec_addr  = d->exec_addr;
+    s->size       = (uint32_t)d->size;
+    s->type       = (uint8_t)d->type;
+    for (int k = 0; k < FC_SNAP_NAME_MAX - 1 && d->name[k]; k++) s->name[k] = d->name[k];
+}
+
+static void fc_snap_ent_to(const fc_snap_ent_t *s, vfs_dirent_t *d) {
+    memset(d, 0, sizeof(*d));
+    d->type        = s->type;
+    d->size        = s->size;
+    d->sin         = s->sin;
+    d->load_addr   = s->load_addr;
+    d->exec_addr   = s->exec_addr;
+    d->riscos_type = (uint16_t)((s->load_addr >> 8) & 0xFFFu);
+    for (int k = 0; k < FC_SNAP_NAME_MAX - 1 && s->name[k]; k++) d->name[k] = s->name[k];
+}
+
+static int fc_name_ieq(const char *a, const char *b);   /* defined below */
+
+/* ── IDA cache lookup / insert ─────────────────────────────────────────── */
+static int fc_ida_cache_get(uint32_t parent, const char *name, vfs_dirent_t *out) {
+    for (uint32_t i = 0u; i < FCM->ida_cache_count; i++) {
+        if (FCM->ida_cache[i].parent_sin == parent &&
+            fc_name_ieq(FCM->ida_cache[i].name, name)) {
+            fc_snap_ent_to(&FCM->ida_cache[i], out);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void fc_ida_cache_put(uint32_t parent, const vfs_dirent_t *d) {
+    if (FCM->ida_cache_count >= FC_IDA_CACHE_MAX) return;
+    if (strlen(d->name) >= FC_SNAP_NAME_MAX) return;   /* would truncate */
+    fc_snap_ent_from(&FCM->ida_cache[FCM->ida_cache_count++], parent, d);
+}
+
+/* Does bd have a free MBR gap at FC_SNAP_LBA?  buf = 512-byte scratch.   */
+static int fc_snap_area_ok(blockdev_t *bd, uint8_t *buf) {
+    if (!bd || bd->block_size != 512u || !bd->ops ||
+        !bd->ops->read || !bd->ops->write) return 0;
+    if (bd == FCM->bdev && FCM->lba_base < FC_SNAP_LBA + FC_SNAP_SECTORS)
+        return 0;                                  /* full-disc overlay   */
+    if (blockdev_read(bd, 0ULL, 1, buf) < 0) return 0;
+    if (buf[MBR_SIG_OFFSET] != MBR_SIG_LO || buf[MBR_SIG_OFFSET+1] != MBR_SIG_HI)
+        return 0;
+    const mbr_part_t *parts = (const mbr_part_t *)(buf + MBR_PARTS_OFFSET);
+    int nparts = 0;
+    for (int i = 0; i < 4; i++) {
+        if (parts[i].type == 0) continue;
+        if (parts[i].type == PART_TYPE_GPT_PROT) return 0;
+        if (parts[i].lba_start < FC_SNAP_LBA + FC_SNAP_SECTORS) return 0;
+        nparts++;
+    }
+    return nparts > 0;
+}
+
+/* ── fc_snapshot_load ────────────────────────────────────────────────────────
+ * Look for a snapshot on every 512-byte device; if one names a present
+ * device whose map key still matches, restore the mount from it.
+ * Returns 1 on a hit (globals, root cache and IDA cache restored).         */
+static int fc_snapshot_load(void)
+{
+    fc_snapshot_t *s = (fc_snapshot_t *)kmalloc(FC_SNAP_SECTORS * 512u);
+    uint8_t *buf = (uint8_t *)kmalloc(512);
+    int hit = 0;
+    if (!s || !buf) goto done;
+
+    for (int i = 0; i < blockdev_count && !hit; i++) {
+        blockdev_t *sd = blockdev_list[i];
+        if (!sd || sd->media_class != MEDIA_SD) continue;   /* saved there only */
+        if (sd->block_size != 512u || !sd->ops || !sd->ops->read) continue;
+        if (sd->size < FC_SNAP_LBA + FC_SNAP_SECTORS) continue;
+        if (blockdev_read(sd, (uint64_t)FC_SNAP_LBA, FC_SNAP_SECTORS, s) < 0) continue;
+        if (s->magic != FC_SNAP_MAGIC || s->version != FC_SNAP_VERSION ||
+            s->length != sizeof(fc_snapshot_t)) continue;
+        if (fc_fnv32((const uint8_t *)s + 16, s->length - 16u) != s->checksum) {
+            uart_puts("[FileCore] snapshot on "); uart_puts(sd->name);
+            uart_puts(": checksum bad — ignored\n");
+            continue;
+        }
+        if (s->nroot > FC_ROOT_CACHE_MAX || s->nida > FC_IDA_CACHE_MAX) continue;
+
+        /* Find the disc it describes */
+        blockdev_t *bd = NULL;
+        for (int j = 0; j < blockdev_count; j++) {
+            blockdev_t *c = blockdev_list[j];
+            if (c && c->ops && c->ops->read && c->size == s->dev_size &&
+                c->block_size == s->dev_block_size &&
+                strncmp(c->name, s->dev_name, sizeof(c->name)) == 0) { bd = c; break; }
+        }
+        if (!bd) {
+            uart_puts("[FileCore] snapshot disc '"); uart_puts(s->dev_name);
+            uart_puts("' not present\n");
+            continue;
+        }
+
+        uint32_t cyc = 0u, sum = 0u, want = s->cycle_id;
+        if (fc_snap_map_key(bd, s->map_lba, &s->dr, buf, &want,
+                            &cyc, &sum) != 0 ||
+            sum != s->map_sum) {
+            uart_puts("[FileCore] snapshot stale for "); uart_puts(bd->name);
+            uart_puts(" (cycle_id "); fc_hex32(s->cycle_id);
+            uart_puts(" → "); fc_hex32(cyc); uart_puts(")\n");
+            continue;
+        }
+
+        /* ── Restore ──────────────────────────────────────────────────── */
+        FCM->bdev     = bd;
+        FCM->lba_base = s->lba_base;
+        FCM->sectors  = s->part_sec;
+        FCM->type     = PART_TYPE_RISCOS;
+
+        FCM->log2ss        = s->dr.log2_sector_size;
+        FCM->log2bpmb      = s->dr.log2_bpmb;
+        FCM->zone_spare    = s->dr.zone_spare;
+        FCM->id_len        = s->dr.id_len;
+        FCM->nzones        = s->dr.nzones;
+        FCM->nzones_hi     = s->dr.nzones_hi;
+        FCM->big_flag      = s->dr.big_flag;
+        FCM->root_dir      = s->dr.root_dir;
+        FCM->root_dir_size = s->dr.root_dir_size;
+        for (int k = 0; k < 10; k++) FCM->disc_name[k] = s->dr.disc_name[k];
+        FCM->disc_name[10] = '\0';
+
+        /* The map can be unchanged while the root directory was rewritten */
+        uint32_t rsum = 0u;
+        if (fc_snap_root_sum(&rsum) != 0 || rsum != s->root_sum) {
+            uart_puts("[FileCore] snapshot stale for "); uart_puts(bd->name);
+            uart_puts(" (root directory changed)\n");
+            fc_mount_reset(FCM);
+            continue;
+        }
+
+        for (uint32_t r = 0u; r < s->nroot; r++)
+            fc_snap_ent_to(&s->root[r], &FCM->root_cache[r]);
+        FCM->root_cache_count = s->nroot;
+        FCM->root_cache_valid = (s->nroot > 0u);
+
+        for (uint32_t r = 0u; r < s->nida; r++) FCM->ida_cache[r] = s->ida[r];
+        FCM->ida_cache_count = s->nida;
+
+        uart_puts("[FileCore] snapshot HIT on "); uart_puts(sd->name);
+        uart_puts(" → "); uart_puts(bd->name);
+        uart_puts("  disc='"); fc_print_name(FCM->disc_name, 10);
+        uart_puts("'  cycle_id="); fc_hex32(cyc);
+        uart_puts("  root="); fc_dec(s->nroot);
+        uart_puts("  ida="); fc_dec(s->nida); uart_puts("\n");
+        hit = 1;
+    }
+
+done:
+    if (s)   kfree(s);
+    if (buf) kfree(buf);
+    return hit;
+}
+
+/* ── fc_snapshot_save ────────────────────────────────────────────────────────
+ * Called at the end of a full filecore_list_root walk.  Writes the current
+ * mount state to the SD card's reserved area, if it has one.  Failure is
+ * logged and otherwise harmless — the next boot simply probes again.       */
+static void fc_snapshot_save(void)
+{
+    if (!FCM->bdev || !FCM->root_cache_valid) return;
+
+    fc_snapshot_t *s = (fc_snapshot_t *)kcalloc(1, FC_SNAP_SECTORS * 512u);
+    fc_snapshot_t *old = (fc_snapshot_t *)kmalloc(FC_SNAP_SECTORS * 512u);
+    uint8_t *buf = (uint8_t *)kmalloc(512);
+    if (!s || !old || !buf) goto done;
+
+    /* ── Build ────────────────────────────────────────────────────────── */
+    filecore_disc_rec_t *dr = &s->dr;
+    dr->log2_sector_size = FCM->log2ss;
+    dr->log2_bpmb        = FCM->log2bpmb;
+    dr->zone_spare       = FCM->zone_spare;
+    dr->id_len           = FCM->id_len;
+    dr->nzones           = FCM->nzones;
+    dr->nzones_hi        = FCM->nzones_hi;
+    dr->big_flag         = FCM->big_flag;
+    dr->root_dir         = FCM->root_dir;
+    dr->root_dir_size    = FCM->root_dir_size;
+    for (int k = 0; k < 10; k++) dr->disc_name[k] = FCM->disc_name[k];
+
+    s->map_lba = fc_snap_map_lba(dr, FCM->lba_base);
+    uint32_t cyc = 0u, sum = 0u, rsum = 0u;
+    if (fc_snap_map_key(FCM->bdev, s->map_lba, dr, buf, NULL,
+                        &cyc, &sum) != 0 ||
+        fc_snap_root_sum(&rsum) != 0) {
+        uart_puts("[FileCore] snapshot: map key read failed — not saved\n");
+        goto done;
+    }
+    s->cycle_id  = cyc;
+    s->map_sum   = sum;
+    s->root_sum  = rsum;
+    dr->cycle_id = (uint16_t)cyc;
+
+    for (int k = 0; k < 15 && FCM->bdev->name[k]; k++) s->dev_name[k] = FCM->bdev->name[k];
+    s->dev_size       = FCM->bdev->size;
+    s->dev_block_size = FCM->bdev->block_size;
+    s->lba_base       = FCM->lba_base;
+    s->part_sec       = FCM->sectors;
+
+    for (uint32_t r = 0u; r < FCM->root_cache_count; r++) {
+        if (strlen(FCM->root_cache[r].name) >= FC_SNAP_NAME_MAX) {
+            uart_puts("[FileCore] snapshot: root name too long — not saved\n");
+            goto done;
+        }
+        fc_snap_ent_from(&s->root[r], FCM->root_dir, &FCM->root_cache[r]);
+    }
+    s->nroot = FCM->root_cache_count;
+    for (uint32_t r = 0u; r < FCM->ida_cache_count; r++) s->ida[r] = FCM->ida_cache[r];
+    s->nida = FCM->ida_cache_count;
+
+    s->magic    = FC_SNAP_MAGIC;
+    s->version  = FC_SNAP_VERSION;
+    s->length   = sizeof(fc_snapshot_t);
+    s->checksum = fc_fnv32((const uint8_t *)s + 16, s->length - 16u);
+
+    /* ── Pick a home: the SD card's MBR gap, nothing else ───────────── */
+    blockdev_t *home = NULL;
+    for (int i = 0; i < blockdev_count && !home; i++) {
+        blockdev_t *c = blockdev_list[i];
+        if (!c || c->media_class != MEDIA_SD) continue;
+        if (!fc_snap_area_ok(c, buf)) continue;
+        if (blockdev_read(c, (uint64_t)FC_SNAP_LBA, FC_SNAP_SECTORS, old) < 0) continue;
+        int free_area = (old->magic == FC_SNAP_MAGIC);
+        if (!free_area) {
+            const uint8_t *ob = (const uint8_t *)old;
+            free_area = 1;
+            for (uint32_t b = 0u; b < FC_SNAP_SECTORS * 512u; b++)
+                if (ob[b]) { free_area = 0; break; }
+        }
+        if (free_area) home = c;
+    }
+    if (!home) {
+        uart_puts("[FileCore] snapshot: no reserved area available — not saved\n");
+        goto done;
+    }
+
+    if (blockdev_write(home, (uint64_t)FC_SNAP_LBA, FC_SNAP_SECTORS, s) < 0) {
+        uart_puts("[FileCore] snapshot: write error on "); uart_puts(home->name);
+        uart_puts("\n");
+        goto done;
+    }
+    uart_puts("[FileCore] snapshot saved to "); uart_puts(home->name);
+    uart_puts(" LBA "); fc_dec(FC_SNAP_LBA);
+    uart_puts("  cycle_id="); fc_hex32(s->cycle_id);
+    uart_puts("  root="); fc_dec(s->nroot);
+    uart_puts("  ida="); fc_dec(s->nida); uart_puts("\n");
+
+done:
+    if (s)   kfree(s);
+    if (old) kfree(old);
+    if (buf) kfree(buf);
+}
+
+/* ── Per-device probe state (boot395) ────────────────────────────────────────
+ * boot395: the old filecore_init walked every block device serially — MBR,
+ * partition DiscRecs, GPT, overlay, mid-zone name probe — so a slow or
+ * wedged device (SD card in CMD timeout, USB bridge retrying a sense) held up
+ * detection on all the others.  Each device is now probed independently into
+ * its own fc_probe_t; when filecore_init is called from task context (boot
+ * step 10 runs in init_process) every device gets its own probe task,
+ * otherwise they run back-to-back from the calling context.
+ *
+ * Every probe carries its own deadline (FC_PROBE_TIMEOUT_MS).  The probe
+ * itself checks it between steps and skips what is left — a DiscRec found
+ * by then still counts, it just scores as unnamed.  A single read can stall
+ * far longer than that (RTL9210 retrying a sense), so in the task path the
+ * chooser also stops waiting for a probe once its deadline passes: the
+ * device is reported as TIMEOUT and left for fc_mount_scan() to pick up on
+ * first use.  The chooser settles as soon as no running probe could still
+ * beat the best candidate found.                                           */
+#define FC_PROBE_MAX         16        /* == MAX_BLOCKDEVS                    */
+#define FC_PROBE_TIMEOUT_MS  3000u     /* per-device budget                   */
+
+typedef struct {
+    blockdev_t          *bd;
+    filecore_disc_rec_t  dr;           /* DiscRec (with zone name override)  */
+    uint32_t             lba_base;     /* resolved ADFS lba_base             */
+    uint32_t             part_sec;     /* partition size (0 = full disc)     */
+    uint64_t             t_start;      /* cntpct at probe start              */
+    uint64_t             deadline;     /* cntpct at which the probe is abandoned */
+    uint32_t             elapsed_ms;
+    int                  found;        /* 1 = FileCore DiscRec resolved      */
+    int                  timed_out;    /* deadline hit: later steps skipped  */
+    int                  abandoned;    /* chooser stopped waiting for it     */
+    int                  worker;       /* g_fc_probe_task[] index, -1 = none */
+    volatile int         done;
+} fc_probe_t;
+
+static fc_probe_t    g_fc_probe[FC_PROBE_MAX];
+static int           g_fc_probe_count   = 0;
+static volatile int  g_fc_probe_next    = 0;   /* next slot to claim        */
+static volatile int  g_fc_probe_ndone   = 0;   /* slots finished            */
+static volatile int  g_fc_probe_live    = 0;   /* probe tasks not yet exited */
+static task_t       *g_fc_probe_task[FC_PROBE_MAX];
+
+static inline uint64_t fc_ticks(void) {
+    uint64_t cnt;
+    __asm__ volatile("mrs %0, cntpct_el0" : "=r"(cnt));
+    return cnt;
+}
+
+static inline uint64_t fc_ticks_per_ms(void) {
+    uint64_t freq;
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return freq / 1000ULL ? freq / 1000ULL : 1ULL;
+}
+
+/* Check the per-device deadline between probe steps. */
+static int fc_probe_expired(fc_probe_t *p) {
+    if (fc_ticks() < p->deadline) return 0;
+    if (!p->timed_out) {
+        p->timed_out = 1;
+        uart_puts("[FileCore]   "); uart_puts(p->bd->name);
+        uart_puts(": probe deadline exceeded — abandoning\n");
+    }
+    return 1;
+}
+
+/* ── fc_probe_device ─────────────────────────────────────────────────────────
+ * Exactly mirrors PartMgr's detection sequence for one block device:
  *   1. Read LBA 0 → parse MBR → find 0xAD partition at part_lba
  *   2. Try zone-0 DiscRec at (part_lba, byte 4)
  *   3. Try boot DiscRec at (part_lba + 6, byte 0x1C0)
@@ -633,177 +1195,460 @@ static int fc_scan_gpt(blockdev_t *bd, uint8_t *buf,
  *      → lba_base = part_lba (NOT 0 — THE FIX, boot213)
  *   5. boot292: If boot DiscRec disc_name empty, probe mid-zone DiscRec for
  *      authoritative name (e.g. 'laxarusb' for Lexar, 'NVMe' for Castle NVMe).
- *   6. Score by media_class + has_name (boot293):
- *        NVMe named=14, SSD named=12, USB-Flash named=10, SD named=7
- *        NVMe unnamed=6, SSD unnamed=5, USB-Flash unnamed=3, SD unnamed=1
- *      Accept if score > current best.  Stop only at score=14 (NVMe named).
- *   7. Store lba_base, disc params, g_fc_bdev                              */
-void filecore_init(void)
+ * Results go to *p only — no globals are touched, so probes may run
+ * concurrently.  Scoring and selection happen in filecore_init.            */
+static void fc_probe_device(fc_probe_t *p)
 {
-    uart_puts("[FileCore] Scanning block devices (boot300)...\n");
+    blockdev_t *bd = p->bd;
 
-    uint8_t *buf = (uint8_t *)kmalloc(512);
-    if (!buf) { uart_puts("[FileCore] kmalloc fail\n"); return; }
+    p->t_start  = fc_ticks();
+    if (!p->deadline)               /* task path: set when the slot is filled */
+        p->deadline = p->t_start + FC_PROBE_TIMEOUT_MS * fc_ticks_per_ms();
 
-    /* boot293: media_class-aware scoring — NVMe > SSD > USB-Flash > SD.
-     * boot296: no early exit — always scan all registered devices and keep
-     * the highest scorer as boot pointer.  Device order doesn't matter.    */
-    int best_score = 0;
-
-    for (int i = 0; i < blockdev_count; i++) {
-        blockdev_t *bd = blockdev_list[i];
-        if (!bd || bd->size == 0 || !bd->ops || !bd->ops->read) continue;
+    uart_puts("[FileCore] Device: "); uart_puts(bd->name);
+    uart_puts("  block_size="); fc_dec(bd->block_size); uart_puts("\n");
 
-        uart_puts("[FileCore] Device: "); uart_puts(bd->name);
-        uart_puts("  block_size="); fc_dec(bd->block_size); uart_puts("\n");
+    uint8_t *buf = (uint8_t *)kmalloc(512);
+    if (!buf) { uart_puts("[FileCore] kmalloc fail\n"); goto out; }
 
-        /* ── Step 1: Read MBR ─────────────────────────────────────────── */
-        if (bd->ops->read(bd, 0ULL, 1, buf) < 0) {
-            uart_puts("[FileCore]   LBA 0 read error\n"); continue;
-        }
+    /* ── Step 1: Read MBR ─────────────────────────────────────────────── */
+    if (blockdev_read(bd, 0ULL, 1, buf) < 0) {
+        uart_puts("[FileCore]   LBA 0 read error\n"); goto out;
+    }
 
-        uint8_t  part_type = 0;
-        uint32_t part_lba  = 0;
-        uint32_t part_sec  = 0;
-        int mbr_rc = filecore_parse_mbr(buf, &part_type, &part_lba, &part_sec);
+    uint8_t  part_type = 0;
+    uint32_t part_lba  = 0;
+    uint32_t part_sec  = 0;
+    int mbr_rc = filecore_parse_mbr(buf, &part_type, &part_lba, &part_sec);
+
+    /* boot236: distinguish true MBR failure (-1) from "MBR present but no
+     * recognised RISC OS partition" (-2).  For -2 we still try the full-
+     * disc FileCore overlay — that's how the NVMe (Castle full-disc, no
+     * MBR partition entries) is detected.  Only -1 is a hard skip.       */
+    if (mbr_rc == -1) {
+        uart_puts("[FileCore]   No usable MBR on this device\n"); goto out;
+    }
 
-        /* boot236: distinguish true MBR failure (-1) from "MBR present but no
-         * recognised RISC OS partition" (-2).  For -2 we still try the full-
-         * disc FileCore overlay — that's how the NVMe (Castle full-disc, no
-         * MBR partition entries) is detected.  Only -1 is a hard skip.       */
-        if (mbr_rc == -1) {
-            uart_puts("[FileCore]   No usable MBR on this device\n"); continue;
-        }
+    filecore_disc_rec_t dr;
+    uint32_t resolved_lba_base = 0;
+    int dr_found = 0;
 
-        filecore_disc_rec_t dr;
-        uint32_t resolved_lba_base = 0;
-        int dr_found = 0;
+    /* ── Step 2+3: Try partition-relative DiscRec (0xAD only) ────────── */
+    if (mbr_rc == 0 && part_type == PART_TYPE_RISCOS) {
+        uart_puts("[FileCore] 0xAD partition at LBA="); fc_hex32(part_lba); uart_puts("\n");
 
-        /* ── Step 2+3: Try partition-relative DiscRec (0xAD only) ────── */
-        if (mbr_rc == 0 && part_type == PART_TYPE_RISCOS) {
-            uart_puts("[FileCore] 0xAD partition at LBA="); fc_hex32(part_lba); uart_puts("\n");
+        uart_puts("[FileCore] Trying zone-0 at part_lba="); fc_hex32(part_lba); uart_puts("\n");
+        if (fc_try_zone0_discrec(bd, part_lba, buf, &dr) == 0) {
+            uart_puts("[FileCore] Zone-0 DiscRec valid → partitioned ADFS\n");
+            resolved_lba_base = part_lba;
+            dr_found = 1;
+        }
 
-            uart_puts("[FileCore] Trying zone-0 at part_lba="); fc_hex32(part_lba); uart_puts("\n");
-            if (fc_try_zone0_discrec(bd, part_lba, buf, &dr) == 0) {
-                uart_puts("[FileCore] Zone-0 DiscRec valid → partitioned ADFS\n");
+        if (!dr_found && !fc_probe_expired(p)) {
+            uart_puts("[FileCore] Trying boot DiscRec (part_lba+6)...\n");
+            int rc = fc_try_boot_discrec(bd, part_lba, buf, &dr);
+            if (rc >= 0) {
+                uart_puts("[FileCore] Boot DiscRec valid at part_lba+6 → partitioned ADFS\n");
                 resolved_lba_base = part_lba;
                 dr_found = 1;
             }
+        }
+    } else {
+        /* mbr_rc==0 non-0xAD winner (FAT32 etc.), or mbr_rc==-2 (no
+         * recognised partition at all — e.g. NVMe full-disc Castle).
+         * Skip straight to the full-disc overlay attempt.                 */
+        uart_puts("[FileCore]   No 0xAD partition — trying full-disc overlay\n");
+    }
 
-            if (!dr_found) {
-                uart_puts("[FileCore] Trying boot DiscRec (part_lba+6)...\n");
-                int rc = fc_try_boot_discrec(bd, part_lba, buf, &dr);
-                if (rc >= 0) {
-                    uart_puts("[FileCore] Boot DiscRec valid at part_lba+6 → partitioned ADFS\n");
-                    resolved_lba_base = part_lba;
-                    dr_found = 1;
-                }
+    /* ── Step 4: Full-disc overlay fallback ───────────────────────────── */
+    /* ADFS full-disc overlay: the ADFS address space starts at LBA 0.
+     * The MBR at LBA 0 IS zone 0 of the map.  Zone and data LBAs are
+     * absolute (lba_base=0).  PartMgr confirms this: it reads Lexar
+     * zone 962 at absolute LBA 0x774BC0 with lba_base=0.
+     * boot213's lba_base=part_lba was WRONG — reverted in boot215.
+     * boot236: also reached for devices with MBR but no 0xAD partition,
+     * allowing full-disc Castle FileCore drives (NVMe) to be detected.      */
+    if (!dr_found) {
+        if (fc_probe_expired(p)) goto out;
+        uart_puts("[FileCore] Both partition checks failed\n");
+
+        /* boot267: Try GPT scan before full-disc overlay.
+         * Handles GPT-partitioned discs (e.g. Samsung NVMe via RTL9210).  */
+        uint32_t gpt_lba = 0, gpt_sec = 0;
+        if (fc_scan_gpt(bd, buf, &gpt_lba, &gpt_sec) == 0) {
+            uart_puts("[FileCore] GPT FileCore partition at LBA=");
+            fc_hex32(gpt_lba); uart_puts("\n");
+            int rc2 = fc_try_boot_discrec(bd, gpt_lba, buf, &dr);
+            if (rc2 >= 0) {
+                uart_puts("[FileCore] GPT disc record valid\n");
+                resolved_lba_base = gpt_lba;
+                dr_found = 1;
             }
-        } else {
-            /* mbr_rc==0 non-0xAD winner (FAT32 etc.), or mbr_rc==-2 (no
-             * recognised partition at all — e.g. NVMe full-disc Castle).
-             * Skip straight to the full-disc overlay attempt.             */
-            uart_puts("[FileCore]   No 0xAD partition — trying full-disc overlay\n");
-        }
-
-        /* ── Step 4: Full-disc overlay fallback ───────────────────────── */
-        /* ADFS full-disc overlay: the ADFS address space starts at LBA 0.
-         * The MBR at LBA 0 IS zone 0 of the map.  Zone and data LBAs are
-         * absolute (lba_base=0).  PartMgr confirms this: it reads Lexar
-         * zone 962 at absolute LBA 0x774BC0 with lba_base=0.
-         * boot213's lba_base=part_lba was WRONG — reverted in boot215.
-         * boot236: also reached for devices with MBR but no 0xAD partition,
-         * allowing full-disc Castle FileCore drives (NVMe) to be detected.  */
+        }
+
         if (!dr_found) {
-            uart_puts("[FileCore] Both partition checks failed\n");
-
-            /* boot267: Try GPT scan before full-disc overlay.
-             * Handles GPT-partitioned discs (e.g. Samsung NVMe via RTL9210).  */
-            uint32_t gpt_lba = 0, gpt_sec = 0;
-            if (fc_scan_gpt(bd, buf, &gpt_lba, &gpt_sec) == 0) {
-                uart_puts("[FileCore] GPT FileCore partition at LBA=");
-                fc_hex32(gpt_lba); uart_puts("\n");
-                int rc2 = fc_try_boot_discrec(bd, gpt_lba, buf, &dr);
-                if (rc2 >= 0) {
-                    uart_puts("[FileCore] GPT disc record valid\n");
-                    resolved_lba_base = gpt_lba;
-                    dr_found = 1;
-                }
+            if (fc_probe_expired(p)) goto out;
+            uart_puts("[FileCore] → Full-disc FileCore overlayed over MBR\n");
+            uart_puts("[FileCore] Trying boot DiscRec at absolute LBA 6...\n");
+            int rc = fc_try_boot_discrec(bd, 0, buf, &dr);
+            if (rc >= 0) {
+                uart_puts("[FileCore] Boot DiscRec valid at LBA 6 → lba_base=0 (full-disc overlay)\n");
+                resolved_lba_base = 0;
+                dr_found = 1;
+            } else {
+                uart_puts("[FileCore] Absolute LBA 6 also bad — no ADFS on this device\n");
             }
+        }
+    }
 
-            if (!dr_found) {
-                uart_puts("[FileCore] → Full-disc FileCore overlayed over MBR\n");
-                uart_puts("[FileCore] Trying boot DiscRec at absolute LBA 6...\n");
-                int rc = fc_try_boot_discrec(bd, 0, buf, &dr);
-                if (rc >= 0) {
-                    uart_puts("[FileCore] Boot DiscRec valid at LBA 6 → lba_base=0 (full-disc overlay)\n");
-                    resolved_lba_base = 0;
-                    dr_found = 1;
-                } else {
-                    uart_puts("[FileCore] Absolute LBA 6 also bad — no ADFS on this device\n");
+    if (!dr_found) goto out;
+
+    /* boot292: If boot DiscRec has empty disc_name, probe the mid-zone
+     * DiscRec which holds the authoritative name (e.g. 'laxarusb' for
+     * Lexar full-disc overlay, 'NVMe' for Castle NVMe drive).
+     * Do this BEFORE scoring so preference logic sees the real name.
+     * boot395: skipped once the deadline has passed — the device still
+     * counts, it just scores as unnamed.                                  */
+    if ((dr.disc_name[0] == '\0' || dr.disc_name[0] == ' ') &&
+        !fc_probe_expired(p)) {
+        uint32_t ss_probe    = 1u << dr.log2_sector_size;
+        uint32_t splfau_probe = (ss_probe > 0)
+                              ? (1u << dr.log2_bpmb) / ss_probe : 0u;
+        uint32_t ubits_probe  = ss_probe * 8u - dr.zone_spare;
+        uint32_t drsz_probe   = 60u * 8u;   /* 480 bits — Full DiscRec */
+        uint32_t tnz_probe    = dr.nzones;
+        if (dr.big_flag) tnz_probe += (uint32_t)dr.nzones_hi << 8;
+        uint32_t mid_probe    = tnz_probe / 2u;
+
+        if (mid_probe > 0 && splfau_probe > 0) {
+            filecore_disc_rec_t dr_mid;
+            if (fc_read_zone_discrec(bd, mid_probe, resolved_lba_base,
+                                      ubits_probe, drsz_probe,
+                                      splfau_probe, buf, &dr_mid) == 0) {
+                int mhn = (dr_mid.disc_name[0] != '\0' &&
+                           dr_mid.disc_name[0] != ' ');
+                if (mhn) {
+                    uart_puts("[FileCore]   boot292: zone disc_name='");
+                    fc_print_name(dr_mid.disc_name, 10);
+                    uart_puts("' overrides empty boot DiscRec\n");
+                    for (int k = 0; k < 10; k++)
+                        dr.disc_name[k] = dr_mid.disc_name[k];
                 }
             }
         }
+    }
 
-        if (!dr_found) continue;
-
-        /* boot292: If boot DiscRec has empty disc_name, probe the mid-zone
-         * DiscRec which holds the authoritative name (e.g. 'laxarusb' for
-         * Lexar full-disc overlay, 'NVMe' for Castle NVMe drive).
-         * Do this BEFORE scoring so preference logic sees the real name.   */
-        if (dr.disc_name[0] == '\0' || dr.disc_name[0] == ' ') {
-            uint32_t ss_probe    = 1u << dr.log2_sector_size;
-            uint32_t splfau_probe = (ss_probe > 0)
-                                  ? (1u << dr.log2_bpmb) / ss_probe : 0u;
-            uint32_t ubits_probe  = ss_probe * 8u - dr.zone_spare;
-            uint32_t drsz_probe   = 60u * 8u;   /* 480 bits — Full DiscRec */
-            uint32_t tnz_probe    = dr.nzones;
-            if (dr.big_flag) tnz_probe += (uint32_t)dr.nzones_hi << 8;
-            uint32_t mid_probe    = tnz_probe / 2u;
-
-            if (mid_probe > 0 && splfau_probe > 0) {
-                filecore_disc_rec_t dr_mid;
-                if (fc_read_zone_discrec(bd, mid_probe, resolved_lba_base,
-                                          ubits_probe, drsz_probe,
-                                          splfau_probe, buf, &dr_mid) == 0) {
-                    int mhn = (dr_mid.disc_name[0] != '\0' &&
-                               dr_mid.disc_name[0] != ' ');
-                    if (mhn) {
-                        uart_puts("[FileCore]   boot292: zone disc_name='");
-                        fc_print_name(dr_mid.disc_name, 10);
-                        uart_puts("' overrides empty boot DiscRec\n");
-                        for (int k = 0; k < 10; k++)
-                            dr.disc_name[k] = dr_mid.disc_name[k];
-                    }
-                }
-            }
+    p->dr       = dr;
+    p->lba_base = resolved_lba_base;
+    p->part_sec = part_sec;
+    p->found    = 1;
+
+out:
+    if (buf) kfree(buf);
+    p->elapsed_ms = (uint32_t)((fc_ticks() - p->t_start) / fc_ticks_per_ms());
+    __atomic_store_n(&p->done, 1, __ATOMIC_RELEASE);
+}
+
+/* ── Probe worker task ───────────────────────────────────────────────────────
+ * Claims slots from g_fc_probe[] until none are left.  Tasks start with IRQs
+ * masked; the USB and SD drivers complete reads from their interrupt
+ * handlers, so a worker unmasks them first, as kernel_main does.  A worker
+ * the chooser has given up on still finishes its probe — the slot is only
+ * reused once g_fc_probe_live drops to zero.  Workers never return — like
+ * signal.c's default action they park themselves as TASK_ZOMBIE, after
+ * clearing their g_fc_probe_task[] entry so nothing touches them again.   */
+static void fc_probe_worker(void)
+{
+    asm volatile("msr daifclr, #2" ::: "memory");
+
+    int self = -1;
+    for (int w = 0; w < FC_PROBE_MAX; w++)
+        if (g_fc_probe_task[w] == current_task) { self = w; break; }
+
+    for (;;) {
+        int slot = __atomic_fetch_add(&g_fc_probe_next, 1, __ATOMIC_ACQ_REL);
+        if (slot >= g_fc_probe_count) break;
+
+        g_fc_probe[slot].worker = self;
+        fc_probe_device(&g_fc_probe[slot]);
+        __atomic_add_fetch(&g_fc_probe_ndone, 1, __ATOMIC_ACQ_REL);
+    }
+
+    if (self >= 0) g_fc_probe_task[self] = NULL;
+    __atomic_sub_fetch(&g_fc_probe_live, 1, __ATOMIC_ACQ_REL);
+    current_task->state = TASK_ZOMBIE;
+    for (;;) schedule();
+}
+
+/* boot293: media_class-aware scoring.
+ *
+ * NVMe and SSD are preferred over USB flash and SD card because they
+ * are designed as boot media — faster, higher write endurance, and
+ * more reliable under frequent kernel rewrite cycles.
+ *
+ * Score table (named / unnamed):
+ *   NVMe      14 /  6   — USB-NVMe bridge (RTL9210 etc.)
+ *   SSD       12 /  5   — USB-SATA SSD enclosure (ASMedia etc.)
+ *   USB-Flash 10 /  3   — thumb drive (Lexar laxarusb etc.)
+ *   SD         7 /  1   — SD / eMMC card
+ *   Unknown   10 /  3   — unclassified USB, treat as flash               */
+static int fc_media_score(const blockdev_t *bd, int has_name)
+{
+    switch (bd->media_class) {
+        case MEDIA_NVME:      return has_name ? 14 :  6;
+        case MEDIA_SSD:       return has_name ? 12 :  5;
+        case MEDIA_USB_FLASH: return has_name ? 10 :  3;
+        case MEDIA_SD:        return has_name ?  7 :  1;
+        default:              return has_name ? 10 :  3;
+    }
+}
+
+static int fc_probe_score(const fc_probe_t *p)
+{
+    int has_name = (p->dr.disc_name[0] != '\0' && p->dr.disc_name[0] != ' ');
+    return fc_media_score(p->bd, has_name);
+}
+
+/* A finished probe that resolved a DiscRec.  A probe that hit its deadline
+ * after the DiscRec was found still counts (it scores as unnamed).        */
+static int fc_probe_usable(const fc_probe_t *p)
+{
+    return __atomic_load_n(&p->done, __ATOMIC_ACQUIRE) && p->found;
+}
+
+/*
+ * fc_probe_settled — can the boot disc be chosen yet?
+ *
+ * Finds the winner among finished probes exactly as the evaluation loop in
+ * filecore_init does (highest score, earliest device on a tie) and checks
+ * every probe still running against it: one that could still win — named,
+ * for its media class — must be waited for until its deadline, after which
+ * it is abandoned.  Returns 1 once nothing left running can change the
+ * result.
+ */
+static int fc_probe_settled(void)
+{
+    uint64_t now  = fc_ticks();
+    int      best = -1, best_score = 0;
+
+    for (int s = 0; s < g_fc_probe_count; s++) {
+        fc_probe_t *p = &g_fc_probe[s];
+        if (!fc_probe_usable(p)) continue;
+        int sc = fc_probe_score(p);
+        if (best < 0 || sc > best_score) { best = s; best_score = sc; }
+    }
+
+    int settled = 1;
+    for (int s = 0; s < g_fc_probe_count; s++) {
+        fc_probe_t *p = &g_fc_probe[s];
+        if (p->abandoned || __atomic_load_n(&p->done, __ATOMIC_ACQUIRE)) continue;
+        if (now >= p->deadline) {
+            p->abandoned = 1;
+            uart_puts("[FileCore]   "); uart_puts(p->bd->name);
+            uart_puts(": probe deadline exceeded — not waiting for it\n");
+            continue;
         }
+        int max = fc_media_score(p->bd, 1);
+        if (best < 0 || max > best_score || (max == best_score && s < best))
+            settled = 0;
+    }
+    return settled;
+}
 
-        /* ── Evaluate this candidate ─────────────────────────────────── */
-        /* boot293: media_class-aware scoring.
-         *
-         * NVMe and SSD are preferred over USB flash and SD card because they
-         * are designed as boot media — faster, higher write endurance, and
-         * more reliable under frequent kernel rewrite cycles.
-         *
-         * Score table (named / unnamed):
-         *   NVMe      14 /  6   — USB-NVMe bridge (RTL9210 etc.)
-         *   SSD       12 /  5   — USB-SATA SSD enclosure (ASMedia etc.)
-         *   USB-Flash 10 /  3   — thumb drive (Lexar laxarusb etc.)
-         *   SD         7 /  1   — SD / eMMC card
-         *   Unknown   10 /  3   — unclassified USB, treat as flash
-         *
-         * Stop scanning immediately at score >= 10 (named flash/SSD/NVMe).  */
-        int this_has_name = (dr.disc_name[0] != '\0' && dr.disc_name[0] != ' ');
-        int this_score;
-        switch (bd->media_class) {
-            case MEDIA_NVME:      this_score = this_has_name ? 14 :  6; break;
-            case MEDIA_SSD:       this_score = this_has_name ? 12 :  5; break;
-            case MEDIA_USB_FLASH: this_score = this_has_name ? 10 :  3; break;
-            case MEDIA_SD:        this_score = this_has_name ?  7 :  1; break;
-            default:              this_score = this_has_name ? 10 :  3; break;
-        }
-        int accept = (!g_fc_bdev) || (this_score > best_score);
+/* ── Mount table (boot408) ─────────────────────────────────────────────────── */
+static void fc_mount_reset(fc_mount_t *m)
+{
+    uint8_t    *dirbuf = m->dirbuf;     /* keep the directory buffer */
+    sleeplock_t lock   = m->dir_lock;   /* and a holder's claim on it */
+    memset(m, 0, sizeof(*m));
+    m->log2ss     = 9;
+    m->log2bpmb   = 10;
+    m->zone_spare = 32;
+    m->id_len     = 19;
+    m->dirbuf     = dirbuf;
+    m->dir_lock   = lock;
+}
+
+/* "ADFS::<disc>" for hard media, "SDFS::<disc>" for SD / eMMC; the device
+ * name stands in for an unnamed disc.                                    */
+static void fc_mount_name(fc_mount_t *m)
+{
+    const char *fs  = (m->bdev->media_class == MEDIA_SD) ? "SDFS::" : "ADFS::";
+    size_t      pos = 0;
+    while (*fs) m->name[pos++] = *fs++;
+
+    int named = (m->disc_name[0] != '\0' && m->disc_name[0] != ' ');
+    const char *src = named ? m->disc_name : m->bdev->name;
+    for (int k = 0; src[k] && src[k] != ' ' && pos < sizeof(m->name) - 1; k++)
+        m->name[pos++] = src[k];
+    m->name[pos] = '\0';
+}
+
+/* Copy a resolved probe's partition and DiscRec into a mount */
+static void fc_mount_setup(fc_mount_t *m, const fc_probe_t *p)
+{
+    fc_mount_reset(m);
+    m->bdev     = p->bd;
+    m->lba_base = p->lba_base;
+    m->sectors  = p->part_sec;
+    m->type     = PART_TYPE_RISCOS;
+
+    m->log2ss        = p->dr.log2_sector_size;
+    m->log2bpmb      = p->dr.log2_bpmb;
+    m->zone_spare    = p->dr.zone_spare;
+    m->id_len        = p->dr.id_len;
+    m->nzones        = p->dr.nzones;
+    m->nzones_hi     = p->dr.nzones_hi;
+    m->big_flag      = p->dr.big_flag;
+    m->root_dir      = p->dr.root_dir;
+    m->root_dir_size = p->dr.root_dir_size;  /* +48 per DiscReader */
+    for (int k = 0; k < 10; k++) m->disc_name[k] = p->dr.disc_name[k];
+    m->disc_name[10] = '\0';
+    fc_mount_name(m);
+}
+
+static int fc_mount_has_bdev(const blockdev_t *bd)
+{
+    for (int i = 0; i < g_fc_mount_count; i++)
+        if (g_fc_mounts[i].bdev == bd) return 1;
+    return 0;
+}
+
+/* Add every other resolved probe as a further mount */
+static void fc_mount_add_probes(void)
+{
+    for (int s = 0; s < g_fc_probe_count && g_fc_mount_count < FC_MOUNT_MAX; s++) {
+        fc_probe_t *p = &g_fc_probe[s];
+        if (!fc_probe_usable(p) || fc_mount_has_bdev(p->bd)) continue;
+        fc_mount_t *m = &g_fc_mounts[g_fc_mount_count++];
+        fc_mount_setup(m, p);
+        uart_puts("[FileCore] Mounted "); uart_puts(m->name);
+        uart_puts(" on "); uart_puts(p->bd->name); uart_puts("\n");
+    }
+}
+
+int filecore_mount_count(void)
+{
+    return g_fc_mount_count;
+}
+
+void *filecore_mount_get(int idx)
+{
+    return (idx >= 0 && idx < g_fc_mount_count) ? &g_fc_mounts[idx] : NULL;
+}
+
+const char *filecore_mount_name(const void *mount)
+{
+    return mount ? ((const fc_mount_t *)mount)->name : "";
+}
+
+/* ── filecore_init ───────────────────────────────────────────────────────────
+ * 1. Snapshot every readable block device into g_fc_probe[].
+ * 2. boot395: probe them — one probe task per device when called from task
+ *    context, sequentially otherwise.  The task path stops waiting as soon
+ *    as fc_probe_settled() says the result can no longer change.
+ * 3. Score each candidate by media_class + has_name (boot293) and keep the
+ *    best, walking in device order so ties resolve exactly as before.
+ * 4. Store lba_base, disc params, bdev in mount 0; report per-device latency.
+ * 5. boot408: every other FileCore disc becomes a further mount.         */
+void filecore_init(void)
+{
+    uart_puts("[FileCore] Scanning block devices (boot395)...\n");
+    for (int i = 0; i < FC_MOUNT_MAX; i++) fc_mount_reset(&g_fc_mounts[i]);
+    g_fc_mount_count   = 0;
+    g_fc_scan_pending  = 0;
+
+    uint64_t t0 = fc_ticks();
+
+    /* A probe abandoned by an earlier scan may still be using the slots */
+    if (__atomic_load_n(&g_fc_probe_live, __ATOMIC_ACQUIRE) > 0) {
+        uart_puts("[FileCore] earlier probe still running — scan skipped\n");
+        return;
+    }
+
+    /* boot396: warm boot — trust the mount snapshot if the disc is unchanged */
+    g_fc_snap_hit = fc_snapshot_load();
+    if (g_fc_snap_hit) {
+        fc_mount_name(&g_fc_mounts[0]);
+        g_fc_mount_count  = 1;
+        g_fc_scan_pending = 1;      /* other discs: probed on first use */
+        uart_puts("[FileCore] probe walk skipped (snapshot) in ");
+        fc_dec((uint32_t)((fc_ticks() - t0) / fc_ticks_per_ms()));
+        uart_puts(" ms\n");
+        return;
+    }
+
+    g_fc_probe_count = 0;
+    for (int i = 0; i < blockdev_count && g_fc_probe_count < FC_PROBE_MAX; i++) {
+        blockdev_t *bd = blockdev_list[i];
+        if (!bd || bd->size == 0 || !bd->ops || !bd->ops->read) continue;
+        fc_probe_t *p = &g_fc_probe[g_fc_probe_count++];
+        memset(p, 0, sizeof(*p));
+        p->bd     = bd;
+        p->worker = -1;
+    }
+    g_fc_probe_next  = 0;
+    g_fc_probe_ndone = 0;
+
+    /* boot395: parallel probe.  Only possible from a task — a context
+     * switch from kernel_main would lose the boot stack.  Workers must
+     * outrank us: the scheduler always runs the first ready task of the
+     * highest priority, so we drop one level below them (init runs at
+     * TASK_MAX_PRIORITY) and poll with yield() — there is no timer wake
+     * to block on, and a deadline has to end the wait.                   */
+    int nworkers = 0;
+    if (current_task && g_fc_probe_count > 1) {
+        int saved = current_task->priority;
+        if (saved >= TASK_MAX_PRIORITY) current_task->priority = TASK_MAX_PRIORITY - 1;
+        int prio = current_task->priority + 1;
+        for (int w = 0; w < g_fc_probe_count; w++)   /* every probe starts now */
+            g_fc_probe[w].deadline = t0 + FC_PROBE_TIMEOUT_MS * fc_ticks_per_ms();
+        for (int w = 0; w < g_fc_probe_count; w++) {
+            __atomic_add_fetch(&g_fc_probe_live, 1, __ATOMIC_ACQ_REL);
+            g_fc_probe_task[w] = task_create("FCProbe", fc_probe_worker, prio, 0);
+            if (g_fc_probe_task[w]) nworkers++;
+            else __atomic_sub_fetch(&g_fc_probe_live, 1, __ATOMIC_ACQ_REL);
+        }
+
+        if (nworkers > 0) {
+            uart_puts("[FileCore] Probing "); fc_dec((uint32_t)g_fc_probe_count);
+            uart_puts(" device(s) on "); fc_dec((uint32_t)nworkers);
+            uart_puts(" task(s)\n");
+            while (!fc_probe_settled())
+                yield();
+        }
+        current_task->priority = saved;
+
+        /* Probes left running finish in the background, below the desktop.
+         * Exited workers have cleared their g_fc_probe_task[] entry.      */
+        for (int s = 0; s < g_fc_probe_count; s++) {
+            fc_probe_t *p = &g_fc_probe[s];
+            int w = p->worker;
+            if (w < 0 || __atomic_load_n(&p->done, __ATOMIC_ACQUIRE)) continue;
+            if (g_fc_probe_task[w]) g_fc_probe_task[w]->priority = 1;
+        }
+    }
+
+    if (nworkers == 0) {
+        for (int s = 0; s < g_fc_probe_count; s++) {
+            fc_probe_device(&g_fc_probe[s]);
+            g_fc_probe_ndone++;
+        }
+    }
+
+    /* ── Evaluate candidates ──────────────────────────────────────────── */
+    /* boot296: consider every device that has finished and keep the
+     * highest scorer as boot pointer.  Probes still running could not
+     * have won (fc_probe_settled); they are mounted on first use.        */
+    int best_score = 0;
+
+    for (int s = 0; s < g_fc_probe_count; s++) {
+        fc_probe_t *p = &g_fc_probe[s];
+        if (!fc_probe_usable(p)) continue;
+
+        blockdev_t *bd = p->bd;
+        int this_score = fc_probe_score(p);
+        int accept = (!g_fc_mounts[0].bdev) || (this_score > best_score);
 
         if (!accept) {
             uart_puts("[FileCore]   "); uart_puts(bd->name);
@@ -814,39 +1659,24 @@ void filecore_init(void)
         }
 
         /* ── Store disc parameters ────────────────────────────────────── */
-        g_fc_bdev     = bd;
-        g_fc_lba_base = resolved_lba_base;
-        g_fc_sectors  = part_sec;
-        g_fc_type     = PART_TYPE_RISCOS;
-        best_score    = this_score;
-
-        g_dr_log2ss     = dr.log2_sector_size;
-        g_dr_log2bpmb   = dr.log2_bpmb;
-        g_dr_zone_spare = dr.zone_spare;
-        g_dr_id_len     = dr.id_len;
-        g_dr_nzones        = dr.nzones;
-        g_dr_nzones_hi     = dr.nzones_hi;
-        g_dr_big_flag      = dr.big_flag;
-        g_dr_root_dir      = dr.root_dir;
-        g_dr_root_dir_size = dr.root_dir_size;  /* +48 per DiscReader */
-        for (int k = 0; k < 10; k++) g_dr_disc_name[k] = dr.disc_name[k];
-        g_dr_disc_name[10] = '\0';
+        fc_mount_setup(&g_fc_mounts[0], p);
+        best_score = this_score;
 
         /* Log the root_dir_size from DiscRec (useful for variable-size BigDirs) */
-        uart_puts("[FileCore]   root_dir_size (DiscRec +48)="); fc_dec(g_dr_root_dir_size);
+        uart_puts("[FileCore]   root_dir_size (DiscRec +48)="); fc_dec(FCM->root_dir_size);
         uart_puts("\n");
 
-        uint32_t total_nzones = g_dr_nzones;
-        if (g_dr_big_flag) total_nzones += (uint32_t)g_dr_nzones_hi << 8;
+        uint32_t total_nzones = FCM->nzones;
+        if (FCM->big_flag) total_nzones += (uint32_t)FCM->nzones_hi << 8;
 
         uart_puts("[FileCore] *** Candidate: RISC OS FileCore on ");
         uart_puts(bd->name); uart_puts(" ***\n");
-        uart_puts("[FileCore]   lba_base="); fc_hex32(g_fc_lba_base);
+        uart_puts("[FileCore]   lba_base="); fc_hex32(FCM->lba_base);
         uart_puts("  total_nzones="); fc_dec(total_nzones);
-        uart_puts("  root_dir="); fc_hex32(g_dr_root_dir);
+        uart_puts("  root_dir="); fc_hex32(FCM->root_dir);
         uart_puts("\n");
         uart_puts("[FileCore]   disc_name='");
-        fc_print_name(g_dr_disc_name, 10);
+        fc_print_name(FCM->disc_name, 10);
         uart_puts("'  score="); fc_dec(best_score); uart_puts("\n");
         uart_puts("[FileCore]   → score="); fc_dec(best_score);
         uart_puts(" (");
@@ -857,10 +1687,37 @@ void filecore_init(void)
         uart_puts(") — best so far\n");
     }
 
-    kfree(buf);
+    /* ── Per-device probe latency ─────────────────────────────────────── */
+    for (int s = 0; s < g_fc_probe_count; s++) {
+        fc_probe_t *p = &g_fc_probe[s];
+        uart_puts("[FileCore] probe "); uart_puts(p->bd->name);
+        if (!__atomic_load_n(&p->done, __ATOMIC_ACQUIRE)) {
+            uart_puts(p->abandoned ? ": TIMEOUT (still running)\n"
+                                   : ": still running — cannot win\n");
+            g_fc_scan_pending = 1;      /* mount it on first use */
+            continue;
+        }
+        uart_puts(": "); fc_dec(p->elapsed_ms); uart_puts(" ms  ");
+        uart_puts(p->found     ? "FileCore" :
+                  p->timed_out ? "TIMEOUT" : "no FileCore");
+        if (p->found) {
+            if (p->timed_out) uart_puts(" (name probe skipped)");
+            uart_puts("  score="); fc_dec((uint32_t)fc_probe_score(p));
+        }
+        uart_puts(p->bd == g_fc_mounts[0].bdev ? "  [boot]\n" : "\n");
+    }
+    uart_puts("[FileCore] probe total: ");
+    fc_dec((uint32_t)((fc_ticks() - t0) / fc_ticks_per_ms()));
+    uart_puts(" ms ("); uart_puts(nworkers > 0 ? "parallel" : "sequential");
+    uart_puts(")\n");
 
-    if (!g_fc_bdev)
+    if (!g_fc_mounts[0].bdev) {
         uart_puts("[FileCore] No RISC OS FileCore disc found\n");
+        return;
+    }
+    g_fc_mount_count = 1;
+    uart_puts("[FileCore] Boot disc "); uart_puts(g_fc_mounts[0].name); uart_puts("\n");
+    fc_mount_add_probes();
 }
 
 /* Forward declarations for helpers defined later in this file */
@@ -895,11 +1752,6 @@ static void filecore_step6_load_module(uint32_t disc_map_lba, uint32_t used_bits
  * filecore_list_root (which calls it in Step 5) can reference it.           */
 int filecore_get_child_entry(uint32_t dir_sin, uint32_t idx, vfs_dirent_t *out);
 
-/* module_load_from_memory declared in module.h — forward-declare here to
- * avoid pulling the full module.h include into filecore.c's scope.          */
-extern int module_load_from_memory(void *buffer, uint32_t size,
-                                    const char *suggested_name);
-
 /* boot385: obey file executor — defined at end of file */
 void filecore_exec_obey(const uint8_t *buf, uint32_t size);
 
@@ -913,23 +1765,23 @@ void filecore_exec_obey(const uint8_t *buf, uint32_t size);
  * step (chain traverse to the root directory) can be verified.            */
 void filecore_list_root(void)
 {
-    if (!g_fc_bdev) {
+    if (!FCM->bdev) {
         uart_puts("[FileCore] No drive mounted\n"); return;
     }
 
     uart_puts("\n[FileCore] === Zone DiscRec scan (boot237) ===\n");
-    uart_puts("[FileCore]   lba_base="); fc_hex32(g_fc_lba_base); uart_puts("\n");
+    uart_puts("[FileCore]   lba_base="); fc_hex32(FCM->lba_base); uart_puts("\n");
 
     /* ── Derive zone-map geometry from stored disc params ─────────────── */
-    uint32_t sector_size = 1u << g_dr_log2ss;          /* 512 for Lexar    */
-    uint32_t bpmb        = 1u << g_dr_log2bpmb;        /* 1024 for Lexar   */
+    uint32_t sector_size = 1u << FCM->log2ss;          /* 512 for Lexar    */
+    uint32_t bpmb        = 1u << FCM->log2bpmb;        /* 1024 for Lexar   */
     uint32_t secperlfau  = bpmb / sector_size;          /* 2   for Lexar    */
     uint32_t bits_per_sec = sector_size * 8u;           /* 4096             */
-    uint32_t used_bits   = bits_per_sec - g_dr_zone_spare; /* 4064          */
+    uint32_t used_bits   = bits_per_sec - FCM->zone_spare; /* 4064          */
     uint32_t dr_size     = 60u * 8u;                    /* 480 bits         */
 
-    uint32_t total_nzones = g_dr_nzones;
-    if (g_dr_big_flag) total_nzones += (uint32_t)g_dr_nzones_hi << 8;
+    uint32_t total_nzones = FCM->nzones;
+    if (FCM->big_flag) total_nzones += (uint32_t)FCM->nzones_hi << 8;
 
     uint32_t mid_zone = total_nzones / 2u;              /* 962 for Lexar    */
 
@@ -943,7 +1795,7 @@ void filecore_list_root(void)
      *             = (962 × 4064 − 480) × 2 = 7,818,176 = 0x774BC0          *
      * This equals fc_zone_lba(mid_zone) = the physical data start of zone   *
      * 962, which is where RISC OS stores map copy 1.                        */
-    uint32_t disc_map_lba = g_fc_lba_base
+    uint32_t disc_map_lba = FCM->lba_base
                           + (mid_zone * used_bits - dr_size) * secperlfau;
 
     uart_puts("[FileCore]   sector_size="); fc_dec(sector_size);
@@ -958,9 +1810,9 @@ void filecore_list_root(void)
 
     /* ── Map Copy 1 address diagnostic ─────────────────────────────────── */
     {
-        uint32_t map_lba     = fc_zone_lba(mid_zone, g_fc_lba_base,
+        uint32_t map_lba     = fc_zone_lba(mid_zone, FCM->lba_base,
                                             used_bits, dr_size, secperlfau);
-        uint32_t map_byte_lo = map_lba << g_dr_log2ss;   /* disc_byte low 32b */
+        uint32_t map_byte_lo = map_lba << FCM->log2ss;   /* disc_byte low 32b */
         uart_puts("[FileCore]   map_copy1_lba="); fc_hex32(map_lba);
         uart_puts("  disc_byte_lo="); fc_hex32(map_byte_lo); uart_puts("\n");
     }
@@ -968,11 +1820,19 @@ void filecore_list_root(void)
     uint8_t *buf = (uint8_t *)kmalloc(512);
     if (!buf) { uart_puts("[FileCore] kmalloc fail\n"); return; }
 
+    /* boot396: mount restored from snapshot — geometry, root cache and the
+     * !Boot IDAs are already known, so skip the zone/root diagnostics and
+     * the Step 1–4 directory walk and go straight to the boot steps.      */
+    if (g_fc_snap_hit) {
+        uart_puts("[FileCore] snapshot mount — skipping Steps 1–4\n");
+        goto fc_boot_steps;
+    }
+
     /* ── Zone 0 (usually corrupted by MBR overlay) ──────────────────── */
     uart_puts("[FileCore] Zone 0 (lba_base):\n");
     {
         filecore_disc_rec_t dr0;
-        fc_read_zone_discrec(g_fc_bdev, 0, g_fc_lba_base,
+        fc_read_zone_discrec(FCM->bdev, 0, FCM->lba_base,
                              used_bits, dr_size, secperlfau, buf, &dr0);
         /* Note: on Lexar (MBR overlay) this sector is the MBR itself —
          * the DiscRec bytes at +4 will be garbage. Expected.             */
@@ -981,13 +1841,13 @@ void filecore_list_root(void)
     /* ── Zone mid_zone = total_nzones/2 = 962 (Full DiscRec) ─────────── */
     uart_puts("[FileCore] Zone "); fc_dec(mid_zone); uart_puts(" (Full DiscRec):\n");
     {
-        uint32_t zone962_lba = fc_zone_lba(mid_zone, g_fc_lba_base,
+        uint32_t zone962_lba = fc_zone_lba(mid_zone, FCM->lba_base,
                                             used_bits, dr_size, secperlfau);
         uart_puts("[FileCore]   mid_zone="); fc_dec(mid_zone);
         uart_puts("  computed LBA="); fc_hex32(zone962_lba); uart_puts("\n");
 
         filecore_disc_rec_t dr962;
-        if (fc_read_zone_discrec(g_fc_bdev, mid_zone, g_fc_lba_base,
+        if (fc_read_zone_discrec(FCM->bdev, mid_zone, FCM->lba_base,
                                   used_bits, dr_size, secperlfau, buf, &dr962) == 0) {
             uart_puts("[FileCore] *** Full DiscRec found in zone ");
             fc_dec(mid_zone); uart_puts(" ***\n");
@@ -999,36 +1859,36 @@ void filecore_list_root(void)
             fc_dec(dr962.root_dir_size); uart_puts("\n");
 
             /* Verify it matches the boot DiscRec root_dir */
-            if (dr962.root_dir == g_dr_root_dir) {
+            if (dr962.root_dir == FCM->root_dir) {
                 uart_puts("[FileCore]   root_dir MATCHES boot DiscRec ✓\n");
             } else {
                 uart_puts("[FileCore]   root_dir MISMATCH: boot=");
-                fc_hex32(g_dr_root_dir); uart_puts("\n");
+                fc_hex32(FCM->root_dir); uart_puts("\n");
             }
 
-            /* boot239: update g_dr_disc_name from the authoritative Full DiscRec.
+            /* boot239: update FCM->disc_name from the authoritative Full DiscRec.
              * The boot DiscRec (LBA 6) may have a bad checksum (NVMe overlay)
              * and can have an empty disc_name even when the zone DiscRec has the
              * real name (e.g. 'NVMe').  Overwrite with the zone name whenever it
              * is non-empty so the correct name is available to preference logic.  */
             int zone_has_name = (dr962.disc_name[0] != '\0' &&
                                  dr962.disc_name[0] != ' ');
-            int boot_has_name = (g_dr_disc_name[0] != '\0' &&
-                                 g_dr_disc_name[0] != ' ');
+            int boot_has_name = (FCM->disc_name[0] != '\0' &&
+                                 FCM->disc_name[0] != ' ');
             if (zone_has_name && !boot_has_name) {
                 uart_puts("[FileCore]   boot239: updating disc_name from zone DiscRec: '");
                 fc_print_name(dr962.disc_name, 10);
                 uart_puts("'\n");
-                for (int k = 0; k < 10; k++) g_dr_disc_name[k] = dr962.disc_name[k];
-                g_dr_disc_name[10] = '\0';
+                for (int k = 0; k < 10; k++) FCM->disc_name[k] = dr962.disc_name[k];
+                FCM->disc_name[10] = '\0';
             }
 
             /* Also update root_dir_size if we got a plausible value from the zone DiscRec */
             if (dr962.root_dir_size >= 2048u && dr962.root_dir_size <= FC_MAX_DIR_SIZE
                     && (dr962.root_dir_size & 511u) == 0u) {
-                g_dr_root_dir_size = dr962.root_dir_size;
+                FCM->root_dir_size = dr962.root_dir_size;
                 uart_puts("[FileCore]   boot239: root_dir_size confirmed from zone DiscRec: ");
-                fc_dec(g_dr_root_dir_size); uart_puts(" bytes\n");
+                fc_dec(FCM->root_dir_size); uart_puts(" bytes\n");
             }
         } else {
             uart_puts("[FileCore] Zone "); fc_dec(mid_zone);
@@ -1043,8 +1903,8 @@ void filecore_list_root(void)
      *   bits [31:id_len]  = chain_offset (hops to terminal LFAU)
      */
     {
-        uint32_t ida       = g_dr_root_dir;
-        uint32_t id_len    = g_dr_id_len;
+        uint32_t ida       = FCM->root_dir;
+        uint32_t id_len    = FCM->id_len;
         uint32_t id_mask   = (1u << (id_len - 1u)) - 1u;   /* 18 bits = 0x3FFFF */
         uint32_t frag_id   = (ida >> 1) & id_mask;
         uint32_t chain_off = ida >> id_len;
@@ -1062,11 +1922,11 @@ void filecore_list_root(void)
          *   bit_in_zone = B % 4096
          *   zone_lba = fc_zone_lba(zone, ...)
          * For frag_id=92928: zone=22, bit=2816, LBA=177856              */
-        uint32_t zone_bits = g_dr_zone_spare + used_bits;   /* = 4096 */
+        uint32_t zone_bits = FCM->zone_spare + used_bits;   /* = 4096 */
         uint32_t chain_zone = frag_id / zone_bits;
         uint32_t chain_bit  = frag_id % zone_bits;
-        uint32_t chain_lba  = (chain_zone == 0u) ? g_fc_lba_base
-                            : g_fc_lba_base + (chain_zone * used_bits - dr_size) * secperlfau;
+        uint32_t chain_lba  = (chain_zone == 0u) ? FCM->lba_base
+                            : FCM->lba_base + (chain_zone * used_bits - dr_size) * secperlfau;
 
         uart_puts("[FileCore]   chain start: zone="); fc_dec(chain_zone);
         uart_puts("  bit_in_zone="); fc_dec(chain_bit);
@@ -1078,14 +1938,14 @@ void filecore_list_root(void)
         /* ── Step 1: Dump zone map sector at chain start ───────────────── */
         /* chain_zone / chain_bit computed just above from frag_id.        */
         {
-            uint32_t cz_lba = (chain_zone == 0u) ? g_fc_lba_base
-                            : g_fc_lba_base + (chain_zone * used_bits - dr_size) * secperlfau;
+            uint32_t cz_lba = (chain_zone == 0u) ? FCM->lba_base
+                            : FCM->lba_base + (chain_zone * used_bits - dr_size) * secperlfau;
             uart_puts("[FileCore] Chain zone "); fc_dec(chain_zone);
             uart_puts("  map LBA="); fc_hex32(cz_lba); uart_puts("\n");
 
             uint8_t *zbuf = (uint8_t *)kmalloc(512);
             if (zbuf) {
-                if (g_fc_bdev->ops->read(g_fc_bdev,
+                if (blockdev_read(FCM->bdev,
                                          (uint64_t)cz_lba, 1, zbuf) >= 0) {
                     /* 16 bytes centred on chain_bit/8 */
                     uint32_t bc = chain_bit / 8u;
@@ -1098,9 +1958,9 @@ void filecore_list_root(void)
                         uart_puts(k < bs + 15u ? " " : "\n");
                     }
                     uint32_t ev = adfs_read_bits(zbuf, chain_bit,
-                                                  (int)g_dr_id_len);
+                                                  (int)FCM->id_len);
                     uart_puts("[FileCore]   entry @bit"); fc_dec(chain_bit);
-                    uart_puts(" ("); fc_dec(g_dr_id_len);
+                    uart_puts(" ("); fc_dec(FCM->id_len);
                     uart_puts("b)="); fc_hex32(ev); uart_puts("\n");
                 } else {
                     uart_puts("[FileCore]   chain zone read error\n");
@@ -1112,9 +1972,9 @@ void filecore_list_root(void)
         /* Estimated data LBA for the chain-start LFAU (0-hop approximation).
          * Used as the brute-scan anchor if chain traverse fails.          */
         uint32_t est_data_lba = fc_bit_addr_to_data_lba(
-                                    frag_id, g_fc_lba_base,
-                                    g_dr_zone_spare, used_bits, dr_size,
-                                    g_dr_id_len, secperlfau);
+                                    frag_id, FCM->lba_base,
+                                    FCM->zone_spare, used_bits, dr_size,
+                                    FCM->id_len, secperlfau);
         uart_puts("[FileCore]   est_data_lba (chain-start)=");
         fc_hex32(est_data_lba); uart_puts("\n");
 
@@ -1135,9 +1995,9 @@ void filecore_list_root(void)
         {
             /* Compute root dir LBA from corrected formula (no /id_len).     */
             const uint32_t ROOT_LBA = fc_bit_addr_to_data_lba(
-                                          frag_id, g_fc_lba_base,
-                                          g_dr_zone_spare, used_bits, dr_size,
-                                          g_dr_id_len, secperlfau);
+                                          frag_id, FCM->lba_base,
+                                          FCM->zone_spare, used_bits, dr_size,
+                                          FCM->id_len, secperlfau);
 
             uart_puts("[FileCore] === Step 2A: Direct read at root dir LBA ===\n");
             uart_puts("[FileCore]   frag_id="); fc_dec(frag_id);
@@ -1151,7 +2011,7 @@ void filecore_list_root(void)
             } else {
                 int ok = 1;
                 for (int s = 0; s < 4 && ok; s++) {
-                    if (g_fc_bdev->ops->read(g_fc_bdev,
+                    if (blockdev_read(FCM->bdev,
                                              (uint64_t)(ROOT_LBA + (uint32_t)s),
                                              1, dir4 + (uint32_t)(s * 512)) < 0) {
                         uart_puts("[FileCore]   read error sector "); fc_dec((uint32_t)s);
@@ -1255,16 +2115,16 @@ void filecore_list_root(void)
             uint32_t dir_alloc = 2048u;  /* safe default */
 
             /* Primary: root_dir_size from zone DiscRec (set above) */
-            if (g_dr_root_dir_size >= 2048u && g_dr_root_dir_size <= FC_MAX_DIR_SIZE
-                    && (g_dr_root_dir_size & 511u) == 0u) {
-                dir_alloc = g_dr_root_dir_size;
+            if (FCM->root_dir_size >= 2048u && FCM->root_dir_size <= FC_MAX_DIR_SIZE
+                    && (FCM->root_dir_size & 511u) == 0u) {
+                dir_alloc = FCM->root_dir_size;
                 uart_puts("[FileCore]   dir_alloc from zone DiscRec: ");
                 fc_dec(dir_alloc); uart_puts(" bytes\n");
             } else {
                 /* Fallback: peek sector 0 header */
                 uint8_t *peek = (uint8_t *)kmalloc(512u);
                 if (peek) {
-                    if (g_fc_bdev->ops->read(g_fc_bdev,
+                    if (blockdev_read(FCM->bdev,
                             (uint64_t)root_probe, 1, peek) >= 0) {
                         uint32_t ds = (uint32_t)peek[12]
                                     | ((uint32_t)peek[13]<<8)
@@ -1288,7 +2148,7 @@ void filecore_list_root(void)
                 int rd_ok = 1;
                 uint32_t dir_nsecs = dir_alloc / 512u;
                 for (uint32_t s = 0; s < dir_nsecs && rd_ok; s++) {
-                    if (g_fc_bdev->ops->read(g_fc_bdev,
+                    if (blockdev_read(FCM->bdev,
                             (uint64_t)(root_probe + s),
                             1, dir + s * 512u) < 0) {
                         uart_puts("[FileCore]   sector read error s=");
@@ -1423,8 +2283,10 @@ void filecore_list_root(void)
 
                         /* boot234: Populate VFS root cache using correct entry_start
                          * (computed from BIGDIR_NAMELEN, not hard-coded to 32). */
+                        fc_mount_t *dm = fc_dir_lock();
                         filecore_populate_root_cache(dir, count,
                                                      entry_start, name_tab);
+                        fc_dir_unlock(dm);
 
                         /* ── Step 3 (boot231): linear SBPr scan from root+4 ────
                          *                                                        *
@@ -1466,7 +2328,7 @@ void filecore_list_root(void)
                                      lba < scan_end; lba += scan_step) {
 
                                     /* Quick probe: read 1 sector, check SBPr */
-                                    if (g_fc_bdev->ops->read(g_fc_bdev,
+                                    if (blockdev_read(FCM->bdev,
                                             (uint64_t)lba, 1, sbuf) < 0) continue;
 
                                     if (sbuf[4] != 'S' || sbuf[5] != 'B' ||
@@ -1488,7 +2350,7 @@ void filecore_list_root(void)
                                     /* Candidate — read remaining sectors */
                                     int srd = 1;
                                     for (uint32_t s = 1; s < snsecs && srd; s++) {
-                                        if (g_fc_bdev->ops->read(g_fc_bdev,
+                                        if (blockdev_read(FCM->bdev,
                                                 (uint64_t)(lba + s),
                                                 1, sbuf + s * 512u) < 0) {
                                             uart_puts("[SCAN] RD_FAIL LBA="); fc_hex32(lba + s);
@@ -1640,21 +2502,21 @@ void filecore_list_root(void)
          *
          * Replaces brute-force linear scan.  Reads each child dir and logs
          * its SBPr header so we can verify chain resolution is correct.    */
-        if (g_root_cache_valid && g_root_cache_count > 0u) {
+        if (FCM->root_cache_valid && FCM->root_cache_count > 0u) {
             uart_puts("\n[FileCore] === Step 4: IDA-based child navigation ===\n");
             uart_puts("[FileCore]   disc_map_lba="); fc_hex32(disc_map_lba);
             uart_puts("  nzones="); fc_dec(total_nzones);
             uart_puts("  ids_pz=");
-            fc_dec(((g_dr_zone_spare + used_bits) - g_dr_zone_spare)
-                   / (g_dr_id_len + 1u));
+            fc_dec(((FCM->zone_spare + used_bits) - FCM->zone_spare)
+                   / (FCM->id_len + 1u));
             uart_puts("\n");
 
             uint8_t *cbuf = (uint8_t *)kmalloc(FC_MAX_DIR_SIZE);
             if (!cbuf) {
                 uart_puts("[Step4] kmalloc fail\n");
             } else {
-                for (uint32_t ei = 0u; ei < g_root_cache_count; ei++) {
-                    vfs_dirent_t *e = &g_root_cache[ei];
+                for (uint32_t ei = 0u; ei < FCM->root_cache_count; ei++) {
+                    vfs_dirent_t *e = &FCM->root_cache[ei];
                     uint32_t child_ida = e->sin;
 
                     uart_puts("[Step4] #"); fc_dec(ei + 1u);
@@ -1670,9 +2532,9 @@ void filecore_list_root(void)
                     uint32_t child_lba = 0u;
                     int rc = fc_ida_to_data_lba(
                                 child_ida,
-                                g_fc_lba_base, disc_map_lba,
-                                g_dr_zone_spare, used_bits,
-                                dr_size, g_dr_id_len,
+                                FCM->lba_base, disc_map_lba,
+                                FCM->zone_spare, used_bits,
+                                dr_size, FCM->id_len,
                                 secperlfau, total_nzones,
                                 &child_lba);
 
@@ -1685,7 +2547,7 @@ void filecore_list_root(void)
                     uart_puts("\n");
 
                     /* Read first sector of child object */
-                    if (g_fc_bdev->ops->read(g_fc_bdev,
+                    if (blockdev_read(FCM->bdev,
                             (uint64_t)child_lba, 1, cbuf) < 0) {
                         uart_puts("[Step4]   read error\n");
                         continue;
@@ -1727,6 +2589,7 @@ void filecore_list_root(void)
             uart_puts("[FileCore] === Step 4 done ===\n\n");
         }
 
+fc_boot_steps:
         /* ── Step 5 (boot387/boot388): Execute PreDesk boot obey ───────────────
          *
          * boot386 revealed $.!Boot.!Boot is release notes text, not a boot script.
@@ -1738,7 +2601,7 @@ void filecore_list_root(void)
             extern void uart_set_quiet(int q);
             uart_set_quiet(0);
         }
-        if (g_root_cache_valid && g_root_cache_count > 0u) {
+        if (FCM->root_cache_valid && FCM->root_cache_count > 0u) {
             uart_puts("[FileCore] === Step 5: Execute $.!Boot.Choices.Boot.PreDesk ===\n");
 
             extern void con_printf(const char *fmt, ...);
@@ -1791,7 +2654,7 @@ void filecore_list_root(void)
          * Path tried in order:  $.!Boot.Modules  then  $.!Boot.Loader
          * Any file with 0x34 ≤ size ≤ 4 MB is read and passed to
          * module_load_from_memory().  First successful load breaks the loop.  */
-        if (g_root_cache_valid && g_root_cache_count > 0u) {
+        if (FCM->root_cache_valid && FCM->root_cache_count > 0u) {
             uart_puts("[FileCore] === Step 6: Load module from disc ===\n");
             filecore_step6_load_module(disc_map_lba, used_bits, dr_size,
                                         secperlfau, total_nzones);
@@ -1802,10 +2665,60 @@ void filecore_list_root(void)
         (void)frag_id; (void)chain_off; (void)est_data_lba;
     }
 
+    /* boot396: persist the mount for the next (warm) boot */
+    if (!g_fc_snap_hit) fc_snapshot_save();
+
     kfree(buf);
     uart_puts("[FileCore] Zone scan complete\n");
 }
 
+/* ── fc_read_file_into ───────────────────────────────────────────────────────
+ * boot400: resolve IDA → LBA and read the sectors covering [off, size) of the
+ * file straight into dst (cap bytes).  The object is one contiguous fragment,
+ * so it is read as a single request; boot413: the block layer splits it to
+ * the device's transfer limits.  off must be sector-aligned (boot401:
+ * demand paging reads one page at a time).  Returns 0 on success, -1 on
+ * resolve/read failure or if dst is too small.                              */
+
+static int fc_read_file_into(uint32_t sin, uint32_t size, uint32_t off,
+                              void *dst, uint32_t cap, uint32_t disc_map_lba,
+                              uint32_t used_bits,  uint32_t dr_size,
+                              uint32_t secperlfau, uint32_t nzones)
+{
+    if (!FCM->bdev || !dst || off >= size) return -1;
+
+    uint32_t sector_size = 1u << FCM->log2ss;
+    if (off & (sector_size - 1u)) return -1;
+    uint32_t nsecs       = (size - off + sector_size - 1u) / sector_size;
+    if ((uint64_t)nsecs * sector_size > (uint64_t)cap)
+        nsecs = cap / sector_size;                /* partial window read */
+    if (nsecs == 0u) return -1;
+
+    uint32_t file_lba = 0u;
+    if (fc_ida_to_data_lba(sin,
+                            FCM->lba_base, disc_map_lba,
+                            FCM->zone_spare, used_bits,
+                            dr_size, FCM->id_len,
+                            secperlfau, nzones,
+                            &file_lba) != 0) {
+        uart_puts("[FileRead] IDA resolve failed sin="); fc_hex32(sin); uart_puts("\n");
+        return -1;
+    }
+
+    file_lba += off / sector_size;
+    if (off == 0u) {
+        uart_puts("[FileRead] lba="); fc_hex32(file_lba);
+        uart_puts("  nsecs=");        fc_dec(nsecs);
+        uart_puts("  size=");         fc_dec(size); uart_puts("\n");
+    }
+
+    if (blockdev_read(FCM->bdev, (uint64_t)file_lba, nsecs, dst) < 0) {
+        uart_puts("[FileRead] read error lba="); fc_hex32(file_lba); uart_puts("\n");
+        return -1;
+    }
+    return 0;
+}
+
 /* ── filecore_read_file_buf ──────────────────────────────────────────────────
  * Read a complete file from disc into a newly allocated buffer.
  * Resolves IDA → LBA, reads ceil(size/sector_size) sectors.
@@ -1817,36 +2730,17 @@ static uint8_t *filecore_read_file_buf(uint32_t sin, uint32_t size,
                                         uint32_t used_bits,  uint32_t dr_size,
                                         uint32_t secperlfau, uint32_t nzones)
 {
-    if (!g_fc_bdev || size == 0u || size > 4u * 1024u * 1024u) return NULL;
-
-    uint32_t sector_size = 1u << g_dr_log2ss;
-    uint32_t file_lba    = 0u;
-
-    if (fc_ida_to_data_lba(sin,
-                            g_fc_lba_base, disc_map_lba,
-                            g_dr_zone_spare, used_bits,
-                            dr_size, g_dr_id_len,
-                            secperlfau, nzones,
-                            &file_lba) != 0) {
-        uart_puts("[FileRead] IDA resolve failed sin="); fc_hex32(sin); uart_puts("\n");
-        return NULL;
-    }
+    if (!FCM->bdev || size == 0u || size > 4u * 1024u * 1024u) return NULL;
 
+    uint32_t sector_size = 1u << FCM->log2ss;
     uint32_t nsecs = (size + sector_size - 1u) / sector_size;
     uint8_t *buf   = (uint8_t *)kmalloc(nsecs * sector_size);
     if (!buf) { uart_puts("[FileRead] kmalloc fail\n"); return NULL; }
 
-    uart_puts("[FileRead] lba="); fc_hex32(file_lba);
-    uart_puts("  nsecs=");        fc_dec(nsecs);
-    uart_puts("  size=");         fc_dec(size); uart_puts("\n");
-
-    for (uint32_t s = 0u; s < nsecs; s++) {
-        if (g_fc_bdev->ops->read(g_fc_bdev,
-                (uint64_t)(file_lba + s), 1, buf + s * sector_size) < 0) {
-            uart_puts("[FileRead] read error sector="); fc_dec(s); uart_puts("\n");
-            kfree(buf);
-            return NULL;
-        }
+    if (fc_read_file_into(sin, size, 0u, buf, nsecs * sector_size, disc_map_lba,
+                          used_bits, dr_size, secperlfau, nzones) != 0) {
+        kfree(buf);
+        return NULL;
     }
     return buf;
 }
@@ -1880,11 +2774,35 @@ static int fc_name_ieq(const char *a, const char *b)
  * Returns 0 and fills *out_ent on success, -1 if not found.                */
 static int fc_find_in_dir(uint32_t dir_sin, const char *name, vfs_dirent_t *out_ent)
 {
-    for (uint32_t i = 0u; i < 256u; i++) {
-        if (filecore_get_child_entry(dir_sin, i, out_ent) != 0) return -1;
-        if (fc_name_ieq(out_ent->name, name)) return 0;
+    fc_mount_t *m = fc_dir_lock();
+    int rc = -1;
+
+    /* boot396: resolved-IDA cache (restored from the mount snapshot) */
+    if (fc_ida_cache_get(dir_sin, name, out_ent) == 0) {
+        rc = 0;
+    } else {
+        for (uint32_t i = 0u; i < 256u; i++) {
+            if (filecore_get_child_entry(dir_sin, i, out_ent) != 0) break;
+            if (fc_name_ieq(out_ent->name, name)) {
+                fc_ida_cache_put(dir_sin, out_ent);
+                rc = 0;
+                break;
+            }
+        }
     }
-    return -1;
+    fc_dir_unlock(m);
+    return rc;
+}
+
+/* Lazy module body fetch (boot397): read on the mount the module was
+ * registered from, whichever disc the calling task has active.          */
+static int fc_module_fetch(void *mount, uint32_t sin, uint32_t size,
+                           void *dst, uint32_t cap)
+{
+    void *prev = filecore_enter(mount);
+    int   rc   = filecore_read_file_into(sin, size, dst, cap);
+    filecore_enter(prev);
+    return rc;
 }
 
 /* ── fc_try_load_modules_from_dir ────────────────────────────────────────────
@@ -1894,6 +2812,8 @@ static int fc_find_in_dir(uint32_t dir_sin, const char *name, vfs_dirent_t *out_
  * boot389: load ALL valid modules in the directory (not just the first one).
  *          Also add con_printf output so results are visible on framebuffer
  *          even when uart_set_quiet(1) is active.
+ * boot397: only the first MODULE_LAZY_HEAD_BYTES are read here; modules
+ *          are registered lazily and loaded in full on first use.
  *
  * Returns count of modules successfully loaded.                             */
 static int fc_try_load_modules_from_dir(uint32_t dir_sin, const char *label,
@@ -1956,18 +2876,25 @@ static int fc_try_load_modules_from_dir(uint32_t dir_sin, const char *label,
         uart_puts("[Step6] Trying '"); uart_puts(ent.name);
         uart_puts("' type=&FFA sz="); fc_dec((uint32_t)ent.size); uart_puts("\n");
 
-        uint8_t *fbuf = filecore_read_file_buf(ent.sin, (uint32_t)ent.size,
+        /* boot397: read the header sector only and register lazily — the
+         * body is fetched from this mount via fc_module_fetch() on the
+         * module's first SWI or subscribed service call.                  */
+        uint32_t head_len = (uint32_t)ent.size < MODULE_LAZY_HEAD_BYTES
+                          ? (uint32_t)ent.size : MODULE_LAZY_HEAD_BYTES;
+        uint8_t *hbuf = filecore_read_file_buf(ent.sin, head_len,
                                                 disc_map_lba, used_bits, dr_size,
                                                 secperlfau, nzones);
-        if (!fbuf) {
+        if (!hbuf) {
             uart_puts("[Step6] read fail skip\n");
             continue;
         }
 
-        int mrc = module_load_from_memory(fbuf, (uint32_t)ent.size, ent.name);
+        int mrc = module_register_lazy(hbuf, head_len, (uint32_t)ent.size,
+                                        ent.name, fc_module_fetch, FCM, ent.sin);
+        kfree(hbuf);
         if (mrc == 0) {
             uart_puts("[Step6] *** '"); uart_puts(ent.name);
-            uart_puts("' loaded OK ***\n");
+            uart_puts("' registered (lazy) ***\n");
             /* boot389: report success on framebuffer */
             con_set_colours(0xFF004000u, 0xFFE0E0E0u);
             con_printf("  Mod: %s [OK]\n", ent.name);
@@ -1976,7 +2903,6 @@ static int fc_try_load_modules_from_dir(uint32_t dir_sin, const char *label,
             /* boot389: DON'T return — load all modules in directory */
         } else {
             uart_puts("[Step6] rc="); fc_dec((uint32_t)(-mrc)); uart_puts(" skip\n");
-            kfree(fbuf);
         }
     }
     return loaded;
@@ -2013,9 +2939,9 @@ static void filecore_step6_load_module(uint32_t disc_map_lba,
 
     /* Step A1: !Boot from root cache (case-sensitive — '!' is literal) */
     uint32_t boot_sin = 0u;
-    for (uint32_t ri = 0u; ri < g_root_cache_count; ri++) {
-        if (fc_name_ieq(g_root_cache[ri].name, "!Boot")) {
-            boot_sin = g_root_cache[ri].sin; break;
+    for (uint32_t ri = 0u; ri < FCM->root_cache_count; ri++) {
+        if (fc_name_ieq(FCM->root_cache[ri].name, "!Boot")) {
+            boot_sin = FCM->root_cache[ri].sin; break;
         }
     }
     if (!boot_sin) {
@@ -2093,9 +3019,9 @@ path_b:
     uart_puts("[Step6] Path B: $.!LanMan98\n");
 
     uint32_t lanman_sin = 0u;
-    for (uint32_t ri = 0u; ri < g_root_cache_count; ri++) {
-        if (fc_name_ieq(g_root_cache[ri].name, "!LanMan98")) {
-            lanman_sin = g_root_cache[ri].sin; break;
+    for (uint32_t ri = 0u; ri < FCM->root_cache_count; ri++) {
+        if (fc_name_ieq(FCM->root_cache[ri].name, "!LanMan98")) {
+            lanman_sin = FCM->root_cache[ri].sin; break;
         }
     }
     if (!lanman_sin) {
@@ -2273,7 +3199,7 @@ static int fc_ida_to_data_lba(uint32_t ida,
     if (!zbuf) { uart_puts("[IDA] kmalloc fail\n"); return -1; }
 
     uint32_t map_sec = disc_map_lba + home_zone;
-    if (g_fc_bdev->ops->read(g_fc_bdev, (uint64_t)map_sec, 1, zbuf) < 0) {
+    if (blockdev_read(FCM->bdev, (uint64_t)map_sec, 1, zbuf) < 0) {
         uart_puts("[IDA] map read fail zone="); fc_dec(home_zone); uart_puts("\n");
         kfree(zbuf);
         return -1;
@@ -2409,10 +3335,10 @@ static void filecore_populate_root_cache(const uint8_t *dir,
                                           uint32_t entry_start,
                                           uint32_t name_tab)
 {
-    g_root_cache_count = 0u;
-    g_root_cache_valid = 0;
+    FCM->root_cache_count = 0u;
+    FCM->root_cache_valid = 0;
 
-    for (uint32_t i = 0u; i < count && g_root_cache_count < FC_ROOT_CACHE_MAX; i++) {
+    for (uint32_t i = 0u; i < count && FCM->root_cache_count < FC_ROOT_CACHE_MAX; i++) {
         uint32_t eoff = entry_start + i * 28u;
         uint32_t load = (uint32_t)dir[eoff+ 0]|((uint32_t)dir[eoff+ 1]<<8)|
                         ((uint32_t)dir[eoff+ 2]<<16)|((uint32_t)dir[eoff+ 3]<<24);
@@ -2431,7 +3357,7 @@ static void filecore_populate_root_cache(const uint8_t *dir,
         uint32_t noff = (uint32_t)dir[eoff+24]|((uint32_t)dir[eoff+25]<<8)|
                         ((uint32_t)dir[eoff+26]<<16)|((uint32_t)dir[eoff+27]<<24);
 
-        vfs_dirent_t *d = &g_root_cache[g_root_cache_count];
+        vfs_dirent_t *d = &FCM->root_cache[FCM->root_cache_count];
         d->load_addr   = load;
         d->exec_addr   = (uint32_t)dir[eoff+4]|((uint32_t)dir[eoff+5]<<8)|
                          ((uint32_t)dir[eoff+6]<<16)|((uint32_t)dir[eoff+7]<<24);
@@ -2456,126 +3382,127 @@ static void filecore_populate_root_cache(const uint8_t *dir,
         }
         d->name[k] = '\0';
 
-        g_root_cache_count++;
+        FCM->root_cache_count++;
     }
-    g_root_cache_valid = 1;
-    uart_puts("[VFS] Root cache populated: "); fc_dec(g_root_cache_count);
+    FCM->root_cache_valid = 1;
+    uart_puts("[VFS] Root cache populated: "); fc_dec(FCM->root_cache_count);
     uart_puts(" entries\n");
 }
 
+static int fc_root_ready(void);     /* boot408: defined below */
+
 /* Called by vfs.c readdir to retrieve a cached root entry */
 int filecore_get_root_entry(uint32_t idx, vfs_dirent_t *out)
 {
-    if (!g_root_cache_valid || idx >= g_root_cache_count) return -1;
-    *out = g_root_cache[idx];
-    return 0;
+    fc_mount_t *m = fc_dir_lock();
+    int rc = -1;
+    if (fc_root_ready() && idx < m->root_cache_count) {
+        *out = m->root_cache[idx];
+        rc = 0;
+    }
+    fc_dir_unlock(m);
+    return rc;
 }
 
-/* ── filecore_get_child_entry ────────────────────────────────────────────────
- * Resolve a subdirectory by its IDA (dir_sin) and return entry[idx] from it.
- *
- * Algorithm (boot268 IDA-based navigation):
- *   1. Derive disc geometry from global disc-record params.
- *   2. Call fc_ida_to_data_lba() to resolve IDA → data LBA.
- *   3. Read dir_size bytes from that LBA.
- *   4. Validate SBPr header.
- *   5. Return the entry at index idx as a vfs_dirent_t.
- *
- * Returns 0 on success, -1 on any failure (not mounted, resolve fail,
- * read error, not a BigDir, idx out of range).                              */
-int filecore_get_child_entry(uint32_t dir_sin, uint32_t idx,
-                              vfs_dirent_t *out)
+/* ── Directory buffer cache ──────────────────────────────────────────────────
+ * boot407: the most recently read BigDir stays in memory keyed by IDA, so
+ * listing a directory entry-by-entry (fc_find_in_dir, Step 6) or in
+ * batches (filecore_getdents) reads and validates it once, not per index.
+ * The disc is mounted read-only, so the copy only goes stale on remount.
+ * boot408: one buffer per mount, so discs do not evict each other.      */
+
+static uint32_t fc_le32(const uint8_t *p)
 {
-    if (!g_fc_bdev || !out) return -1;
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Resolve dir_sin and return its SBPr image (cached); NULL on failure */
+static const uint8_t *fc_load_dir(uint32_t dir_sin, uint32_t *dir_size_out)
+{
+    if (FCM->dirbuf_valid && FCM->dirbuf_sin == dir_sin) {
+        *dir_size_out = FCM->dirbuf_size;
+        return FCM->dirbuf;
+    }
+    if (!FCM->bdev) return NULL;
 
     /* ── Derive zone-map geometry (same as filecore_list_root) ── */
-    uint32_t sector_size  = 1u << g_dr_log2ss;
-    uint32_t bpmb         = 1u << g_dr_log2bpmb;
+    uint32_t sector_size  = 1u << FCM->log2ss;
+    uint32_t bpmb         = 1u << FCM->log2bpmb;
     uint32_t secperlfau   = bpmb / sector_size;
     uint32_t bits_per_sec = sector_size * 8u;
-    uint32_t used_bits    = bits_per_sec - g_dr_zone_spare;
+    uint32_t used_bits    = bits_per_sec - FCM->zone_spare;
     uint32_t dr_size      = 60u * 8u;
 
-    uint32_t total_nzones = g_dr_nzones;
-    if (g_dr_big_flag) total_nzones += (uint32_t)g_dr_nzones_hi << 8u;
+    uint32_t total_nzones = FCM->nzones;
+    if (FCM->big_flag) total_nzones += (uint32_t)FCM->nzones_hi << 8u;
     uint32_t mid_zone     = total_nzones / 2u;
-    uint32_t disc_map_lba = g_fc_lba_base
+    uint32_t disc_map_lba = FCM->lba_base
                           + (mid_zone * used_bits - dr_size) * secperlfau;
 
     /* ── IDA → data LBA ── */
     uint32_t dir_lba = 0u;
     if (fc_ida_to_data_lba(dir_sin,
-                            g_fc_lba_base, disc_map_lba,
-                            g_dr_zone_spare, used_bits,
-                            dr_size, g_dr_id_len,
+                            FCM->lba_base, disc_map_lba,
+                            FCM->zone_spare, used_bits,
+                            dr_size, FCM->id_len,
                             secperlfau, total_nzones,
                             &dir_lba) != 0) {
         uart_puts("[GCE] IDA resolve failed for sin=");
         fc_hex32(dir_sin); uart_puts("\n");
-        return -1;
+        return NULL;
     }
 
-    /* ── Read first sector; get dir_size from SBPr header ── */
-    uint8_t *dbuf = (uint8_t *)kmalloc(FC_MAX_DIR_SIZE);
-    if (!dbuf) return -1;
+    if (!FCM->dirbuf) {
+        FCM->dirbuf = (uint8_t *)kmalloc(FC_MAX_DIR_SIZE);
+        if (!FCM->dirbuf) return NULL;
+    }
+    FCM->dirbuf_valid = 0;
+    uint8_t *dbuf = FCM->dirbuf;
 
-    if (g_fc_bdev->ops->read(g_fc_bdev, (uint64_t)dir_lba, 1, dbuf) < 0) {
+    /* ── Read first sector; get dir_size from SBPr header ── */
+    if (blockdev_read(FCM->bdev, (uint64_t)dir_lba, 1, dbuf) < 0) {
         uart_puts("[GCE] read error lba="); fc_hex32(dir_lba); uart_puts("\n");
-        kfree(dbuf); return -1;
+        return NULL;
     }
 
     if (dbuf[4] != 'S' || dbuf[5] != 'B' || dbuf[6] != 'P' || dbuf[7] != 'r') {
         uart_puts("[GCE] not SBPr at lba="); fc_hex32(dir_lba); uart_puts("\n");
-        kfree(dbuf); return -1;
+        return NULL;
     }
 
-    uint32_t dir_size = (uint32_t)dbuf[12] | ((uint32_t)dbuf[13]<<8)
-                      | ((uint32_t)dbuf[14]<<16) | ((uint32_t)dbuf[15]<<24);
+    uint32_t dir_size = fc_le32(dbuf + 12);
     if (dir_size < 2048u || dir_size > FC_MAX_DIR_SIZE || (dir_size & 511u) != 0u)
         dir_size = 2048u;
 
-    /* ── Read remaining sectors ── */
+    /* ── Read the remaining sectors in one request ── */
     uint32_t nsecs = dir_size / sector_size;
-    for (uint32_t s = 1u; s < nsecs; s++) {
-        if (g_fc_bdev->ops->read(g_fc_bdev, (uint64_t)(dir_lba + s),
-                                  1, dbuf + s * sector_size) < 0) {
-            kfree(dbuf); return -1;
-        }
-    }
-
-    /* ── Decode SBPr header ── */
-    uint32_t namelen     = (uint32_t)dbuf[8]  | ((uint32_t)dbuf[9]<<8)
-                         | ((uint32_t)dbuf[10]<<16) | ((uint32_t)dbuf[11]<<24);
-    uint32_t count       = (uint32_t)dbuf[16] | ((uint32_t)dbuf[17]<<8)
-                         | ((uint32_t)dbuf[18]<<16) | ((uint32_t)dbuf[19]<<24);
-
-    if (idx >= count) { kfree(dbuf); return -1; }
-
-    uint32_t entry_start = 28u + ((namelen + 1u + 3u) & ~3u);
-    uint32_t name_tab    = entry_start + count * 28u;
-    uint32_t oven_off    = dir_size - 8u;
-
-    /* ── Extract entry at idx ── */
-    uint32_t eoff = entry_start + idx * 28u;
-
-    uint32_t load = (uint32_t)dbuf[eoff+ 0]|((uint32_t)dbuf[eoff+ 1]<<8)|
-                    ((uint32_t)dbuf[eoff+ 2]<<16)|((uint32_t)dbuf[eoff+ 3]<<24);
-    uint32_t exec = (uint32_t)dbuf[eoff+ 4]|((uint32_t)dbuf[eoff+ 5]<<8)|
-                    ((uint32_t)dbuf[eoff+ 6]<<16)|((uint32_t)dbuf[eoff+ 7]<<24);
-    uint32_t len  = (uint32_t)dbuf[eoff+ 8]|((uint32_t)dbuf[eoff+ 9]<<8)|
-                    ((uint32_t)dbuf[eoff+10]<<16)|((uint32_t)dbuf[eoff+11]<<24);
-    uint32_t ida  = (uint32_t)dbuf[eoff+12]|((uint32_t)dbuf[eoff+13]<<8)|
-                    ((uint32_t)dbuf[eoff+14]<<16)|((uint32_t)dbuf[eoff+15]<<24);
-    uint32_t gce_attr = (uint32_t)dbuf[eoff+16]|((uint32_t)dbuf[eoff+17]<<8)|
-                    ((uint32_t)dbuf[eoff+18]<<16)|((uint32_t)dbuf[eoff+19]<<24);
-    uint32_t nlen = (uint32_t)dbuf[eoff+20]|((uint32_t)dbuf[eoff+21]<<8)|
-                    ((uint32_t)dbuf[eoff+22]<<16)|((uint32_t)dbuf[eoff+23]<<24);
-    uint32_t noff = (uint32_t)dbuf[eoff+24]|((uint32_t)dbuf[eoff+25]<<8)|
-                    ((uint32_t)dbuf[eoff+26]<<16)|((uint32_t)dbuf[eoff+27]<<24);
+    if (nsecs > 1u &&
+        blockdev_read(FCM->bdev, (uint64_t)(dir_lba + 1u),
+                              nsecs - 1u, dbuf + sector_size) < 0)
+        return NULL;
+
+    FCM->dirbuf_sin   = dir_sin;
+    FCM->dirbuf_size  = dir_size;
+    FCM->dirbuf_valid = 1;
+    *dir_size_out  = dir_size;
+    return dbuf;
+}
+
+/* Decode BigDir entry at eoff; names are bounded by 'limit' (the oven) */
+static void fc_decode_entry(const uint8_t *dbuf, uint32_t eoff,
+                            uint32_t name_tab, uint32_t limit,
+                            vfs_dirent_t *out)
+{
+    uint32_t load     = fc_le32(dbuf + eoff +  0);
+    uint32_t ida      = fc_le32(dbuf + eoff + 12);
+    uint32_t gce_attr = fc_le32(dbuf + eoff + 16);
+    uint32_t nlen     = fc_le32(dbuf + eoff + 20);
+    uint32_t noff     = fc_le32(dbuf + eoff + 24);
 
     out->load_addr   = load;
-    out->exec_addr   = exec;
-    out->size        = (uint64_t)len;
+    out->exec_addr   = fc_le32(dbuf + eoff + 4);
+    out->size        = (uint64_t)fc_le32(dbuf + eoff + 8);
     out->sin         = ida;
     out->riscos_type = (uint16_t)((load >> 8) & 0xFFFu);
 
@@ -2587,17 +3514,134 @@ int filecore_get_child_entry(uint32_t dir_sin, uint32_t idx,
     else
         out->type = VFS_DIRENT_FILE;
 
-    /* ── Copy name (0x0D terminated, bounded by oven_off) ── */
+    /* ── Copy name (0x0D terminated, bounded by limit) ── */
     uint32_t nabs = name_tab + noff;
     uint32_t k;
     for (k = 0u; k < nlen && k < VFS_NAME_MAX - 1u; k++) {
-        if (nabs + k >= oven_off || dbuf[nabs + k] == 0x0Du) break;
+        if (nabs + k >= limit || dbuf[nabs + k] == 0x0Du) break;
         out->name[k] = (char)(dbuf[nabs + k] & 0x7Fu);
     }
     out->name[k] = '\0';
+}
 
-    kfree(dbuf);
-    return 0;
+/* SBPr header → entry count, first entry offset, name table, oven offset */
+static uint32_t fc_dir_layout(const uint8_t *dbuf, uint32_t dir_size,
+                              uint32_t *entry_start, uint32_t *name_tab,
+                              uint32_t *oven_off)
+{
+    uint32_t namelen = fc_le32(dbuf + 8);
+    uint32_t count   = fc_le32(dbuf + 16);
+    if (namelen > dir_size) namelen = dir_size;    /* no wrap below */
+    *entry_start = 28u + ((namelen + 1u + 3u) & ~3u);
+    if (*entry_start > dir_size - 8u) {            /* corrupt: past the oven */
+        *entry_start = dir_size - 8u;
+        count = 0u;
+    }
+    if (count > (dir_size - 8u - *entry_start) / 28u) count = 0u;   /* corrupt */
+    *name_tab    = *entry_start + count * 28u;
+    *oven_off    = dir_size - 8u;
+    return count;
+}
+
+/* boot408: the boot disc's root cache is filled by filecore_list_root (or
+ * the snapshot); other mounts parse their root directory on first use.  */
+static int fc_root_ready(void)
+{
+    fc_mount_t *m = fc_dir_lock();
+    int ok = m->root_cache_valid;
+
+    if (!ok && m->bdev) {
+        uint32_t dir_size;
+        const uint8_t *dbuf = fc_load_dir(m->root_dir, &dir_size);
+        if (dbuf) {
+            uint32_t entry_start, name_tab, oven_off;
+            uint32_t count = fc_dir_layout(dbuf, dir_size, &entry_start,
+                                           &name_tab, &oven_off);
+            filecore_populate_root_cache(dbuf, count, entry_start, name_tab);
+            ok = 1;
+        }
+    }
+    fc_dir_unlock(m);
+    return ok;
+}
+
+/* ── filecore_get_child_entry ────────────────────────────────────────────────
+ * Resolve a subdirectory by its IDA (dir_sin) and return entry[idx] from it.
+ *
+ * Algorithm (boot268 IDA-based navigation):
+ *   1. Derive disc geometry from global disc-record params.
+ *   2. Call fc_ida_to_data_lba() to resolve IDA → data LBA.
+ *   3. Read dir_size bytes from that LBA.
+ *   4. Validate SBPr header.
+ *   5. Return the entry at index idx as a vfs_dirent_t.
+ * boot407: steps 1–4 live in fc_load_dir() and are cached per directory.
+ *
+ * Returns 0 on success, -1 on any failure (not mounted, resolve fail,
+ * read error, not a BigDir, idx out of range).                              */
+int filecore_get_child_entry(uint32_t dir_sin, uint32_t idx,
+                              vfs_dirent_t *out)
+{
+    if (!FCM->bdev || !out) return -1;
+
+    fc_mount_t *m = fc_dir_lock();
+    int rc = -1;
+    uint32_t dir_size;
+    const uint8_t *dbuf = fc_load_dir(dir_sin, &dir_size);
+    if (dbuf) {
+        uint32_t entry_start, name_tab, oven_off;
+        uint32_t count = fc_dir_layout(dbuf, dir_size, &entry_start,
+                                       &name_tab, &oven_off);
+        if (idx < count) {
+            fc_decode_entry(dbuf, entry_start + idx * 28u, name_tab, oven_off, out);
+            rc = 0;
+        }
+    }
+    fc_dir_unlock(m);
+    return rc;
+}
+
+/* ── filecore_getdents ───────────────────────────────────────────────────────
+ * boot407: pack entries [*cookie ..] of a directory into buf as
+ * vfs_dirent_packed_t records from a single directory parse.  The root
+ * is served from the mount-time root cache.  Returns bytes written, 0 at
+ * end of directory, -1 on error (or if buf can't hold the next entry). */
+int filecore_getdents(uint32_t dir_sin, uint32_t *cookie, void *buf, uint32_t bufsz)
+{
+    if (!cookie || !buf) return -1;
+
+    uint8_t *dst  = (uint8_t *)buf;
+    uint32_t used = 0u;
+    uint32_t idx  = *cookie;
+    int      full = 0;
+    vfs_dirent_t ent;
+    fc_mount_t *m = fc_dir_lock();
+
+    if (dir_sin == m->root_dir) {
+        if (!fc_root_ready()) { fc_dir_unlock(m); return -1; }
+        for (; idx < m->root_cache_count; idx++) {
+            size_t n = vfs_dirent_pack(dst + used, bufsz - used, &m->root_cache[idx]);
+            if (n == 0u) { full = 1; break; }
+            used += (uint32_t)n;
+        }
+    } else {
+        uint32_t dir_size;
+        const uint8_t *dbuf = fc_load_dir(dir_sin, &dir_size);
+        if (!dbuf) { fc_dir_unlock(m); return -1; }
+
+        uint32_t entry_start, name_tab, oven_off;
+        uint32_t count = fc_dir_layout(dbuf, dir_size, &entry_start, &name_tab, &oven_off);
+        for (; idx < count; idx++) {
+            fc_decode_entry(dbuf, entry_start + idx * 28u, name_tab, oven_off, &ent);
+            size_t n = vfs_dirent_pack(dst + used, bufsz - used, &ent);
+            if (n == 0u) { full = 1; break; }
+            used += (uint32_t)n;
+        }
+    }
+    fc_dir_unlock(m);
+
+    if (full && used == 0u) return -1;              /* buf too small */
+    *cookie = idx;
+    return (int)used;
 }
 
 /* ── filecore_show_results ───────────────────────────────────────────────────
@@ -2614,7 +3658,7 @@ void filecore_show_results(void)
     con_printf("  FileCore: Phoenix disc scan\n");
     con_set_colours(0xFF202020u, 0xFFE0E0E0u);   /* dark on light grey */
 
-    if (!g_fc_bdev) {
+    if (!FCM->bdev) {
         con_printf("  No RISC OS disc found\n");
         return;
     }
@@ -2622,7 +3666,7 @@ void filecore_show_results(void)
     /* Disc name (trim trailing spaces) */
     char name[11];
     int ni;
-    for (ni = 0; ni < 10; ni++) name[ni] = g_dr_disc_name[ni];
+    for (ni = 0; ni < 10; ni++) name[ni] = FCM->disc_name[ni];
     name[10] = '\0';
     for (ni = 9; ni >= 0 && (name[ni] == ' ' || name[ni] == '\0'); ni--)
         name[ni] = '\0';
@@ -2630,10 +3674,10 @@ void filecore_show_results(void)
     con_printf("  Disc: %s\n", name[0] ? name : "unnamed");
 
     /* Root directory listing */
-    if (g_root_cache_valid && g_root_cache_count > 0u) {
-        con_printf("  $: %u objects:", (unsigned)g_root_cache_count);
-        for (uint32_t i = 0u; i < g_root_cache_count && i < 8u; i++)
-            con_printf("  %s", g_root_cache[i].name);
+    if (FCM->root_cache_valid && FCM->root_cache_count > 0u) {
+        con_printf("  $: %u objects:", (unsigned)FCM->root_cache_count);
+        for (uint32_t i = 0u; i < FCM->root_cache_count && i < 8u; i++)
+            con_printf("  %s", FCM->root_cache[i].name);
         con_printf("\n");
     } else {
         con_printf("  $ (empty or not read)\n");
@@ -2734,7 +3778,7 @@ static int adfs_chain_traverse(uint32_t frag_id, uint32_t chain_offset,
             uart_puts(" L="); fc_hex32(map_lba); uart_puts("\n");
         }
 
-        if (g_fc_bdev->ops->read(g_fc_bdev, (uint64_t)map_lba, 1, zbuf) < 0) {
+        if (blockdev_read(FCM->bdev, (uint64_t)map_lba, 1, zbuf) < 0) {
             uart_puts("[ADFS] read err hop="); fc_dec(hop); uart_puts("\n");
             kfree(zbuf);
             return -1;
@@ -2790,7 +3834,7 @@ static int adfs_chain_traverse(uint32_t frag_id, uint32_t chain_offset,
 
     int read_ok = 1;
     for (int s = 0; s < 4; s++) {
-        if (g_fc_bdev->ops->read(g_fc_bdev,
+        if (blockdev_read(FCM->bdev,
                                   (uint64_t)(data_lba + (uint32_t)s),
                                   1, dirbuf + (uint32_t)s * 512u) < 0) {
             uart_puts("[ADFS]   data read error at sector "); fc_dec((uint32_t)s); uart_puts("\n");
@@ -2881,7 +3925,7 @@ static void adfs_hugo_brute_scan(uint32_t start_lba, uint32_t scan_lbas,
     uint32_t found = 0u;
 
     for (uint32_t lba = start_lba; lba < start_lba + scan_lbas; lba += step) {
-        if (g_fc_bdev->ops->read(g_fc_bdev, (uint64_t)lba, 1, buf) < 0) continue;
+        if (blockdev_read(FCM->bdev, (uint64_t)lba, 1, buf) < 0) continue;
 
         if (buf[1] == 'H' && buf[2] == 'u' && buf[3] == 'g' && buf[4] == 'o') {
             uart_puts("[ADFS] *** Hugo magic at LBA="); fc_hex32(lba); uart_puts(" ***\n");
@@ -2891,7 +3935,7 @@ static void adfs_hugo_brute_scan(uint32_t start_lba, uint32_t scan_lbas,
             if (dirbuf) {
                 int ok = 1;
                 for (int s = 0; s < 4; s++) {
-                    if (g_fc_bdev->ops->read(g_fc_bdev,
+                    if (blockdev_read(FCM->bdev,
                                               (uint64_t)(lba + (uint32_t)s),
                                               1, dirbuf + (uint32_t)s * 512u) < 0) {
                         uart_puts("[ADFS]   read error at sector ");
@@ -2923,6 +3967,88 @@ static void adfs_hugo_brute_scan(uint32_t start_lba, uint32_t scan_lbas,
     }
 }
 
+/* ── Mount selection (boot408) ───────────────────────────────────────────────
+ * A path may name its disc: "ADFS::NVMe.$.!Boot", "SDFS::Boot.$", or the
+ * bare "HardDisc4.$.!Boot".  The prefix is matched against the mount
+ * names case-insensitively; a bare disc name that matches nothing keeps
+ * the caller's current mount (the pre-boot408 behaviour), an unknown
+ * "FS::disc" fails.  *rest is left just past the prefix.                   */
+
+/* Compare a[0..n) against NUL-terminated b, case-insensitively */
+static int fc_name_nieq(const char *a, size_t n, const char *b)
+{
+    size_t i;
+    for (i = 0; i < n; i++) {
+        char ca = a[i], cb = b[i];
+        if (!cb) return 0;
+        if (ca >= 'a' && ca <= 'z') ca -= 32;
+        if (cb >= 'a' && cb <= 'z') cb -= 32;
+        if (ca != cb) return 0;
+    }
+    return b[i] == '\0';
+}
+
+/* Probe the devices a warm boot skipped (mount 0 came from the snapshot),
+ * or whose boot-time probe task was still running when the disc was chosen */
+static void fc_mount_scan(void)
+{
+    if (__atomic_load_n(&g_fc_probe_live, __ATOMIC_ACQUIRE) > 0)
+        return;                     /* slots still in use: retry next lookup */
+    g_fc_scan_pending = 0;
+    g_fc_probe_count  = 0;
+    for (int i = 0; i < blockdev_count && g_fc_probe_count < FC_PROBE_MAX; i++) {
+        blockdev_t *bd = blockdev_list[i];
+        if (!bd || bd->size == 0 || !bd->ops || !bd->ops->read) continue;
+        if (fc_mount_has_bdev(bd)) continue;
+        fc_probe_t *p = &g_fc_probe[g_fc_probe_count++];
+        memset(p, 0, sizeof(*p));
+        p->bd = bd;
+        fc_probe_device(p);
+    }
+    fc_mount_add_probes();
+}
+
+static fc_mount_t *fc_mount_match(const char *name, size_t n, int full)
+{
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < g_fc_mount_count; i++) {
+            fc_mount_t *m = &g_fc_mounts[i];
+            const char *mn = full ? m->name : m->name + 6;   /* past "xDFS::" */
+            if (fc_name_nieq(name, n, mn)) return m;
+        }
+        if (!g_fc_scan_pending) break;
+        fc_mount_scan();
+    }
+    return NULL;
+}
+
+static fc_mount_t *fc_mount_for_path(const char *path, const char **rest)
+{
+    const char *dot = path;
+    while (*dot && *dot != '.') dot++;
+    *rest = path;
+
+    const char *colons = path;
+    while (colons < dot && !(colons[0] == ':' && colons[1] == ':')) colons++;
+
+    if (colons < dot) {                         /* "FS::disc" or "FS::"  */
+        const char *disc = colons + 2;
+        if (disc == dot || *disc == '$') {      /* "ADFS::$.x" – current */
+            *rest = disc;
+            return fc_cur();
+        }
+        *rest = (*dot == '.') ? dot + 1 : dot;
+        return fc_mount_match(path, (size_t)(dot - path), 1);
+    }
+    if (path[0] != '$' && dot > path && dot[0] == '.' && dot[1] == '$') {
+                                                /* "disc.$…"             */
+        fc_mount_t *m = fc_mount_match(path, (size_t)(dot - path), 0);
+        *rest = dot + 1;
+        return m ? m : fc_cur();
+    }
+    return fc_cur();
+}
+
 /* ── filecore_find_path ──────────────────────────────────────────────────────
  * Resolve a RISC OS path to a vfs_dirent_t.  Accepted path forms:
  *   $.!Boot                          (root-relative)
@@ -2932,23 +4058,18 @@ static void adfs_hugo_brute_scan(uint32_t start_lba, uint32_t scan_lbas,
  *   $.                               (root itself)
  *
  * Algorithm:
- *   1. Strip optional "ADFS::" FS prefix.
- *   2. Advance past disc name to "$." (first "$.").
- *   3. First component: search g_root_cache.
+ *   1. Select the mount named by an optional "FS::disc" / "disc" prefix.
+ *   2. Advance to "$." (first "$.").
+ *   3. First component: search the mount's root cache.
  *   4. Subsequent components: fc_find_in_dir() on the current SIN.
  *
  * Returns 0 and fills *out on success, -1 if not found.
- * boot385: full implementation replacing boot299 stub.                      */
-int filecore_find_path(const char *path, vfs_dirent_t *out)
-{
-    if (!path || !out || !g_root_cache_valid) return -1;
-
-    const char *p = path;
+ * boot385: full implementation replacing boot299 stub.
+ * boot408: filecore_lookup() also reports the mount the entry lives on.    */
 
-    /* Strip "ADFS::" or "adfs::" FS prefix */
-    if ((p[0]=='A'||p[0]=='a') && p[1]=='D' && p[2]=='F' &&
-        p[3]=='S' && p[4]==':' && p[5]==':')
-        p += 6;
+static int fc_find_path_cur(const char *p, vfs_dirent_t *out)
+{
+    if (!fc_root_ready()) return -1;
 
     /* Advance to "$." — skip disc name if present */
     {
@@ -2959,9 +4080,9 @@ int filecore_find_path(const char *path, vfs_dirent_t *out)
     }
 
     /* Path is just "$" or "$." — return synthetic root dirent */
-    if (*p == '\0') {
+    if (*p == '\0' || (p[0] == '$' && p[1] == '\0')) {
         out->type       = VFS_DIRENT_DIR;
-        out->sin        = g_dr_root_dir;
+        out->sin        = FCM->root_dir;
         out->size       = 0;
         out->load_addr  = 0;
         out->exec_addr  = 0;
@@ -2981,9 +4102,9 @@ int filecore_find_path(const char *path, vfs_dirent_t *out)
 
     vfs_dirent_t cur;
     int found = 0;
-    for (uint32_t ri = 0u; ri < g_root_cache_count; ri++) {
-        if (fc_name_eq(g_root_cache[ri].name, comp)) {
-            cur = g_root_cache[ri];
+    for (uint32_t ri = 0u; ri < FCM->root_cache_count; ri++) {
+        if (fc_name_eq(FCM->root_cache[ri].name, comp)) {
+            cur = FCM->root_cache[ri];
             found = 1;
             break;
         }
@@ -3005,6 +4126,28 @@ int filecore_find_path(const char *path, vfs_dirent_t *out)
     return 0;
 }
 
+int filecore_lookup(const char *path, vfs_dirent_t *out, void **mount)
+{
+    if (!path || !out) return -1;
+
+    const char *rest;
+    fc_mount_t *m = fc_mount_for_path(path, &rest);
+    if (!m || !m->bdev) return -1;
+
+    void *prev = filecore_enter(m);
+    sleeplock_lock(&m->dir_lock);       /* root_cache walk + descent */
+    int rc = fc_find_path_cur(rest, out);
+    sleeplock_unlock(&m->dir_lock);
+    filecore_enter(prev);
+    if (rc == 0 && mount) *mount = m;
+    return rc;
+}
+
+int filecore_find_path(const char *path, vfs_dirent_t *out)
+{
+    return filecore_lookup(path, out, NULL);
+}
+
 /* ── Obey file executor ──────────────────────────────────────────────────────
  * boot385: parse and execute an ADFS !Boot obey file byte buffer.
  *
@@ -3240,6 +4383,24 @@ void filecore_exec_obey(const uint8_t *buf, uint32_t size)
     uart_puts("[Obey] --- done ---\n");
 }
 
+/* ── fc_file_geometry ────────────────────────────────────────────────────────
+ * Derive the map geometry filecore_read_file_buf() needs from the g_dr_*
+ * globals of the mounted disc.                                              */
+static void fc_file_geometry(uint32_t *dml, uint32_t *used_bits,
+                              uint32_t *dr_size, uint32_t *secperlfau,
+                              uint32_t *nzones)
+{
+    uint32_t sector_size = 1u << FCM->log2ss;
+    uint32_t bpmb        = 1u << FCM->log2bpmb;
+    *secperlfau = bpmb / sector_size;
+    *used_bits  = (sector_size * 8u) - FCM->zone_spare;
+    *dr_size    = 60u * 8u;
+    *nzones     = FCM->nzones;
+    if (FCM->big_flag) *nzones += (uint32_t)FCM->nzones_hi << 8u;
+    uint32_t mid_zone = *nzones / 2u;
+    *dml = FCM->lba_base + (mid_zone * *used_bits - *dr_size) * *secperlfau;
+}
+
 /* ── filecore_read_file ──────────────────────────────────────────────────────
  * Public wrapper: read a file by IDA (sin) into a newly-allocated buffer.
  * Derives disc geometry from g_dr_* globals and calls filecore_read_file_buf.
@@ -3248,19 +4409,43 @@ void filecore_exec_obey(const uint8_t *buf, uint32_t size)
  * (boot299 stub — not exercised in boot300)                                 */
 uint8_t *filecore_read_file(uint32_t sin, uint32_t size)
 {
-    if (!g_fc_bdev || size == 0u) return NULL;
-
-    uint32_t sector_size = 1u << g_dr_log2ss;
-    uint32_t bpmb        = 1u << g_dr_log2bpmb;
-    uint32_t secperlfau  = bpmb / sector_size;
-    uint32_t used_bits   = (sector_size * 8u) - g_dr_zone_spare;
-    uint32_t dr_size     = 60u * 8u;
-    uint32_t nzones      = g_dr_nzones;
-    if (g_dr_big_flag) nzones += (uint32_t)g_dr_nzones_hi << 8u;
-    uint32_t mid_zone    = nzones / 2u;
-    uint32_t dml         = g_fc_lba_base
-                         + (mid_zone * used_bits - dr_size) * secperlfau;
+    if (!FCM->bdev || size == 0u) return NULL;
 
+    uint32_t dml, used_bits, dr_size, secperlfau, nzones;
+    fc_file_geometry(&dml, &used_bits, &dr_size, &secperlfau, &nzones);
     return filecore_read_file_buf(sin, size, dml, used_bits, dr_size,
                                    secperlfau, nzones);
 }
+
+/* ── filecore_read_file_into ─────────────────────────────────────────────────
+ * boot400: read a file by IDA (sin) into a caller-owned buffer of cap bytes,
+ * which must cover size rounded up to the disc's sector size.  Lets the
+ * module loader read straight into its final page-aligned image with no
+ * intermediate copy.  Returns 0 on success, -1 on failure.                  */
+int filecore_read_file_into(uint32_t sin, uint32_t size, void *dst, uint32_t cap)
+{
+    if (!FCM->bdev || size == 0u) return -1;
+
+    uint32_t dml, used_bits, dr_size, secperlfau, nzones;
+    fc_file_geometry(&dml, &used_bits, &dr_size, &secperlfau, &nzones);
+    uint32_t sector_size = 1u << FCM->log2ss;
+    if ((uint64_t)((size + sector_size - 1u) / sector_size) * sector_size > cap)
+        return -1;
+    return fc_read_file_into(sin, size, 0u, dst, cap, dml, used_bits, dr_size,
+                             secperlfau, nzones);
+}
+
+/* ── filecore_read_file_range ────────────────────────────────────────────────
+ * boot401: read the sectors covering [off, off+cap) of a file (clipped at
+ * size) into dst.  off must be sector-aligned; used by the page-fault path
+ * to fault in one file page at a time.  Returns 0 on success, -1 on failure. */
+int filecore_read_file_range(uint32_t sin, uint32_t size, uint32_t off,
+                             void *dst, uint32_t cap)
+{
+    if (!FCM->bdev || off >= size) return -1;
+
+    uint32_t dml, used_bits, dr_size, secperlfau, nzones;
+    fc_file_geometry(&dml, &used_bits, &dr_size, &secperlfau, &nzones);
+    return fc_read_file_into(sin, size, off, dst, cap, dml, used_bits, dr_size,
+                             secperlfau, nzones);
+}
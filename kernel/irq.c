@@ -35,6 +35,8 @@
  *   GIC initialisation here establishes the hardware baseline. Class drivers
  *   (HID, mass storage) will register handlers via irq_set_handler() once
  *   interrupt-driven transfers are implemented.
+ *   boot415: pci.c registers xhci_irq_handler on PCIE_MSI_IRQ_VECTOR; it
+ *   feeds the xHCI software event queues, with polling kept as fallback.
  */
 
 #include "kernel.h"
@@ -205,10 +207,7 @@ void irq_init(void) {
     debug_print("[IRQ] Interrupt system ready (GIC-400 @ 0xFF840000)\n");
     debug_print("[IRQ] NOTE: CPU IRQ mask still set (DAIF.I=1).\n");
     debug_print("[IRQ]       Call: asm volatile(\"msr daifclr, #2\") to unmask.\n");
-    debug_print("[IRQ] NOTE: xHCI currently uses polling — no GIC IRQ needed yet.\n");
-    debug_print("[IRQ]       When interrupt-driven USB is implemented, register\n");
-    debug_print("[IRQ]       irq_set_handler(SPI_PCIE_MSI, xhci_irq_handler, ctrl)\n");
-    debug_print("[IRQ]       then irq_unmask(SPI_PCIE_MSI) to activate.\n");
+    debug_print("[IRQ] NOTE: xhci_setup_msi() registers the xHCI MSI handler (INTID 180).\n");
 }
 
 /*
@@ -13,10 +13,12 @@
  *     IRQ controller
  *     Timer
  *     PCI bus scan
- *     VFS + FileCore
- *     Network stack
- *     WIMP (deferred – needs userspace)
+ *     USB, MMC
  *     Create init task → schedule()
+ *   init_process()
+ *     VFS + FileCore      ← parallel per-device probe tasks
+ *     Network stack, modules
+ *     WIMP
  */
 
 #include "kernel.h"
@@ -145,10 +147,9 @@ void kernel_main(uint64_t dtb_ptr)
      * irq_init() and the exception vectors are set (VBAR_EL1 = exception_vectors
      * in boot.S).  Clearing the I-bit allows the CPU to take IRQ exceptions.
      *
-     * NOTE: The xHCI driver operates in polling mode (evt_ring_poll), so no
-     * USB interrupts are expected yet.  This unmask is required for the
-     * ARM Generic Timer (PPI 30) which timer_init() will configure, and
-     * prepares the system for future interrupt-driven USB (PCIe MSI SPI 48).
+     * This unmask is required for the ARM Generic Timer (PPI 30) which
+     * timer_init() will configure, and for the xHCI MSI handler that
+     * pci_init() registers below (boot415: INTID 180, polled fallback).
      *
      * msr daifclr, #2  clears the I (IRQ) bit only; F (FIQ) and A (SError)
      * remain masked until explicitly needed.
@@ -187,7 +188,28 @@ void kernel_main(uint64_t dtb_ptr)
         con_printf("  MMC:    no card\n");
     }
 
-    /* [10/10] VFS + Network + Signals */
+    /* [10/10] runs in init_process(): the FileCore probe (boot395) puts
+     * each block device in its own task, which needs the scheduler live. */
+
+    /* Create the init task and start scheduling */
+    task_create("init", init_process, TASK_MAX_PRIORITY, (1ULL << 0));
+    schedule();
+
+    /* Should never reach here */
+    halt_system();
+    while (1) { asm volatile("wfi"); }
+}
+
+
+/* ------------------------------------------------------------------ */
+/* init_process - first user-space task                               */
+/* ------------------------------------------------------------------ */
+void init_process(void)
+{
+    /* [10/10] VFS + Network + Signals — in task context so the FileCore
+     * probe (boot395) can run one task per block device.  Tasks start with
+     * IRQs masked; unmask them as kernel_main had them for this step.   */
+    asm volatile("msr daifclr, #2" ::: "memory");
     debug_print("\n[10/10] VFS / Network / Signals...\n");
     vfs_init();
     filecore_init();
@@ -224,21 +246,6 @@ void kernel_main(uint64_t dtb_ptr)
     debug_print("  Boot complete - launching init\n");
     debug_print("========================================\n\n");
 
-    /* Create the init task and start scheduling */
-    task_create("init", init_process, TASK_MAX_PRIORITY, (1ULL << 0));
-    schedule();
-
-    /* Should never reach here */
-    halt_system();
-    while (1) { asm volatile("wfi"); }
-}
-
-
-/* ------------------------------------------------------------------ */
-/* init_process - first user-space task                               */
-/* ------------------------------------------------------------------ */
-void init_process(void)
-{
     debug_print("init: launching desktop...\n");
 
     /* Wimp is the primary interactive task — give it higher priority so
@@ -18,7 +18,7 @@ typedef int32_t pid_t;
 /* Constants */
 #define TASK_NAME_LEN       32
 #define MAX_CPUS            8
-#define MAX_FD              64
+#define MAX_FD              256     /* boot405: room for poll/epoll fan-in */
 #define PAGE_SIZE           4096
 #define PAGE_MASK           (~(PAGE_SIZE - 1))
 
@@ -95,10 +95,14 @@ struct task {
     int             child_count;
     spinlock_t      children_lock;
     int             exit_status;
-    void           *pgtable_l0;
+    void           *pgtable_l0;     /* boot401: TTBR0 table, NULL = kernel map */
+    struct vm_area *vmas;           /* boot401: user regions (demand paged)    */
+    uint32_t        asid;           /* boot401: (generation << 8) | ASID       */
     int             started;        /* 0 = never scheduled, 1 = has run */
     void           *files[MAX_FD];
     void           *cwd;
+    void           *fs_ctx;         /* boot408: active FileCore mount, NULL = boot disc */
+    uint64_t        wake_at;        /* boot420: CNTPCT at which a block ends, 0 = none */
     signal_state_t  signal_state;
 };
 
@@ -113,6 +117,23 @@ typedef struct {
     uint64_t    schedule_count;
 } cpu_sched_t;
 
+/* boot421: sleeping lock — a waiter blocks instead of spinning, so it
+ * may be held across blockdev_read() and other sleeping calls.  The
+ * owner may take it again (depth counts); not for IRQ context.        */
+typedef struct sleep_waiter {
+    struct sleep_waiter *next;
+    task_t              *task;
+} sleep_waiter_t;
+
+typedef struct {
+    spinlock_t      lock;
+    task_t         *owner;
+    int             depth;
+    sleep_waiter_t *waiters;
+} sleeplock_t;
+
+#define SLEEPLOCK_INIT { SPINLOCK_INIT, NULL, 0, NULL }
+
 extern cpu_sched_t cpu_sched[MAX_CPUS];   // SINGLE extern
 extern int vl805_init(void);		// second extern
 
@@ -127,6 +148,9 @@ void schedule(void);
 void yield(void);
 void task_block(task_state_t state);
 void task_wakeup(task_t *task);
+void task_wake_after(uint32_t ms);
+void sleeplock_lock(sleeplock_t *sl);
+void sleeplock_unlock(sleeplock_t *sl);
 void enqueue_task(cpu_sched_t *sched, task_t *task);
 
 /* Spinlock functions */
@@ -148,6 +172,7 @@ int mmu_map(task_t *task, uint64_t virt, uint64_t size, int prot, int guard);
 int mmu_duplicate_pagetable(task_t *parent, task_t *child);
 void mmu_free_usermemory(task_t *task);
 void mmu_free_pagetable(task_t *task);
+void mmu_switch_to(task_t *task);
 
 void timer_init(void);
 void timer_init_cpu(void);
@@ -12,6 +12,8 @@
 #include "net/net.h"
 /* boot376: PhoenixGENET DCI4 module — RX dispatch + DCI4 SWI interface */
 #include "drivers/net/genet_module.h"
+/* boot417: keyboard_event_t for the WIMP key drain (timestamped events) */
+#include "drivers/input/keyboard.h"
 
 /* Forward declare UART functions */
 extern void uart_putc(char c);
@@ -231,8 +233,10 @@ void net_init(void) {}
  *   • xhci_check_hotplug() — processes root-hub PSCE events
  *
  * HID is polled every iteration (~yield cadence ≈ 10 ms).
- * Hotplug is rate-limited to every 500 ms to avoid flooding the bus with
- * GET_PORT_STATUS control transfers.
+ * boot418: so is hotplug — hubs report changes on their status-change
+ * endpoints and the root hub with Port Status Change Events, so an idle
+ * check sends no GET_PORT_STATUS and a plug is seen within one pass.
+ * boot419: usb_enum_run() then steps the new device's port state machine.
  */
 
 /* ARM system counter: CNTPCT_EL0 / CNTFRQ_EL0, gives milliseconds */
@@ -253,6 +257,7 @@ void wimp_task(void)
     extern void hid_poll_mice(void)              __attribute__((weak));
     extern void hub_poll_hotplug(void)           __attribute__((weak));
     extern int  xhci_check_hotplug(void)         __attribute__((weak));
+    extern void usb_enum_run(void)               __attribute__((weak));
     extern void mouse_get_pos(int16_t *x,
                               int16_t *y)        __attribute__((weak));
     extern void cursor_update(int x, int y)      __attribute__((weak));
@@ -316,7 +321,7 @@ void wimp_task(void)
                 g_our_ip[0], g_our_ip[1], g_our_ip[2], g_our_ip[3]);
 
     /* keyboard_poll: drain the RISC OS keyboard event ring */
-    extern int keyboard_poll(void *ev) __attribute__((weak));
+    extern int keyboard_poll(keyboard_event_t *ev) __attribute__((weak));
 
     /* boot267: DWC2 OTG HID poll (mouse/keyboard via hub on USB-C port) */
     extern void dwc2_hid_poll(void) __attribute__((weak));
@@ -331,7 +336,6 @@ void wimp_task(void)
     uart_drain();
     debug_print("[WIMP] drain done, stalls=%u\n", (unsigned)g_uart_stalls);
 
-    uint32_t last_hotplug  = wimp_ms();
     uint32_t last_hid      = wimp_ms();
     uint32_t last_mouse    = wimp_ms(); /* boot285: 4 ms high-frequency mouse poll */
     uint32_t last_beat     = wimp_ms();
@@ -843,9 +847,10 @@ void wimp_task(void)
          * boot285: High-frequency mouse poll keeps the interrupt TRB
          * perpetually queued and catches each 7 ms mouse report within
          * one poll window.  Deltas stay small → smooth cursor tracking.
-         * hid_poll_mice() calls usb_interrupt_transfer(timeout=0) which
-         * does a single event-ring check and returns immediately (<5 µs)
-         * when no data is ready — WIMP is never stalled.                */
+         * boot417: HID endpoints are pre-posted and decoded as their
+         * completions are drained; hid_poll_mice() only drains the event
+         * ring for when no MSI did, and returns at once — WIMP is never
+         * stalled.                                                      */
         {
             uint32_t now_m = wimp_ms();
             if ((now_m - last_mouse) >= 4u) {
@@ -854,9 +859,11 @@ void wimp_task(void)
             }
         }
 
-        /* ── Keyboard input (xHCI path): ~60 Hz (16 ms), blocking 8 ms.
+        /* ── Keyboard input (xHCI path): ~60 Hz (16 ms).
          * boot285: hid_poll_all() now skips mice (handled above).
-         * boot275: raised from 10 Hz so brief keypresses are caught.   */
+         * boot275: raised from 10 Hz so brief keypresses are caught.
+         * boot417: non-blocking for pre-posted keyboards; the 8 ms wait
+         * is left only for endpoints that could not be pre-posted.     */
         uint32_t now_hid = wimp_ms();
         if ((now_hid - last_hid) >= 16u) {
             last_hid = now_hid;
@@ -872,13 +879,17 @@ void wimp_task(void)
             }
         }
 
-        /* ── Keyboard events: drain queue, break on ESC ───────────────── */
+        /* ── Keyboard events: drain queue, break on ESC ───────────────── *
+         * boot417: printable keys are echoed to the console here — the
+         * HID drivers may now post from interrupt context.               */
         if (keyboard_poll) {
-            uint8_t ev[4];
-            while (keyboard_poll(ev)) {
-                uint8_t kcode = ev[0];  /* HID key_code */
-                uint8_t kchar = ev[1];  /* ASCII key_char */
-                debug_print("[WIMP] key code=0x%02x char=0x%02x\n", kcode, kchar);
+            keyboard_event_t ev;
+            while (keyboard_poll(&ev)) {
+                uint8_t kcode = ev.key_code;  /* HID key_code */
+                uint8_t kchar = ev.key_char;  /* ASCII key_char */
+                debug_print("[WIMP] key code=0x%02x char=0x%02x lat=%ums\n",
+                            kcode, kchar, (unsigned)(wimp_ms() - ev.time_ms));
+                if (kchar >= 0x20) con_putc((char)kchar);
                 if (kchar == 0x1B) {    /* ESC key */
                     if (con_puts) con_puts("\n[Loop stopped by ESC]\n");
                     debug_print("[WIMP] ESC pressed — loop halted\n");
@@ -915,15 +926,10 @@ void wimp_task(void)
             }
         }
 
-        /* ── USB hotplug: 500 ms ───────────────────────────────────────── */
-        {
-            uint32_t now = wimp_ms();
-            if ((now - last_hotplug) >= 500u) {
-                last_hotplug = now;
-                if (hub_poll_hotplug)   hub_poll_hotplug();
-                if (xhci_check_hotplug) xhci_check_hotplug();
-            }
-        }
+        /* ── USB hotplug: event-driven, every pass (boot418) ───────────── */
+        if (hub_poll_hotplug)   hub_poll_hotplug();
+        if (xhci_check_hotplug) xhci_check_hotplug();
+        if (usb_enum_run)       usb_enum_run();     /* boot419: debounce/reset timers */
 
         yield();
     }
@@ -1,7 +1,8 @@
 /*
  * mmu.c – AArch64 MMU for RISC OS Phoenix
  *
- * Design: flat identity map, MMU + caches on, no per-task page tables yet.
+ * Design: flat identity map, MMU + caches on.  boot401: per-task TTBR0
+ *   tables for the user window (L1 slots 256–511), demand paged.
  *
  * ARM architecture note (DDI0487, Table D5-11):
  *   With 4 KB granule and T0SZ = 25 (39-bit VA), the translation walk
@@ -35,6 +36,8 @@
 #include "spinlock.h"
 #include "errno.h"
 #include "error.h"
+#include "mmu.h"
+#include "vfs.h"
 #include <stdint.h>
 
 /* ── Constants ───────────────────────────────────────────────────── */
@@ -377,14 +380,7 @@ void mmu_init(void)
     debug_print("[MMU] Enabled (identity map, caches on)\n");
 }
 
-/* ── Stubs — future per-task page table support ──────────────────── */
-
-void mmu_init_task(task_t *task)         { (void)task; }
-int  mmu_map(task_t *task, uint64_t virt, uint64_t size, int prot, int guard)
-     { (void)task; (void)virt; (void)size; (void)prot; (void)guard; return 0; }
-int  mmu_duplicate_pagetable(task_t *p, task_t *c) { (void)p; (void)c; return 0; }
-void mmu_map_kernel(uint64_t v, uint64_t s, int p)  { (void)v; (void)s; (void)p; }
-void page_ref_inc(uint64_t phys)                     { (void)phys; }
+/* ── TLB maintenance ─────────────────────────────────────────────── */
 
 void mmu_tlb_invalidate_all(void) {
     asm volatile("tlbi vmalle1is\ndsb ish\nisb" ::: "memory");
@@ -395,6 +391,630 @@ void mmu_tlb_invalidate_addr(uint64_t virt, uint64_t size) {
     asm volatile("tlbi vae1is, %0\ndsb ish\nisb" :: "r"(virt >> 12) : "memory");
 }
 
-/* boot352 stubs — full per-task page table teardown is future work */
-void mmu_free_pagetable(task_t *task)   { (void)task; }
-void mmu_free_usermemory(task_t *task)  { (void)task; }
+/* ── boot401: per-task user address spaces ───────────────────────── */
+
+/*
+ * User window: L1 slots 256–511 (USER_VA_BASE – USER_VA_END).  The kernel
+ * identity map only uses low slots (0–3, 24, 65, 124), so each task's
+ * top-level table starts as a copy of l1_table[0..255] — global kernel
+ * mappings, shared — and owns slots 256–511 (nG, tagged with its ASID).
+ * With T0SZ=25 the walk starts at L1, so task->pgtable_l0 holds that
+ * L1 table; tasks without one run on l1_table itself.
+ *
+ * Nothing is mapped eagerly.  mmu_map()/mmu_map_file() only record a
+ * vm_area; data_abort_handler() faults pages in on first touch:
+ *   file-backed  → frame from the file page cache (shared, RO/COW)
+ *   anonymous    → the shared zero frame (RO/COW) until first write
+ * fork (boot402) shares every present page COW instead of copying.
+ */
+
+#define USER_L1_FIRST   256
+#define PTE_ADDR_MASK   0x0000FFFFFFFFF000ULL
+#define PTE_AP_EL0_RW   (1ULL << 6)
+#define PTE_AP_EL0_RO   (3ULL << 6)
+#define PTE_NG          (1ULL << 11)
+#define PTE_SW_COW      (1ULL << 55)   /* software: writable after copy */
+
+/* ESR_EL1 decoding (DDI0487 D13.2.37) */
+#define ESR_EC(esr)     ((uint32_t)((esr) >> 26) & 0x3Fu)
+#define EC_IABT_LOW     0x20u
+#define EC_IABT_CUR     0x21u
+#define EC_DABT_LOW     0x24u
+#define EC_DABT_CUR     0x25u
+#define ESR_WNR         (1u << 6)
+#define ESR_FSC(esr)    ((uint32_t)(esr) & 0x3Fu)   /* DFSC / IFSC */
+#define FSC_TRANS(fsc)  (((fsc) & 0x3Cu) == 0x04u)  /* translation, L0–L3 */
+#define FSC_PERM(fsc)   (((fsc) & 0x3Cu) == 0x0Cu)  /* permission,  L0–L3 */
+#define SPSR_I          (1u << 7)
+
+/* ── Frame pool ──────────────────────────────────────────────────── */
+
+/*
+ * User pages and user page tables come from a page-aligned pool carved
+ * out of the kernel heap on first use.  Identity map: a frame's PA is
+ * also its kernel VA.  g_frame_ref counts mappings + page-cache holds.
+ */
+#define FRAME_POOL_PAGES  4096u            /* 16 MB */
+
+static uint8_t   *g_frame_base;
+static uint16_t   g_frame_ref[FRAME_POOL_PAGES];
+static uint16_t   g_frame_free[FRAME_POOL_PAGES];
+static uint32_t   g_frame_nfree;
+static uint64_t   g_zero_frame;
+static spinlock_t g_vm_lock = SPINLOCK_INIT;
+
+static int frame_index(uint64_t pa)
+{
+    uint64_t base = (uint64_t)(uintptr_t)g_frame_base;
+    if (!g_frame_base || pa < base ||
+        pa >= base + (uint64_t)FRAME_POOL_PAGES * PAGE_SIZE)
+        return -1;
+    return (int)((pa - base) >> PAGE_SHIFT);
+}
+
+static int frame_pool_init(void)
+{
+    if (g_frame_base) return 0;
+    uint8_t *raw = (uint8_t *)kmalloc((size_t)FRAME_POOL_PAGES * PAGE_SIZE
+                                      + PAGE_SIZE);
+    if (!raw) return -ENOMEM;
+    g_frame_base = (uint8_t *)(((uintptr_t)raw + PAGE_SIZE - 1)
+                               & ~(uintptr_t)(PAGE_SIZE - 1));
+    for (uint32_t i = 0; i < FRAME_POOL_PAGES; i++) {
+        g_frame_ref[i]  = 0;
+        g_frame_free[i] = (uint16_t)(FRAME_POOL_PAGES - 1u - i);
+    }
+    g_frame_nfree = FRAME_POOL_PAGES;
+
+    /* Zero frame: pinned by the pool's own reference, never freed */
+    uint32_t z = g_frame_free[--g_frame_nfree];
+    g_frame_ref[z] = 1;
+    g_zero_frame = (uint64_t)(uintptr_t)(g_frame_base + (size_t)z * PAGE_SIZE);
+    memset((void *)(uintptr_t)g_zero_frame, 0, PAGE_SIZE);
+    debug_print("[MMU] user frame pool: %u pages @ %p\n",
+                FRAME_POOL_PAGES, (void *)g_frame_base);
+    return 0;
+}
+
+/* Returns a zeroed frame with one reference, or 0 when the pool is empty */
+static uint64_t frame_alloc(void)
+{
+    unsigned long flags;
+    spin_lock_irqsave(&g_vm_lock, &flags);
+    if (frame_pool_init() != 0 || g_frame_nfree == 0) {
+        spin_unlock_irqrestore(&g_vm_lock, flags);
+        return 0;
+    }
+    uint32_t i = g_frame_free[--g_frame_nfree];
+    g_frame_ref[i] = 1;
+    spin_unlock_irqrestore(&g_vm_lock, flags);
+
+    uint64_t pa = (uint64_t)(uintptr_t)(g_frame_base + (size_t)i * PAGE_SIZE);
+    memset((void *)(uintptr_t)pa, 0, PAGE_SIZE);
+    return pa;
+}
+
+static void frame_put(uint64_t pa)
+{
+    int i = frame_index(pa);
+    if (i < 0) return;
+    unsigned long flags;
+    spin_lock_irqsave(&g_vm_lock, &flags);
+    if (g_frame_ref[i] && --g_frame_ref[i] == 0)
+        g_frame_free[g_frame_nfree++] = (uint16_t)i;
+    spin_unlock_irqrestore(&g_vm_lock, flags);
+}
+
+static uint32_t frame_refs(uint64_t pa)
+{
+    int i = frame_index(pa);
+    return i < 0 ? 0u : g_frame_ref[i];
+}
+
+void page_ref_inc(uint64_t phys)
+{
+    int i = frame_index(phys & PTE_ADDR_MASK);
+    if (i < 0) return;
+    unsigned long flags;
+    spin_lock_irqsave(&g_vm_lock, &flags);
+    g_frame_ref[i]++;
+    spin_unlock_irqrestore(&g_vm_lock, flags);
+}
+
+/* ── File page cache ─────────────────────────────────────────────── */
+
+/*
+ * Frames holding file pages, keyed by (mount, SIN, page offset) — SINs
+ * are only unique within one disc (boot408).  The cache owns
+ * one reference; mappings add theirs.  Text pages are therefore read once
+ * and shared by every task running the binary.  An entry whose frame has
+ * no other holder (ref == 1) may be evicted to make room.
+ *
+ * A miss reads from disc, and the block layer puts the faulting task to
+ * sleep until the read completes, so other tasks can fault on the same
+ * file meanwhile.  g_pcache_lock covers lookup and insert but not the
+ * read; the insert looks the key up again and a page someone else read
+ * first wins.
+ */
+#define PCACHE_SLOTS   256u
+#define PCACHE_PROBE   8u
+
+typedef struct {
+    const void *fs;
+    uint32_t    sin;
+    uint32_t    off;
+    uint64_t    frame;   /* 0 = empty slot */
+} pcache_ent_t;
+
+static pcache_ent_t g_pcache[PCACHE_SLOTS];
+static spinlock_t   g_pcache_lock = SPINLOCK_INIT;
+
+static uint32_t pcache_hash(const void *fs, uint32_t sin, uint32_t off)
+{
+    uint32_t f = (uint32_t)((uintptr_t)fs >> 4);
+    return ((sin ^ f) * 2654435761u ^ (off >> PAGE_SHIFT) * 40503u) % PCACHE_SLOTS;
+}
+
+/* Cached frame for the key with a reference for the caller, or 0.
+ * Caller holds g_pcache_lock.                                         */
+static uint64_t pcache_lookup(const void *fs, uint32_t sin, uint32_t off, uint32_t h)
+{
+    for (uint32_t p = 0; p < PCACHE_PROBE; p++) {
+        pcache_ent_t *e = &g_pcache[(h + p) % PCACHE_SLOTS];
+        if (e->frame && e->fs == fs && e->sin == sin && e->off == off) {
+            page_ref_inc(e->frame);
+            return e->frame;
+        }
+    }
+    return 0;
+}
+
+/* Returns the frame holding file page 'off' of (fs, sin, fsize) with one
+ * reference for the caller, reading it from disc on a miss; 0 on error.
+ * May sleep on a miss.                                                 */
+static uint64_t pcache_get(void *fs, uint32_t sin, uint32_t fsize, uint32_t off)
+{
+    uint32_t      h = pcache_hash(fs, sin, off);
+    unsigned long flags;
+
+    spin_lock_irqsave(&g_pcache_lock, &flags);
+    uint64_t hit = pcache_lookup(fs, sin, off, h);
+    spin_unlock_irqrestore(&g_pcache_lock, flags);
+    if (hit) return hit;
+
+    uint64_t frame = frame_alloc();
+    if (!frame) return 0;
+    void *prev = filecore_enter(fs);
+    int   rc   = filecore_read_file_range(sin, fsize, off,
+                                          (void *)(uintptr_t)frame, PAGE_SIZE);
+    filecore_enter(prev);
+    if (rc != 0) {
+        frame_put(frame);
+        return 0;
+    }
+    uint32_t valid = fsize - off;
+    if (valid < PAGE_SIZE)
+        memset((uint8_t *)(uintptr_t)frame + valid, 0, PAGE_SIZE - valid);
+
+    spin_lock_irqsave(&g_pcache_lock, &flags);
+    hit = pcache_lookup(fs, sin, off, h);          /* read while we slept? */
+    if (hit) {
+        spin_unlock_irqrestore(&g_pcache_lock, flags);
+        frame_put(frame);
+        return hit;
+    }
+    for (uint32_t p = 0; p < PCACHE_PROBE; p++) {
+        pcache_ent_t *e = &g_pcache[(h + p) % PCACHE_SLOTS];
+        if (e->frame && frame_refs(e->frame) > 1u) continue;
+        if (e->frame) frame_put(e->frame);          /* evict idle page */
+        e->fs    = fs;
+        e->sin   = sin;
+        e->off   = off;
+        e->frame = frame;
+        page_ref_inc(frame);                         /* cache's hold */
+        break;
+    }
+    spin_unlock_irqrestore(&g_pcache_lock, flags);
+    return frame;
+}
+
+/* ── Page tables ─────────────────────────────────────────────────── */
+
+static uint64_t *pt_next(uint64_t *table, uint32_t idx, int create)
+{
+    if (!(table[idx] & PTE_VALID)) {
+        if (!create) return NULL;
+        uint64_t t = frame_alloc();
+        if (!t) return NULL;
+        table[idx] = t | PTE_VALID | PTE_TABLE;
+    }
+    return (uint64_t *)(uintptr_t)(table[idx] & PTE_ADDR_MASK);
+}
+
+static uint64_t *vm_pte(task_t *task, uint64_t va, int create)
+{
+    uint64_t *l2 = pt_next((uint64_t *)task->pgtable_l0,
+                           (uint32_t)(va >> 30) & 0x1FF, create);
+    if (!l2) return NULL;
+    uint64_t *l3 = pt_next(l2, (uint32_t)(va >> 21) & 0x1FF, create);
+    if (!l3) return NULL;
+    return &l3[(va >> PAGE_SHIFT) & 0x1FF];
+}
+
+static uint64_t vm_pte_make(uint64_t pa, int prot, int cow)
+{
+    uint64_t pte = pa | PTE_VALID | PTE_PAGE | PTE_AF | PTE_SH_INNER |
+                   PTE_ATTRINDX(MAIR_NORMAL) | PTE_NG | PTE_PXN;
+    if (!(prot & PROT_EXEC)) pte |= PTE_UXN;
+    if ((prot & PROT_WRITE) && !cow) pte |= PTE_AP_EL0_RW;
+    else                             pte |= PTE_AP_EL0_RO;
+    if (cow) pte |= PTE_SW_COW;
+    return pte;
+}
+
+static void vm_tlb_flush_page(task_t *task, uint64_t va)
+{
+    uint64_t op = ((uint64_t)(task->asid & 0xFFu) << 48) | (va >> PAGE_SHIFT);
+    asm volatile("dsb ishst\ntlbi vae1is, %0\ndsb ish\nisb" :: "r"(op) : "memory");
+}
+
+static void vm_tlb_flush_asid(task_t *task)
+{
+    uint64_t op = (uint64_t)(task->asid & 0xFFu) << 48;
+    asm volatile("dsb ishst\ntlbi aside1is, %0\ndsb ish\nisb" :: "r"(op) : "memory");
+}
+
+/* Freshly written code: clean D to PoU and invalidate I for the frame */
+static void vm_sync_icache(uint64_t pa)
+{
+    for (uint64_t a = pa; a < pa + PAGE_SIZE; a += 64)
+        asm volatile("dc cvau, %0" :: "r"(a) : "memory");
+    asm volatile("dsb ish" ::: "memory");
+    for (uint64_t a = pa; a < pa + PAGE_SIZE; a += 64)
+        asm volatile("ic ivau, %0" :: "r"(a) : "memory");
+    asm volatile("dsb ish\nisb" ::: "memory");
+}
+
+/* ── ASIDs ───────────────────────────────────────────────────────── */
+
+/*
+ * 8-bit ASIDs with a generation counter: task->asid = (gen << 8) | asid.
+ * ASID 0 is the kernel's.  When the 255 per generation run out the whole
+ * TLB is flushed once and every task picks a fresh ASID on next switch.
+ */
+static uint32_t g_asid_gen  = 1;
+static uint32_t g_asid_next = 1;
+
+static void asid_ensure(task_t *task)
+{
+    if ((task->asid >> 8) == g_asid_gen) return;
+    if (g_asid_next > 0xFFu) {
+        g_asid_gen++;
+        g_asid_next = 1;
+        mmu_tlb_invalidate_all();
+    }
+    task->asid = (g_asid_gen << 8) | g_asid_next++;
+}
+
+void mmu_switch_to(task_t *task)
+{
+    uint64_t ttbr = (uint64_t)(uintptr_t)l1_table;
+    if (task && task->pgtable_l0) {
+        asid_ensure(task);
+        ttbr = (uint64_t)(uintptr_t)task->pgtable_l0 |
+               ((uint64_t)(task->asid & 0xFFu) << 48);
+    }
+    asm volatile("msr ttbr0_el1, %0\nisb" :: "r"(ttbr) : "memory");
+}
+
+/* ── Address space setup ─────────────────────────────────────────── */
+
+void mmu_init_task(task_t *task)
+{
+    /* Created on first mmu_map() — kernel tasks never need one */
+    task->pgtable_l0 = NULL;
+    task->vmas       = NULL;
+    task->asid       = 0;
+}
+
+static int vm_space_init(task_t *task)
+{
+    if (task->pgtable_l0) return 0;
+    uint64_t t = frame_alloc();
+    if (!t) return -ENOMEM;
+    uint64_t *top = (uint64_t *)(uintptr_t)t;
+    for (int i = 0; i < USER_L1_FIRST; i++)
+        top[i] = l1_table[i];
+    task->pgtable_l0 = top;
+    task->asid       = 0;
+    return 0;
+}
+
+static vm_area_t *vm_find(task_t *task, uint64_t va)
+{
+    for (vm_area_t *v = task->vmas; v; v = v->next)
+        if (va >= v->start && va < v->end) return v;
+    return NULL;
+}
+
+static int vm_add(task_t *task, uint64_t virt, uint64_t size, int prot, void *fs,
+                  uint32_t sin, uint32_t fsize, uint64_t foff, uint64_t fbytes)
+{
+    uint64_t start = virt & ~(uint64_t)(PAGE_SIZE - 1);
+    uint64_t end   = (virt + size + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1);
+    if (size == 0 || start < USER_VA_BASE || end > USER_VA_END || end <= start)
+        return -EINVAL;
+    for (vm_area_t *v = task->vmas; v; v = v->next)
+        if (start < v->end && v->start < end) return -EEXIST;
+    if (vm_space_init(task) != 0) return -ENOMEM;
+
+    vm_area_t *vma = (vm_area_t *)kmalloc(sizeof(vm_area_t));
+    if (!vma) return -ENOMEM;
+    vma->start  = start;
+    vma->end    = end;
+    vma->prot   = prot;
+    vma->fs     = fs;
+    vma->sin    = sin;
+    vma->fsize  = fsize;
+    vma->foff   = foff;
+    vma->fbytes = fbytes;
+    vma->next   = task->vmas;
+    task->vmas  = vma;
+    return 0;
+}
+
+/* Anonymous, demand-zero region.  guard != 0 leaves the lowest page
+ * unmapped so a stack overflow faults instead of running into the
+ * region below.                                                     */
+int mmu_map(task_t *task, uint64_t virt, uint64_t size, int prot, int guard)
+{
+    if (!task) return -EINVAL;
+    if (guard) {
+        if (size <= PAGE_SIZE) return -EINVAL;
+        virt += PAGE_SIZE;
+        size -= PAGE_SIZE;
+    }
+    return vm_add(task, virt, size, prot, NULL, 0, 0, 0, 0);
+}
+
+/* File-backed region: the first fbytes bytes come from file 'sin' on
+ * FileCore mount fs at byte offset foff (page-aligned), the rest of the
+ * region reads as zero.                                              */
+int mmu_map_file(task_t *task, uint64_t virt, uint64_t size, int prot, void *fs,
+                 uint32_t sin, uint32_t fsize, uint64_t foff, uint64_t fbytes)
+{
+    if (!task || !sin || (foff & (PAGE_SIZE - 1)) || fbytes > size)
+        return -EINVAL;
+    return vm_add(task, virt, size, prot, fs, sin, fsize, foff, fbytes);
+}
+
+/* ── Fault handling ──────────────────────────────────────────────── */
+
+/* Write to a present RO page marked COW: take it over if this mapping
+ * is the only holder, otherwise copy it.                             */
+static int vm_cow_break(task_t *task, uint64_t va, uint64_t *pte, int prot)
+{
+    uint64_t old = *pte & PTE_ADDR_MASK;
+    if (old != g_zero_frame && frame_refs(old) == 1u) {
+        *pte = vm_pte_make(old, prot, 0);
+    } else {
+        uint64_t frame = frame_alloc();
+        if (!frame) return -ENOMEM;
+        if (old != g_zero_frame)
+            memcpy((void *)(uintptr_t)frame, (void *)(uintptr_t)old, PAGE_SIZE);
+        if (prot & PROT_EXEC) vm_sync_icache(frame);
+        *pte = vm_pte_make(frame, prot, 0);
+        frame_put(old);
+    }
+    vm_tlb_flush_page(task, va);
+    return 0;
+}
+
+static int vm_fault_in(task_t *task, vm_area_t *vma, uint64_t va, int is_write)
+{
+    uint64_t  rel   = va - vma->start;
+    uint64_t  frame = 0;
+    uint64_t *pte;
+    int       cow   = 0;
+
+    if (vma->sin && rel < vma->fbytes) {
+        uint64_t have   = vma->fbytes - rel;
+        uint64_t cached = pcache_get(vma->fs, vma->sin, vma->fsize,
+                                     (uint32_t)(vma->foff + rel));
+        if (!cached) return -EIO;
+        /* The read can sleep: look the PTE up again in task's table */
+        pte = vm_pte(task, va, 1);
+        if (!pte) { frame_put(cached); return -ENOMEM; }
+        if (*pte & PTE_VALID) {                     /* resolved while we slept */
+            frame_put(cached);
+            return 0;
+        }
+        if (have >= PAGE_SIZE && !is_write) {
+            frame = cached;                          /* share */
+            cow   = (vma->prot & PROT_WRITE) != 0;
+        } else {
+            frame = frame_alloc();                   /* private copy */
+            if (!frame) { frame_put(cached); return -ENOMEM; }
+            memcpy((void *)(uintptr_t)frame, (void *)(uintptr_t)cached,
+                   have >= PAGE_SIZE ? PAGE_SIZE : (size_t)have);
+            frame_put(cached);
+        }
+    } else {
+        pte = vm_pte(task, va, 1);
+        if (!pte) return -ENOMEM;
+        if (is_write) {
+            frame = frame_alloc();
+            if (!frame) return -ENOMEM;
+        } else {
+            frame = g_zero_frame;
+            page_ref_inc(frame);
+            cow = (vma->prot & PROT_WRITE) != 0;
+        }
+    }
+
+    if ((vma->prot & PROT_EXEC) && frame != g_zero_frame)
+        vm_sync_icache(frame);
+    *pte = vm_pte_make(frame, vma->prot, cow);
+    asm volatile("dsb ishst\nisb" ::: "memory");
+    return 0;
+}
+
+/*
+ * Called from the synchronous exception vector for every sync exception.
+ * Returns 0 when the fault was a resolvable user-window page fault (the
+ * vector then returns to the faulting instruction), negative errno when
+ * it is not (the vector falls through to the crash dump).
+ *
+ * Only translation faults (page not present, or a stale TLB entry for one
+ * that now is) and permission faults on a COW page are resolved; access
+ * flag, alignment and every other fault status go to the crash dump.
+ *
+ * Faulting in a file page can sleep in the block layer.  The vector keeps
+ * ELR/SPSR and SP_EL0 in its frame, so IRQs are unmasked for the duration
+ * when the interrupted code had them unmasked, and left as they were
+ * otherwise.
+ */
+int data_abort_handler(uint64_t esr, uint64_t far)
+{
+    uint32_t ec = ESR_EC(esr);
+    int is_data = (ec == EC_DABT_LOW || ec == EC_DABT_CUR);
+    int is_inst = (ec == EC_IABT_LOW || ec == EC_IABT_CUR);
+    if (!is_data && !is_inst) return -EFAULT;
+
+    uint32_t fsc = ESR_FSC(esr);
+    if (!FSC_TRANS(fsc) && !FSC_PERM(fsc)) return -EFAULT;
+
+    task_t *task = current_task;
+    if (!task || !task->pgtable_l0 || far < USER_VA_BASE || far >= USER_VA_END)
+        return -EFAULT;
+
+    vm_area_t *vma = vm_find(task, far);
+    if (!vma) return -EFAULT;
+
+    int is_write = is_data && (esr & ESR_WNR);
+    if (is_write && !(vma->prot & PROT_WRITE)) return -EFAULT;
+    if (is_inst  && !(vma->prot & PROT_EXEC))  return -EFAULT;
+
+    uint64_t  va  = far & ~(uint64_t)(PAGE_SIZE - 1);
+    uint64_t *pte = vm_pte(task, va, 1);
+    if (!pte) return -ENOMEM;
+
+    if (FSC_PERM(fsc)) {
+        if (is_write && (*pte & PTE_VALID) && (*pte & PTE_SW_COW))
+            return vm_cow_break(task, va, pte, vma->prot);
+        return -EFAULT;
+    }
+
+    if (*pte & PTE_VALID) {         /* already resolved: stale TLB entry */
+        vm_tlb_flush_page(task, va);
+        return 0;
+    }
+
+    uint64_t spsr, daif;
+    asm volatile("mrs %0, spsr_el1\nmrs %1, daif" : "=r"(spsr), "=r"(daif));
+    if (!(spsr & SPSR_I)) asm volatile("msr daifclr, #2" ::: "memory");
+    int rc = vm_fault_in(task, vma, va, is_write);
+    asm volatile("msr daif, %0" :: "r"(daif) : "memory");
+    return rc;
+}
+
+/* ── Teardown ────────────────────────────────────────────────────── */
+
+/*
+ * boot402: copy-on-write fork.  The child gets its own table and a copy
+ * of the parent's regions; every present user page is shared, with
+ * writable ones downgraded to RO + PTE_SW_COW in both tables and the
+ * frame's reference count raised.  The first write on either side takes
+ * vm_cow_break(): the last holder keeps the frame, others copy.  Cost is
+ * the page-table walk only — no user data is copied at fork time.
+ */
+int mmu_duplicate_pagetable(task_t *p, task_t *c)
+{
+    c->pgtable_l0 = NULL;
+    c->vmas       = NULL;
+    c->asid       = 0;
+    if (!p || !p->pgtable_l0) return 0;
+    if (vm_space_init(c) != 0) return -ENOMEM;
+
+    vm_area_t **tail = &c->vmas;
+    for (vm_area_t *v = p->vmas; v; v = v->next) {
+        vm_area_t *n = (vm_area_t *)kmalloc(sizeof(vm_area_t));
+        if (!n) goto fail;
+        *n = *v;
+        n->next = NULL;
+        *tail = n;
+        tail  = &n->next;
+    }
+
+    uint64_t *ptop = (uint64_t *)p->pgtable_l0;
+    uint64_t *ctop = (uint64_t *)c->pgtable_l0;
+    int downgraded = 0;
+    for (int i1 = USER_L1_FIRST; i1 < PT_ENTRIES; i1++) {
+        uint64_t *pl2 = pt_next(ptop, (uint32_t)i1, 0);
+        if (!pl2) continue;
+        uint64_t *cl2 = pt_next(ctop, (uint32_t)i1, 1);
+        if (!cl2) goto fail;
+        for (int i2 = 0; i2 < PT_ENTRIES; i2++) {
+            uint64_t *pl3 = pt_next(pl2, (uint32_t)i2, 0);
+            if (!pl3) continue;
+            uint64_t *cl3 = pt_next(cl2, (uint32_t)i2, 1);
+            if (!cl3) goto fail;
+            for (int i3 = 0; i3 < PT_ENTRIES; i3++) {
+                uint64_t pte = pl3[i3];
+                if (!(pte & PTE_VALID)) continue;
+                if ((pte & (3ULL << 6)) == PTE_AP_EL0_RW) {
+                    pte = (pte & ~(3ULL << 6)) | PTE_AP_EL0_RO | PTE_SW_COW;
+                    pl3[i3] = pte;
+                    downgraded = 1;
+                }
+                page_ref_inc(pte & PTE_ADDR_MASK);
+                cl3[i3] = pte;
+            }
+        }
+    }
+    /* Parent may hold RW translations for pages now COW — its ASID only */
+    if (downgraded && (p->asid >> 8) == g_asid_gen) vm_tlb_flush_asid(p);
+    return 0;
+
+fail:
+    mmu_free_pagetable(c);
+    return -ENOMEM;
+}
+
+void mmu_map_kernel(uint64_t v, uint64_t s, int p)  { (void)v; (void)s; (void)p; }
+
+/* Drop every user mapping and region; the top-level table is kept */
+void mmu_free_usermemory(task_t *task)
+{
+    if (!task || !task->pgtable_l0) return;
+    uint64_t *top = (uint64_t *)task->pgtable_l0;
+
+    for (int i1 = USER_L1_FIRST; i1 < PT_ENTRIES; i1++) {
+        uint64_t *l2 = pt_next(top, (uint32_t)i1, 0);
+        if (!l2) continue;
+        for (int i2 = 0; i2 < PT_ENTRIES; i2++) {
+            uint64_t *l3 = pt_next(l2, (uint32_t)i2, 0);
+            if (!l3) continue;
+            for (int i3 = 0; i3 < PT_ENTRIES; i3++)
+                if (l3[i3] & PTE_VALID) frame_put(l3[i3] & PTE_ADDR_MASK);
+            frame_put((uint64_t)(uintptr_t)l3);
+        }
+        frame_put((uint64_t)(uintptr_t)l2);
+        top[i1] = 0;
+    }
+    if ((task->asid >> 8) == g_asid_gen) vm_tlb_flush_asid(task);
+
+    vm_area_t *v = task->vmas;
+    while (v) { vm_area_t *n = v->next; kfree(v); v = n; }
+    task->vmas = NULL;
+}
+
+void mmu_free_pagetable(task_t *task)
+{
+    if (!task || !task->pgtable_l0) return;
+    mmu_free_usermemory(task);
+    if (task == current_task) mmu_switch_to(NULL);
+    frame_put((uint64_t)(uintptr_t)task->pgtable_l0);
+    task->pgtable_l0 = NULL;
+    task->asid       = 0;
+}
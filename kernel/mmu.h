@@ -3,16 +3,38 @@
 
 #include <stdint.h>
 
+/* boot401: user window — L1 slots 256–511 of each task's TTBR0 table */
+#define USER_VA_BASE    0x0000004000000000ULL
+#define USER_VA_END     0x0000008000000000ULL
+#define USER_STACK_TOP  (USER_VA_END - 0x1000ULL)
+
+/* boot401: a demand-paged user region.  sin == 0 → anonymous (zero fill);
+ * otherwise the first fbytes bytes come from the file at offset foff.    */
+typedef struct vm_area {
+    struct vm_area *next;
+    uint64_t        start;      /* page-aligned, inclusive */
+    uint64_t        end;        /* page-aligned, exclusive */
+    int             prot;       /* PROT_READ | PROT_WRITE | PROT_EXEC */
+    void           *fs;         /* FileCore mount of the file (boot408) */
+    uint32_t        sin;        /* FileCore SIN of backing file       */
+    uint32_t        fsize;      /* backing file size                  */
+    uint64_t        foff;       /* file offset of 'start'             */
+    uint64_t        fbytes;     /* file-backed bytes from 'start'     */
+} vm_area_t;
+
 void mmu_init(void);
 void mmu_init_task(task_t *task);
 int mmu_map(task_t *task, uint64_t virt, uint64_t size, int prot, int guard);
+int mmu_map_file(task_t *task, uint64_t virt, uint64_t size, int prot, void *fs,
+                 uint32_t sin, uint32_t fsize, uint64_t foff, uint64_t fbytes);
 int mmu_duplicate_pagetable(task_t *parent, task_t *child);
 void mmu_free_usermemory(task_t *task);
 void mmu_free_pagetable(task_t *task);
-void data_abort_handler(uint64_t esr, uint64_t far);
+void mmu_switch_to(task_t *task);
+int data_abort_handler(uint64_t esr, uint64_t far);
 void page_ref_inc(uint64_t phys);
 void mmu_tlb_invalidate_all(void);
 void mmu_tlb_invalidate_addr(uint64_t virt, uint64_t size);
 void mmu_map_kernel(uint64_t virt, uint64_t size, int prot);
 
-#endif
\ No newline at end of file
+#endif
@@ -18,6 +18,7 @@
 #include "module.h"
 #include "vfs.h"
 #include "errno.h"
+#include "mmu.h"
 
 /* kernel.h (included via module.h) already declares:
  *   kmalloc, kfree, memset, strncmp, strlen, memcpy
@@ -41,8 +42,107 @@ static void mod_hex32(uint32_t v) {
 
 static risc_os_module_t *g_module_list = NULL;
 
+/* ── SWI dispatch table (boot398) ────────────────────────────────────────────
+ * A RISC OS SWI chunk is 64 SWIs: chunk = swi & 0xFFFFC0 with the X bit
+ * (0x20000) ignored, so XOS_Foo reaches the same module as OS_Foo.  The
+ * chunk index is 18 bits wide; its low 14 bits — SWIs below 0x100000,
+ * which is every module SWI base in use — split 7/7 into a two-level
+ * direct table: 128 top pointers, second-level pages of 128 slots
+ * allocated on first use.  A lookup is two loads — no list walk, no
+ * logging on the hot path.  Chunks above the table (OS-specific SWI
+ * numbers, bits 20-23) fall back to the g_module_list walk and keep no
+ * call counters.  Maintained by module_register() / module_unregister().  */
+#define SWI_X_BIT          0x00020000u
+#define SWI_CHUNK_MASK     0x00FFFFC0u
+#define SWI_OFFSET_MASK    0x0000003Fu
+#define SWI_CHUNK_IDX(n)   ((((n) & ~SWI_X_BIT) & SWI_CHUNK_MASK) >> 6)  /* 18 bits */
+#define SWI_L1_SHIFT       7
+#define SWI_L1_SIZE        128u
+#define SWI_L2_SIZE        128u
+
+typedef struct swi_slot {
+    risc_os_module_t *mod;
+    uint32_t          calls[64];          /* per-SWI call counters        */
+} swi_slot_t;
+
+static swi_slot_t *g_swi_table[SWI_L1_SIZE];
+static uint32_t    g_swi_unhandled = 0u;
+
+/* Does swi_number's chunk have a g_swi_table slot? */
+static inline int swi_in_table(uint32_t swi_number)
+{
+    return (SWI_CHUNK_IDX(swi_number) >> SWI_L1_SHIFT) < SWI_L1_SIZE;
+}
+
+/* NULL when the chunk is outside the table (see swi_in_table) or has no
+ * page yet and create == 0, or the page allocation failed.              */
+static swi_slot_t *swi_slot_lookup(uint32_t swi_number, int create)
+{
+    uint32_t idx = SWI_CHUNK_IDX(swi_number);
+    if ((idx >> SWI_L1_SHIFT) >= SWI_L1_SIZE) return NULL;
+    swi_slot_t *page = g_swi_table[idx >> SWI_L1_SHIFT];
+    if (!page) {
+        if (!create) return NULL;
+        page = (swi_slot_t *)kcalloc(SWI_L2_SIZE, sizeof(swi_slot_t));
+        if (!page) return NULL;
+        g_swi_table[idx >> SWI_L1_SHIFT] = page;
+    }
+    return &page[idx & (SWI_L2_SIZE - 1u)];
+}
+
+/* Slow path: newest registered module claiming swi_number's chunk.      */
+static risc_os_module_t *swi_chunk_owner(uint32_t swi_number)
+{
+    uint32_t idx = SWI_CHUNK_IDX(swi_number);
+    for (risc_os_module_t *m = g_module_list; m; m = m->next)
+        if (m->swi_base && SWI_CHUNK_IDX(m->swi_base) == idx) return m;
+    return NULL;
+}
+
+/* Install mod as the owner of its SWI chunk (most recent registration wins,
+ * matching the old newest-first list walk).                                */
+static void swi_table_add(risc_os_module_t *mod)
+{
+    if (!mod->swi_base) return;                 /* no SWIs */
+    if (!swi_in_table(mod->swi_base)) return;   /* reached by list walk */
+    swi_slot_t *slot = swi_slot_lookup(mod->swi_base, 1);
+    if (!slot) { uart_puts("[SWI] table alloc failed\n"); return; }
+    if (slot->mod && slot->mod != mod) {
+        uart_puts("[SWI] chunk "); mod_hex32(mod->swi_base & SWI_CHUNK_MASK);
+        uart_puts(" "); uart_puts(slot->mod->name);
+        uart_puts(" → "); uart_puts(mod->name); uart_puts("\n");
+    }
+    slot->mod = mod;
+    memset(slot->calls, 0, sizeof(slot->calls));
+}
+
+/* Drop mod from the table; hand the chunk to any older module claiming it. */
+static void swi_table_remove(risc_os_module_t *mod)
+{
+    if (!mod->swi_base) return;
+    swi_slot_t *slot = swi_slot_lookup(mod->swi_base, 0);
+    if (!slot || slot->mod != mod) return;
+    slot->mod = NULL;
+    uint32_t idx = SWI_CHUNK_IDX(mod->swi_base);
+    for (risc_os_module_t *m = g_module_list; m; m = m->next) {
+        if (m != mod && m->swi_base && SWI_CHUNK_IDX(m->swi_base) == idx) {
+            slot->mod = m;
+            break;
+        }
+    }
+    memset(slot->calls, 0, sizeof(slot->calls));
+}
+
 #define DEFAULT_WORKSPACE_SIZE  4096
 
+/* boot400: workspace sizing.  An RO64 module with module_flags bit 2 set
+ * records its zero-init size at +0x34; that (rounded to 16, clamped) is
+ * the workspace it gets.  Modules without the field keep the 4 KB default. */
+#define MODULE_FLAG_ZI_SIZE     (1u << 2)
+#define MODULE_WS_MIN           64u
+#define MODULE_WS_MAX           (1u * 1024u * 1024u)
+#define MODULE_MAX_SIZE         (4u * 1024u * 1024u)
+
 /* ── module_call_with_r12 ────────────────────────────────────────────────────
  * Call an AArch64 module entry point with x12 = workspace pointer.
  * Only works with AArch64-native modules (module_flags bit 24 set).
@@ -69,6 +169,227 @@ static int module_call_with_r12(void *code_entry, void *workspace,
     return (int)(uint32_t)result;
 }
 
+static uint32_t mod_rd32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* ── module_workspace_size ───────────────────────────────────────────────────
+ * boot400: workspace bytes for a module image ('avail' bytes readable).    */
+static uint32_t module_workspace_size(const uint8_t *img, uint32_t avail)
+{
+    const risc_os_module_header_t *hdr = (const risc_os_module_header_t *)img;
+    if (!(hdr->init_entry & MODULE_INIT_64BIT) ||
+        !(hdr->module_flags & MODULE_FLAG_ZI_SIZE) || avail < 0x38u)
+        return DEFAULT_WORKSPACE_SIZE;
+
+    uint32_t zi = mod_rd32(img + 0x34u);
+    if (zi < MODULE_WS_MIN) zi = MODULE_WS_MIN;
+    if (zi > MODULE_WS_MAX) zi = MODULE_WS_MAX;
+    return (zi + 15u) & ~15u;
+}
+
+/* ── module_alloc_workspace ──────────────────────────────────────────────── */
+static int module_alloc_workspace(risc_os_module_t *mod, const uint8_t *img,
+                                   uint32_t avail)
+{
+    uint32_t ws_size = module_workspace_size(img, avail);
+    mod->workspace = kmalloc(ws_size);
+    if (!mod->workspace) return -ENOMEM;
+    memset(mod->workspace, 0, ws_size);
+    mod->workspace_size = ws_size;
+    return 0;
+}
+
+/* ── Page-aligned module images ──────────────────────────────────────────────
+ * boot400: kmalloc only guarantees 16-byte alignment.  Over-allocate by a
+ * page and keep the raw pointer in the word just below the image so the
+ * image starts on a page boundary and shares no cache lines.            */
+static uint8_t *module_image_alloc(uint32_t len)
+{
+    uint8_t *raw = (uint8_t *)kmalloc(len + PAGE_SIZE + sizeof(void *));
+    if (!raw) return NULL;
+    uintptr_t img = ((uintptr_t)raw + sizeof(void *) + PAGE_SIZE - 1u)
+                  & ~(uintptr_t)(PAGE_SIZE - 1u);
+    ((void **)img)[-1] = raw;
+    return (uint8_t *)img;
+}
+
+static void module_image_free(uint8_t *img)
+{
+    if (img) kfree(((void **)img)[-1]);
+}
+
+/* ── module_image_sync ───────────────────────────────────────────────────────
+ * boot400: make freshly loaded code visible to instruction fetch (clean D
+ * to PoU, invalidate I).  The image stays RWX: the kernel identity map is
+ * 1 GB blocks and mmu_map_kernel() is still a stub, so there are no
+ * per-page attributes to give module text yet.                            */
+static void module_image_sync(uint8_t *img, uint32_t len, int exec)
+{
+    uintptr_t start = (uintptr_t)img & ~(uintptr_t)63u;
+    uintptr_t end   = (uintptr_t)img + len;
+    if (exec) {
+        for (uintptr_t a = start; a < end; a += 64u)
+            asm volatile("dc cvau, %0" :: "r"(a) : "memory");
+        asm volatile("dsb ish" ::: "memory");
+        for (uintptr_t a = start; a < end; a += 64u)
+            asm volatile("ic ivau, %0" :: "r"(a) : "memory");
+        asm volatile("dsb ish\nisb" ::: "memory");
+    }
+}
+
+/* ── mod_copy_title ──────────────────────────────────────────────────────────
+ * Resolve module title and copy to heap.
+ * title_ptr (+0x10) is an offset into the module body.  Use it if it
+ * points to printable ASCII within the first 'avail' bytes, otherwise use
+ * suggested_name.
+ *
+ * boot391: always kmalloc a copy so mod->name is safe for the module's
+ * lifetime.  suggested_name is usually a pointer into a stack-allocated
+ * vfs_dirent_t.name[] field.  Without a copy, all stub modules loaded
+ * from the same directory share the same stack address, and by the time
+ * module_dump_list() runs that memory has been overwritten (boot390
+ * showed "Templates" for ABIMod, Colours, IconBorderFob).
+ * boot397: bounded by 'avail' so lazy registration can use header bytes. */
+static const char *mod_copy_title(const uint8_t *img, uint32_t avail,
+                                   const char *suggested_name)
+{
+    const risc_os_module_header_t *hdr = (const risc_os_module_header_t *)img;
+    const char *src = suggested_name ? suggested_name : "Unnamed";
+    uint32_t    max = 255u;
+    if (hdr->title_ptr >= 0x34u && hdr->title_ptr < avail) {
+        uint8_t c = img[hdr->title_ptr];
+        if (c >= 0x20u && c <= 0x7Eu) {
+            src = (const char *)(img + hdr->title_ptr);
+            if (avail - hdr->title_ptr < max) max = avail - hdr->title_ptr;
+        }
+    }
+    uint32_t n = 0u;
+    while (n < max && src[n] >= 0x20 && src[n] <= 0x7E) n++;
+    char *copy = (char *)kmalloc(n + 1u);
+    if (!copy) return "Unnamed";
+    for (uint32_t i = 0u; i < n; i++) copy[i] = src[i];
+    copy[n] = '\0';
+    return copy;
+}
+
+/* ── module_parse_service_table ──────────────────────────────────────────────
+ * boot397: RISC OS 3.5+ service table (PRM 5a-11).  A module that has one
+ * starts its service entry with a marker instruction — MOV R0,R0 for ARM32,
+ * NOP for AArch64 — and the word immediately before the entry holds the
+ * table's offset:
+ *     +0  flags (0)   +4  handler offset   +8..  reason codes, 0-terminated
+ * Only the first 'avail' bytes are inspected.  No table, or a table that
+ * runs past 'avail', leaves svc_count = -1 (offer every reason).          */
+#define SVC_MARK_ARM32    0xE1A00000u     /* MOV R0,R0 */
+#define SVC_MARK_AARCH64  0xD503201Fu     /* NOP       */
+#define SVC_TABLE_MAX     64u
+
+static void module_parse_service_table(risc_os_module_t *mod,
+                                        const uint8_t *img, uint32_t avail)
+{
+    mod->svc_reasons = NULL;
+    mod->svc_count   = -1;
+
+    uint32_t se = ((const risc_os_module_header_t *)img)->service_entry;
+    if (se < 0x38u || (se & 3u) || se + 4u > avail) return;
+
+    uint32_t mark = mod_rd32(img + se);
+    if (mark != SVC_MARK_ARM32 && mark != SVC_MARK_AARCH64) return;
+
+    uint32_t tab = mod_rd32(img + se - 4u);
+    if (tab < 0x34u || (tab & 3u) || tab + 8u > avail) return;
+    if (mod_rd32(img + tab) != 0u) return;          /* unknown flags */
+
+    uint32_t n = 0u;
+    for (;;) {
+        uint32_t off = tab + 8u + n * 4u;
+        if (off + 4u > avail || n >= SVC_TABLE_MAX) return;
+        if (mod_rd32(img + off) == 0u) break;
+        n++;
+    }
+
+    if (n > 0u) {
+        mod->svc_reasons = (uint32_t *)kmalloc(n * sizeof(uint32_t));
+        if (!mod->svc_reasons) return;
+        for (uint32_t i = 0u; i < n; i++)
+            mod->svc_reasons[i] = mod_rd32(img + tab + 8u + i * 4u);
+    }
+    mod->svc_count = (int)n;
+}
+
+/* ── Service subscriber index (boot399) ──────────────────────────────────────
+ * module_broadcast_service used to offer every service call to every
+ * initialised module.  Modules with a service table are now indexed per
+ * reason (hash of 64 chains); modules with a handler but no table go on
+ * g_svc_all and still see every reason.  A broadcast walks the reason's
+ * chain merged with g_svc_all in registration order (newest first), so
+ * claim order is exactly what the old list walk produced.                  */
+#define SVC_HASH_SIZE  64u
+
+typedef struct svc_sub {
+    struct svc_sub    *next;
+    risc_os_module_t  *mod;
+    uint32_t           reason;
+} svc_sub_t;
+
+static svc_sub_t *g_svc_index[SVC_HASH_SIZE];
+static svc_sub_t *g_svc_all     = NULL;
+static uint32_t   g_mod_reg_seq = 0u;
+
+static int module_has_service(const risc_os_module_t *mod)
+{
+    return mod->service_fn || (mod->header && mod->header->service_entry);
+}
+
+/* Insert keeping each chain sorted newest (highest reg_seq) first. */
+static void svc_chain_insert(svc_sub_t **head, svc_sub_t *sub)
+{
+    while (*head && (*head)->mod->reg_seq > sub->mod->reg_seq)
+        head = &(*head)->next;
+    sub->next = *head;
+    *head = sub;
+}
+
+static void svc_index_add(risc_os_module_t *mod)
+{
+    if (!module_has_service(mod)) return;
+    if (mod->svc_count < 0) {
+        svc_sub_t *sub = (svc_sub_t *)kmalloc(sizeof(svc_sub_t));
+        if (!sub) return;
+        sub->mod = mod; sub->reason = 0u;
+        svc_chain_insert(&g_svc_all, sub);
+        return;
+    }
+    for (int i = 0; i < mod->svc_count; i++) {
+        svc_sub_t *sub = (svc_sub_t *)kmalloc(sizeof(svc_sub_t));
+        if (!sub) return;
+        sub->mod = mod; sub->reason = mod->svc_reasons[i];
+        svc_chain_insert(&g_svc_index[sub->reason % SVC_HASH_SIZE], sub);
+    }
+}
+
+static void svc_chain_remove(svc_sub_t **head, risc_os_module_t *mod)
+{
+    while (*head) {
+        if ((*head)->mod == mod) {
+            svc_sub_t *dead = *head;
+            *head = dead->next;
+            kfree(dead);
+        } else {
+            head = &(*head)->next;
+        }
+    }
+}
+
+static void svc_index_remove(risc_os_module_t *mod)
+{
+    svc_chain_remove(&g_svc_all, mod);
+    for (int i = 0; i < mod->svc_count; i++)
+        svc_chain_remove(&g_svc_index[mod->svc_reasons[i] % SVC_HASH_SIZE], mod);
+}
+
 /* ── module_register_native ──────────────────────────────────────────────── */
 /* boot379: extended with swi_base + swi_fn so native C modules can handle
  * SWIs without needing a binary module header.  Pass 0/NULL for modules that
@@ -80,14 +401,16 @@ int module_register_native(const char *name,
                             uint32_t swi_base,
                             int (*swi_fn)(uint32_t swi_offset, uint32_t *regs))
 {
-    (void)final; (void)service;
+    (void)final;
 
     risc_os_module_t *mod = (risc_os_module_t *)kmalloc(sizeof(risc_os_module_t));
     if (!mod) return -ENOMEM;
     memset(mod, 0, sizeof(*mod));
-    mod->name     = name;
-    mod->swi_base = swi_base;
-    mod->swi_fn   = swi_fn;
+    mod->name       = name;
+    mod->swi_base   = swi_base;
+    mod->swi_fn     = swi_fn;
+    mod->service_fn = service;       /* boot399 */
+    mod->svc_count  = -1;            /* no table: offered every reason */
 
     int rc = module_register(mod);
     if (rc == 0 && init) {
@@ -103,10 +426,30 @@ int module_register(risc_os_module_t *mod)
     if (!mod || !mod->name) return -EINVAL;
     mod->next     = g_module_list;
     g_module_list = mod;
+    mod->reg_seq  = ++g_mod_reg_seq;
+    swi_table_add(mod);
+    svc_index_add(mod);
     uart_puts("[Module] Registered: "); uart_puts(mod->name); uart_puts("\n");
     return 0;
 }
 
+/* ── module_unregister ───────────────────────────────────────────────────────
+ * boot398: unlink a module and release its SWI chunk.  Finalisation and
+ * freeing the image/workspace are the caller's business (RMKill path).     */
+int module_unregister(risc_os_module_t *mod)
+{
+    if (!mod) return -EINVAL;
+    risc_os_module_t **pp = &g_module_list;
+    while (*pp && *pp != mod) pp = &(*pp)->next;
+    if (!*pp) return -ENOENT;
+    *pp = mod->next;
+    mod->next = NULL;
+    swi_table_remove(mod);
+    svc_index_remove(mod);
+    uart_puts("[Module] Removed: "); uart_puts(mod->name); uart_puts("\n");
+    return 0;
+}
+
 /* ── module_load_from_memory ─────────────────────────────────────────────── */
 int module_load_from_memory(void *buffer, uint32_t size, const char *suggested_name)
 {
@@ -130,30 +473,9 @@ int module_load_from_memory(void *buffer, uint32_t size, const char *suggested_n
     /* Actual offset strips bits 30-31 */
     uint32_t init_off = raw_init & ~(3u << 30);
 
-    /* Resolve module title and copy to heap.
-     * title_ptr (+0x10) is an offset into the module body.  Use it if it
-     * points to printable ASCII in range, otherwise use suggested_name.
-     *
-     * boot391: always kmalloc a copy so mod->name is safe for the module's
-     * lifetime.  suggested_name is usually a pointer into a stack-allocated
-     * vfs_dirent_t.name[] field.  Without a copy, all stub modules loaded
-     * from the same directory share the same stack address, and by the time
-     * module_dump_list() runs that memory has been overwritten (boot390
-     * showed "Templates" for ABIMod, Colours, IconBorderFob).               */
-    const char *mod_name;
-    {
-        const char *src = suggested_name ? suggested_name : "Unnamed";
-        if (hdr->title_ptr >= 0x34u && hdr->title_ptr < size) {
-            uint8_t c = ((uint8_t *)buffer)[hdr->title_ptr];
-            if (c >= 0x20u && c <= 0x7Eu)
-                src = (const char *)((uint8_t *)buffer + hdr->title_ptr);
-        }
-        uint32_t n = 0u;
-        while (src[n] && n < 255u) n++;
-        char *copy = (char *)kmalloc(n + 1u);
-        if (copy) { for (uint32_t i = 0u; i <= n; i++) copy[i] = src[i]; }
-        mod_name = copy ? copy : "Unnamed";
-    }
+    /* boot397: title resolution moved to mod_copy_title() */
+    const char *mod_name = mod_copy_title((const uint8_t *)buffer, size,
+                                           suggested_name);
 
     uart_puts("[Module] '"); uart_puts(mod_name);
     uart_puts("' "); mod_dec(size); uart_puts(" bytes  ");
@@ -173,10 +495,9 @@ int module_load_from_memory(void *buffer, uint32_t size, const char *suggested_n
         if (!mod) return -ENOMEM;
         memset(mod, 0, sizeof(*mod));
 
-        mod->workspace = kmalloc(DEFAULT_WORKSPACE_SIZE);
-        if (!mod->workspace) { kfree(mod); return -ENOMEM; }
-        memset(mod->workspace, 0, DEFAULT_WORKSPACE_SIZE);
-        mod->workspace_size = DEFAULT_WORKSPACE_SIZE;
+        if (module_alloc_workspace(mod, (const uint8_t *)buffer, size) != 0) {
+            kfree(mod); return -ENOMEM;
+        }
 
         mod->base_addr   = buffer;
         mod->size        = size;
@@ -184,6 +505,7 @@ int module_load_from_memory(void *buffer, uint32_t size, const char *suggested_n
         mod->name        = mod_name;
         mod->swi_base    = hdr->swi_base;
         mod->initialised = 0;    /* not called — AArch32 EL0 pending */
+        module_parse_service_table(mod, (const uint8_t *)buffer, size);
 
         int rc = module_register(mod);
         if (rc != 0) { kfree(mod->workspace); kfree(mod); return rc; }
@@ -200,16 +522,16 @@ int module_load_from_memory(void *buffer, uint32_t size, const char *suggested_n
     if (!mod) return -ENOMEM;
     memset(mod, 0, sizeof(*mod));
 
-    mod->workspace = kmalloc(DEFAULT_WORKSPACE_SIZE);
-    if (!mod->workspace) { kfree(mod); return -ENOMEM; }
-    memset(mod->workspace, 0, DEFAULT_WORKSPACE_SIZE);
-    mod->workspace_size = DEFAULT_WORKSPACE_SIZE;
+    if (module_alloc_workspace(mod, (const uint8_t *)buffer, size) != 0) {
+        kfree(mod); return -ENOMEM;
+    }
 
     mod->base_addr = buffer;
     mod->size      = size;
     mod->header    = hdr;
     mod->name      = mod_name;
     mod->swi_base  = hdr->swi_base;
+    module_parse_service_table(mod, (const uint8_t *)buffer, size);
 
     int rc = module_register(mod);
     if (rc != 0) { kfree(mod->workspace); kfree(mod); return rc; }
@@ -229,7 +551,118 @@ int module_load_from_memory(void *buffer, uint32_t size, const char *suggested_n
     return 0;
 }
 
-/* ── module_load_from_file ───────────────────────────────────────────────── */
+/* ── module_register_lazy ────────────────────────────────────────────────────
+ * boot397: register a disc module from its leading bytes only.  Title, SWI
+ * chunk and service table come from 'head' (copied — caller keeps it); the
+ * full image is fetched on first use by module_materialise().  Boot I/O and
+ * heap then scale with the modules actually called, not the ones on disc.
+ * AArch64 init is deferred to the same point.                              */
+int module_register_lazy(const void *head, uint32_t head_len, uint32_t size,
+                          const char *suggested_name, module_fetch_fn fetch,
+                          void *mount, uint32_t cookie)
+{
+    if (!head || !fetch || head_len < 0x34u || size < head_len ||
+        size > MODULE_MAX_SIZE) {
+        uart_puts("[Module] Buffer too small\n");
+        return -ENOEXEC;
+    }
+
+    risc_os_module_t *mod = (risc_os_module_t *)kmalloc(sizeof(risc_os_module_t));
+    if (!mod) return -ENOMEM;
+    memset(mod, 0, sizeof(*mod));
+
+    uint8_t *hcopy = (uint8_t *)kmalloc(head_len);
+    if (!hcopy) { kfree(mod); return -ENOMEM; }
+    memcpy(hcopy, head, head_len);
+
+    risc_os_module_header_t *hdr = (risc_os_module_header_t *)hcopy;
+    mod->header       = hdr;
+    mod->base_addr    = NULL;
+    mod->size         = size;
+    mod->name         = mod_copy_title(hcopy, head_len, suggested_name);
+    mod->swi_base     = hdr->swi_base;
+    mod->lazy         = 1;
+    mod->fetch        = fetch;
+    mod->fetch_mount  = mount;
+    mod->fetch_cookie = cookie;
+    module_parse_service_table(mod, hcopy, head_len);
+
+    uart_puts("[Module] '"); uart_puts(mod->name);
+    uart_puts("' lazy "); mod_dec(size); uart_puts(" bytes  ");
+    uart_puts((hdr->init_entry & MODULE_INIT_64BIT) ? "AArch64" : "ARM32");
+    uart_puts("  swi="); mod_hex32(hdr->swi_base);
+    uart_puts("  svc=");
+    if (mod->svc_count < 0) uart_puts("all"); else mod_dec((uint32_t)mod->svc_count);
+    uart_puts("\n");
+
+    int rc = module_register(mod);
+    if (rc != 0) { kfree(mod->svc_reasons); kfree(hcopy); kfree(mod); }
+    return rc;
+}
+
+/* ── module_materialise ──────────────────────────────────────────────────────
+ * boot397: read a lazy module's body, allocate its workspace and (AArch64
+ * only) run Init — everything module_load_from_memory does at load time.
+ * Returns 0 when the module is resident, negative errno otherwise (the
+ * module stays lazy and the next use retries).                             */
+static int module_materialise(risc_os_module_t *mod)
+{
+    if (!mod->lazy) return 0;
+
+    /* Same right-sized, page-aligned image RMLoad builds (boot400) */
+    uint32_t cap  = (mod->size + PAGE_SIZE - 1u) & ~(uint32_t)(PAGE_SIZE - 1u);
+    uint8_t *body = module_image_alloc(cap);
+    if (!body) return -ENOMEM;
+    if (mod->fetch(mod->fetch_mount, mod->fetch_cookie, mod->size, body, cap) != 0) {
+        uart_puts("[Module] lazy fetch failed: "); uart_puts(mod->name);
+        uart_puts("\n");
+        module_image_free(body);
+        return -EIO;
+    }
+    memset(body + mod->size, 0, cap - mod->size);
+
+    /* The disc copy must still be the module we registered */
+    if (memcmp(body, mod->header, sizeof(risc_os_module_header_t)) != 0) {
+        uart_puts("[Module] lazy header changed on disc: "); uart_puts(mod->name);
+        uart_puts("\n");
+        module_image_free(body);
+        return -ENOEXEC;
+    }
+
+    if (module_alloc_workspace(mod, body, mod->size) != 0) {
+        module_image_free(body);
+        return -ENOMEM;
+    }
+    module_image_sync(body, cap,
+                         (mod->header->init_entry & MODULE_INIT_64BIT) != 0);
+
+    kfree(mod->header);
+    mod->header         = (risc_os_module_header_t *)body;
+    mod->base_addr      = body;
+    mod->lazy           = 0;
+
+    uart_puts("[Module] '"); uart_puts(mod->name);
+    uart_puts("' loaded on first use ("); mod_dec(mod->size);
+    uart_puts(" bytes)\n");
+
+    uint32_t raw_init = mod->header->init_entry;
+    uint32_t init_off = raw_init & ~(3u << 30);
+    if ((raw_init & MODULE_INIT_64BIT) && init_off && init_off < mod->size) {
+        int init_rc = module_call_with_r12(body + init_off, mod->workspace, 0, 0);
+        mod->initialised = (init_rc == 0);
+        if (!mod->initialised) {
+            uart_puts("[Module] Init() failed rc="); mod_dec((uint32_t)init_rc);
+            uart_puts("\n");
+        }
+    }
+    return 0;
+}
+
+/* ── module_load_from_file ────────────────────────────────────────────────────
+ * boot400: the image is sized from the file's dirent (i_size), page-aligned,
+ * and filled by one FileCore extent read straight into place — no 2 MB
+ * scratch buffer, no second copy.  Non-FileCore files fall back to vfs_read
+ * into the same right-sized image.                                         */
 int module_load_from_file(const char *path)
 {
     uart_puts("[Module] RMLOAD: "); uart_puts(path); uart_puts("\n");
@@ -237,75 +670,216 @@ int module_load_from_file(const char *path)
     file_t *f = vfs_open(path, 0);
     if (!f) return -ENOENT;
 
-#define MAX_MODULE_SIZE (2u * 1024u * 1024u)
-    uint8_t *buf = (uint8_t *)kmalloc(MAX_MODULE_SIZE);
-    if (!buf) { vfs_close(f); return -ENOMEM; }
+    uint32_t size = f->f_inode ? (uint32_t)f->f_inode->i_size : 0u;
+    if (size == 0u)             { vfs_close(f); return -ENOENT; }
+    if (size < 0x34u || size > MODULE_MAX_SIZE) {
+        uart_puts("[Module] bad module size "); mod_dec(size); uart_puts("\n");
+        vfs_close(f);
+        return -ENOEXEC;
+    }
 
-    ssize_t total = 0, bytes;
-    while (total < (ssize_t)MAX_MODULE_SIZE) {
-        bytes = vfs_read(f, buf + total, MAX_MODULE_SIZE - (uint32_t)total);
-        if (bytes <= 0) break;
-        total += bytes;
+    uint32_t cap = (size + PAGE_SIZE - 1u) & ~(uint32_t)(PAGE_SIZE - 1u);
+    uint8_t *img = module_image_alloc(cap);
+    if (!img) { vfs_close(f); return -ENOMEM; }
+
+    void *prev = filecore_enter(f->f_inode->private);   /* file's disc */
+    int   rd   = filecore_read_file_into(f->f_inode->sin, size, img, cap);
+    filecore_enter(prev);
+    if (rd != 0) {
+        ssize_t total = 0, bytes;
+        while (total < (ssize_t)size) {
+            bytes = vfs_read(f, img + total, size - (uint32_t)total);
+            if (bytes <= 0) break;
+            total += bytes;
+        }
+        if (total != (ssize_t)size) {
+            vfs_close(f); module_image_free(img); return -EIO;
+        }
     }
     vfs_close(f);
+    memset(img + size, 0, cap - size);
 
-    if (total == 0) { kfree(buf); return -ENOENT; }
+    module_image_sync(img, cap,
+        (((risc_os_module_header_t *)img)->init_entry & MODULE_INIT_64BIT) != 0);
 
-    int rc = module_load_from_memory(buf, (uint32_t)total, NULL);
-    if (rc != 0) kfree(buf);
+    int rc = module_load_from_memory(img, size, NULL);
+    if (rc != 0) module_image_free(img);
     return rc;
 }
 
 /* ── swi_dispatch ────────────────────────────────────────────────────────── */
 /* boot379: check swi_fn first for native C modules; then fall through to
- * binary module header path for AArch64 binary modules.                     */
+ * binary module header path for AArch64 binary modules.
+ * boot398: O(1) chunk lookup via g_swi_table; per-SWI call counters; no
+ * uart output on the dispatch path (only for unhandled SWIs).               */
 int swi_dispatch(uint32_t swi_number, uint32_t *regs)
 {
-    uint32_t chunk  = swi_number & 0xFFFFFF00u;
-    uint32_t offset = swi_number & 0x000000FFu;
-    risc_os_module_t *mod = g_module_list;
-    while (mod) {
-        if (mod->swi_base == chunk) {
-            /* Native C module path (boot379) */
-            if (mod->swi_fn) {
-                uart_puts("[SWI] "); uart_puts(mod->name);
-                uart_puts(" "); mod_hex32(swi_number); uart_puts("\n");
-                return mod->swi_fn(offset, regs);
-            }
-            /* Binary AArch64 module path */
-            if (mod->header && mod->header->swi_handler) {
-                uart_puts("[SWI] "); uart_puts(mod->name);
-                uart_puts(" "); mod_hex32(swi_number); uart_puts("\n");
-                void *handler = (uint8_t *)mod->base_addr + mod->header->swi_handler;
-                return module_call_with_r12(handler, mod->workspace,
-                                             (uint64_t)swi_number,
-                                             (uint64_t)(uintptr_t)regs);
-            }
+    swi_slot_t *slot = swi_slot_lookup(swi_number, 0);
+    risc_os_module_t *mod = slot ? slot->mod
+                          : (swi_in_table(swi_number) ? NULL
+                                                      : swi_chunk_owner(swi_number));
+    uint32_t offset = swi_number & SWI_OFFSET_MASK;
+
+    if (mod) {
+        /* boot397: first SWI into a lazy module's chunk loads it */
+        if (mod->lazy && module_materialise(mod) != 0) return -ENOSYS;
+        if (slot) slot->calls[offset]++;
+
+        /* Native C module path (boot379) */
+        if (mod->swi_fn)
+            return mod->swi_fn(offset, regs);
+
+        /* Binary AArch64 module path */
+        if (mod->header && mod->header->swi_handler) {
+            void *handler = (uint8_t *)mod->base_addr + mod->header->swi_handler;
+            return module_call_with_r12(handler, mod->workspace,
+                                         (uint64_t)swi_number,
+                                         (uint64_t)(uintptr_t)regs);
         }
-        mod = mod->next;
     }
+    g_swi_unhandled++;
     uart_puts("[SWI] Unhandled: "); mod_hex32(swi_number); uart_puts("\n");
     return -ENOSYS;
 }
 
-/* ── module_broadcast_service ────────────────────────────────────────────── */
-int module_broadcast_service(uint32_t service_reason, uint32_t *regs)
+/* ── swi_dump_stats ──────────────────────────────────────────────────────── */
+/* boot398: print non-zero per-SWI call counters, grouped by chunk.          */
+void swi_dump_stats(void)
 {
-    uart_puts("[Service] "); mod_hex32(service_reason); uart_puts("\n");
-    risc_os_module_t *mod = g_module_list;
-    while (mod) {
-        if (mod->header && mod->header->service_entry && mod->initialised) {
-            void *fn = (uint8_t *)mod->base_addr + mod->header->service_entry;
-            int rc = module_call_with_r12(fn, mod->workspace,
-                                           (uint64_t)service_reason,
-                                           (uint64_t)(uintptr_t)regs);
-            if (rc == 0) {
-                uart_puts("[Service] Claimed by "); uart_puts(mod->name);
-                uart_puts("\n");
-                return 0;
+    uart_puts("[SWI] Call counts:\n");
+    for (uint32_t hi = 0u; hi < SWI_L1_SIZE; hi++) {
+        swi_slot_t *page = g_swi_table[hi];
+        if (!page) continue;
+        for (uint32_t lo = 0u; lo < SWI_L2_SIZE; lo++) {
+            swi_slot_t *slot = &page[lo];
+            if (!slot->mod) continue;
+            uint32_t base = ((hi << SWI_L1_SHIFT) | lo) << 6;
+            for (uint32_t o = 0u; o < 64u; o++) {
+                if (!slot->calls[o]) continue;
+                uart_puts("  "); mod_hex32(base + o);
+                uart_puts(" "); uart_puts(slot->mod->name);
+                uart_puts(" +"); mod_dec(o);
+                uart_puts(": "); mod_dec(slot->calls[o]); uart_puts("\n");
             }
         }
-        mod = mod->next;
+    }
+    uart_puts("  unhandled: "); mod_dec(g_swi_unhandled); uart_puts("\n");
+}
+
+/* ── swi_bench ───────────────────────────────────────────────────────────────
+ * boot398: dispatch cost.  Times 'iters' rounds of (a) the chunk table
+ * lookup and (b) the pre-boot398 g_module_list walk for every owned chunk,
+ * then (c) full swi_dispatch() calls into a no-op native handler installed
+ * on a free chunk for the duration.  The target is < 100 ns per SWI.     */
+#define SWI_BENCH_CHUNK   0x000DFFC0u       /* user SWI area, normally free */
+#ifndef SWI_BENCH_ITERS
+#define SWI_BENCH_ITERS   0u                /* module_init_all: 0 = off     */
+#endif
+
+static int swi_bench_fn(uint32_t swi_offset, uint32_t *regs)
+{
+    (void)swi_offset; (void)regs;
+    return 0;
+}
+
+static uint64_t swi_now_ns(void)
+{
+    uint64_t cnt, freq;
+    __asm__ volatile("mrs %0, cntpct_el0" : "=r"(cnt));
+    __asm__ volatile("mrs %0, cntfrq_el0" : "=r"(freq));
+    return freq ? (cnt * 1000ULL) / (freq / 1000000ULL) : 0;
+}
+
+void swi_bench(uint32_t iters)
+{
+    if (!iters) return;
+
+    uint32_t nlookup = 0u, hits = 0u;
+    uint64_t t0 = swi_now_ns();
+    for (uint32_t it = 0u; it < iters; it++)
+        for (risc_os_module_t *m = g_module_list; m; m = m->next) {
+            if (!m->swi_base || !swi_in_table(m->swi_base)) continue;
+            swi_slot_t *slot = swi_slot_lookup(m->swi_base, 0);
+            if (slot && slot->mod) hits++;
+            nlookup++;
+        }
+    uint64_t t_table = swi_now_ns() - t0;
+
+    t0 = swi_now_ns();
+    for (uint32_t it = 0u; it < iters; it++)
+        for (risc_os_module_t *m = g_module_list; m; m = m->next) {
+            if (!m->swi_base || !swi_in_table(m->swi_base)) continue;
+            if (swi_chunk_owner(m->swi_base)) hits++;
+        }
+    uint64_t t_walk = swi_now_ns() - t0;
+
+    static risc_os_module_t bench_mod;
+    uint64_t t_disp = 0;
+    swi_slot_t *slot = swi_slot_lookup(SWI_BENCH_CHUNK, 1);
+    if (slot && !slot->mod) {
+        memset(&bench_mod, 0, sizeof(bench_mod));
+        bench_mod.name     = "SWIBench";
+        bench_mod.swi_base = SWI_BENCH_CHUNK;
+        bench_mod.swi_fn   = swi_bench_fn;
+        swi_table_add(&bench_mod);
+        uint32_t regs[10] = { 0 };
+        t0 = swi_now_ns();
+        for (uint32_t it = 0u; it < iters; it++)
+            (void)swi_dispatch(SWI_BENCH_CHUNK | (it & SWI_OFFSET_MASK), regs);
+        t_disp = swi_now_ns() - t0;
+        swi_table_remove(&bench_mod);
+    }
+
+    uart_puts("[SWI] bench: chunks="); mod_dec(iters ? nlookup / iters : 0u);
+    uart_puts(" iters="); mod_dec(iters);
+    uart_puts("  table "); mod_dec((uint32_t)(nlookup ? t_table / nlookup : 0));
+    uart_puts(" ns/lookup  list walk ");
+    mod_dec((uint32_t)(nlookup ? t_walk / nlookup : 0));
+    uart_puts(" ns/lookup  dispatch ");
+    if (t_disp) mod_dec((uint32_t)(t_disp / iters)); else uart_puts("-");
+    uart_puts(" ns/SWI\n");
+}
+
+/* ── module_broadcast_service ────────────────────────────────────────────── */
+/* boot399: only subscribers of service_reason are called — the reason's
+ * index chain merged (newest first) with the no-table modules.  No uart
+ * output per call.  rc == 0 from a handler claims the service.             */
+static int module_offer_service(risc_os_module_t *mod, uint32_t service_reason,
+                                 uint32_t *regs)
+{
+    /* boot397: a lazy AArch64 module is loaded by the first service call
+     * its service table subscribes to (any call if it has no table).       */
+    if (mod->lazy) {
+        if (!(mod->header->init_entry & MODULE_INIT_64BIT)) return -ENOENT;
+        if (module_materialise(mod) != 0) return -ENOENT;
+    }
+    if (!mod->initialised) return -ENOENT;
+
+    if (mod->service_fn)
+        return mod->service_fn(service_reason, regs) == 0 ? 0 : -ENOENT;
+
+    void *fn = (uint8_t *)mod->base_addr + mod->header->service_entry;
+    int rc = module_call_with_r12(fn, mod->workspace,
+                                   (uint64_t)service_reason,
+                                   (uint64_t)(uintptr_t)regs);
+    return rc == 0 ? 0 : -ENOENT;
+}
+
+int module_broadcast_service(uint32_t service_reason, uint32_t *regs)
+{
+    svc_sub_t *r = g_svc_index[service_reason % SVC_HASH_SIZE];
+    svc_sub_t *a = g_svc_all;
+
+    for (;;) {
+        while (r && r->reason != service_reason) r = r->next;
+        if (!r && !a) break;
+
+        svc_sub_t *pick;
+        if (!a || (r && r->mod->reg_seq > a->mod->reg_seq)) { pick = r; r = r->next; }
+        else                                                 { pick = a; a = a->next; }
+
+        if (module_offer_service(pick->mod, service_reason, regs) == 0)
+            return 0;
     }
     return -ENOENT;
 }
@@ -319,6 +893,7 @@ void module_dump_list(void)
     while (mod) {
         uart_puts("  "); uart_puts(mod->name);
         if (mod->initialised) uart_puts(" [OK]");
+        if (mod->lazy)        uart_puts(" [lazy]");
         uart_puts("\n");
         mod = mod->next;
         count++;
@@ -459,4 +1034,7 @@ void module_init_all(void)
      * VFS is fully wired to the FileCore read path (future work).          */
     uart_puts("[Module] Module system ready\n");
     module_dump_list();
+
+    /* boot398: SWI dispatch timing — build with -DSWI_BENCH_ITERS=N      */
+    if (SWI_BENCH_ITERS) swi_bench(SWI_BENCH_ITERS);
 }
@@ -15,6 +15,10 @@
  *
  * Author: Phoenix OS project
  * Updated: boot388, May 2026
+ * Updated: boot397, Oct 2026 – lazy disc modules + service table
+ * Updated: boot398, Oct 2026 – O(1) SWI chunk table + per-SWI counters
+ * Updated: boot399, Oct 2026 – per-reason service subscriber index
+ * Updated: boot400, Oct 2026 – right-sized page-aligned RMLoad, header-sized workspace
  */
 
 #ifndef MODULE_H
@@ -45,6 +49,16 @@ typedef struct __attribute__((packed)) risc_os_module_header {
 #define MODULE_INIT_64BIT       (1u << 30)   /* bit 30 of +0x04 init_entry  */
 #define MODULE_FLAG_AARCH64     (1u << 24)   /* old Phoenix guess — kept for compat */
 
+/* boot397: body fetcher for lazily registered modules — reads the whole
+ * module image (cookie names it on 'mount') into dst, cap bytes, which the
+ * module loader page-aligns.  Returns 0 on success, -1 on failure.       */
+typedef int (*module_fetch_fn)(void *mount, uint32_t cookie, uint32_t size,
+                               void *dst, uint32_t cap);
+
+/* Bytes of a disc module read up front for lazy registration: header,
+ * title and (normally) the service table all sit in the first sector.    */
+#define MODULE_LAZY_HEAD_BYTES  512u
+
 /* ── Module instance ─────────────────────────────────────────────────────── */
 typedef struct risc_os_module {
     struct risc_os_module      *next;
@@ -59,6 +73,23 @@ typedef struct risc_os_module {
     void                       *private_data;
     /* boot379: native C SWI handler — set for C modules, NULL for binary ones */
     int                       (*swi_fn)(uint32_t swi_offset, uint32_t *regs);
+    /* boot397: lazy disc modules.  While lazy=1 only the leading header
+     * bytes are resident (header → kmalloc'd copy, base_addr NULL); the
+     * body is read through fetch(fetch_mount, fetch_cookie, ...) on the
+     * first SWI into swi_base or the first service call the module
+     * subscribes to — from the disc it was registered from.              */
+    int                         lazy;
+    module_fetch_fn             fetch;
+    void                       *fetch_mount;
+    uint32_t                    fetch_cookie;
+    /* boot397: service table (RISC OS 3.5+).  svc_count < 0 = no table
+     * found — the module is offered every service reason.                */
+    uint32_t                   *svc_reasons;
+    int                         svc_count;
+    /* boot399: native C service handler + registration order (the service
+     * index offers a call newest-first, as the old list walk did).       */
+    int                       (*service_fn)(uint32_t reason, uint32_t *regs);
+    uint32_t                    reg_seq;
 } risc_os_module_t;
 
 /* ── Public API ──────────────────────────────────────────────────────────── */
@@ -71,12 +102,18 @@ int  module_register_native(const char *name,
                              uint32_t swi_base,
                              int (*swi_fn)(uint32_t swi_offset, uint32_t *regs));
 int  module_register(risc_os_module_t *mod);
+int  module_unregister(risc_os_module_t *mod);
 int  module_load_from_file(const char *path);
 int  module_load_from_memory(void *buffer, uint32_t size,
                               const char *suggested_name);
+int  module_register_lazy(const void *head, uint32_t head_len, uint32_t size,
+                          const char *suggested_name, module_fetch_fn fetch,
+                          void *mount, uint32_t cookie);
 void module_init_all(void);
 void module_dump_list(void);   /* renamed from module_list to avoid collision */
 int  swi_dispatch(uint32_t swi_number, uint32_t *regs);
+void swi_dump_stats(void);
+void swi_bench(uint32_t iters);
 int  module_broadcast_service(uint32_t service_reason, uint32_t *regs);
 
 #endif /* MODULE_H */
@@ -665,26 +665,27 @@ void xhci_setup_msi(void) {
         uart_puts("[MSI] WARNING: MSI cap not found in VL805 cap list\n");
 
     /*
-     * boot86 conclusion: xHCI uses pure polling — GIC registration skipped.
+     * boot86 conclusion: xHCI used pure polling — GIC registration skipped.
      *
      * After 86 boots the VL805 MSI → GIC → CPU interrupt path on BCM2711
-     * is confirmed unreliable:
+     * was unreliable:
      *   - PCIE_INTR2_STATUS bit 8 sets reliably (RC receives TLP from MCU).
      *   - PCIE_MSI_INTR0_MASK_CLR written correctly (boot86: MASK_STATUS=0).
      *   - GIC ISENABLER, ITARGETSR, ICFGR all verified correct.
      *   - msi_fire_count stays 0x00000000 across every boot.
-     *
-     * Root cause is likely in the BCM2711 MSI_INTR0→GIC fan-out path or a
-     * firmware-owned GIC configuration that blocks SPI 148.  The UBUS DMA
-     * write path is also broken (event ring canary always unchanged).
-     *
-     * Decision: use tight CNTPCT_EL0-based polling in xhci_wait_event.
-     *   Interrupt transfers for USB 2 HID devices (bInterval polling) are
-     *   handled at the USB transfer layer, not via PCIe MSI.
      * The MSI BAR/DATA_CONFIG/VL805 capability setup above is kept because
      * the VL805 MCU requires MSI to be enabled in config space to operate.
+     *
+     * boot415: register the handler again.  It now drains the event ring
+     * into per-slot software queues (usb_xhci.c) and only does so once
+     * xhci_init() has finished, so the boot67 garbage-TRB problem cannot
+     * recur.  Waiters still drain the ring themselves, so a board where
+     * the MSI never arrives keeps working exactly as in polling mode.
      */
-    uart_puts("[MSI] xHCI polling mode — GIC registration skipped (boot86)\n");
+    extern void xhci_irq_handler(int vector, void *data);
+    irq_set_handler(PCIE_MSI_IRQ_VECTOR, xhci_irq_handler, NULL);
+    irq_unmask(PCIE_MSI_IRQ_VECTOR);
+    uart_puts("[MSI] xHCI handler registered on INTID 180 (polled fallback kept)\n");
 }
 
 /* ── BCM2711 outbound ATU setup ─────────────────────────────────── */
@@ -1,76 +1,337 @@
 /*
- * pipe.c – UNIX pipes for RISC OS Phoenix (Simplified stub version)
+ * pipe.c – UNIX pipes for RISC OS Phoenix
  * Author: R Andrews – 26 Nov 2025
  * Updated: 15 Feb 2026 - Simplified for compilation
+ * Updated: boot404, Oct 2026 – lock-free SPSC ring + splice()
+ * Updated: boot405, Oct 2026 – poll wait queue for poll/select/epoll
+ *
+ * One writer end, one reader end, PIPE_BUFFER_SIZE ring.  write_pos is
+ * only stored by the producer and read_pos only by the consumer; both
+ * increase monotonically (free-running, masked on access) and are
+ * published with release/acquire ordering, so the data path takes no
+ * lock.  The spinlock only guards waiter hand-off, and a waiter is woken
+ * only on the empty→non-empty / full→non-full transitions.
  */
 
 #include "kernel.h"
 #include "vfs.h"
+#include "pipe.h"
 #include "spinlock.h"
 #include "errno.h"
 #include <stdint.h>
 
-#define PIPE_BUFFER_SIZE 4096
-
-/* Poll constants */
-#define POLLIN  0x0001
-#define POLLOUT 0x0004
+#define PIPE_BUFFER_SIZE 4096            /* power of two */
+#define PIPE_MASK        (PIPE_BUFFER_SIZE - 1)
 
 typedef struct pipe_buffer {
     uint8_t data[PIPE_BUFFER_SIZE];
-    size_t read_pos;
-    size_t write_pos;
-    size_t count;
-    spinlock_t lock;
+    size_t read_pos;                     /* consumer-owned, free-running */
+    size_t write_pos;                    /* producer-owned, free-running */
+    spinlock_t lock;                     /* waiter hand-off only */
     task_t *read_waiter;
     task_t *write_waiter;
+    wait_queue_t poll_wq;                /* poll/select/epoll, both ends */
+    int readers;                         /* open read ends  (0 or 1) */
+    int writers;                         /* open write ends (0 or 1) */
 } pipe_buffer_t;
 
-/* Stub: Create pipe – returns two file descriptors */
-int pipe(int pipefd[2]) {
-    // TODO: Implement full pipe support
-    // For now, just return an error
-    errno = ENOSYS;
-    (void)pipefd;
-    return -1;
+/* ── Ring helpers ────────────────────────────────────────────────────────── */
+
+static inline size_t pipe_used(pipe_buffer_t *p)
+{
+    return __atomic_load_n(&p->write_pos, __ATOMIC_ACQUIRE) -
+           __atomic_load_n(&p->read_pos,  __ATOMIC_ACQUIRE);
 }
 
-/* Stub: Read from pipe */
+/* Contiguous readable bytes at the consumer index */
+static inline size_t pipe_read_span(pipe_buffer_t *p, uint8_t **at)
+{
+    size_t used = pipe_used(p);
+    size_t idx  = p->read_pos & PIPE_MASK;
+    size_t span = PIPE_BUFFER_SIZE - idx;
+    *at = &p->data[idx];
+    return used < span ? used : span;
+}
+
+/* Contiguous writable bytes at the producer index */
+static inline size_t pipe_write_span(pipe_buffer_t *p, uint8_t **at)
+{
+    size_t space = PIPE_BUFFER_SIZE - pipe_used(p);
+    size_t idx   = p->write_pos & PIPE_MASK;
+    size_t span  = PIPE_BUFFER_SIZE - idx;
+    *at = &p->data[idx];
+    return space < span ? space : span;
+}
+
+static void pipe_wake(pipe_buffer_t *p, task_t **slot)
+{
+    unsigned long flags;
+    spin_lock_irqsave(&p->lock, &flags);
+    task_t *t = *slot;
+    *slot = NULL;
+    spin_unlock_irqrestore(&p->lock, flags);
+    if (t) task_wakeup(t);
+}
+
+/* Publish n consumed bytes; wake the writer if the ring was full */
+static void pipe_consume(pipe_buffer_t *p, size_t n)
+{
+    size_t was_used = pipe_used(p);
+    __atomic_store_n(&p->read_pos, p->read_pos + n, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (was_used == PIPE_BUFFER_SIZE || p->write_waiter)
+        pipe_wake(p, &p->write_waiter);
+    if (was_used == PIPE_BUFFER_SIZE)
+        wait_queue_wake(&p->poll_wq, POLLOUT);
+}
+
+/* Publish n produced bytes; wake the reader if the ring was empty */
+static void pipe_produce(pipe_buffer_t *p, size_t n)
+{
+    size_t was_used = pipe_used(p);
+    __atomic_store_n(&p->write_pos, p->write_pos + n, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (was_used == 0 || p->read_waiter)
+        pipe_wake(p, &p->read_waiter);
+    if (was_used == 0)
+        wait_queue_wake(&p->poll_wq, POLLIN);
+}
+
+/*
+ * Sleep until ready(p) or the other end goes away.  The task is marked
+ * BLOCKED before the re-check, so a wakeup landing between the check and
+ * schedule() just makes it READY again — no lost wakeups.
+ */
+static int pipe_wait(pipe_buffer_t *p, task_t **slot,
+                     int (*ready)(pipe_buffer_t *))
+{
+    task_t *self = current_task;
+    if (!self) return -EAGAIN;           /* before the scheduler: can't block */
+
+    unsigned long flags;
+    spin_lock_irqsave(&p->lock, &flags);
+    *slot = self;
+    self->state = TASK_BLOCKED;
+    spin_unlock_irqrestore(&p->lock, flags);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (ready(p)) {
+        spin_lock_irqsave(&p->lock, &flags);
+        if (*slot == self) *slot = NULL;
+        self->state = TASK_RUNNING;
+        spin_unlock_irqrestore(&p->lock, flags);
+        return 0;
+    }
+    schedule();
+    return 0;
+}
+
+static int pipe_readable(pipe_buffer_t *p) { return pipe_used(p) > 0 || !p->writers; }
+static int pipe_writable(pipe_buffer_t *p)
+{
+    return pipe_used(p) < PIPE_BUFFER_SIZE || !p->readers;
+}
+
+/* ── file_ops ────────────────────────────────────────────────────────────── */
+
 ssize_t pipe_read(file_t *file, void *buf, size_t count) {
-    // TODO: Implement pipe read
-    (void)file;
-    (void)buf;
-    (void)count;
-    errno = ENOSYS;
-    return -1;
+    pipe_buffer_t *p = file ? (pipe_buffer_t *)file->private : NULL;
+    if (!p || (file->f_flags & O_WRONLY)) { errno = EBADF; return -1; }
+    if (count == 0) return 0;
+
+    while (pipe_used(p) == 0) {
+        if (!p->writers) return 0;                          /* EOF */
+        if ((file->f_flags & O_NONBLOCK) ||
+            pipe_wait(p, &p->read_waiter, pipe_readable) != 0) {
+            errno = EAGAIN;
+            return -1;
+        }
+    }
+
+    uint8_t *dst = (uint8_t *)buf;
+    size_t done = 0;
+    while (done < count) {
+        uint8_t *src;
+        size_t n = pipe_read_span(p, &src);
+        if (n == 0) break;
+        if (n > count - done) n = count - done;
+        memcpy(dst + done, src, n);
+        pipe_consume(p, n);
+        done += n;
+    }
+    return (ssize_t)done;
 }
 
-/* Stub: Write to pipe */
 ssize_t pipe_write(file_t *file, const void *buf, size_t count) {
-    // TODO: Implement pipe write
-    (void)file;
-    (void)buf;
-    (void)count;
-    errno = ENOSYS;
-    return -1;
+    pipe_buffer_t *p = file ? (pipe_buffer_t *)file->private : NULL;
+    if (!p || !(file->f_flags & O_WRONLY)) { errno = EBADF; return -1; }
+
+    const uint8_t *src = (const uint8_t *)buf;
+    size_t done = 0;
+    while (done < count) {
+        if (!p->readers) { errno = EPIPE; return done ? (ssize_t)done : -1; }
+
+        uint8_t *dst;
+        size_t n = pipe_write_span(p, &dst);
+        if (n == 0) {
+            if (done && (file->f_flags & O_NONBLOCK)) break;
+            if ((file->f_flags & O_NONBLOCK) ||
+                pipe_wait(p, &p->write_waiter, pipe_writable) != 0) {
+                if (done) break;
+                errno = EAGAIN;
+                return -1;
+            }
+            continue;
+        }
+        if (n > count - done) n = count - done;
+        memcpy(dst, src + done, n);
+        pipe_produce(p, n);
+        done += n;
+    }
+    return (ssize_t)done;
 }
 
-/* Stub: Poll pipe for events */
-int pipe_poll(file_t *file) {
-    // TODO: Implement pipe poll
-    (void)file;
-    return 0;
+int pipe_poll(file_t *file, poll_table_t *pt) {
+    pipe_buffer_t *p = file ? (pipe_buffer_t *)file->private : NULL;
+    if (!p) return POLLNVAL;
+    poll_wait(pt, &p->poll_wq);
+    size_t used = pipe_used(p);
+    if (file->f_flags & O_WRONLY) {
+        if (!p->readers) return POLLERR;
+        return used < PIPE_BUFFER_SIZE ? POLLOUT : 0;
+    }
+    int ev = used ? POLLIN : 0;
+    if (!p->writers) ev |= POLLHUP;
+    return ev;
 }
 
-/* Stub: Close pipe */
 void pipe_close(file_t *file) {
-    // TODO: Implement pipe close
-    (void)file;
+    pipe_buffer_t *p = file ? (pipe_buffer_t *)file->private : NULL;
+    if (!p) return;
+
+    unsigned long flags;
+    spin_lock_irqsave(&p->lock, &flags);
+    if (file->f_flags & O_WRONLY) p->writers--; else p->readers--;
+    int last = (p->readers == 0 && p->writers == 0);
+    spin_unlock_irqrestore(&p->lock, flags);
+
+    /* The other end sees EOF / EPIPE — wake it */
+    if (!last) {
+        pipe_wake(p, &p->read_waiter);
+        pipe_wake(p, &p->write_waiter);
+        wait_queue_wake(&p->poll_wq, POLLIN | POLLOUT | POLLHUP | POLLERR);
+    } else {
+        kfree(p);
+    }
 }
 
 /* Pipe operations */
 file_ops_t pipe_ops = {
-    .read = pipe_read,
+    .read  = pipe_read,
     .write = pipe_write,
+    .poll  = pipe_poll,
     .close = pipe_close,
 };
+
+/* Create pipe – pipefd[0] read end, pipefd[1] write end */
+int pipe(int pipefd[2]) {
+    if (!pipefd) { errno = EINVAL; return -1; }
+
+    pipe_buffer_t *p = kmalloc(sizeof(pipe_buffer_t));
+    if (!p) { errno = ENOMEM; return -1; }
+    memset(p, 0, sizeof(*p));
+    spinlock_init(&p->lock);
+    wait_queue_init(&p->poll_wq);
+    p->readers = 1;
+    p->writers = 1;
+
+    file_t *rf = vfs_file_alloc(&pipe_ops, p, O_RDONLY);
+    file_t *wf = vfs_file_alloc(&pipe_ops, p, O_WRONLY);
+    if (!rf || !wf) goto fail;
+
+    pipefd[0] = vfs_fd_install(rf);
+    if (pipefd[0] < 0) goto fail;
+    pipefd[1] = vfs_fd_install(wf);
+    if (pipefd[1] < 0) {
+        rf->f_ops = NULL;                /* uninstall without running close */
+        vfs_fd_close(pipefd[0]);         /* also recycles rf */
+        rf = NULL;
+        goto fail;
+    }
+    return 0;
+
+fail:
+    vfs_file_free(rf);
+    vfs_file_free(wf);
+    kfree(p);
+    return -1;
+}
+
+/* ── splice ──────────────────────────────────────────────────────────────────
+ * Move up to len bytes between a pipe and another descriptor (FileCore
+ * file, TCP socket, or another pipe) through the pipe's ring: the other
+ * side's read/write op is pointed straight at the ring span, so the data
+ * never passes through a caller buffer.  Returns bytes moved, 0 at EOF,
+ * or -1 with errno (EAGAIN when nothing could move without blocking).   */
+static int is_pipe(file_t *f) { return f && f->f_ops == &pipe_ops; }
+
+ssize_t splice(int fd_in, int fd_out, size_t len, unsigned int flags)
+{
+    file_t *in  = vfs_fd_get(fd_in);
+    file_t *out = vfs_fd_get(fd_out);
+    if (!in || !out) { errno = EBADF; return -1; }
+    int nonblock = (flags & SPLICE_F_NONBLOCK) != 0;
+    size_t done = 0;
+
+    if (is_pipe(in) && !(in->f_flags & O_WRONLY)) {
+        /* pipe → out */
+        pipe_buffer_t *p = (pipe_buffer_t *)in->private;
+        if (!out->f_ops || !out->f_ops->write) { errno = EINVAL; return -1; }
+        while (done < len) {
+            uint8_t *src;
+            size_t n = pipe_read_span(p, &src);
+            if (n == 0) {
+                if (done || !p->writers) break;
+                if (nonblock || pipe_wait(p, &p->read_waiter, pipe_readable) != 0) {
+                    errno = EAGAIN; return -1;
+                }
+                continue;
+            }
+            if (n > len - done) n = len - done;
+            ssize_t w = out->f_ops->write(out, src, n);
+            if (w <= 0) { if (done) break; return w < 0 ? -1 : 0; }
+            pipe_consume(p, (size_t)w);
+            done += (size_t)w;
+            if ((size_t)w < n) break;                 /* sink is full */
+        }
+        return (ssize_t)done;
+    }
+
+    if (is_pipe(out) && (out->f_flags & O_WRONLY)) {
+        /* in → pipe */
+        pipe_buffer_t *p = (pipe_buffer_t *)out->private;
+        if (!in->f_ops || !in->f_ops->read) { errno = EINVAL; return -1; }
+        while (done < len) {
+            if (!p->readers) { if (done) break; errno = EPIPE; return -1; }
+            uint8_t *dst;
+            size_t n = pipe_write_span(p, &dst);
+            if (n == 0) {
+                if (done) break;
+                if (nonblock || pipe_wait(p, &p->write_waiter, pipe_writable) != 0) {
+                    errno = EAGAIN; return -1;
+                }
+                continue;
+            }
+            if (n > len - done) n = len - done;
+            ssize_t r = in->f_ops->read(in, dst, n);
+            if (r <= 0) { if (done) break; return r < 0 ? -1 : 0; }
+            pipe_produce(p, (size_t)r);
+            done += (size_t)r;
+            if ((size_t)r < n) break;                 /* source drained */
+        }
+        return (ssize_t)done;
+    }
+
+    errno = EINVAL;                                   /* neither end a pipe */
+    return -1;
+}
@@ -1,6 +1,7 @@
 /*
  * pipe.h – UNIX pipes header
  * Author: R Andrews – 26 Nov 2025
+ * Updated: boot404, Oct 2026 – splice()
  */
 
 #ifndef PIPE_H
@@ -8,7 +9,12 @@
 
 #include <stdint.h>
 
+#define SPLICE_F_NONBLOCK   0x02    /* don't block on the pipe */
+
 /* Create a pipe */
 int pipe(int pipefd[2]);
 
+/* Move data between a pipe and another descriptor without a user buffer */
+ssize_t splice(int fd_in, int fd_out, size_t len, unsigned int flags);
+
 #endif /* PIPE_H */
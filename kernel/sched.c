@@ -62,8 +62,17 @@ void sched_init_cpu(int cpu_id) {
                 cpu_id, task->stack_top);
 }
 
-/* Idle task function */
+/* Idle task function.
+ * boot420: turns on the generic timer event stream (CNTKCTL_EL1.EVNTEN,
+ * counter bit 15 → one event every ~1.2 ms at 54 MHz) so the wfe below
+ * also returns while no interrupt is due, and a task_wake_after()
+ * deadline is noticed even when every task is blocked.               */
 static void idle_task_fn(void) {
+    uint64_t kctl;
+    __asm__ volatile ("mrs %0, cntkctl_el1" : "=r"(kctl));
+    kctl = (kctl & ~(0xFULL << 4)) | (15ULL << 4) | (1ULL << 2);
+    __asm__ volatile ("msr cntkctl_el1, %0\nisb" :: "r"(kctl));
+
     while (1) {
         __asm__ volatile ("wfe");  /* Wait for event */
         /* boot273: always yield after wfe so WIMP (priority 10) gets
@@ -131,12 +140,25 @@ static void dequeue_task(cpu_sched_t *sched, task_t *task) {
     spin_unlock_irqrestore(&sched->lock, flags);
 }
 
-/* Pick next task to run */
+static inline uint64_t sched_ticks(void) {
+    uint64_t cnt;
+    __asm__ volatile ("mrs %0, cntpct_el0" : "=r"(cnt));
+    return cnt;
+}
+
+/* Pick next task to run.
+ * boot420: a blocked task whose task_wake_after() deadline has passed
+ * is made ready here — there is no timer interrupt to do it.          */
 static task_t *pick_next_task(cpu_sched_t *sched) {
     task_t *best = NULL;
     int best_priority = -1;
+    uint64_t now = sched_ticks();
     
     for (task_t *task = sched->runqueue_head; task; task = task->next) {
+        if (task->state == TASK_BLOCKED && task->wake_at && now >= task->wake_at) {
+            task->wake_at = 0;
+            task->state   = TASK_READY;
+        }
         if (task->state == TASK_READY && task->priority > best_priority) {
             best = task;
             best_priority = task->priority;
@@ -247,6 +269,8 @@ void schedule(void) {
                     prev ? prev->name : "null",
                     next ? next->name : "null",
                     (next && next->started) ? "ret" : "eret");
+        /* boot401: user window follows the task (kernel map is global) */
+        mmu_switch_to(next);
         context_switch(prev, next);
         /* Only the "ret" (resume) path reaches here — eret does not return. */
     }
@@ -266,9 +290,26 @@ void task_block(task_state_t state) {
     }
 }
 
+/*
+ * task_wake_after — bound the current task's next block to ms.
+ *
+ * boot420: call just before blocking (setting TASK_BLOCKED and calling
+ * schedule(), under whatever lock the waker takes, as blockdev_wait
+ * does).  The task is woken by task_wakeup() or, failing that, by
+ * pick_next_task() once ms have passed.
+ */
+void task_wake_after(uint32_t ms) {
+    task_t *task = current_task;
+    uint64_t freq;
+    if (!task) return;
+    __asm__ volatile ("mrs %0, cntfrq_el0" : "=r"(freq));
+    task->wake_at = sched_ticks() + (uint64_t)ms * (freq / 1000ULL) + 1ULL;
+}
+
 /* Wake up a blocked task */
 void task_wakeup(task_t *task) {
     if (task && task->state == TASK_BLOCKED) {
+        task->wake_at = 0;
         task->state = TASK_READY;
         // Send reschedule IPI if on different CPU
         int task_cpu = __builtin_ctzll(task->cpu_affinity);
@@ -277,3 +318,61 @@ void task_wakeup(task_t *task) {
         }
     }
 }
+
+/*
+ * sleeplock_lock / sleeplock_unlock — see sleeplock_t in kernel.h.
+ *
+ * boot421: the waiter queues a stack node and blocks; unlock wakes
+ * every waiter and each retries, so the highest-priority one wins.
+ * Before the scheduler runs (current_task NULL) there is nobody to
+ * exclude and both are no-ops.
+ */
+void sleeplock_lock(sleeplock_t *sl) {
+    task_t *self = current_task;
+    sleep_waiter_t w;
+    unsigned long flags;
+
+    if (!self) return;
+    if (sl->owner == self) { sl->depth++; return; }
+
+    for (;;) {
+        spin_lock_irqsave(&sl->lock, &flags);
+        if (!sl->owner) {
+            sl->owner = self;
+            sl->depth = 1;
+            spin_unlock_irqrestore(&sl->lock, flags);
+            return;
+        }
+        w.task = self;
+        w.next = sl->waiters;
+        sl->waiters = &w;
+        self->state = TASK_BLOCKED;
+        spin_unlock_irqrestore(&sl->lock, flags);
+        schedule();
+
+        /* Unlock detached the whole list; drop our node if it did not. */
+        spin_lock_irqsave(&sl->lock, &flags);
+        for (sleep_waiter_t **pp = &sl->waiters; *pp; pp = &(*pp)->next) {
+            if (*pp == &w) { *pp = w.next; break; }
+        }
+        spin_unlock_irqrestore(&sl->lock, flags);
+    }
+}
+
+void sleeplock_unlock(sleeplock_t *sl) {
+    sleep_waiter_t *w;
+    unsigned long flags;
+
+    if (!current_task || sl->owner != current_task) return;
+    if (--sl->depth > 0) return;
+
+    /* Wake under the spinlock: a woken waiter's node lives on its own
+     * stack and it takes this lock before it can return.              */
+    spin_lock_irqsave(&sl->lock, &flags);
+    sl->owner = NULL;
+    w = sl->waiters;
+    sl->waiters = NULL;
+    for (; w; w = w->next)
+        task_wakeup(w->task);
+    spin_unlock_irqrestore(&sl->lock, flags);
+}
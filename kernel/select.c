@@ -1,54 +1,661 @@
 /*
- * select.c – select() and poll() system calls (Simplified stub)
+ * select.c – select(), poll() and epoll for RISC OS Phoenix
  * Author: R Andrews – 26 Nov 2025
  * Updated: 15 Feb 2026 - Stub version for compilation
+ * Updated: boot405, Oct 2026 – wait queues, event-driven poll/select, epoll
+ *
+ * Every pollable file type owns wait queues and wakes them only when its
+ * readiness changes.  poll()/select() hook one wait entry per descriptor
+ * on the first scan and then sleep; a wakeup marks the caller triggered
+ * and the next scan just samples (no re-registration).  epoll keeps the
+ * interest set registered between calls: a wakeup moves the one epitem
+ * onto the ready list, so epoll_wait costs O(ready), not O(watched).
+ *
+ * A finite timeout blocks with a task_wake_after() deadline (the
+ * scheduler wakes the task once it passes, there being no timer
+ * interrupt); an infinite timeout blocks outright.
  */
 
 #include "kernel.h"
 #include "vfs.h"
+#include "select.h"
+#include "spinlock.h"
 #include "errno.h"
 #include <stdint.h>
 
-/* Type definitions for select/poll */
-typedef unsigned long fd_mask;
-#define FD_SETSIZE 1024
-#define NFDBITS (8 * sizeof(fd_mask))
+#define NO_DEADLINE     UINT64_MAX
+#define POLL_ALWAYS     (POLLERR | POLLHUP | POLLNVAL)
+
+/* ── Wait queues ─────────────────────────────────────────────────────────── */
+
+void wait_queue_init(wait_queue_t *wq)
+{
+    spinlock_init(&wq->lock);
+    wq->head = NULL;
+}
+
+void wait_queue_add(wait_queue_t *wq, wait_entry_t *we)
+{
+    unsigned long flags;
+    spin_lock_irqsave(&wq->lock, &flags);
+    we->wq   = wq;
+    we->prev = NULL;
+    we->next = wq->head;
+    if (wq->head) wq->head->prev = we;
+    wq->head = we;
+    spin_unlock_irqrestore(&wq->lock, flags);
+    /* Order the hook before the caller samples readiness */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void wait_queue_remove(wait_entry_t *we)
+{
+    wait_queue_t *wq = we->wq;
+    if (!wq) return;
+
+    unsigned long flags;
+    spin_lock_irqsave(&wq->lock, &flags);
+    if (we->prev) we->prev->next = we->next;
+    else          wq->head       = we->next;
+    if (we->next) we->next->prev = we->prev;
+    we->next = we->prev = NULL;
+    we->wq   = NULL;
+    spin_unlock_irqrestore(&wq->lock, flags);
+}
+
+/* Run every hooked callback; 'events' says which condition changed */
+void wait_queue_wake(wait_queue_t *wq, int events)
+{
+    if (!__atomic_load_n(&wq->head, __ATOMIC_ACQUIRE)) return;
+
+    unsigned long flags;
+    spin_lock_irqsave(&wq->lock, &flags);
+    for (wait_entry_t *we = wq->head; we; we = we->next)
+        we->func(we, events);
+    spin_unlock_irqrestore(&wq->lock, flags);
+}
+
+/* ── Time ────────────────────────────────────────────────────────────────── */
+
+static uint64_t now_ms(void)
+{
+    uint64_t ticks, freq;
+    __asm__ volatile ("mrs %0, cntpct_el0" : "=r"(ticks));
+    __asm__ volatile ("mrs %0, cntfrq_el0" : "=r"(freq));
+    uint64_t khz = freq / 1000u;
+    return khz ? ticks / khz : 0;
+}
+
+static uint64_t deadline_from_ms(int timeout_ms)
+{
+    if (timeout_ms < 0) return NO_DEADLINE;
+    return now_ms() + (uint64_t)timeout_ms;
+}
+
+static int expired(uint64_t deadline)
+{
+    return deadline != NO_DEADLINE && now_ms() >= deadline;
+}
+
+/* ── Poll waiter ─────────────────────────────────────────────────────────── */
 
 typedef struct {
-    fd_mask fds_bits[FD_SETSIZE / NFDBITS];
-} fd_set;
+    poll_table_t  pt;
+    task_t       *task;
+    int           triggered;
+    wait_entry_t *entries;
+    int           nentries;
+    int           cap;
+} poll_waiter_t;
+
+static void pollwake(wait_entry_t *we, int events)
+{
+    (void)events;
+    poll_waiter_t *pw = (poll_waiter_t *)we->private;
+    __atomic_store_n(&pw->triggered, 1, __ATOMIC_RELEASE);
+    if (pw->task) task_wakeup(pw->task);
+}
+
+static void poll_queue(poll_table_t *pt, wait_queue_t *wq)
+{
+    poll_waiter_t *pw = (poll_waiter_t *)pt;
+    if (pw->nentries >= pw->cap) return;
+    wait_entry_t *we = &pw->entries[pw->nentries++];
+    we->func    = pollwake;
+    we->private = pw;
+    wait_queue_add(wq, we);
+}
 
-typedef unsigned long nfds_t;
+static void poll_waiter_init(poll_waiter_t *pw, wait_entry_t *entries, int cap)
+{
+    pw->pt.queue  = poll_queue;
+    pw->task      = current_task;
+    pw->triggered = 0;
+    pw->entries   = entries;
+    pw->nentries  = 0;
+    pw->cap       = cap;
+}
 
-struct timeval {
-    long tv_sec;
-    long tv_usec;
+static void poll_waiter_done(poll_waiter_t *pw)
+{
+    for (int i = 0; i < pw->nentries; i++)
+        wait_queue_remove(&pw->entries[i]);
+    pw->nentries = 0;
+}
+
+/*
+ * Sleep until a hooked queue fires or the deadline passes; returns 1 on
+ * timeout.  Same no-lost-wakeup pattern as pipe_wait: BLOCKED before the
+ * re-check of 'triggered'.  A finite deadline is armed with
+ * task_wake_after(), so the task really sleeps whatever its priority;
+ * the loop re-checks after every wakeup.  Without a task (before the
+ * scheduler) there is nothing to block and the wait spins.
+ */
+static int poll_sleep(poll_waiter_t *pw, uint64_t deadline)
+{
+    task_t *self = current_task;
+
+    while (!__atomic_load_n(&pw->triggered, __ATOMIC_ACQUIRE)) {
+        if (expired(deadline)) return 1;
+        if (!self) continue;
+
+        if (deadline != NO_DEADLINE) {
+            uint64_t left = deadline - now_ms();
+            task_wake_after(left > 0xFFFFFFFFu ? 0xFFFFFFFFu : (uint32_t)left);
+        }
+        self->state = TASK_BLOCKED;
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&pw->triggered, __ATOMIC_ACQUIRE)) {
+            self->state   = TASK_RUNNING;
+            self->wake_at = 0;
+        } else {
+            schedule();
+        }
+        if (deadline == NO_DEADLINE) return 0;
+    }
+    return 0;
+}
+
+/* ── poll() ──────────────────────────────────────────────────────────────── */
+
+int poll(struct pollfd *fds, nfds_t nfds, int timeout_ms)
+{
+    if (nfds && !fds) { errno = EFAULT; return -1; }
+    if (nfds > MAX_FD) { errno = EINVAL; return -1; }
+
+    uint64_t deadline = deadline_from_ms(timeout_ms);
+    wait_entry_t *entries = NULL;
+    poll_waiter_t pw;
+    poll_table_t *pt = NULL;
+
+    if (nfds == 0) {                    /* plain sleep; < 0 = forever */
+        poll_waiter_init(&pw, NULL, 0);
+        if (timeout_ms != 0) poll_sleep(&pw, deadline);
+        return 0;
+    }
+
+    if (timeout_ms != 0) {
+        entries = kmalloc(nfds * sizeof(wait_entry_t));
+        if (!entries) { errno = ENOMEM; return -1; }
+        memset(entries, 0, nfds * sizeof(wait_entry_t));
+        poll_waiter_init(&pw, entries, (int)nfds);
+        pt = &pw.pt;
+    } else {
+        poll_waiter_init(&pw, NULL, 0);
+    }
+
+    int count;
+    for (;;) {
+        count = 0;
+        __atomic_store_n(&pw.triggered, 0, __ATOMIC_RELEASE);
+
+        for (nfds_t i = 0; i < nfds; i++) {
+            fds[i].revents = 0;
+            if (fds[i].fd < 0) continue;
+
+            file_t *file = vfs_fd_get(fds[i].fd);
+            int mask = file ? vfs_poll(file, pt) : POLLNVAL;
+            mask &= fds[i].events | POLL_ALWAYS;
+            if (mask) {
+                fds[i].revents = (short)mask;
+                count++;
+                pt = NULL;              /* already have an answer */
+            }
+        }
+        pt = NULL;                      /* hooked once; later scans sample */
+
+        if (count || timeout_ms == 0 || !entries) break;
+        if (poll_sleep(&pw, deadline)) break;
+    }
+
+    poll_waiter_done(&pw);
+    if (entries) kfree(entries);
+    return count;
+}
+
+/* ── select() ────────────────────────────────────────────────────────────── */
+
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+           struct timeval *timeout)
+{
+    if (nfds < 0 || nfds > MAX_FD) { errno = EINVAL; return -1; }
+
+    int timeout_ms = -1;
+    if (timeout) {
+        if (timeout->tv_sec < 0 || timeout->tv_usec < 0) {
+            errno = EINVAL;
+            return -1;
+        }
+        long ms = timeout->tv_sec * 1000 + (timeout->tv_usec + 999) / 1000;
+        timeout_ms = ms > 0x7FFFFFFF ? 0x7FFFFFFF : (int)ms;
+    }
+
+    /* Gather the set bits into a pollfd list */
+    int n = 0;
+    for (int fd = 0; fd < nfds; fd++)
+        if ((readfds   && FD_ISSET(fd, readfds))  ||
+            (writefds  && FD_ISSET(fd, writefds)) ||
+            (exceptfds && FD_ISSET(fd, exceptfds)))
+            n++;
+
+    struct pollfd *pfds = NULL;
+    if (n) {
+        pfds = kmalloc((size_t)n * sizeof(struct pollfd));
+        if (!pfds) { errno = ENOMEM; return -1; }
+    }
+
+    int i = 0;
+    for (int fd = 0; fd < nfds; fd++) {
+        short ev = 0;
+        if (readfds   && FD_ISSET(fd, readfds))   ev |= POLLIN;
+        if (writefds  && FD_ISSET(fd, writefds))  ev |= POLLOUT;
+        if (exceptfds && FD_ISSET(fd, exceptfds)) ev |= POLLPRI;
+        if (!ev) continue;
+        pfds[i].fd = fd;
+        pfds[i].events = ev;
+        pfds[i].revents = 0;
+        i++;
+    }
+
+    int rc = poll(pfds, (nfds_t)n, timeout_ms);
+    if (rc < 0) { if (pfds) kfree(pfds); return -1; }
+
+    for (int fd = 0; fd < nfds; fd++) {
+        if (readfds)   FD_CLR(fd, readfds);
+        if (writefds)  FD_CLR(fd, writefds);
+        if (exceptfds) FD_CLR(fd, exceptfds);
+    }
+
+    int bits = 0;
+    for (i = 0; i < n; i++) {
+        short re = pfds[i].revents;
+        if (re & POLLNVAL) {
+            kfree(pfds);
+            errno = EBADF;
+            return -1;
+        }
+        int fd = pfds[i].fd;
+        if (readfds && (pfds[i].events & POLLIN) && (re & (POLLIN | POLLHUP | POLLERR))) {
+            FD_SET(fd, readfds); bits++;
+        }
+        if (writefds && (pfds[i].events & POLLOUT) && (re & (POLLOUT | POLLERR))) {
+            FD_SET(fd, writefds); bits++;
+        }
+        if (exceptfds && (pfds[i].events & POLLPRI) && (re & POLLPRI)) {
+            FD_SET(fd, exceptfds); bits++;
+        }
+    }
+
+    if (pfds) kfree(pfds);
+    return bits;
+}
+
+/* ── epoll ───────────────────────────────────────────────────────────────────
+ * An epitem sits on its file's wait queue for the lifetime of the watch.
+ * Its callback appends it to the owning eventpoll's ready list (once) and
+ * wakes epoll_wait.  Level-triggered items are re-queued after reporting
+ * until a sample says they are no longer ready; EPOLLET items are not.  */
+
+#define EP_HASH         64
+#define EP_PRIVATE      (EPOLLONESHOT | EPOLLET)
+#define EP_MAX_NESTS    4       /* epoll-in-epoll depth, as Linux      */
+
+/* epitem.on_rdlist */
+#define EP_IDLE         0
+#define EP_READY        1       /* linked on ep->rdlist              */
+#define EP_HARVEST      2       /* taken by epoll_wait, being sampled */
+
+typedef struct eventpoll eventpoll_t;
+
+struct epitem {
+    struct epitem *hnext;       /* interest-set hash chain          */
+    struct epitem *rdnext;      /* ready list                       */
+    struct epitem *fnext;       /* file->f_ep chain                 */
+    eventpoll_t   *ep;
+    file_t        *file;
+    int            fd;
+    uint32_t       events;      /* interest mask (0 once ONESHOT fired) */
+    uint32_t       flags;       /* EPOLLET / EPOLLONESHOT            */
+    epoll_data_t   data;
+    int            on_rdlist;   /* EP_IDLE / EP_READY / EP_HARVEST   */
+    int            rearm;       /* woken while EP_HARVEST            */
+    int            keep;        /* re-queue after harvest            */
+    wait_entry_t   we;
 };
+typedef struct epitem epitem_t;
 
-struct pollfd {
-    int fd;
-    short events;
-    short revents;
+struct eventpoll {
+    spinlock_t     lock;
+    epitem_t      *hash[EP_HASH];
+    epitem_t      *rdlist;
+    epitem_t      *rdtail;
+    wait_queue_t   wq;          /* epoll_wait sleepers, nested pollers */
+    file_t        *file;
 };
 
-/* Stub: select() system call */
-int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, struct timeval *timeout) {
-    // TODO: Implement select
-    (void)nfds;
-    (void)readfds;
-    (void)writefds;
-    (void)exceptfds;
-    (void)timeout;
-    errno = ENOSYS;
-    return -1;
-}
-
-/* Stub: poll() system call */
-int poll(struct pollfd *fds, nfds_t nfds, int timeout_ms) {
-    // TODO: Implement poll
-    (void)fds;
-    (void)nfds;
-    (void)timeout_ms;
-    errno = ENOSYS;
-    return -1;
+static file_ops_t eventpoll_ops;
+
+static eventpoll_t *ep_from_fd(int epfd)
+{
+    file_t *f = vfs_fd_get(epfd);
+    if (!f || f->f_ops != &eventpoll_ops) return NULL;
+    return (eventpoll_t *)f->private;
+}
+
+/* Caller holds ep->lock */
+static void ep_rdlist_append(eventpoll_t *ep, epitem_t *epi)
+{
+    if (epi->on_rdlist != EP_IDLE) return;
+    epi->on_rdlist = EP_READY;
+    epi->rdnext = NULL;
+    if (ep->rdtail) ep->rdtail->rdnext = epi;
+    else            ep->rdlist         = epi;
+    ep->rdtail = epi;
+}
+
+/* Caller holds ep->lock */
+static void ep_rdlist_unlink(eventpoll_t *ep, epitem_t *epi)
+{
+    if (epi->on_rdlist != EP_READY) return;
+    epitem_t **pp = &ep->rdlist, *prev = NULL;
+    while (*pp && *pp != epi) { prev = *pp; pp = &(*pp)->rdnext; }
+    if (*pp) {
+        *pp = epi->rdnext;
+        if (ep->rdtail == epi) ep->rdtail = prev;
+    }
+    epi->on_rdlist = EP_IDLE;
+}
+
+static void ep_poll_callback(wait_entry_t *we, int events)
+{
+    epitem_t *epi = (epitem_t *)we->private;
+    eventpoll_t *ep = epi->ep;
+
+    if (!(events & (epi->events | POLL_ALWAYS)) || !epi->events) return;
+
+    unsigned long flags;
+    spin_lock_irqsave(&ep->lock, &flags);
+    if (epi->on_rdlist == EP_HARVEST) epi->rearm = 1;
+    else ep_rdlist_append(ep, epi);
+    spin_unlock_irqrestore(&ep->lock, flags);
+
+    wait_queue_wake(&ep->wq, POLLIN);
+}
+
+typedef struct {
+    poll_table_t pt;
+    epitem_t    *epi;
+} ep_pqueue_t;
+
+static void ep_ptable_queue(poll_table_t *pt, wait_queue_t *wq)
+{
+    epitem_t *epi = ((ep_pqueue_t *)pt)->epi;
+    if (epi->we.wq) return;                 /* one source per watch */
+    wait_queue_add(wq, &epi->we);
+}
+
+static epitem_t *ep_find(eventpoll_t *ep, int fd, epitem_t ***link)
+{
+    epitem_t **pp = &ep->hash[(unsigned)fd % EP_HASH];
+    while (*pp && (*pp)->fd != fd) pp = &(*pp)->hnext;
+    if (link) *link = pp;
+    return *pp;
+}
+
+static void ep_remove(eventpoll_t *ep, epitem_t *epi)
+{
+    wait_queue_remove(&epi->we);            /* source lock, not ep->lock */
+
+    unsigned long flags;
+    spin_lock_irqsave(&ep->lock, &flags);
+    epitem_t **pp;
+    if (ep_find(ep, epi->fd, &pp) == epi) *pp = epi->hnext;
+    ep_rdlist_unlink(ep, epi);
+    spin_unlock_irqrestore(&ep->lock, flags);
+
+    epitem_t **fp = &epi->file->f_ep;
+    while (*fp && *fp != epi) fp = &(*fp)->fnext;
+    if (*fp) *fp = epi->fnext;
+
+    kfree(epi);
+}
+
+static int ep_eventpoll_poll(file_t *file, poll_table_t *pt)
+{
+    eventpoll_t *ep = (eventpoll_t *)file->private;
+    poll_wait(pt, &ep->wq);
+    return __atomic_load_n(&ep->rdlist, __ATOMIC_ACQUIRE) ? POLLIN : 0;
+}
+
+static void ep_eventpoll_close(file_t *file)
+{
+    eventpoll_t *ep = (eventpoll_t *)file->private;
+    for (int b = 0; b < EP_HASH; b++)
+        while (ep->hash[b]) ep_remove(ep, ep->hash[b]);
+    kfree(ep);
+}
+
+static file_ops_t eventpoll_ops = {
+    .poll  = ep_eventpoll_poll,
+    .close = ep_eventpoll_close,
+};
+
+int epoll_create(int size)
+{
+    if (size <= 0) { errno = EINVAL; return -1; }
+
+    eventpoll_t *ep = kmalloc(sizeof(eventpoll_t));
+    if (!ep) { errno = ENOMEM; return -1; }
+    memset(ep, 0, sizeof(*ep));
+    spinlock_init(&ep->lock);
+    wait_queue_init(&ep->wq);
+
+    file_t *file = vfs_file_alloc(&eventpoll_ops, ep, O_RDONLY);
+    if (!file) { kfree(ep); return -1; }
+    ep->file = file;
+
+    int fd = vfs_fd_install(file);
+    if (fd < 0) { kfree(ep); vfs_file_free(file); return -1; }
+    return fd;
+}
+
+/*
+ * Would watching epoll set 'from' from inside 'ep' close a loop?  Walks
+ * the epoll files nested under 'from'; a path back to ep, or one deeper
+ * than EP_MAX_NESTS, is refused.  Nested sets only change in epoll_ctl,
+ * which never sleeps, so the walk sees a stable graph.
+ */
+static int ep_loop_check(eventpoll_t *ep, eventpoll_t *from, int depth)
+{
+    if (from == ep) return 1;
+    if (depth >= EP_MAX_NESTS) return 1;
+    for (int b = 0; b < EP_HASH; b++)
+        for (epitem_t *epi = from->hash[b]; epi; epi = epi->hnext)
+            if (epi->file->f_ops == &eventpoll_ops &&
+                ep_loop_check(ep, (eventpoll_t *)epi->file->private, depth + 1))
+                return 1;
+    return 0;
+}
+
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event)
+{
+    eventpoll_t *ep = ep_from_fd(epfd);
+    if (!ep) { errno = EBADF; return -1; }
+
+    file_t *file = vfs_fd_get(fd);
+    if (!file) { errno = EBADF; return -1; }
+    if (file == ep->file) { errno = EINVAL; return -1; }
+    if (!file->f_ops || !file->f_ops->poll) { errno = EPERM; return -1; }
+    if (op != EPOLL_CTL_DEL && !event) { errno = EFAULT; return -1; }
+
+    unsigned long flags;
+    spin_lock_irqsave(&ep->lock, &flags);
+    epitem_t *epi = ep_find(ep, fd, NULL);
+    spin_unlock_irqrestore(&ep->lock, flags);
+
+    switch (op) {
+    case EPOLL_CTL_ADD: {
+        if (epi) { errno = EEXIST; return -1; }
+        if (file->f_ops == &eventpoll_ops &&
+            ep_loop_check(ep, (eventpoll_t *)file->private, 0)) {
+            errno = ELOOP;
+            return -1;
+        }
+        epi = kmalloc(sizeof(epitem_t));
+        if (!epi) { errno = ENOMEM; return -1; }
+        memset(epi, 0, sizeof(*epi));
+        epi->ep         = ep;
+        epi->file       = file;
+        epi->fd         = fd;
+        epi->events     = event->events & ~EP_PRIVATE;
+        epi->flags      = event->events &  EP_PRIVATE;
+        epi->data       = event->data;
+        epi->we.func    = ep_poll_callback;
+        epi->we.private = epi;
+
+        spin_lock_irqsave(&ep->lock, &flags);
+        epitem_t **pp = &ep->hash[(unsigned)fd % EP_HASH];
+        epi->hnext = *pp;
+        *pp = epi;
+        spin_unlock_irqrestore(&ep->lock, flags);
+        epi->fnext = file->f_ep;
+        file->f_ep = epi;
+
+        /* Hook the file's queue, then sample once for current state */
+        ep_pqueue_t epq = { .pt = { .queue = ep_ptable_queue }, .epi = epi };
+        int mask = vfs_poll(file, &epq.pt);
+        if (mask & (epi->events | POLL_ALWAYS)) {
+            spin_lock_irqsave(&ep->lock, &flags);
+            ep_rdlist_append(ep, epi);
+            spin_unlock_irqrestore(&ep->lock, flags);
+            wait_queue_wake(&ep->wq, POLLIN);
+        }
+        return 0;
+    }
+
+    case EPOLL_CTL_MOD: {
+        if (!epi) { errno = ENOENT; return -1; }
+        spin_lock_irqsave(&ep->lock, &flags);
+        epi->events = event->events & ~EP_PRIVATE;
+        epi->flags  = event->events &  EP_PRIVATE;
+        epi->data   = event->data;
+        spin_unlock_irqrestore(&ep->lock, flags);
+
+        int mask = vfs_poll(file, NULL);
+        if (mask & (epi->events | POLL_ALWAYS)) {
+            spin_lock_irqsave(&ep->lock, &flags);
+            ep_rdlist_append(ep, epi);
+            spin_unlock_irqrestore(&ep->lock, flags);
+            wait_queue_wake(&ep->wq, POLLIN);
+        }
+        return 0;
+    }
+
+    case EPOLL_CTL_DEL:
+        if (!epi) { errno = ENOENT; return -1; }
+        ep_remove(ep, epi);
+        return 0;
+
+    default:
+        errno = EINVAL;
+        return -1;
+    }
+}
+
+/*
+ * Report up to maxevents from the ready list; only ready items are touched.
+ * Taken items stay chained (EP_HARVEST) so a concurrent wakeup just sets
+ * 'rearm' instead of relinking them under us.
+ */
+static int ep_harvest(eventpoll_t *ep, struct epoll_event *events, int maxevents)
+{
+    unsigned long flags;
+    spin_lock_irqsave(&ep->lock, &flags);
+    epitem_t *list = ep->rdlist;
+    ep->rdlist = ep->rdtail = NULL;
+    for (epitem_t *e = list; e; e = e->rdnext) {
+        e->on_rdlist = EP_HARVEST;
+        e->rearm = 0;
+    }
+    spin_unlock_irqrestore(&ep->lock, flags);
+
+    int n = 0;
+    for (epitem_t *epi = list; epi; epi = epi->rdnext) {
+        epi->keep = 0;
+        if (n == maxevents) { epi->keep = 1; continue; }  /* next call */
+
+        int mask = vfs_poll(epi->file, NULL) & (epi->events | POLL_ALWAYS);
+        if (!mask || !epi->events) continue;    /* stale wakeup: drop */
+
+        events[n].events = (uint32_t)mask;
+        events[n].data   = epi->data;
+        n++;
+
+        if (epi->flags & EPOLLONESHOT)
+            epi->events = 0;                    /* disarmed until MOD */
+        else if (!(epi->flags & EPOLLET))
+            epi->keep = 1;                      /* level: until not ready */
+    }
+
+    spin_lock_irqsave(&ep->lock, &flags);
+    while (list) {
+        epitem_t *epi = list;
+        list = epi->rdnext;
+        epi->on_rdlist = EP_IDLE;
+        if (epi->keep || epi->rearm) ep_rdlist_append(ep, epi);
+    }
+    spin_unlock_irqrestore(&ep->lock, flags);
+    return n;
+}
+
+int epoll_wait(int epfd, struct epoll_event *events, int maxevents,
+               int timeout_ms)
+{
+    eventpoll_t *ep = ep_from_fd(epfd);
+    if (!ep) { errno = EBADF; return -1; }
+    if (!events || maxevents <= 0) { errno = EINVAL; return -1; }
+
+    uint64_t deadline = deadline_from_ms(timeout_ms);
+    wait_entry_t we;
+    poll_waiter_t pw;
+    poll_waiter_init(&pw, &we, 1);
+
+    for (;;) {
+        int n = ep_harvest(ep, events, maxevents);
+        if (n || timeout_ms == 0) return n;
+
+        __atomic_store_n(&pw.triggered, 0, __ATOMIC_RELEASE);
+        poll_wait(&pw.pt, &ep->wq);
+        int empty = !__atomic_load_n(&ep->rdlist, __ATOMIC_ACQUIRE);
+        int timed_out = empty ? poll_sleep(&pw, deadline) : 0;
+        poll_waiter_done(&pw);
+        if (timed_out) return 0;
+    }
+}
+
+/* A watched file is being closed: drop its epitems from every epoll set */
+void eventpoll_release(file_t *file)
+{
+    while (file->f_ep)
+        ep_remove(file->f_ep->ep, file->f_ep);
 }
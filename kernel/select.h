@@ -0,0 +1,77 @@
+/*
+ * select.h – select(), poll() and epoll for RISC OS Phoenix
+ * boot405: readiness multiplexing over file_ops.poll + wait queues
+ */
+
+#ifndef SELECT_H
+#define SELECT_H
+
+#include <stdint.h>
+#include "vfs.h"
+
+/* ── select() ───────────────────────────────────────────────────────────── */
+typedef unsigned long fd_mask;
+#define FD_SETSIZE 1024
+#define NFDBITS (8 * sizeof(fd_mask))
+
+typedef struct {
+    fd_mask fds_bits[FD_SETSIZE / NFDBITS];
+} fd_set;
+
+#define FD_ZERO(s)      memset((s), 0, sizeof(fd_set))
+#define FD_SET(fd, s)   ((s)->fds_bits[(fd) / NFDBITS] |=  (1UL << ((fd) % NFDBITS)))
+#define FD_CLR(fd, s)   ((s)->fds_bits[(fd) / NFDBITS] &= ~(1UL << ((fd) % NFDBITS)))
+#define FD_ISSET(fd, s) (((s)->fds_bits[(fd) / NFDBITS] >> ((fd) % NFDBITS)) & 1UL)
+
+struct timeval {
+    long tv_sec;
+    long tv_usec;
+};
+
+/* ── poll() ─────────────────────────────────────────────────────────────── */
+typedef unsigned long nfds_t;
+
+struct pollfd {
+    int fd;
+    short events;
+    short revents;
+};
+
+/* ── epoll ──────────────────────────────────────────────────────────────── */
+#define EPOLL_CTL_ADD   1
+#define EPOLL_CTL_DEL   2
+#define EPOLL_CTL_MOD   3
+
+#define EPOLLIN         POLLIN
+#define EPOLLPRI        POLLPRI
+#define EPOLLOUT        POLLOUT
+#define EPOLLERR        POLLERR
+#define EPOLLHUP        POLLHUP
+#define EPOLLONESHOT    (1u << 30)      /* disarm after one report        */
+#define EPOLLET         (1u << 31)      /* report transitions only        */
+
+typedef union epoll_data {
+    void     *ptr;
+    int       fd;
+    uint32_t  u32;
+    uint64_t  u64;
+} epoll_data_t;
+
+struct epoll_event {
+    uint32_t     events;
+    epoll_data_t data;
+};
+
+int select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds,
+           struct timeval *timeout);
+int poll(struct pollfd *fds, nfds_t nfds, int timeout_ms);
+
+int epoll_create(int size);
+int epoll_ctl(int epfd, int op, int fd, struct epoll_event *event);
+int epoll_wait(int epfd, struct epoll_event *events, int maxevents,
+               int timeout_ms);
+
+/* Drop every epoll watch on a file that is being closed (vfs_fd_close) */
+void eventpoll_release(file_t *file);
+
+#endif /* SELECT_H */
@@ -2,6 +2,7 @@
  * task.c – Task management for RISC OS Phoenix
  * Author:   R Andrews  – 06 Feb 2026
  * Updated: 15 Feb 2026 - Added error handling
+ * Updated: boot401 – Oct 2026 – demand-paged execve (file-backed regions)
  */
 
 #include "kernel.h"
@@ -144,6 +145,10 @@ int fork(void)
     uint64_t offset = parent->sp_el0 - (parent->stack_top - KERNEL_STACK_SIZE);
     child->sp_el0 = child->stack_top - offset;
 
+    /* The child shares every open file: one more reference each */
+    for (int fd = 0; fd < MAX_FD; fd++)
+        if (child->files[fd]) vfs_file_get((file_t *)child->files[fd]);
+
     /* Add to scheduler queue — enqueue_task() locks internally */
     int cpu = get_cpu_id();
     cpu_sched_t *sched = &cpu_sched[cpu];
@@ -159,11 +164,55 @@ fail_free_child:
     return -1;
 }
 
+/* boot401: argv/envp are copied into one kernel buffer before the old
+ * user window is torn down — they usually point into it.              */
+typedef struct {
+    char  *buf;
+    char **argv;
+    char **envp;
+    int    argc;
+    int    envc;
+} exec_args_t;
+
+static int exec_args_copy(exec_args_t *a, char *const argv[], char *const envp[])
+{
+    size_t bytes = 0;
+    a->argc = a->envc = 0;
+    while (argv && argv[a->argc] && a->argc < 1024)
+        bytes += strnlen(argv[a->argc++], 255) + 1;
+    while (envp && envp[a->envc] && a->envc < 1024)
+        bytes += strnlen(envp[a->envc++], 255) + 1;
+
+    size_t nptr = (size_t)(a->argc + a->envc + 2);
+    a->buf = kmalloc(nptr * sizeof(char *) + bytes + 1);
+    if (!a->buf) return -ENOMEM;
+    a->argv = (char **)a->buf;
+    a->envp = a->argv + a->argc + 1;
+
+    char *str = a->buf + nptr * sizeof(char *);
+    for (int i = 0; i < a->argc; i++) {
+        strncpy_safe(str, argv[i], 256);
+        a->argv[i] = str;
+        str += strnlen(str, 255) + 1;
+    }
+    a->argv[a->argc] = NULL;
+    for (int i = 0; i < a->envc; i++) {
+        strncpy_safe(str, envp[i], 256);
+        a->envp[i] = str;
+        str += strnlen(str, 255) + 1;
+    }
+    a->envp[a->envc] = NULL;
+    return 0;
+}
+
+/* boot401: PT_LOAD segments are recorded as file-backed regions and
+ * faulted in page by page (mmu.c data_abort_handler), so startup cost
+ * follows the pages actually touched rather than the binary's size.   */
 int execve(const char *pathname, char *const argv[], char *const envp[])
 {
     task_t *task = current_task;
     file_t *file = NULL;
-    void *page = NULL;
+    exec_args_t args = { 0 };
     
     /* Validate parameters */
     if (!pathname || !argv || !envp) {
@@ -198,13 +247,21 @@ int execve(const char *pathname, char *const argv[], char *const envp[])
         goto fail;
     }
 
+    if (exec_args_copy(&args, argv, envp) != 0) {
+        errno = ENOMEM;
+        debug_print("ERROR: execve - failed to copy arguments\n");
+        goto fail;
+    }
+
     mmu_free_usermemory(task);
 
     uint64_t entry = ehdr.e_entry;
     uint64_t phoff = ehdr.e_phoff;
     int phnum = ehdr.e_phnum;
+    uint32_t sin   = file->f_inode->sin;
+    uint32_t fsize = (uint32_t)file->f_inode->i_size;
 
-    /* Load program segments */
+    /* Record program segments — nothing is read here */
     for (int i = 0; i < phnum; i++) {
         Elf64_Phdr phdr;
         vfs_seek(file, phoff + i * ehdr.e_phentsize, SEEK_SET);
@@ -216,55 +273,55 @@ int execve(const char *pathname, char *const argv[], char *const envp[])
         }
 
         if (phdr.p_type == PT_LOAD) {
-            size_t memsz = (phdr.p_memsz + PAGE_SIZE - 1) & PAGE_MASK;
-            page = kmalloc(memsz);
-            if (!page) {
-                errno = ENOMEM;
-                debug_print("ERROR: execve - failed to allocate memory for segment %d\n", i);
+            uint64_t delta = phdr.p_vaddr & (PAGE_SIZE - 1);
+            if ((phdr.p_offset & (PAGE_SIZE - 1)) != delta ||
+                phdr.p_filesz > phdr.p_memsz ||
+                phdr.p_offset + phdr.p_filesz > fsize) {
+                errno = ENOEXEC;
+                debug_print("ERROR: execve - segment %d misaligned or truncated\n", i);
                 goto fail;
             }
 
-            vfs_seek(file, phdr.p_offset, SEEK_SET);
-            read_size = vfs_read(file, page, phdr.p_filesz);
-            if (read_size != phdr.p_filesz) {
-                errno = EIO;
-                debug_print("ERROR: execve - failed to read segment %d\n", i);
-                kfree(page);
-                page = NULL;
-                goto fail;
-            }
-
-            memset((char*)page + phdr.p_filesz, 0, phdr.p_memsz - phdr.p_filesz);
-
             int prot = 0;
             if (phdr.p_flags & PF_R) prot |= PROT_READ;
             if (phdr.p_flags & PF_W) prot |= PROT_WRITE;
             if (phdr.p_flags & PF_X) prot |= PROT_EXEC;
 
-            if (mmu_map(task, phdr.p_vaddr, phdr.p_memsz, prot, 0) != 0) {
-                errno = ENOMEM;
-                debug_print("ERROR: execve - failed to map segment %d\n", i);
-                kfree(page);
-                page = NULL;
+            int rc = phdr.p_filesz
+                ? mmu_map_file(task, phdr.p_vaddr - delta, phdr.p_memsz + delta,
+                               prot, file->f_inode->private, sin, fsize,
+                               phdr.p_offset - delta,
+                               phdr.p_filesz + delta)
+                : mmu_map(task, phdr.p_vaddr, phdr.p_memsz, prot, 0);
+            if (rc != 0) {
+                errno = (rc == -EINVAL) ? ENOEXEC : ENOMEM;
+                debug_print("ERROR: execve - failed to map segment %d "
+                            "(vaddr 0x%llx outside user window?)\n",
+                            i, phdr.p_vaddr);
                 goto fail;
             }
-            
-            page = NULL; /* Ownership transferred to page table */
         }
     }
 
     vfs_close(file);
     file = NULL;
 
+    /* Demand-zero stack with a guard page; the copies below fault its
+     * top pages in through the task's own table.                    */
+    if (mmu_map(task, USER_STACK_TOP - USER_STACK_SIZE, USER_STACK_SIZE,
+                PROT_READ | PROT_WRITE, 1) != 0) {
+        errno = ENOMEM;
+        debug_print("ERROR: execve - failed to map stack\n");
+        goto fail;
+    }
+    mmu_switch_to(task);
+
     // Stack setup with safe string operations
-    uint64_t sp = 0x0000fffffffff000ULL;
-    int argc = 0, envc = 0;
-    
-    /* Count arguments and environment variables safely */
-    while (argv && argv[argc] && argc < 1024) argc++;
-    while (envp && envp[envc] && envc < 1024) envc++;
+    uint64_t sp = USER_STACK_TOP;
+    int argc = args.argc, envc = args.envc;
 
     sp -= 8 * (argc + envc + 2);
+    sp &= ~15ULL;
     uint64_t *arg_env = (uint64_t*)sp;
 
     char *str_ptr = (char*)(sp - (argc + envc + 2) * 256);
@@ -273,27 +330,22 @@ int execve(const char *pathname, char *const argv[], char *const envp[])
 
     /* Copy arguments with bounds checking */
     for (int i = 0; i < argc; i++) {
-        if (argv[i]) {
-            strncpy_safe(str_ptr, argv[i], 256);
-            argv_ptrs[i] = (uint64_t)str_ptr;
-            str_ptr += strnlen(argv[i], 256) + 1;
-        }
+        strncpy_safe(str_ptr, args.argv[i], 256);
+        argv_ptrs[i] = (uint64_t)str_ptr;
+        str_ptr += strnlen(args.argv[i], 256) + 1;
     }
     argv_ptrs[argc] = 0;
 
     /* Copy environment with bounds checking */
     for (int i = 0; i < envc; i++) {
-        if (envp[i]) {
-            strncpy_safe(str_ptr, envp[i], 256);
-            envp_ptrs[i] = (uint64_t)str_ptr;
-            str_ptr += strnlen(envp[i], 256) + 1;
-        }
+        strncpy_safe(str_ptr, args.envp[i], 256);
+        envp_ptrs[i] = (uint64_t)str_ptr;
+        str_ptr += strnlen(args.envp[i], 256) + 1;
     }
     envp_ptrs[envc] = 0;
+    kfree(args.buf);
 
-    mmu_map(task, sp & PAGE_MASK, PAGE_SIZE * 8, PROT_READ | PROT_WRITE, 0);
-
-    task->sp_el0 = sp;
+    task->sp_el0 = (sp - (argc + envc + 2) * 256) & ~15ULL;
     task->elr_el1 = entry;
     task->spsr_el1 = 0;
 
@@ -301,12 +353,12 @@ int execve(const char *pathname, char *const argv[], char *const envp[])
     task->regs[1] = (uint64_t)argv_ptrs;
     task->regs[2] = (uint64_t)envp_ptrs;
 
-    debug_print("execve: '%s' loaded at 0x%llx (argc=%d)\n", pathname, entry, argc);
+    debug_print("execve: '%s' mapped, entry 0x%llx (argc=%d)\n", pathname, entry, argc);
 
     return 0;
 
 fail:
-    if (page) kfree(page);
+    if (args.buf) kfree(args.buf);
     if (file) vfs_close(file);
     return -1;
 }
@@ -3,24 +3,242 @@
  * Author:  R Andrews  – 05 Feb 2026
  * Updated: 15 Feb 2026 - Stub version for compilation
  * Updated: boot247, April 2026 – FileCore VFS driver; vfs_dirent_t readdir
+ * Updated: boot404, Oct 2026 – descriptor table (vfs_fd_*) for pipes/sockets
+ * Updated: boot405, Oct 2026 – vfs_poll passes a poll_table; epoll release on close
+ * Updated: boot406, Oct 2026 – refcounted inode cache, slab file_t allocator
+ * Updated: boot407, Oct 2026 – batched getdents (file and path forms)
+ * Updated: boot408, Oct 2026 – filesystem list + mount table; one FileCore mount per disc
  */
 
 #include "kernel.h"
 #include "vfs.h"
 #include "pipe.h"
+#include "select.h"
 #include "errno.h"
 #include "spinlock.h"
 
 #define MAX_INODES      1024
-#define MAX_FILES       1024
+#define ICACHE_BUCKETS  256             /* power of two */
+
+/* ── Filesystems and mounts ──────────────────────────────────────────────────
+ * boot408: drivers register once; each vfs_mount() gets its own fsdata
+ * (for FileCore, one per disc).  A path picks its mount by name prefix
+ * ("ADFS::NVMe.$…"); unprefixed paths go to the first mount.           */
+#define VFS_MAX_FS      4
+#define VFS_MAX_MOUNTS  8
+
+typedef struct {
+    const vfs_filesystem_t *fs;
+    void                   *fsdata;
+    char                    name[24];
+} vfs_mount_t;
+
+static const vfs_filesystem_t *filesystems[VFS_MAX_FS];
+static int                     nfilesystems = 0;
+static vfs_mount_t             mounts[VFS_MAX_MOUNTS];
+static int                     nmounts = 0;
+
+/* ── Inode cache ─────────────────────────────────────────────────────────────
+ * boot406: inodes come from a fixed pool and are hashed by (filesystem,
+ * SIN), so reopening a file finds its cached inode.  i_count counts
+ * references (open files); at zero the inode stays hashed but moves to
+ * an LRU list, and allocation reclaims the least-recently-used one when
+ * the pool is exhausted.  Each hash bucket has its own lock; lru_lock
+ * covers the LRU and free lists and nests inside a bucket lock.        */
+
+typedef struct {
+    spinlock_t lock;
+    inode_t   *head;
+} icache_bucket_t;
+
+static inode_t         inodes[MAX_INODES];
+static int             inodes_used = 0;         /* never-handed-out tail */
+static inode_t        *inode_free  = NULL;      /* returned anonymous inodes */
+static inode_t        *lru_head    = NULL;      /* most recently released */
+static inode_t        *lru_tail    = NULL;      /* reclaim candidate      */
+static spinlock_t      lru_lock    = SPINLOCK_INIT;
+static icache_bucket_t icache[ICACHE_BUCKETS];
+
+static unsigned icache_hash(const void *fs, uint32_t sin)
+{
+    uint64_t k = (uint64_t)(uintptr_t)fs ^ ((uint64_t)sin * 0x9E3779B97F4A7C15ULL);
+    return (unsigned)(k >> 32) & (ICACHE_BUCKETS - 1);
+}
+
+/* Caller holds lru_lock */
+static void lru_unlink(inode_t *inode)
+{
+    if (!inode->i_on_lru) return;
+    if (inode->i_lru_prev) inode->i_lru_prev->i_lru_next = inode->i_lru_next;
+    else                   lru_head = inode->i_lru_next;
+    if (inode->i_lru_next) inode->i_lru_next->i_lru_prev = inode->i_lru_prev;
+    else                   lru_tail = inode->i_lru_prev;
+    inode->i_lru_prev = inode->i_lru_next = NULL;
+    inode->i_on_lru = 0;
+}
+
+/* Caller holds lru_lock */
+static void lru_push(inode_t *inode)
+{
+    inode->i_lru_prev = NULL;
+    inode->i_lru_next = lru_head;
+    if (lru_head) lru_head->i_lru_prev = inode;
+    else          lru_tail = inode;
+    lru_head = inode;
+    inode->i_on_lru = 1;
+}
+
+/* Unhash and return the least-recently-used idle inode, or NULL */
+static inode_t *icache_reclaim(void)
+{
+    unsigned long fl, bl;
+    for (int tries = 0; tries < 4; tries++) {
+        spin_lock_irqsave(&lru_lock, &fl);
+        inode_t *victim = lru_tail;
+        unsigned b = victim ? icache_hash(victim->i_fs, victim->sin) : 0;
+        spin_unlock_irqrestore(&lru_lock, fl);
+        if (!victim) return NULL;
+
+        /* Bucket first, then LRU; re-check the victim is still idle */
+        spin_lock_irqsave(&icache[b].lock, &bl);
+        spin_lock_irqsave(&lru_lock, &fl);
+        int ok = victim->i_on_lru && victim->i_count == 0;
+        if (ok) lru_unlink(victim);
+        spin_unlock_irqrestore(&lru_lock, fl);
+        if (ok) {
+            inode_t **pp = &icache[b].head;
+            while (*pp && *pp != victim) pp = &(*pp)->i_hnext;
+            if (*pp) *pp = victim->i_hnext;
+            victim->i_hashed = 0;
+        }
+        spin_unlock_irqrestore(&icache[b].lock, bl);
+        if (ok) return victim;
+    }
+    return NULL;
+}
+
+/* Take a blank inode from the pool (free list, unused tail, then LRU) */
+static inode_t *inode_get_blank(void)
+{
+    unsigned long fl;
+    inode_t *inode = NULL;
+
+    spin_lock_irqsave(&lru_lock, &fl);
+    if (inode_free) {
+        inode = inode_free;
+        inode_free = inode->i_hnext;
+    } else if (inodes_used < MAX_INODES) {
+        inode = &inodes[inodes_used++];
+    }
+    spin_unlock_irqrestore(&lru_lock, fl);
+
+    if (!inode) inode = icache_reclaim();
+    if (!inode) { errno = ENFILE; return NULL; }
+
+    memset(inode, 0, sizeof(*inode));
+    inode->file_type = 0xFFF;  /* Default Text */
+    inode->i_count   = 1;
+    return inode;
+}
+
+/*
+ * Look up (fs, sin) in the cache and take a reference, allocating and
+ * hashing a fresh inode on a miss (*fresh set so the caller fills it).
+ */
+inode_t *vfs_iget(const void *fs, uint32_t sin, int *fresh)
+{
+    unsigned b = icache_hash(fs, sin);
+    unsigned long bl, fl;
+    inode_t *inode;
+
+    if (fresh) *fresh = 0;
+    spin_lock_irqsave(&icache[b].lock, &bl);
+    for (inode = icache[b].head; inode; inode = inode->i_hnext) {
+        if (inode->i_fs == fs && inode->sin == sin) {
+            if (inode->i_count++ == 0) {
+                spin_lock_irqsave(&lru_lock, &fl);
+                lru_unlink(inode);
+                spin_unlock_irqrestore(&lru_lock, fl);
+            }
+            spin_unlock_irqrestore(&icache[b].lock, bl);
+            return inode;
+        }
+    }
+    spin_unlock_irqrestore(&icache[b].lock, bl);
+
+    inode_t *blank = inode_get_blank();
+    if (!blank) return NULL;
+    blank->i_fs = fs;
+    blank->sin  = sin;
+
+    /* Someone may have cached the same key while the lock was dropped */
+    spin_lock_irqsave(&icache[b].lock, &bl);
+    for (inode = icache[b].head; inode; inode = inode->i_hnext) {
+        if (inode->i_fs == fs && inode->sin == sin) {
+            if (inode->i_count++ == 0) {
+                spin_lock_irqsave(&lru_lock, &fl);
+                lru_unlink(inode);
+                spin_unlock_irqrestore(&lru_lock, fl);
+            }
+            spin_unlock_irqrestore(&icache[b].lock, bl);
+            vfs_iput(blank);            /* unhashed: back to the free list */
+            return inode;
+        }
+    }
+    blank->i_hashed = 1;
+    blank->i_hnext  = icache[b].head;
+    icache[b].head  = blank;
+    spin_unlock_irqrestore(&icache[b].lock, bl);
+
+    if (fresh) *fresh = 1;
+    return blank;
+}
+
+/* Drop a reference; idle cached inodes go on the LRU, anonymous ones free */
+void vfs_iput(inode_t *inode)
+{
+    if (!inode) return;
+    unsigned long bl, fl;
+
+    if (!inode->i_hashed) {
+        spin_lock_irqsave(&lru_lock, &fl);
+        if (--inode->i_count == 0) {
+            inode->i_hnext = inode_free;
+            inode_free = inode;
+        }
+        spin_unlock_irqrestore(&lru_lock, fl);
+        return;
+    }
+
+    unsigned b = icache_hash(inode->i_fs, inode->sin);
+    spin_lock_irqsave(&icache[b].lock, &bl);
+    if (--inode->i_count == 0) {
+        spin_lock_irqsave(&lru_lock, &fl);
+        lru_push(inode);
+        spin_unlock_irqrestore(&lru_lock, fl);
+    }
+    spin_unlock_irqrestore(&icache[b].lock, bl);
+}
+
+/* ── file_t slab ─────────────────────────────────────────────────────────────
+ * boot406: file_t objects are carved a page at a time and recycled through
+ * a free list, so open/close is O(1) and never exhausts a fixed table.   */
 
-static inode_t inodes[MAX_INODES];
-static int num_inodes = 0;
-static spinlock_t inode_lock = SPINLOCK_INIT;
+#define FILE_SLAB_OBJS  (PAGE_SIZE / sizeof(file_t))
 
-static file_t files[MAX_FILES];
-static int num_files = 0;
-static spinlock_t file_lock = SPINLOCK_INIT;
+static file_t     *file_free = NULL;
+static spinlock_t  file_lock = SPINLOCK_INIT;
+
+static int file_slab_grow(void)
+{
+    file_t *slab = kmalloc(FILE_SLAB_OBJS * sizeof(file_t));
+    if (!slab) return -1;
+    for (size_t i = 0; i < FILE_SLAB_OBJS; i++) {
+        slab[i].private = file_free;    /* free-list link */
+        file_free = &slab[i];
+    }
+    return 0;
+}
 
 /* Forward declarations for FileCore public API (defined in filecore.c) */
 extern int      filecore_find_path(const char *path, vfs_dirent_t *out);
@@ -29,6 +247,7 @@ extern void     kfree(void *);
 
 /* ── FileCore file_ops ───────────────────────────────────────────────────── */
 
+/* inode->private is the FileCore mount the file was found on (boot408) */
 static ssize_t fc_vfs_read(file_t *file, void *buf, size_t count)
 {
     if (!file || !file->f_inode) return -1;
@@ -36,7 +255,9 @@ static ssize_t fc_vfs_read(file_t *file, void *buf, size_t count)
     uint32_t size = (uint32_t)file->f_inode->i_size;
     if (size == 0u || count == 0u) return 0;
 
+    void    *prev = filecore_enter(file->f_inode->private);
     uint8_t *fbuf = filecore_read_file(sin, size);
+    filecore_enter(prev);
     if (!fbuf) return -1;
 
     uint64_t pos = file->f_pos;
@@ -77,16 +298,40 @@ static file_ops_t filecore_file_ops = {
     .close = NULL,
 };
 
+/* boot407: FileCore directories — f_pos is the entry cookie */
+static ssize_t fc_vfs_getdents(file_t *file, void *buf, size_t bufsz)
+{
+    if (!file || !file->f_inode) return -1;
+    uint32_t cookie = (uint32_t)file->f_pos;
+    if (bufsz > 0xFFFFFFFFu) bufsz = 0xFFFFFFFFu;
+    void *prev = filecore_enter(file->f_inode->private);
+    int   n    = filecore_getdents(file->f_inode->sin, &cookie, buf, (uint32_t)bufsz);
+    filecore_enter(prev);
+    if (n < 0) { errno = EINVAL; return -1; }
+    file->f_pos = cookie;
+    return n;
+}
+
+static file_ops_t filecore_dir_ops = {
+    .seek     = fc_vfs_seek,
+    .getdents = fc_vfs_getdents,
+};
+
 /* ── resolve_path ────────────────────────────────────────────────────────── */
+/* Returns a referenced inode; metadata is refreshed from the directory
+ * entry so a cached inode tracks the file's current size and type.
+ * boot408: inodes are keyed by (mount, SIN) — SINs repeat across discs. */
 static inode_t *resolve_path(const char *path)
 {
     vfs_dirent_t ent;
-    if (filecore_find_path(path, &ent) != 0) return NULL;
+    void *mount = NULL;
+    if (filecore_lookup(path, &ent, &mount) != 0) return NULL;
 
-    inode_t *inode = vfs_alloc_inode();
+    inode_t *inode = vfs_iget(mount, ent.sin, NULL);
     if (!inode) return NULL;
 
-    inode->sin       = ent.sin;
+    inode->private   = mount;
+
     inode->i_size    = (uint64_t)ent.size;
     inode->i_blocks  = (ent.size + 511u) / 512u;
     inode->load_addr = ent.load_addr;
@@ -96,23 +341,9 @@ static inode_t *resolve_path(const char *path)
     return inode;
 }
 
-/* Allocate new inode */
+/* Allocate an anonymous (uncached) inode, e.g. for a device or pipe */
 inode_t *vfs_alloc_inode(void) {
-    unsigned long flags;
-    spin_lock_irqsave(&inode_lock, &flags);
-
-    if (num_inodes >= MAX_INODES) {
-        spin_unlock_irqrestore(&inode_lock, flags);
-        errno = ENFILE;
-        return NULL;
-    }
-
-    inode_t *inode = &inodes[num_inodes++];
-    memset(inode, 0, sizeof(*inode));
-    inode->file_type = 0xFFF;  /* Default Text */
-
-    spin_unlock_irqrestore(&inode_lock, flags);
-    return inode;
+    return inode_get_blank();
 }
 
 /* Set RISC OS file type */
@@ -122,44 +353,37 @@ void vfs_set_file_type(inode_t *inode, uint16_t type) {
     }
 }
 
-/* Stub: Open file */
+/* Open file – reuses the cached inode when the file was opened before */
 file_t *vfs_open(const char *path, int flags) {
     if (!path) {
         errno = EINVAL;
         return NULL;
     }
 
-    unsigned long fl;
-    spin_lock_irqsave(&file_lock, &fl);
-
-    if (num_files >= MAX_FILES) {
-        spin_unlock_irqrestore(&file_lock, fl);
-        errno = EMFILE;
-        return NULL;
-    }
-
     inode_t *inode = resolve_path(path);
     if (!inode) {
-        spin_unlock_irqrestore(&file_lock, fl);
         errno = ENOENT;
         return NULL;
     }
 
-    file_t *file = &files[num_files++];
+    file_t *file = vfs_file_alloc(get_fs_ops(inode), NULL, flags);
+    if (!file) {
+        vfs_iput(inode);
+        return NULL;
+    }
     file->f_inode = inode;
-    file->f_pos = 0;
-    file->f_flags = flags;
-    file->f_ops = get_fs_ops(inode);
-
-    spin_unlock_irqrestore(&file_lock, fl);
     return file;
 }
 
-/* Stub: Close file */
+/* Close file – runs the type's close op, then recycles the file_t */
 void vfs_close(file_t *file) {
-    if (file && file->f_ops && file->f_ops->close) {
+    if (!file) return;
+    if (__atomic_sub_fetch(&file->f_count, 1, __ATOMIC_ACQ_REL) > 0) return;
+    if (file->f_ep) eventpoll_release(file);    /* unhook epoll watches */
+    if (file->f_ops && file->f_ops->close) {
         file->f_ops->close(file);
     }
+    vfs_file_free(file);
 }
 
 /* Stub: Read from file */
@@ -189,12 +413,154 @@ off_t vfs_seek(file_t *file, off_t offset, int whence) {
     return file->f_ops->seek(file, offset, whence);
 }
 
-/* Stub: Poll file */
-int vfs_poll(file_t *file) {
-    if (!file || !file->f_ops || !file->f_ops->poll) {
-        return 0;
+/* Poll file – files without a poll op are always ready (regular files) */
+int vfs_poll(file_t *file, poll_table_t *pt) {
+    if (!file || !file->f_ops) return POLLNVAL;
+    if (!file->f_ops->poll) return POLLIN | POLLOUT;
+    return file->f_ops->poll(file, pt);
+}
+
+/* ── Batched directory reads ─────────────────────────────────────────────── */
+
+/* Append one packed record for ent; returns its length, 0 if it won't fit */
+size_t vfs_dirent_pack(void *dst, size_t space, const vfs_dirent_t *ent)
+{
+    size_t namelen = strlen(ent->name);
+    if (namelen > 255u) namelen = 255u;
+    size_t reclen = (sizeof(vfs_dirent_packed_t) + namelen + 1u + 7u) & ~(size_t)7u;
+    if (reclen > space) return 0;
+
+    vfs_dirent_packed_t *d = (vfs_dirent_packed_t *)dst;
+    d->size        = ent->size;
+    d->sin         = ent->sin;
+    d->load_addr   = ent->load_addr;
+    d->exec_addr   = ent->exec_addr;
+    d->reclen      = (uint16_t)reclen;
+    d->riscos_type = ent->riscos_type;
+    d->type        = (uint8_t)ent->type;
+    d->namelen     = (uint8_t)namelen;
+    memcpy(d->name, ent->name, namelen);
+    d->name[namelen] = '\0';
+    return reclen;
+}
+
+ssize_t vfs_getdents(file_t *file, void *buf, size_t bufsz) {
+    if (!file || !file->f_ops || !file->f_ops->getdents || !buf) {
+        errno = ENOTDIR;
+        return -1;
+    }
+    return file->f_ops->getdents(file, buf, bufsz);
+}
+
+/* Case-insensitive: does path start with the mount name, then '.' or end? */
+static int vfs_mount_prefix(const char *path, const char *name)
+{
+    size_t i;
+    for (i = 0; name[i]; i++) {
+        char a = path[i], b = name[i];
+        if (a >= 'a' && a <= 'z') a -= 32;
+        if (b >= 'a' && b <= 'z') b -= 32;
+        if (a != b) return 0;
+    }
+    return i && (path[i] == '.' || path[i] == '\0');
+}
+
+/* Mount whose name prefixes path, else the first */
+static vfs_mount_t *vfs_mount_for_path(const char *path)
+{
+    if (nmounts == 0) return NULL;
+    for (int i = 0; path && i < nmounts; i++)
+        if (vfs_mount_prefix(path, mounts[i].name)) return &mounts[i];
+    return &mounts[0];
+}
+
+/* Path form over the mounted filesystems; *cookie starts at 0 */
+int vfs_readdir_batch(const char *path, void *buf, size_t bufsz, uint32_t *cookie)
+{
+    vfs_mount_t *m = vfs_mount_for_path(path);
+    if (!m || !m->fs->getdents) return -1;
+    return m->fs->getdents(m->fsdata, path, buf, bufsz, cookie);
+}
+
+/* ── File descriptor table ───────────────────────────────────────────────────
+ * boot404: per-task descriptors live in task->files[]; code running before
+ * the scheduler (current_task == NULL) uses a kernel-wide table.  All files
+ * come from vfs_file_alloc() with one reference; fork takes another for
+ * every inherited descriptor (vfs_file_get).  vfs_close() drops one, and
+ * the last runs the type's close op and returns the file_t to the slab. */
+static void *kernel_fds[MAX_FD];
+
+static void **fd_table(void)
+{
+    return current_task ? current_task->files : kernel_fds;
+}
+
+file_t *vfs_file_alloc(file_ops_t *ops, void *private, int flags)
+{
+    unsigned long fl;
+    spin_lock_irqsave(&file_lock, &fl);
+    if (!file_free && file_slab_grow() != 0) {
+        spin_unlock_irqrestore(&file_lock, fl);
+        errno = ENOMEM;
+        return NULL;
     }
-    return file->f_ops->poll(file);
+    file_t *file = file_free;
+    file_free = (file_t *)file->private;
+    spin_unlock_irqrestore(&file_lock, fl);
+
+    memset(file, 0, sizeof(*file));
+    file->f_ops   = ops;
+    file->private = private;
+    file->f_flags = flags;
+    file->f_count = 1;
+    return file;
+}
+
+/* Another descriptor now refers to file */
+file_t *vfs_file_get(file_t *file)
+{
+    if (file) __atomic_add_fetch(&file->f_count, 1, __ATOMIC_ACQ_REL);
+    return file;
+}
+
+/* Release a file_t and its inode reference (close op already run) */
+void vfs_file_free(file_t *file)
+{
+    if (!file) return;
+    vfs_iput(file->f_inode);
+    file->f_inode = NULL;
+    file->f_ops   = NULL;
+
+    unsigned long fl;
+    spin_lock_irqsave(&file_lock, &fl);
+    file->private = file_free;
+    file_free = file;
+    spin_unlock_irqrestore(&file_lock, fl);
+}
+
+int vfs_fd_install(file_t *file)
+{
+    void **tab = fd_table();
+    for (int fd = 0; fd < MAX_FD; fd++) {
+        if (!tab[fd]) { tab[fd] = file; return fd; }
+    }
+    errno = EMFILE;
+    return -1;
+}
+
+file_t *vfs_fd_get(int fd)
+{
+    if (fd < 0 || fd >= MAX_FD) return NULL;
+    return (file_t *)fd_table()[fd];
+}
+
+int vfs_fd_close(int fd)
+{
+    file_t *file = vfs_fd_get(fd);
+    if (!file) { errno = EBADF; return -1; }
+    fd_table()[fd] = NULL;
+    vfs_close(file);
+    return 0;
 }
 
 /* Return file_ops for the inode's filesystem type */
@@ -203,6 +569,7 @@ file_ops_t *get_fs_ops(inode_t *inode)
     if (!inode) return NULL;
     /* FileCore regular files — directories are not directly read */
     if (inode->i_mode & S_IFREG) return &filecore_file_ops;
+    if (inode->i_mode & S_IFDIR) return &filecore_dir_ops;
     return NULL;
 }
 
@@ -215,17 +582,13 @@ extern void filecore_list_root(void);
 extern int  filecore_get_root_entry(uint32_t idx, vfs_dirent_t *out);
 extern int  filecore_get_child_entry(uint32_t sin, uint32_t idx,
                                       vfs_dirent_t *out);
-/* g_fc_bdev is blockdev_t* in filecore.c — forward as void* to avoid
- * including blockdev headers. The pointer value is only stored, never
- * dereferenced in vfs.c.                                                   */
-extern void *g_fc_bdev;
-/* Simple registry: for now, one slot — extend to array later               */
-static const vfs_filesystem_t *registered_fs = NULL;
-
 int vfs_register_filesystem(const vfs_filesystem_t *fs)
 {
     if (!fs) return -1;
-    registered_fs = fs;
+    for (int i = 0; i < nfilesystems; i++)
+        if (filesystems[i] == fs) return 0;
+    if (nfilesystems >= VFS_MAX_FS) return -1;
+    filesystems[nfilesystems++] = fs;
     uart_puts("[VFS] Registered filesystem: "); uart_puts(fs->name); uart_puts("\n");
     return 0;
 }
@@ -233,14 +596,24 @@ int vfs_register_filesystem(const vfs_filesystem_t *fs)
 int vfs_mount(const char *fsname, const char *mountpoint, uint32_t flags, void *opts)
 {
     (void)opts;
-    if (!registered_fs || !registered_fs->mount) return -1;
+    const vfs_filesystem_t *fs = NULL;
+    for (int i = 0; i < nfilesystems; i++)
+        if (strcmp(filesystems[i]->name, fsname) == 0) fs = filesystems[i];
+    if (!fs || !fs->mount || !mountpoint) return -1;
+    if (nmounts >= VFS_MAX_MOUNTS) return -1;
+
     void *fsdata = NULL;
-    int rc = registered_fs->mount(fsname, mountpoint, flags, &fsdata);
-    if (rc == 0) {
-        uart_puts("[VFS] Mounted "); uart_puts(fsname);
-        uart_puts(" at "); uart_puts(mountpoint); uart_puts("\n");
-    }
-    return rc;
+    int rc = fs->mount(fsname, mountpoint, flags, &fsdata);
+    if (rc != 0) return rc;
+
+    vfs_mount_t *m = &mounts[nmounts++];
+    m->fs     = fs;
+    m->fsdata = fsdata;
+    strncpy(m->name, mountpoint, sizeof(m->name) - 1);
+    m->name[sizeof(m->name) - 1] = '\0';
+    uart_puts("[VFS] Mounted "); uart_puts(fsname);
+    uart_puts(" at "); uart_puts(mountpoint); uart_puts("\n");
+    return 0;
 }
 
 /* ── FileCore VFS driver ────────────────────────────────────────────────── */
@@ -263,19 +636,43 @@ static int filecore_vfs_readdir(void *fsdata, const char *path,
     return -1;          /* end of directory */
 }
 
-/* FileCore mount callback */
+/* boot407: FileCore batched readdir — one directory parse per call.
+ * boot408: fsdata is the default disc; a prefixed path names its own.   */
+static int filecore_vfs_getdents(void *fsdata, const char *path,
+                                 void *buf, size_t bufsz, uint32_t *cookie)
+{
+    vfs_dirent_t dir;
+    void *mount = NULL;
+    if (!path || !path[0] || (path[0] == '/' && !path[1])) path = "$";
+
+    void *prev = filecore_enter(fsdata);
+    int   rc   = filecore_lookup(path, &dir, &mount);
+    if (rc == 0 && dir.type == VFS_DIRENT_DIR) {
+        if (bufsz > 0xFFFFFFFFu) bufsz = 0xFFFFFFFFu;
+        filecore_enter(mount);
+        rc = filecore_getdents(dir.sin, cookie, buf, (uint32_t)bufsz);
+    } else {
+        rc = -1;
+    }
+    filecore_enter(prev);
+    return rc;
+}
+
+/* FileCore mount callback — mnt names a disc found by filecore_init */
 static int filecore_vfs_mount(const char *dev, const char *mnt,
                                uint32_t flags, void **fsdata)
 {
-    (void)dev; (void)mnt; (void)flags;
-
-    uart_puts("[VFS] FileCore: initialising disc scan\n");
-    filecore_init();
-    filecore_list_root();
-
-    *fsdata = g_fc_bdev;
-    uart_puts("[VFS] FileCore: mounted SCSI::laxarusb.$\n");
-    return 0;
+    (void)dev; (void)flags;
+
+    for (int i = 0; i < filecore_mount_count(); i++) {
+        void *m = filecore_mount_get(i);
+        if (strcmp(filecore_mount_name(m), mnt) == 0) {
+            *fsdata = m;
+            return 0;
+        }
+    }
+    uart_puts("[VFS] FileCore: no disc "); uart_puts(mnt); uart_puts("\n");
+    return -1;
 }
 
 static int filecore_vfs_umount(void *fsdata)
@@ -291,6 +688,7 @@ static const vfs_filesystem_t filecore_fs_driver = {
     .mount   = filecore_vfs_mount,
     .umount  = filecore_vfs_umount,
     .readdir = filecore_vfs_readdir,
+    .getdents = filecore_vfs_getdents,
 };
 
 /* Called from kernel_main during boot (optional — kernel.c calls filecore
@@ -303,5 +701,11 @@ void vfs_register_filecore(void)
         uart_puts("[VFS] Registration failed\n");
         return;
     }
-    vfs_mount("FileCore", "HardDisc0", 0, NULL);
+    if (filecore_mount_count() == 0) {
+        uart_puts("[VFS] FileCore: initialising disc scan\n");
+        filecore_init();
+        filecore_list_root();
+    }
+    for (int i = 0; i < filecore_mount_count(); i++)
+        vfs_mount("FileCore", filecore_mount_name(filecore_mount_get(i)), 0, NULL);
 }
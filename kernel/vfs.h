@@ -4,6 +4,10 @@
  * Supports RISC OS file types, pipes, block devices, and FileCore integration.
  * Author:  R Andrews – 05 Feb 2026
  * Updated: boot247, April 2026 – added vfs_filesystem_t, vfs_dirent_t, readdir
+ * Updated: boot404, Oct 2026 – descriptor table, poll bits
+ * Updated: boot405, Oct 2026 – wait queues; poll op takes a poll_table_t
+ * Updated: boot406, Oct 2026 – inode cache fields, vfs_iget/vfs_iput
+ * Updated: boot407, Oct 2026 – batched getdents with packed dirents
  */
 
 #ifndef VFS_H
@@ -12,7 +16,7 @@
 #include <stdint.h>
 
 #ifndef MAX_FD
-#define MAX_FD          64
+#define MAX_FD          256
 #endif
 
 /* ── Open flags ─────────────────────────────────────────────────────────── */
@@ -22,6 +26,14 @@
 #define O_NONBLOCK      0x0004
 #define O_CREAT         0x0008
 
+/* ── Poll bits (file_ops.poll return value) ─────────────────────────────── */
+#define POLLIN          0x0001
+#define POLLPRI         0x0002
+#define POLLOUT         0x0004
+#define POLLERR         0x0008
+#define POLLHUP         0x0010
+#define POLLNVAL        0x0020
+
 /* ── Inode mode bits ────────────────────────────────────────────────────── */
 #define S_IFIFO         (1ULL << 12)    /* Pipe              */
 #define S_IFREG         (1ULL << 13)    /* Regular file      */
@@ -49,10 +61,65 @@ typedef struct {
     char     name[VFS_NAME_MAX];    /* Null-terminated name                 */
 } vfs_dirent_t;
 
+/* ── Packed directory entry (getdents) ──────────────────────────────────────
+ * boot407: variable length — the name is stored inline and NUL-terminated,
+ * and reclen (8-byte aligned) steps to the next record in the buffer.    */
+typedef struct {
+    uint64_t size;                  /* File size in bytes                   */
+    uint32_t sin;                   /* FileCore SIN / IDA                   */
+    uint32_t load_addr;             /* RISC OS load address                 */
+    uint32_t exec_addr;             /* RISC OS exec address (timestamp)     */
+    uint16_t reclen;                /* Bytes to the next record             */
+    uint16_t riscos_type;           /* RISC OS file type                    */
+    uint8_t  type;                  /* VFS_DIRENT_FILE / DIR / SPECIAL      */
+    uint8_t  namelen;               /* strlen(name)                         */
+    char     name[];                /* Null-terminated name                 */
+} vfs_dirent_packed_t;
+
+#define VFS_DIRENT_NEXT(d) \
+    ((vfs_dirent_packed_t *)((uint8_t *)(d) + (d)->reclen))
+
 typedef struct inode inode_t;
 typedef struct file  file_t;
 typedef struct file_ops file_ops_t;
 
+/* ── Wait queues ────────────────────────────────────────────────────────────
+ * boot405: a file type owns a wait_queue_t per readiness source and calls
+ * wait_queue_wake() only when that source changes state (empty→data,
+ * full→space, hang-up).  Its poll op calls poll_wait() on the queue before
+ * sampling readiness, so poll/select/epoll hear about the next change.   */
+typedef struct wait_entry wait_entry_t;
+typedef struct wait_queue wait_queue_t;
+typedef struct poll_table poll_table_t;
+
+struct wait_entry {
+    wait_entry_t *next;
+    wait_entry_t *prev;
+    wait_queue_t *wq;                   /* queue this entry is linked on    */
+    void        (*func)(wait_entry_t *we, int events);
+    void         *private;
+};
+
+struct wait_queue {
+    spinlock_t    lock;
+    wait_entry_t *head;
+};
+
+struct poll_table {
+    void (*queue)(poll_table_t *pt, wait_queue_t *wq);
+};
+
+void wait_queue_init  (wait_queue_t *wq);
+void wait_queue_add   (wait_queue_t *wq, wait_entry_t *we);
+void wait_queue_remove(wait_entry_t *we);
+void wait_queue_wake  (wait_queue_t *wq, int events);
+
+/* Called from file_ops.poll; pt == NULL means "just sample" */
+static inline void poll_wait(poll_table_t *pt, wait_queue_t *wq)
+{
+    if (pt && wq) pt->queue(pt, wq);
+}
+
 /* ── Inode ──────────────────────────────────────────────────────────────── */
 struct inode {
     uint64_t i_mode;        /* File type/mode (S_IFREG, S_IFDIR etc.)   */
@@ -63,6 +130,15 @@ struct inode {
     uint32_t exec_addr;     /* RISC OS exec address                     */
     uint32_t sin;           /* FileCore SIN                             */
     void    *private;       /* FS-specific data (e.g., blockdev)        */
+
+    /* Inode cache (boot406) — owned by vfs.c                              */
+    const void *i_fs;       /* Filesystem identity (hash key with sin)  */
+    uint32_t  i_count;      /* References (open files)                  */
+    uint8_t   i_hashed;     /* In the (fs, sin) hash                    */
+    uint8_t   i_on_lru;     /* Idle, on the reclaim list                */
+    inode_t  *i_hnext;      /* Hash chain / free list                   */
+    inode_t  *i_lru_prev;
+    inode_t  *i_lru_next;
 };
 
 /* ── File ───────────────────────────────────────────────────────────────── */
@@ -72,6 +148,9 @@ struct file {
     int         f_flags;    /* Open flags (O_RDONLY etc.)               */
     file_ops_t *f_ops;      /* File operations                          */
     void       *private;    /* FS-specific private data                 */
+    struct epitem *f_ep;    /* epoll watches on this file (boot405)     */
+    int         f_count;    /* descriptors sharing it (fork); close op  *
+                             * and free run when it drops to zero       */
 };
 
 /* ── File operations ────────────────────────────────────────────────────── */
@@ -79,8 +158,9 @@ struct file_ops {
     ssize_t (*read)   (file_t *file, void *buf, size_t count);
     ssize_t (*write)  (file_t *file, const void *buf, size_t count);
     off_t   (*seek)   (file_t *file, off_t offset, int whence);
-    int     (*poll)   (file_t *file);
+    int     (*poll)   (file_t *file, poll_table_t *pt);
     int     (*readdir)(file_t *file, vfs_dirent_t *dirent);
+    ssize_t (*getdents)(file_t *file, void *buf, size_t bufsz);
     void    (*close)  (file_t *file);
 };
 
@@ -93,10 +173,14 @@ typedef struct {
     int  (*umount) (void *fsdata);
     int  (*readdir)(void *fsdata, const char *path,
                     vfs_dirent_t *dirent, uint32_t *cookie);
+    int  (*getdents)(void *fsdata, const char *path,
+                     void *buf, size_t bufsz, uint32_t *cookie);
 } vfs_filesystem_t;
 
 /* ── VFS API ────────────────────────────────────────────────────────────── */
 inode_t    *vfs_alloc_inode(void);
+inode_t    *vfs_iget(const void *fs, uint32_t sin, int *fresh);
+void        vfs_iput(inode_t *inode);
 void        vfs_set_file_type(inode_t *inode, uint16_t type);
 
 file_t     *vfs_open (const char *path, int flags);
@@ -104,7 +188,14 @@ void        vfs_close(file_t *file);
 ssize_t     vfs_read (file_t *file, void *buf, size_t count);
 ssize_t     vfs_write(file_t *file, const void *buf, size_t count);
 off_t       vfs_seek (file_t *file, off_t offset, int whence);
-int         vfs_poll (file_t *file);
+int         vfs_poll (file_t *file, poll_table_t *pt);
+
+/* boot407: batched directory reads — fill buf with vfs_dirent_packed_t
+ * records; return bytes used, 0 at end of directory, -1 on error.       */
+ssize_t     vfs_getdents(file_t *file, void *buf, size_t bufsz);
+int         vfs_readdir_batch(const char *path, void *buf, size_t bufsz,
+                              uint32_t *cookie);
+size_t      vfs_dirent_pack(void *dst, size_t space, const vfs_dirent_t *ent);
 
 int         vfs_register_filesystem(const vfs_filesystem_t *fs);
 int         vfs_mount  (const char *fsname, const char *mountpoint,
@@ -112,11 +203,34 @@ int         vfs_mount  (const char *fsname, const char *mountpoint,
 
 file_ops_t *get_fs_ops(inode_t *inode);
 
+/* boot404: descriptor table (task->files[], kernel table before sched) */
+file_t     *vfs_file_alloc(file_ops_t *ops, void *private, int flags);
+void        vfs_file_free(file_t *file);
+file_t     *vfs_file_get(file_t *file);
+int         vfs_fd_install(file_t *file);
+file_t     *vfs_fd_get(int fd);
+int         vfs_fd_close(int fd);
+
 /* FileCore VFS entry point — called from kernel_main */
 void        vfs_register_filecore(void);
 
 /* FileCore public API — also callable directly when VFS not needed          */
 int         filecore_find_path(const char *path, vfs_dirent_t *out);
+int         filecore_lookup(const char *path, vfs_dirent_t *out, void **mount);
+int         filecore_getdents(uint32_t dir_sin, uint32_t *cookie,
+                              void *buf, uint32_t bufsz);
 uint8_t    *filecore_read_file(uint32_t sin, uint32_t size);
+int         filecore_read_file_into(uint32_t sin, uint32_t size,
+                                    void *dst, uint32_t cap);
+int         filecore_read_file_range(uint32_t sin, uint32_t size, uint32_t off,
+                                     void *dst, uint32_t cap);
+
+/* boot408: one FileCore mount per disc.  Reads and lookups act on the
+ * calling task's active mount; filecore_enter() switches it and returns
+ * the previous one (NULL = boot disc).                                  */
+void       *filecore_enter(void *mount);
+int         filecore_mount_count(void);
+void       *filecore_mount_get(int idx);
+const char *filecore_mount_name(const void *mount);
 
 #endif /* VFS_H */
@@ -71,8 +71,13 @@ int   tcp_connect  (const uint8_t dst_ip[4], uint16_t dst_port);
 int   tcp_state    (int handle);
 int   tcp_write    (int handle, const uint8_t *data, int len);
 int   tcp_read     (int handle, uint8_t *buf, int bufsz);
+int   tcp_rx_avail (int handle);
+struct wait_queue *tcp_wait_queue(int handle);
 void  tcp_close    (int handle);
 
+/* TCP connection as a file descriptor — read/write/poll/splice (net/socket.c) */
+int   socket_tcp_fd(int handle);
+
 /* ----------------------------------------------------------------
  * PhoenixUDP — TX + RX queue (net/udp.c)  boot379
  * ---------------------------------------------------------------- */
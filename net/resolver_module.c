@@ -357,7 +357,7 @@ int resolver_module_final(void)
 /* ── resolver_module_swi ────────────────────────────────────────────────── */
 /*
  * SWI dispatch for RESOLVER_SWI_BASE chunk.
- * Called by swi_dispatch() with swi_offset = swi_number & 0xFF.
+ * Called by swi_dispatch() with swi_offset = swi_number & 0x3F (boot398).
  *
  * Resolver_GetHostByName (offset 0):
  *   Entry: regs[0] = pointer to hostname string
@@ -1,7 +1,104 @@
 /*
  * socket.c – Network socket (stub)
+ * Updated: boot404, Oct 2026 – TCP connections as file descriptors
+ * Updated: boot405, Oct 2026 – poll hooks the connection's wait queue
+ *
+ * socket_tcp_fd() wraps a PhoenixTCP handle in a file_t so it can be
+ * read, written, polled and used as either end of splice().  The TCP
+ * stack is polled from the NIC path, so a blocking read/write yields
+ * until the connection makes progress rather than sleeping on a queue.
  */
 #include "kernel.h"
+#include "vfs.h"
+#include "errno.h"
+#include "net/net.h"
+
+#define SOCK_HANDLE(f)  ((int)(intptr_t)(f)->private - 1)
+
+static int sock_alive(int st)
+{
+    return st == TCPS_ESTABLISHED || st == TCPS_SYN_SENT;
+}
+
+static ssize_t sock_read(file_t *file, void *buf, size_t count)
+{
+    int h = SOCK_HANDLE(file);
+    if (count > 0x7FFFFFFF) count = 0x7FFFFFFF;
+
+    for (;;) {
+        int n = tcp_read(h, (uint8_t *)buf, (int)count);
+        if (n > 0) return n;
+        if (!sock_alive(tcp_state(h))) return 0;       /* peer closed: EOF */
+        if ((file->f_flags & O_NONBLOCK) || !current_task) {
+            errno = EAGAIN;
+            return -1;
+        }
+        yield();
+    }
+}
+
+static ssize_t sock_write(file_t *file, const void *buf, size_t count)
+{
+    int h = SOCK_HANDLE(file);
+    const uint8_t *src = (const uint8_t *)buf;
+    size_t done = 0;
+
+    while (done < count) {
+        if (!sock_alive(tcp_state(h))) {
+            if (done) break;
+            errno = EPIPE;
+            return -1;
+        }
+        size_t want = count - done;
+        if (want > 0x7FFFFFFF) want = 0x7FFFFFFF;
+        int n = tcp_write(h, src + done, (int)want);  /* ≤ one MSS per call */
+        if (n > 0) { done += (size_t)n; continue; }
+        if (done || (file->f_flags & O_NONBLOCK) || !current_task) break;
+        yield();
+    }
+    if (done == 0 && count) { errno = EAGAIN; return -1; }
+    return (ssize_t)done;
+}
+
+static int sock_poll(file_t *file, poll_table_t *pt)
+{
+    int h  = SOCK_HANDLE(file);
+    poll_wait(pt, tcp_wait_queue(h));
+    int st = tcp_state(h);
+    int ev = tcp_rx_avail(h) ? POLLIN : 0;
+    if (st == TCPS_ESTABLISHED) ev |= POLLOUT;
+    else if (st != TCPS_SYN_SENT) ev |= POLLHUP;
+    return ev;
+}
+
+static void sock_close(file_t *file)
+{
+    tcp_close(SOCK_HANDLE(file));
+}
+
+static file_ops_t sock_tcp_ops = {
+    .read  = sock_read,
+    .write = sock_write,
+    .poll  = sock_poll,
+    .close = sock_close,
+};
+
+/* Install a connected TCP handle as a descriptor; returns the fd or -1 */
+int socket_tcp_fd(int handle)
+{
+    if (tcp_state(handle) == TCPS_CLOSED) { errno = EBADF; return -1; }
+
+    file_t *f = vfs_file_alloc(&sock_tcp_ops, (void *)(intptr_t)(handle + 1), O_RDWR);
+    if (!f) { errno = ENOMEM; return -1; }
+
+    int fd = vfs_fd_install(f);
+    if (fd < 0) {
+        vfs_file_free(f);             /* leave the connection with the caller */
+        errno = EMFILE;
+        return -1;
+    }
+    return fd;
+}
 
 void socket_init(void) {
     debug_print("Network socket: Init (stub)\n");
@@ -25,9 +25,12 @@
  *   - RFC 793 section 3.9 (event processing)
  *
  * Author: R Andrews – boot370
+ * Updated: boot405 – per-connection wait queue, woken from tcp_rx on
+ *          data arrival and state changes (poll/select/epoll)
  */
 
 #include "kernel.h"
+#include "vfs.h"
 #include "net/ethernet.h"
 #include "net/dhcp.h"
 #include "drivers/net/genet.h"
@@ -89,6 +92,8 @@ typedef struct {
     int          rcv_head;   /* consumer index */
     int          rcv_tail;   /* producer index */
 
+    wait_queue_t wq;         /* readiness waiters (boot405) */
+
     int          used;       /* 1 = slot occupied */
 } tcp_conn_t;
 
@@ -221,6 +226,23 @@ static void rcvbuf_push(tcp_conn_t *c, const uint8_t *data, int len)
     }
 }
 
+static int rcvbuf_avail(tcp_conn_t *c)
+{
+    return (c->rcv_tail - c->rcv_head + TCP_RCVBUF_SIZE) % TCP_RCVBUF_SIZE;
+}
+
+/* Wake pollers on empty→data and on any state change */
+static void tcp_notify(tcp_conn_t *c, tcp_state_t was, int had)
+{
+    int ev = 0;
+    if (!had && rcvbuf_avail(c)) ev |= POLLIN;
+    if (c->state != was) {
+        if (c->state == TCPS_ESTABLISHED) ev |= POLLOUT;
+        else ev |= POLLIN | POLLHUP;
+    }
+    if (ev) wait_queue_wake(&c->wq, ev);
+}
+
 /* ----------------------------------------------------------------
  * Public API
  * ---------------------------------------------------------------- */
@@ -255,7 +277,10 @@ void tcp_tick(int handle)
 
 void tcp_init(void)
 {
-    for (int i = 0; i < TCP_MAX_CONNS; i++) s_conns[i].used = 0;
+    for (int i = 0; i < TCP_MAX_CONNS; i++) {
+        s_conns[i].used = 0;
+        wait_queue_init(&s_conns[i].wq);  /* once: watchers may outlive a slot */
+    }
     debug_print("[TCP] PhoenixTCP client ready (%d slots, MSS=%d)\n",
         TCP_MAX_CONNS, TCP_MSS);
 }
@@ -354,6 +379,24 @@ int tcp_read(int handle, uint8_t *buf, int bufsz)
     return avail;
 }
 
+/*
+ * tcp_rx_avail — bytes waiting in the receive buffer (boot404)
+ */
+int tcp_rx_avail(int handle)
+{
+    if (handle < 0 || handle >= TCP_MAX_CONNS || !s_conns[handle].used)
+        return 0;
+    return rcvbuf_avail(&s_conns[handle]);
+}
+
+/* Wait queue for poll_wait() — NULL for a free slot (boot405) */
+wait_queue_t *tcp_wait_queue(int handle)
+{
+    if (handle < 0 || handle >= TCP_MAX_CONNS || !s_conns[handle].used)
+        return NULL;
+    return &s_conns[handle].wq;
+}
+
 /*
  * tcp_close — initiate active close (send FIN)
  * Moves to FIN_WAIT_1.  The connection slot is freed automatically
@@ -422,6 +465,8 @@ void tcp_rx(uint8_t *frame, int flen)
     if (!c) return;
 
     c->snd_wnd = wnd;
+    tcp_state_t was = c->state;
+    int         had = rcvbuf_avail(c);
 
     /* --- RST: unconditional abort regardless of state --- */
     if (flags & TF_RST) {
@@ -430,6 +475,7 @@ void tcp_rx(uint8_t *frame, int flen)
             u16be(tcp + 0), (int)(c - s_conns));
         c->state = TCPS_CLOSED;
         c->used  = 0;
+        tcp_notify(c, was, had);
         return;
     }
 
@@ -523,4 +569,6 @@ void tcp_rx(uint8_t *frame, int flen)
     default:
         break;
     }
+
+    tcp_notify(c, was, had);
 }